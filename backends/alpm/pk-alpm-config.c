@@ -40,7 +40,8 @@ static gchar *xfercmd = NULL;
 typedef struct
 {
 	 gboolean		 checkspace, color, disabledownloadtimeout, ilovecandy,
-				noprogressbar, totaldl, usesyslog, verbosepkglists, is_check;
+				noprogressbar, totaldl, usesyslog, verbosepkglists, is_check,
+				is_files;
 
 	 gchar			*arch, *cleanmethod, *dbpath, *gpgdir, *logfile,
 				*root, *xfercmd;
@@ -688,6 +689,14 @@ pk_alpm_config_initialize_alpm (PkAlpmConfig *config, GError **error)
 		return handle;
 	}
 
+	/* the same repositories, but with the file lists of the packages */
+	if (config->is_files && alpm_option_set_dbext (handle, ".files") < 0) {
+		alpm_err = alpm_errno (handle);
+		g_set_error (error, PK_ALPM_ERROR, alpm_err, "DBExt: %s",
+			     alpm_strerror (alpm_err));
+		return handle;
+	}
+
 	if (config->gpgdir == NULL) {
 		config->gpgdir = g_strconcat (config->root,
 					      "/etc/pacman.d/gnupg/" + dir,
@@ -866,7 +875,7 @@ pk_alpm_config_configure_repos (PkBackend *backend, PkAlpmConfig *config,
 		if (repo_level == ALPM_SIG_USE_DEFAULT)
 			 return FALSE;
 
-		if (!config->is_check) {
+		if (!config->is_check && !config->is_files) {
 			pk_alpm_add_database (backend, repo->name, repo->servers, repo_level);
 		} else {
 			alpm_db_t *db;
@@ -1043,8 +1052,9 @@ pk_alpm_config_configure_alpm (PkBackend *backend, PkAlpmConfig *config, GError
 	return handle;
 }
 
-alpm_handle_t *
-pk_alpm_configure (PkBackend *backend, const gchar *filename, gboolean is_check, GError **error)
+static alpm_handle_t *
+pk_alpm_configure_full (PkBackend *backend, const gchar *filename, gboolean is_check,
+			gboolean is_files, GError **error)
 {
 	PkAlpmConfig *config;
 	alpm_handle_t *handle = NULL;
@@ -1059,6 +1069,7 @@ pk_alpm_configure (PkBackend *backend, const gchar *filename, gboolean is_check,
 
 	if (pk_alpm_config_parse (config, filename, NULL, &e)) {
 		config->is_check = is_check;
+		config->is_files = is_files;
 		handle = pk_alpm_config_configure_alpm (backend, config, &e);
 	}
 
@@ -1071,3 +1082,17 @@ pk_alpm_configure (PkBackend *backend, const gchar *filename, gboolean is_check,
 	}
 	return handle;
 }
+
+alpm_handle_t *
+pk_alpm_configure (PkBackend *backend, const gchar *filename, gboolean is_check, GError **error)
+{
+	return pk_alpm_configure_full (backend, filename, is_check, FALSE, error);
+}
+
+/* a handle for the .files databases of the repositories, which are kept
+ * next to the normal ones */
+alpm_handle_t *
+pk_alpm_configure_files (PkBackend *backend, const gchar *filename, GError **error)
+{
+	return pk_alpm_configure_full (backend, filename, FALSE, TRUE, error);
+}
@@ -25,3 +25,5 @@
 #include <glib.h>
 
 alpm_handle_t	*pk_alpm_configure	(PkBackend *backend, const gchar *filename, gboolean is_check, GError **error);
+
+alpm_handle_t	*pk_alpm_configure_files	(PkBackend *backend, const gchar *filename, GError **error);
@@ -27,23 +27,36 @@
 #include "pk-backend-alpm.h"
 #include "pk-alpm-error.h"
 #include "pk-alpm-packages.h"
+#include "pk-alpm-provides.h"
 
+/* like alpm_find_dbs_satisfier(), preferring a package with the name of
+ * @depend in any database over one which provides it */
 static alpm_pkg_t *
-pk_alpm_list_find_pkgname (const alpm_list_t *pkgs, const gchar *name)
+pk_alpm_find_dbs_satisfier (PkBackend *backend, const alpm_list_t *dbs,
+			    const alpm_depend_t *depend)
 {
-	g_return_val_if_fail (name != NULL, NULL);
+	const alpm_list_t *i;
 
-	for (; pkgs != NULL; pkgs = pkgs->next) {
-		if (g_strcmp0 (name, alpm_pkg_get_name (pkgs->data)) == 0)
-			return pkgs->data;
+	for (i = dbs; i != NULL; i = i->next) {
+		alpm_pkg_t *pkg = alpm_db_get_pkg (i->data, depend->name);
+		if (pkg != NULL &&
+		    pk_alpm_dep_vercmp (alpm_pkg_get_version (pkg), depend->mod, depend->version))
+			return pkg;
+	}
+
+	for (i = dbs; i != NULL; i = i->next) {
+		PkAlpmProvides *provides = pk_alpm_db_get_provides (backend, i->data);
+		alpm_pkg_t *pkg = pk_alpm_provides_find_satisfier (provides, depend);
+		if (pkg != NULL)
+			return pkg;
 	}
 
 	return NULL;
 }
 
 static alpm_list_t *
-pk_alpm_find_provider (PkBackendJob *job, alpm_list_t *pkgs,
-		       const gchar *depend, gboolean recursive,
+pk_alpm_find_provider (PkBackendJob *job, alpm_list_t *pkgs, PkAlpmProvides *seen,
+		       const alpm_depend_t *depend, gboolean recursive,
 		       PkBitfield filters, GError **error)
 {
 	PkBackend *backend = pk_backend_job_get_backend (job);
@@ -51,7 +64,7 @@ pk_alpm_find_provider (PkBackendJob *job, alpm_list_t *pkgs,
 	gboolean skip_local, skip_remote;
 
 	alpm_pkg_t *provider;
-	alpm_list_t *pkgcache, *syncdbs;
+	alpm_list_t *syncdbs;
 
 	g_return_val_if_fail (depend != NULL, pkgs);
 
@@ -59,13 +72,13 @@ pk_alpm_find_provider (PkBackendJob *job, alpm_list_t *pkgs,
 					  PK_FILTER_ENUM_NOT_INSTALLED);
 	skip_remote = pk_bitfield_contain (filters, PK_FILTER_ENUM_INSTALLED);
 
-	if (alpm_find_satisfier (pkgs, depend) != NULL) {
+	if (pk_alpm_provides_find_satisfier (seen, depend) != NULL) {
 		return pkgs;
 	}
 
 	/* look for local dependencies */
-	pkgcache = alpm_db_get_pkgcache (priv->localdb);
-	provider = alpm_find_satisfier (pkgcache, depend);
+	provider = pk_alpm_provides_find_satisfier (pk_alpm_db_get_provides (backend, priv->localdb),
+						    depend);
 
 	if (provider != NULL) {
 		if (!skip_local) {
@@ -73,6 +86,7 @@ pk_alpm_find_provider (PkBackendJob *job, alpm_list_t *pkgs,
 			/* assume later dependencies will also be local */
 			if (recursive) {
 				pkgs = alpm_list_add (pkgs, provider);
+				pk_alpm_provides_add (seen, provider);
 			}
 		}
 
@@ -81,17 +95,20 @@ pk_alpm_find_provider (PkBackendJob *job, alpm_list_t *pkgs,
 
 	/* look for remote dependencies */
 	syncdbs = alpm_get_syncdbs (priv->alpm);
-	provider = alpm_find_dbs_satisfier (priv->alpm, syncdbs, depend);
+	provider = pk_alpm_find_dbs_satisfier (backend, syncdbs, depend);
 
 	if (provider != NULL) {
 		if (!skip_remote)
 			pk_alpm_pkg_emit (job, provider, PK_INFO_ENUM_AVAILABLE);
 		/* keep looking for local dependencies */
-		if (recursive)
+		if (recursive) {
 			pkgs = alpm_list_add (pkgs, provider);
+			pk_alpm_provides_add (seen, provider);
+		}
 	} else {
+		g_autofree gchar *depend_str = alpm_dep_compute_string (depend);
 		int code = ALPM_ERR_UNSATISFIED_DEPS;
-		g_set_error (error, PK_ALPM_ERROR, code, "%s: %s", depend,
+		g_set_error (error, PK_ALPM_ERROR, code, "%s: %s", depend_str,
 			     alpm_strerror (code));
 	}
 
@@ -99,8 +116,8 @@ pk_alpm_find_provider (PkBackendJob *job, alpm_list_t *pkgs,
 }
 
 static alpm_list_t *
-pk_backend_find_requirer (PkBackendJob *job, alpm_list_t *pkgs, const gchar *name, gboolean recursive,
-			  GError **error)
+pk_backend_find_requirer (PkBackendJob *job, alpm_list_t *pkgs, PkAlpmProvides *seen,
+			  const gchar *name, gboolean recursive, GError **error)
 {
 	PkBackend *backend = pk_backend_job_get_backend (job);
 	PkBackendAlpmPrivate *priv = pk_backend_get_user_data (backend);
@@ -108,7 +125,7 @@ pk_backend_find_requirer (PkBackendJob *job, alpm_list_t *pkgs, const gchar *nam
 
 	g_return_val_if_fail (name != NULL, pkgs);
 
-	if (pk_alpm_list_find_pkgname (pkgs, name) != NULL)
+	if (pk_alpm_provides_find_name (seen, name) != NULL)
 		return pkgs;
 
 	/* look for local requirers */
@@ -116,8 +133,10 @@ pk_backend_find_requirer (PkBackendJob *job, alpm_list_t *pkgs, const gchar *nam
 
 	if (requirer != NULL) {
 		pk_alpm_pkg_emit (job, requirer, PK_INFO_ENUM_INSTALLED);
-		if (recursive)
+		if (recursive) {
 			pkgs = alpm_list_add (pkgs, requirer);
+			pk_alpm_provides_add (seen, requirer);
+		}
 	} else {
 		int code = ALPM_ERR_PKG_NOT_FOUND;
 		g_set_error (error, PK_ALPM_ERROR, code, "%s: %s", name,
@@ -132,6 +151,7 @@ pk_backend_depends_on_thread (PkBackendJob* job, GVariant* params, gpointer p)
 {
 	gchar **packages;
 	alpm_list_t *i, *pkgs = NULL;
+	g_autoptr(PkAlpmProvides) seen = pk_alpm_provides_new ();
 	g_autoptr(GError) error = NULL;
 	PkBitfield filters;
 	gboolean recursive;
@@ -151,6 +171,7 @@ pk_backend_depends_on_thread (PkBackendJob* job, GVariant* params, gpointer p)
 			break;
 
 		pkgs = alpm_list_add (pkgs, pkg);
+		pk_alpm_provides_add (seen, pkg);
 	}
 
 	/* package list might be modified along the way but that is ok */
@@ -162,13 +183,11 @@ pk_backend_depends_on_thread (PkBackendJob* job, GVariant* params, gpointer p)
 
 		depends = alpm_pkg_get_depends (i->data);
 		for (; depends != NULL; depends = depends->next) {
-			g_autofree gchar *depend = NULL;
-
 			if (pk_backend_job_is_cancelled (job) || error != NULL)
 				break;
 
-			depend = alpm_dep_compute_string (depends->data);
-			pkgs = pk_alpm_find_provider (job, pkgs, depend, recursive, filters, &error);
+			pkgs = pk_alpm_find_provider (job, pkgs, seen, depends->data,
+						      recursive, filters, &error);
 		}
 	}
 
@@ -180,6 +199,7 @@ pk_backend_required_by_thread (PkBackendJob* job, GVariant* params, gpointer p)
 {
 	gchar **packages;
 	alpm_list_t *i, *pkgs = NULL;
+	g_autoptr(PkAlpmProvides) seen = pk_alpm_provides_new ();
 	g_autoptr(GError) error = NULL;
 	gboolean recursive;
 	PkBitfield filters;
@@ -199,6 +219,7 @@ pk_backend_required_by_thread (PkBackendJob* job, GVariant* params, gpointer p)
 			break;
 
 		pkgs = alpm_list_add (pkgs, pkg);
+		pk_alpm_provides_add (seen, pkg);
 	}
 
 	/* package list might be modified along the way but that is ok */
@@ -213,7 +234,7 @@ pk_backend_required_by_thread (PkBackendJob* job, GVariant* params, gpointer p)
 			if (pk_backend_job_is_cancelled (job) || error != NULL)
 				break;
 
-			pkgs = pk_backend_find_requirer (job, pkgs,
+			pkgs = pk_backend_find_requirer (job, pkgs, seen,
 							 requiredby->data, recursive, &error);
 		}
 
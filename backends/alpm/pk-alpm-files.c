@@ -0,0 +1,316 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2026 PackageKit Authors
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <alpm.h>
+#include <pk-backend.h>
+#include <string.h>
+#include <syslog.h>
+
+#include "pk-backend-alpm.h"
+#include "pk-alpm-config.h"
+#include "pk-alpm-error.h"
+#include "pk-alpm-files.h"
+
+/*
+ * Only the local database has the file lists of its packages, so for the
+ * repositories these are read from the .files databases which are synced
+ * alongside the normal ones when SyncFileLists is enabled. All the paths go
+ * into one sorted array, and a second array holds the same entries sorted
+ * by basename, so a search is a binary search of either of them rather than
+ * a walk of every file of every package. The strings are copied, as the
+ * handle for the .files databases is released once the index is built.
+ */
+struct _PkAlpmFiles {
+	GStringChunk	*strings;
+	GArray		*pkgs;		/* PkAlpmFilesPkg */
+	GArray		*paths;		/* PkAlpmFilesEntry, sorted by path */
+	GArray		*basenames;	/* index into paths, sorted by basename */
+};
+
+typedef struct {
+	const gchar	*path;		/* relative to the root, as in libalpm */
+	guint32		 basename;	/* offset of the basename in path */
+	guint32		 pkg;		/* index into pkgs */
+} PkAlpmFilesEntry;
+
+PkAlpmFiles *
+pk_alpm_files_new (void)
+{
+	PkAlpmFiles *files = g_new0 (PkAlpmFiles, 1);
+
+	files->strings = g_string_chunk_new (64 * 1024);
+	files->pkgs = g_array_new (FALSE, FALSE, sizeof (PkAlpmFilesPkg));
+	files->paths = g_array_new (FALSE, FALSE, sizeof (PkAlpmFilesEntry));
+	files->basenames = g_array_new (FALSE, FALSE, sizeof (guint32));
+	return files;
+}
+
+void
+pk_alpm_files_free (PkAlpmFiles *files)
+{
+	if (files == NULL)
+		return;
+	g_string_chunk_free (files->strings);
+	g_array_unref (files->pkgs);
+	g_array_unref (files->paths);
+	g_array_unref (files->basenames);
+	g_free (files);
+}
+
+void
+pk_alpm_files_add_db (PkAlpmFiles *files, alpm_db_t *db, gboolean local)
+{
+	const gchar *db_name = NULL;
+	const alpm_list_t *i;
+
+	g_return_if_fail (files != NULL);
+	g_return_if_fail (db != NULL);
+
+	if (!local)
+		db_name = g_string_chunk_insert_const (files->strings, alpm_db_get_name (db));
+
+	for (i = alpm_db_get_pkgcache (db); i != NULL; i = i->next) {
+		alpm_filelist_t *filelist = alpm_pkg_get_files (i->data);
+		PkAlpmFilesPkg pkg;
+
+		if (filelist == NULL || filelist->count == 0)
+			continue;
+
+		pkg.db = db_name;
+		pkg.name = g_string_chunk_insert_const (files->strings, alpm_pkg_get_name (i->data));
+		g_array_append_val (files->pkgs, pkg);
+
+		for (gsize j = 0; j < filelist->count; j++) {
+			PkAlpmFilesEntry entry;
+			const gchar *name;
+
+			/* directories are shared by many packages */
+			entry.path = g_string_chunk_insert_const (files->strings,
+								  filelist->files[j].name);
+			name = strrchr (entry.path, G_DIR_SEPARATOR);
+			entry.basename = name != NULL ? name + 1 - entry.path : 0;
+			entry.pkg = files->pkgs->len - 1;
+			g_array_append_val (files->paths, entry);
+		}
+	}
+}
+
+static gint
+pk_alpm_files_path_cmp (gconstpointer a, gconstpointer b)
+{
+	const PkAlpmFilesEntry *entry_a = a;
+	const PkAlpmFilesEntry *entry_b = b;
+	gint cmp = strcmp (entry_a->path, entry_b->path);
+
+	if (cmp != 0)
+		return cmp;
+	return (entry_a->pkg > entry_b->pkg) - (entry_a->pkg < entry_b->pkg);
+}
+
+static const gchar *
+pk_alpm_files_get_basename (PkAlpmFiles *files, guint32 index)
+{
+	const PkAlpmFilesEntry *entry = &g_array_index (files->paths, PkAlpmFilesEntry, index);
+	return entry->path + entry->basename;
+}
+
+static gint
+pk_alpm_files_basename_cmp (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+	PkAlpmFiles *files = user_data;
+	guint32 index_a = *(const guint32 *) a;
+	guint32 index_b = *(const guint32 *) b;
+	gint cmp = strcmp (pk_alpm_files_get_basename (files, index_a),
+			   pk_alpm_files_get_basename (files, index_b));
+
+	if (cmp != 0)
+		return cmp;
+	return (index_a > index_b) - (index_a < index_b);
+}
+
+/* to be called once all the databases have been added */
+void
+pk_alpm_files_sort (PkAlpmFiles *files)
+{
+	g_return_if_fail (files != NULL);
+
+	g_array_sort (files->paths, pk_alpm_files_path_cmp);
+
+	g_array_set_size (files->basenames, files->paths->len);
+	for (guint32 i = 0; i < files->paths->len; i++)
+		g_array_index (files->basenames, guint32, i) = i;
+	g_array_sort_with_data (files->basenames, pk_alpm_files_basename_cmp, files);
+}
+
+static gint
+pk_alpm_files_uint_cmp (gconstpointer a, gconstpointer b)
+{
+	guint index_a = *(const guint *) a;
+	guint index_b = *(const guint *) b;
+	return (index_a > index_b) - (index_a < index_b);
+}
+
+/* returns the index of every package which has a file with the full path
+ * @needle if it starts with a slash, or with the basename @needle if not,
+ * in the order the packages were added */
+GArray *
+pk_alpm_files_find (PkAlpmFiles *files, const gchar *needle)
+{
+	GArray *pkgs = g_array_new (FALSE, FALSE, sizeof (guint));
+	gboolean full_path;
+	guint lo, hi, len;
+
+	g_return_val_if_fail (files != NULL, pkgs);
+	g_return_val_if_fail (needle != NULL, pkgs);
+
+	full_path = G_IS_DIR_SEPARATOR (*needle);
+	if (full_path)
+		++needle;
+
+	/* find the first entry which is not less than the needle */
+	len = files->paths->len;
+	lo = 0;
+	hi = len;
+	while (lo < hi) {
+		guint mid = lo + (hi - lo) / 2;
+		const gchar *str;
+
+		if (full_path) {
+			str = g_array_index (files->paths, PkAlpmFilesEntry, mid).path;
+		} else {
+			str = pk_alpm_files_get_basename (files, g_array_index (files->basenames, guint32, mid));
+		}
+		if (strcmp (str, needle) < 0) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	for (; lo < len; lo++) {
+		const PkAlpmFilesEntry *entry;
+		guint pkg;
+
+		if (full_path) {
+			entry = &g_array_index (files->paths, PkAlpmFilesEntry, lo);
+			if (strcmp (entry->path, needle) != 0)
+				break;
+		} else {
+			guint32 index = g_array_index (files->basenames, guint32, lo);
+			entry = &g_array_index (files->paths, PkAlpmFilesEntry, index);
+			if (strcmp (entry->path + entry->basename, needle) != 0)
+				break;
+		}
+		pkg = entry->pkg;
+		g_array_append_val (pkgs, pkg);
+	}
+
+	/* a package can have the same basename more than once */
+	if (pkgs->len > 1) {
+		guint j = 1;
+
+		g_array_sort (pkgs, pk_alpm_files_uint_cmp);
+		for (guint i = 1; i < pkgs->len; i++) {
+			if (g_array_index (pkgs, guint, i) != g_array_index (pkgs, guint, j - 1))
+				g_array_index (pkgs, guint, j++) = g_array_index (pkgs, guint, i);
+		}
+		g_array_set_size (pkgs, j);
+	}
+
+	return pkgs;
+}
+
+const PkAlpmFilesPkg *
+pk_alpm_files_get_pkg (PkAlpmFiles *files, guint index)
+{
+	g_return_val_if_fail (files != NULL, NULL);
+	g_return_val_if_fail (index < files->pkgs->len, NULL);
+
+	return &g_array_index (files->pkgs, PkAlpmFilesPkg, index);
+}
+
+/* builds the index the first time it is needed */
+PkAlpmFiles *
+pk_alpm_get_files (PkBackend *self)
+{
+	PkBackendAlpmPrivate *priv = pk_backend_get_user_data (self);
+	PkAlpmFiles *files;
+
+	if (priv->files != NULL)
+		return priv->files;
+
+	files = pk_alpm_files_new ();
+	pk_alpm_files_add_db (files, priv->localdb, TRUE);
+
+	if (priv->sync_files) {
+		g_autoptr(GError) error = NULL;
+		alpm_handle_t *handle = pk_alpm_configure_files (self, PK_BACKEND_CONFIG_FILE, &error);
+		const alpm_list_t *i;
+
+		if (handle == NULL) {
+			syslog (LOG_DAEMON | LOG_WARNING, "failed to load file databases: %s", error->message);
+		} else {
+			for (i = alpm_get_syncdbs (handle); i != NULL; i = i->next)
+				pk_alpm_files_add_db (files, i->data, FALSE);
+			alpm_release (handle);
+		}
+	}
+
+	pk_alpm_files_sort (files);
+	priv->files = files;
+
+	g_debug ("indexed %u files of %u packages",
+		 files->paths->len, files->pkgs->len);
+	return files;
+}
+
+/* to be called whenever a database is updated, reloaded or released */
+void
+pk_alpm_files_invalidate (PkBackend *self)
+{
+	PkBackendAlpmPrivate *priv = pk_backend_get_user_data (self);
+
+	g_clear_pointer (&priv->files, pk_alpm_files_free);
+}
+
+/* without force, only the databases which are newer on the mirror are
+ * downloaded */
+gboolean
+pk_alpm_files_update_databases (PkBackendJob *job, gint force, GError **error)
+{
+	PkBackend *backend = pk_backend_job_get_backend (job);
+	alpm_handle_t *handle;
+	gint result;
+
+	handle = pk_alpm_configure_files (backend, PK_BACKEND_CONFIG_FILE, error);
+	if (handle == NULL)
+		return FALSE;
+
+	result = alpm_db_update (handle, alpm_get_syncdbs (handle), force);
+	if (result < 0) {
+		g_set_error (error, PK_ALPM_ERROR, alpm_errno (handle), "failed to update file databases: %s",
+			     alpm_strerror (alpm_errno (handle)));
+	}
+	alpm_release (handle);
+	pk_alpm_files_invalidate (backend);
+
+	return result >= 0;
+}
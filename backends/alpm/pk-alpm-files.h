@@ -0,0 +1,56 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2026 PackageKit Authors
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <alpm.h>
+#include <pk-backend.h>
+
+typedef struct _PkAlpmFiles PkAlpmFiles;
+
+typedef struct {
+	const gchar	*db;		/* NULL for the local database */
+	const gchar	*name;
+} PkAlpmFilesPkg;
+
+PkAlpmFiles	*pk_alpm_files_new		(void);
+
+void		 pk_alpm_files_free		(PkAlpmFiles *files);
+
+void		 pk_alpm_files_add_db		(PkAlpmFiles *files,
+						 alpm_db_t *db,
+						 gboolean local);
+
+void		 pk_alpm_files_sort		(PkAlpmFiles *files);
+
+GArray		*pk_alpm_files_find		(PkAlpmFiles *files,
+						 const gchar *needle);
+
+const PkAlpmFilesPkg *pk_alpm_files_get_pkg	(PkAlpmFiles *files,
+						 guint index);
+
+PkAlpmFiles	*pk_alpm_get_files		(PkBackend *self);
+
+void		 pk_alpm_files_invalidate	(PkBackend *self);
+
+gboolean	 pk_alpm_files_update_databases	(PkBackendJob *job,
+						 gint force,
+						 GError **error);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (PkAlpmFiles, pk_alpm_files_free)
@@ -67,26 +67,26 @@ pk_alpm_find_pkg (PkBackendJob *job, const gchar *package_id, GError **error)
 {
 	PkBackend *backend = pk_backend_job_get_backend (job);
 	PkBackendAlpmPrivate *priv = pk_backend_get_user_data (backend);
-	g_auto(GStrv) package = NULL;
-	const gchar *repo_id;
+	PkPackageIdView view;
+	g_autofree gchar *name = NULL;
 	alpm_db_t *db = NULL;
-	alpm_pkg_t *pkg;
+	alpm_pkg_t *pkg = NULL;
 
 	g_return_val_if_fail (job != NULL, NULL);
 	g_return_val_if_fail (package_id != NULL, NULL);
 
-	package = pk_package_id_split (package_id);
-	repo_id = package[PK_PACKAGE_ID_DATA];
+	if (!pk_package_id_parse (package_id, &view))
+		goto out;
 
 	/* find the database to search in */
-	if (g_strcmp0 (repo_id, "installed") == 0) {
+	if (pk_package_id_view_equal (&view, PK_PACKAGE_ID_DATA, "installed")) {
 		db = priv->localdb;
 	} else {
 		const alpm_list_t *i = alpm_get_syncdbs (priv->alpm_check ? priv->alpm_check : priv->alpm);
 		for (; i != NULL; i = i->next) {
 			const gchar *repo = alpm_db_get_name (i->data);
 
-			if (g_strcmp0 (repo, repo_id) == 0) {
+			if (pk_package_id_view_equal (&view, PK_PACKAGE_ID_DATA, repo)) {
 				db = i->data;
 				break;
 			}
@@ -94,18 +94,18 @@ pk_alpm_find_pkg (PkBackendJob *job, const gchar *package_id, GError **error)
 	}
 
 	if (db != NULL) {
-		pkg = alpm_db_get_pkg (db, package[PK_PACKAGE_ID_NAME]);
-	} else {
-		pkg = NULL;
+		name = g_strndup (view.sections[PK_PACKAGE_ID_NAME], view.lengths[PK_PACKAGE_ID_NAME]);
+		pkg = alpm_db_get_pkg (db, name);
 	}
 
 	if (pkg != NULL) {
 		const gchar *version = alpm_pkg_get_version (pkg);
-		if (g_strcmp0 (version, package[PK_PACKAGE_ID_VERSION]) != 0) {
+		if (!pk_package_id_view_equal (&view, PK_PACKAGE_ID_VERSION, version)) {
 			pkg = NULL;
 		}
 	}
 
+out:
 	if (pkg == NULL) {
 		int code = ALPM_ERR_PKG_NOT_FOUND;
 		g_set_error (error, PK_ALPM_ERROR, code, "%s: %s", package_id,
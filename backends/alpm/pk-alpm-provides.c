@@ -0,0 +1,222 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2026 PackageKit Authors
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <alpm.h>
+#include <pk-backend.h>
+
+#include "pk-backend-alpm.h"
+#include "pk-alpm-provides.h"
+
+/*
+ * Finding what satisfies a dependency using alpm_find_satisfier() walks the
+ * whole package cache, so this keeps the packages of a set, such as a
+ * database, by name and by what they provide. The strings and packages are
+ * owned by libalpm, so the index of a database has to be thrown away with
+ * pk_alpm_provides_invalidate() whenever the database changes.
+ */
+struct _PkAlpmProvides {
+	GHashTable	*names;		/* name → alpm_pkg_t */
+	GHashTable	*provides;	/* provided name → GPtrArray of alpm_pkg_t */
+};
+
+gboolean
+pk_alpm_dep_vercmp (const gchar *version, alpm_depmod_t mod, const gchar *depversion)
+{
+	gint cmp;
+
+	if (mod == ALPM_DEP_MOD_ANY)
+		return TRUE;
+
+	cmp = alpm_pkg_vercmp (version, depversion);
+	switch (mod) {
+	case ALPM_DEP_MOD_EQ:
+		return cmp == 0;
+	case ALPM_DEP_MOD_GE:
+		return cmp >= 0;
+	case ALPM_DEP_MOD_LE:
+		return cmp <= 0;
+	case ALPM_DEP_MOD_LT:
+		return cmp < 0;
+	case ALPM_DEP_MOD_GT:
+		return cmp > 0;
+	default:
+		return TRUE;
+	}
+}
+
+PkAlpmProvides *
+pk_alpm_provides_new (void)
+{
+	PkAlpmProvides *provides = g_new0 (PkAlpmProvides, 1);
+
+	provides->names = g_hash_table_new (g_str_hash, g_str_equal);
+	provides->provides = g_hash_table_new_full (g_str_hash, g_str_equal, NULL,
+						    (GDestroyNotify) g_ptr_array_unref);
+	return provides;
+}
+
+void
+pk_alpm_provides_free (PkAlpmProvides *provides)
+{
+	if (provides == NULL)
+		return;
+	g_hash_table_unref (provides->names);
+	g_hash_table_unref (provides->provides);
+	g_free (provides);
+}
+
+void
+pk_alpm_provides_add (PkAlpmProvides *provides, alpm_pkg_t *pkg)
+{
+	const alpm_list_t *i;
+
+	g_return_if_fail (provides != NULL);
+	g_return_if_fail (pkg != NULL);
+
+	/* the first package added wins, like a walk of the list would */
+	if (!g_hash_table_contains (provides->names, alpm_pkg_get_name (pkg)))
+		g_hash_table_insert (provides->names, (gpointer) alpm_pkg_get_name (pkg), pkg);
+
+	for (i = alpm_pkg_get_provides (pkg); i != NULL; i = i->next) {
+		alpm_depend_t *provision = i->data;
+		GPtrArray *pkgs = g_hash_table_lookup (provides->provides, provision->name);
+
+		if (pkgs == NULL) {
+			pkgs = g_ptr_array_new ();
+			g_hash_table_insert (provides->provides, provision->name, pkgs);
+		}
+
+		/* the same name can be provided with more than one version */
+		if (pkgs->len > 0 && g_ptr_array_index (pkgs, pkgs->len - 1) == pkg)
+			continue;
+		g_ptr_array_add (pkgs, pkg);
+	}
+}
+
+alpm_pkg_t *
+pk_alpm_provides_find_name (PkAlpmProvides *provides, const gchar *name)
+{
+	g_return_val_if_fail (provides != NULL, NULL);
+	g_return_val_if_fail (name != NULL, NULL);
+
+	return g_hash_table_lookup (provides->names, name);
+}
+
+/* returns the packages which have @name in their provides, in the order
+ * they were added */
+const GPtrArray *
+pk_alpm_provides_find_providers (PkAlpmProvides *provides, const gchar *name)
+{
+	g_return_val_if_fail (provides != NULL, NULL);
+	g_return_val_if_fail (name != NULL, NULL);
+
+	return g_hash_table_lookup (provides->provides, name);
+}
+
+/* checks the version of what @pkg provides, as alpm_find_satisfier() does */
+static gboolean
+pk_alpm_pkg_provides_depend (alpm_pkg_t *pkg, const alpm_depend_t *depend)
+{
+	const alpm_list_t *i;
+
+	for (i = alpm_pkg_get_provides (pkg); i != NULL; i = i->next) {
+		alpm_depend_t *provision = i->data;
+
+		if (g_strcmp0 (provision->name, depend->name) != 0)
+			continue;
+
+		/* an unversioned provision only satisfies unversioned depends */
+		if (depend->mod == ALPM_DEP_MOD_ANY)
+			return TRUE;
+		if (provision->mod == ALPM_DEP_MOD_EQ &&
+		    pk_alpm_dep_vercmp (provision->version, depend->mod, depend->version))
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+/* a package with the name of @depend is preferred over one which provides
+ * it, as alpm_find_dbs_satisfier() does */
+alpm_pkg_t *
+pk_alpm_provides_find_satisfier (PkAlpmProvides *provides, const alpm_depend_t *depend)
+{
+	const GPtrArray *pkgs;
+	alpm_pkg_t *pkg;
+
+	g_return_val_if_fail (provides != NULL, NULL);
+	g_return_val_if_fail (depend != NULL, NULL);
+
+	pkg = g_hash_table_lookup (provides->names, depend->name);
+	if (pkg != NULL &&
+	    pk_alpm_dep_vercmp (alpm_pkg_get_version (pkg), depend->mod, depend->version))
+		return pkg;
+
+	pkgs = g_hash_table_lookup (provides->provides, depend->name);
+	for (guint i = 0; pkgs != NULL && i < pkgs->len; i++) {
+		pkg = g_ptr_array_index (pkgs, i);
+		if (pk_alpm_pkg_provides_depend (pkg, depend))
+			return pkg;
+	}
+
+	return NULL;
+}
+
+/* builds the index of @db the first time it is needed */
+PkAlpmProvides *
+pk_alpm_db_get_provides (PkBackend *self, alpm_db_t *db)
+{
+	PkBackendAlpmPrivate *priv = pk_backend_get_user_data (self);
+	PkAlpmProvides *provides;
+	const alpm_list_t *i;
+
+	g_return_val_if_fail (db != NULL, NULL);
+
+	if (priv->provides == NULL) {
+		priv->provides = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+							(GDestroyNotify) pk_alpm_provides_free);
+	}
+
+	provides = g_hash_table_lookup (priv->provides, db);
+	if (provides != NULL)
+		return provides;
+
+	provides = pk_alpm_provides_new ();
+	for (i = alpm_db_get_pkgcache (db); i != NULL; i = i->next)
+		pk_alpm_provides_add (provides, i->data);
+	g_hash_table_insert (priv->provides, db, provides);
+
+	g_debug ("indexed %u names and %u provides of %s",
+		 g_hash_table_size (provides->names),
+		 g_hash_table_size (provides->provides),
+		 alpm_db_get_name (db));
+	return provides;
+}
+
+/* to be called whenever a database is updated, reloaded or released */
+void
+pk_alpm_provides_invalidate (PkBackend *self)
+{
+	PkBackendAlpmPrivate *priv = pk_backend_get_user_data (self);
+
+	if (priv->provides != NULL)
+		g_hash_table_remove_all (priv->provides);
+}
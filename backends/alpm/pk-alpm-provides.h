@@ -0,0 +1,52 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2026 PackageKit Authors
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <alpm.h>
+#include <pk-backend.h>
+
+typedef struct _PkAlpmProvides PkAlpmProvides;
+
+PkAlpmProvides	*pk_alpm_provides_new		(void);
+
+void		 pk_alpm_provides_free		(PkAlpmProvides *provides);
+
+void		 pk_alpm_provides_add		(PkAlpmProvides *provides,
+						 alpm_pkg_t *pkg);
+
+alpm_pkg_t	*pk_alpm_provides_find_name	(PkAlpmProvides *provides,
+						 const gchar *name);
+
+const GPtrArray	*pk_alpm_provides_find_providers (PkAlpmProvides *provides,
+						  const gchar *name);
+
+alpm_pkg_t	*pk_alpm_provides_find_satisfier (PkAlpmProvides *provides,
+						  const alpm_depend_t *depend);
+
+PkAlpmProvides	*pk_alpm_db_get_provides	(PkBackend *self,
+						 alpm_db_t *db);
+
+void		 pk_alpm_provides_invalidate	(PkBackend *self);
+
+gboolean	 pk_alpm_dep_vercmp		(const gchar *version,
+						 alpm_depmod_t mod,
+						 const gchar *depversion);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (PkAlpmProvides, pk_alpm_provides_free)
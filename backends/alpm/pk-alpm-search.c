@@ -26,8 +26,10 @@
 #include <string.h>
 
 #include "pk-backend-alpm.h"
+#include "pk-alpm-files.h"
 #include "pk-alpm-groups.h"
 #include "pk-alpm-packages.h"
+#include "pk-alpm-provides.h"
 
 static gpointer
 pk_backend_pattern_needle (PkBackend *backend, const gchar *needle, GError **error)
@@ -171,25 +173,19 @@ pk_backend_match_name (alpm_pkg_t *pkg, GRegex *regex)
 }
 
 static gboolean
-pk_alpm_pkg_match_provides (alpm_pkg_t *pkg, gpointer pattern)
+pk_alpm_pkg_match_provides (alpm_pkg_t *pkg, const gchar *needle)
 {
 	/* TODO: implement GStreamer codecs, Pango fonts, etc. */
 	const alpm_list_t *i;
 
 	g_return_val_if_fail (pkg != NULL, FALSE);
-	g_return_val_if_fail (pattern != NULL, FALSE);
+	g_return_val_if_fail (needle != NULL, FALSE);
 
 	/* match features provided by package */
 	for (i = alpm_pkg_get_provides (pkg); i != NULL; i = i->next) {
-		const gchar *needle = pattern, *name = i->data;
-
-		for (; *needle == *name; ++needle, ++name) {
-			if (*needle == '\0') {
-				if (*name == '\0' || *name == '=')
-					return TRUE;
-				break;
-			}
-		}
+		const alpm_depend_t *provision = i->data;
+		if (g_strcmp0 (provision->name, needle) == 0)
+			return TRUE;
 	}
 
 	return FALSE;
@@ -232,7 +228,7 @@ static MatchFunc match_funcs[] = {
 	(MatchFunc) pk_backend_match_file,
 	(MatchFunc) pk_backend_match_group,
 	(MatchFunc) pk_backend_match_name,
-	pk_alpm_pkg_match_provides
+	(MatchFunc) pk_alpm_pkg_match_provides
 };
 
 static gboolean
@@ -282,44 +278,139 @@ pk_alpm_search_is_application (alpm_pkg_t *pkg) {
 	return FALSE;
 }
 
+static void
+pk_backend_search_pkg (PkBackendJob *job, alpm_db_t *db, alpm_pkg_t *pkg, MatchFunc match,
+		       const alpm_list_t *patterns, PkBitfield filters)
+{
+	PkBackend *backend = pk_backend_job_get_backend (job);
+	PkBackendAlpmPrivate *priv = pk_backend_get_user_data (backend);
+	const alpm_list_t *j;
+
+	for (j = patterns; j != NULL; j = j->next) {
+		if (!match (pkg, j->data))
+			break;
+	}
+
+	/* not all search terms matched */
+	if (j != NULL)
+		return;
+
+	/* want applications */
+	if (pk_bitfield_contain (filters, PK_FILTER_ENUM_APPLICATION) && !pk_alpm_search_is_application (pkg))
+		return;
+
+	/* don't want applications */
+	if (pk_bitfield_contain (filters, PK_FILTER_ENUM_NOT_APPLICATION) && pk_alpm_search_is_application (pkg))
+		return;
+
+	if (db == priv->localdb) {
+		pk_alpm_pkg_emit (job, pkg, PK_INFO_ENUM_INSTALLED);
+	} else if (!pk_alpm_pkg_is_local (job, pkg)) {
+		pk_alpm_pkg_emit (job, pkg, PK_INFO_ENUM_AVAILABLE);
+	}
+}
+
 static void
 pk_backend_search_db (PkBackendJob *job, alpm_db_t *db, MatchFunc match,
 		      const alpm_list_t *patterns, PkBitfield filters)
 {
 	PkBackend *backend = pk_backend_job_get_backend (job);
-	PkBackendAlpmPrivate *priv = pk_backend_get_user_data (backend);
-	const alpm_list_t *i, *j;
+	const alpm_list_t *i;
 
 	g_return_if_fail (db != NULL);
 	g_return_if_fail (match != NULL);
 
+	/* only the packages which provide the first search term can match */
+	if (match == (MatchFunc) pk_alpm_pkg_match_provides && patterns != NULL) {
+		PkAlpmProvides *provides = pk_alpm_db_get_provides (backend, db);
+		const GPtrArray *pkgs = pk_alpm_provides_find_providers (provides, patterns->data);
+
+		for (guint k = 0; pkgs != NULL && k < pkgs->len; k++) {
+			if (pk_backend_job_is_cancelled (job))
+				break;
+			pk_backend_search_pkg (job, db, g_ptr_array_index (pkgs, k), match, patterns, filters);
+		}
+		return;
+	}
+
 	/* emit packages that match all search terms */
 	for (i = alpm_db_get_pkgcache (db); i != NULL; i = i->next) {
 		if (pk_backend_job_is_cancelled (job))
 			break;
 
-		for (j = patterns; j != NULL; j = j->next) {
-			if (!match (i->data, j->data))
-				break;
+		pk_backend_search_pkg (job, db, i->data, match, patterns, filters);
+	}
+}
+
+/* uses the file index rather than the file lists of every package, which
+ * also has the packages of the repositories if their file lists are synced */
+static void
+pk_backend_search_file_index (PkBackendJob *job, const alpm_list_t *patterns, PkBitfield filters,
+			      gboolean skip_local, gboolean skip_remote)
+{
+	PkBackend *backend = pk_backend_job_get_backend (job);
+	PkBackendAlpmPrivate *priv = pk_backend_get_user_data (backend);
+	PkAlpmFiles *files = pk_alpm_get_files (backend);
+	const alpm_list_t *syncdbs = alpm_get_syncdbs (priv->alpm_check ? priv->alpm_check : priv->alpm);
+	const alpm_list_t *i;
+	g_autoptr(GArray) pkgs = NULL;
+
+	g_return_if_fail (patterns != NULL);
+
+	/* the packages are sorted, so keep the ones every search term found */
+	pkgs = pk_alpm_files_find (files, patterns->data);
+	for (i = patterns->next; i != NULL && pkgs->len > 0; i = i->next) {
+		g_autoptr(GArray) found = pk_alpm_files_find (files, i->data);
+		guint j = 0, k = 0, n = 0;
+
+		while (j < pkgs->len && k < found->len) {
+			guint a = g_array_index (pkgs, guint, j);
+			guint b = g_array_index (found, guint, k);
+
+			if (a < b) {
+				j++;
+			} else if (a > b) {
+				k++;
+			} else {
+				g_array_index (pkgs, guint, n++) = a;
+				j++;
+				k++;
+			}
 		}
+		g_array_set_size (pkgs, n);
+	}
 
-		/* not all search terms matched */
-		if (j != NULL)
-			continue;
+	for (guint j = 0; j < pkgs->len; j++) {
+		const PkAlpmFilesPkg *info = pk_alpm_files_get_pkg (files, g_array_index (pkgs, guint, j));
+		alpm_db_t *db = NULL;
+		alpm_pkg_t *pkg;
+
+		if (pk_backend_job_is_cancelled (job))
+			break;
 
-		/* want applications */
-		if (pk_bitfield_contain (filters, PK_FILTER_ENUM_APPLICATION) && !pk_alpm_search_is_application (i->data))
+		if (info->db == NULL) {
+			if (skip_local)
+				continue;
+			db = priv->localdb;
+		} else {
+			if (skip_remote)
+				continue;
+			for (i = syncdbs; i != NULL; i = i->next) {
+				if (g_strcmp0 (alpm_db_get_name (i->data), info->db) == 0) {
+					db = i->data;
+					break;
+				}
+			}
+		}
+		if (db == NULL)
 			continue;
 
-		/* don't want applications */
-		if (pk_bitfield_contain (filters, PK_FILTER_ENUM_NOT_APPLICATION) && pk_alpm_search_is_application (i->data))
+		/* the .files database can be older or newer than the other one */
+		pkg = alpm_db_get_pkg (db, info->name);
+		if (pkg == NULL)
 			continue;
 
-		if (db == priv->localdb) {
-			pk_alpm_pkg_emit (job, i->data, PK_INFO_ENUM_INSTALLED);
-		} else if (!pk_alpm_pkg_is_local (job, i->data)) {
-			pk_alpm_pkg_emit (job, i->data, PK_INFO_ENUM_AVAILABLE);
-		}
+		pk_backend_search_pkg (job, db, pkg, pk_backend_match_all, patterns, filters);
 	}
 }
 
@@ -407,6 +498,11 @@ pk_backend_search_thread (PkBackendJob *job, GVariant* params, gpointer p)
 		}
 	}
 
+	if (type == SEARCH_TYPE_FILES && patterns != NULL) {
+		pk_backend_search_file_index (job, patterns, filters, skip_local, skip_remote);
+		goto out;
+	}
+
 	/* find installed packages first */
 	if (!skip_local)
 		pk_backend_search_db (job, priv->localdb, match_func, patterns, filters);
@@ -0,0 +1,98 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2026 PackageKit Authors
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <glib/gstdio.h>
+#include <utime.h>
+
+#include "pk-alpm-timestamp.h"
+
+static void
+pk_alpm_test_touch (const gchar *filename, time_t mtime)
+{
+	struct utimbuf times = { mtime, mtime };
+
+	g_assert_true (g_file_set_contents (filename, "", 0, NULL));
+	g_assert_cmpint (g_utime (filename, &times), ==, 0);
+}
+
+static void
+pk_alpm_test_timestamp (void)
+{
+	g_autoptr(GError) error = NULL;
+	g_autofree gchar *tmpdir = NULL;
+	g_autofree gchar *timestamp = NULL;
+	g_autofree gchar *check_db = NULL;
+	g_autofree gchar *system_db = NULL;
+	time_t now = 1000000;
+
+	tmpdir = g_dir_make_tmp ("pk-alpm-test-XXXXXX", &error);
+	g_assert_no_error (error);
+	timestamp = g_build_filename (tmpdir, "core.db.timestamp", NULL);
+	check_db = g_build_filename (tmpdir, "check-core.db", NULL);
+	system_db = g_build_filename (tmpdir, "system-core.db", NULL);
+
+	/* the check copy was synchronized after the system copy */
+	pk_alpm_test_touch (system_db, now - 200);
+	pk_alpm_test_touch (check_db, now - 100);
+	pk_alpm_test_touch (timestamp, now - 100);
+	g_assert_true (pk_alpm_timestamp_db_is_fresh (timestamp, check_db, system_db, G_MAXUINT, now));
+
+	/* both copies got the same database from the mirror */
+	pk_alpm_test_touch (system_db, now - 100);
+	g_assert_true (pk_alpm_timestamp_db_is_fresh (timestamp, check_db, system_db, G_MAXUINT, now));
+
+	/* the cache age is still honoured */
+	g_assert_true (pk_alpm_timestamp_db_is_fresh (timestamp, check_db, system_db, 101, now));
+	g_assert_false (pk_alpm_timestamp_db_is_fresh (timestamp, check_db, system_db, 100, now));
+	g_assert_false (pk_alpm_timestamp_db_is_fresh (timestamp, check_db, system_db, 0, now));
+
+	/* RefreshCache or pacman synchronized the system copy afterwards */
+	pk_alpm_test_touch (system_db, now - 50);
+	g_assert_false (pk_alpm_timestamp_db_is_fresh (timestamp, check_db, system_db, G_MAXUINT, now));
+	g_assert_false (pk_alpm_timestamp_db_is_fresh (timestamp, check_db, system_db, 3600, now));
+
+	/* the system copy was never synchronized */
+	g_assert_cmpint (g_unlink (system_db), ==, 0);
+	g_assert_true (pk_alpm_timestamp_db_is_fresh (timestamp, check_db, system_db, G_MAXUINT, now));
+
+	/* the check copy went missing */
+	g_assert_cmpint (g_unlink (check_db), ==, 0);
+	g_assert_false (pk_alpm_timestamp_db_is_fresh (timestamp, check_db, system_db, G_MAXUINT, now));
+
+	/* the check copy was never synchronized */
+	pk_alpm_test_touch (check_db, now - 100);
+	g_assert_cmpint (g_unlink (timestamp), ==, 0);
+	g_assert_false (pk_alpm_timestamp_db_is_fresh (timestamp, check_db, system_db, G_MAXUINT, now));
+
+	g_assert_cmpint (g_unlink (check_db), ==, 0);
+	g_assert_cmpint (g_rmdir (tmpdir), ==, 0);
+}
+
+int
+main (int argc, char *argv[])
+{
+	g_test_init (&argc, &argv, NULL);
+
+	/* tests go here */
+	g_test_add_func ("/alpm/timestamp", pk_alpm_test_timestamp);
+
+	return g_test_run ();
+}
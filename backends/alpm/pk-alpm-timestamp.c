@@ -0,0 +1,66 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2026 PackageKit Authors
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <glib/gstdio.h>
+
+#include "pk-alpm-timestamp.h"
+
+/**
+ * pk_alpm_timestamp_db_is_fresh:
+ * @timestamp_filename: touched whenever the database was synchronized
+ * @check_db_filename: the copy of the database used to check for updates
+ * @system_db_filename: the copy of the database used by everything else
+ * @cache_age: how old the database may be, in seconds, or %G_MAXUINT
+ * @now: the current time
+ *
+ * The system copy of the database is also synchronized by RefreshCache and
+ * by pacman, and if that happened after the copy used to check for updates
+ * was synchronized it has newer packages than the check copy, whatever
+ * @cache_age is. This does not use libalpm, so it can be tested on its own.
+ *
+ * Return value: %TRUE if the check copy does not have to be synchronized
+ **/
+gboolean
+pk_alpm_timestamp_db_is_fresh (const gchar *timestamp_filename,
+			       const gchar *check_db_filename,
+			       const gchar *system_db_filename,
+			       guint cache_age,
+			       time_t now)
+{
+	GStatBuf timestamp;
+	GStatBuf check_db;
+	GStatBuf system_db;
+
+	if (g_stat (timestamp_filename, &timestamp) < 0)
+		return FALSE;
+	if (cache_age != G_MAXUINT && now - timestamp.st_mtime >= (time_t) cache_age)
+		return FALSE;
+
+	/* libalpm gives a database the time it was changed on the mirror, or
+	 * else the time it was downloaded, so the newer copy is the newer file */
+	if (g_stat (check_db_filename, &check_db) < 0)
+		return FALSE;
+	if (g_stat (system_db_filename, &system_db) == 0 &&
+	    system_db.st_mtime > check_db.st_mtime)
+		return FALSE;
+
+	return TRUE;
+}
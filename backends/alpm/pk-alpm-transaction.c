@@ -23,7 +23,9 @@
 
 #include "pk-backend-alpm.h"
 #include "pk-alpm-error.h"
+#include "pk-alpm-files.h"
 #include "pk-alpm-packages.h"
+#include "pk-alpm-provides.h"
 #include "pk-alpm-transaction.h"
 
 #include <syslog.h>
@@ -1060,6 +1062,8 @@ pk_alpm_transaction_commit (PkBackendJob *job, GError **error)
 	pk_backend_transaction_inhibit_start (backend);
 	commit_result = alpm_trans_commit (priv->alpm, &data);
 	pk_backend_transaction_inhibit_end (backend);
+	pk_alpm_provides_invalidate (backend);
+	pk_alpm_files_invalidate (backend);
 	if (commit_result >= 0)
 		return TRUE;
 
@@ -35,7 +35,10 @@
 #include "pk-backend-alpm.h"
 #include "pk-alpm-config.h"
 #include "pk-alpm-error.h"
+#include "pk-alpm-files.h"
 #include "pk-alpm-packages.h"
+#include "pk-alpm-provides.h"
+#include "pk-alpm-timestamp.h"
 #include "pk-alpm-transaction.h"
 #include "pk-alpm-update.h"
 
@@ -248,23 +251,57 @@ pk_alpm_update_set_db_timestamp (alpm_db_t *db, GError **error)
 	return TRUE;
 }
 
-gboolean
-pk_alpm_refresh_databases (PkBackendJob *job, gint force, alpm_list_t *dbs, GError **error)
+static gchar *
+pk_alpm_update_get_db_filename (alpm_handle_t *handle, alpm_db_t *db)
+{
+	g_autofree gchar *basename = g_strconcat (alpm_db_get_name (db), ".db", NULL);
+	return g_build_filename (alpm_option_get_dbpath (handle), "sync", basename, NULL);
+}
+
+/* whether every database of @check was synchronized less than cache_age
+ * seconds ago, and not before the same database of @system */
+static gboolean
+pk_alpm_update_dbs_are_fresh (alpm_handle_t *system, alpm_handle_t *check, guint cache_age)
+{
+	const alpm_list_t *i;
+	time_t now = time (NULL);
+
+	for (i = alpm_get_syncdbs (check); i; i = alpm_list_next (i)) {
+		g_autofree gchar *timestamp_filename = NULL;
+		g_autofree gchar *check_db_filename = NULL;
+		g_autofree gchar *system_db_filename = NULL;
+
+		timestamp_filename = pk_alpm_update_get_db_timestamp_filename (i->data);
+		check_db_filename = pk_alpm_update_get_db_filename (check, i->data);
+		system_db_filename = pk_alpm_update_get_db_filename (system, i->data);
+		if (!pk_alpm_timestamp_db_is_fresh (timestamp_filename,
+						    check_db_filename,
+						    system_db_filename,
+						    cache_age,
+						    now))
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+/* without force, libalpm only downloads the databases which are newer on the
+ * mirror than the local copy, so an unchanged mirror costs one request */
+static gboolean
+pk_alpm_update_sync_databases (PkBackendJob *job, gint force, alpm_list_t *dbs, GError **error)
 {
 	PkBackend *backend = pk_backend_job_get_backend (job);
 	PkBackendAlpmPrivate *priv = pk_backend_get_user_data (backend);
 	gint result;
 	alpm_list_t *i;
 
-	if (!force)
-		return TRUE;
-
 	if (priv->alpm != priv->alpm_check) {
 		// We can now discard the check db as the main db is more up to date again
 		alpm_release(priv->alpm_check);
 		priv->alpm_check = NULL;
 	}
 	result = alpm_db_update (priv->alpm, dbs, force);
+	pk_alpm_provides_invalidate (backend);
 	if (result < 0) {
 		g_set_error (error, PK_ALPM_ERROR, alpm_errno (priv->alpm), "failed to update database: %s",
 			     alpm_strerror (alpm_errno (priv->alpm)));
@@ -279,6 +316,15 @@ pk_alpm_refresh_databases (PkBackendJob *job, gint force, alpm_list_t *dbs, GErr
 	return TRUE;
 }
 
+gboolean
+pk_alpm_refresh_databases (PkBackendJob *job, gint force, alpm_list_t *dbs, GError **error)
+{
+	if (!force)
+		return TRUE;
+
+	return pk_alpm_update_sync_databases (job, force, dbs, error);
+}
+
 static gboolean
 pk_alpm_update_databases (PkBackendJob *job, gint force, GError **error)
 {
@@ -299,6 +345,14 @@ pk_alpm_update_databases (PkBackendJob *job, gint force, GError **error)
 	if (i == NULL)
 		return pk_alpm_transaction_end (job, error);
 	pk_alpm_transaction_end (job, NULL);
+
+	/* the file lists are optional, so failing to get them is not fatal;
+	 * this needs the database lock, which the transaction held */
+	if (ret && priv->sync_files) {
+		g_autoptr(GError) error_local = NULL;
+		if (!pk_alpm_files_update_databases (job, force, &error_local))
+			syslog (LOG_DAEMON | LOG_WARNING, "%s", error_local->message);
+	}
 	return ret != 0;
 }
 
@@ -332,27 +386,6 @@ pk_alpm_pkg_is_syncfirst (alpm_list_t *syncfirsts, alpm_pkg_t *pkg)
 	return FALSE;
 }
 
-static int dep_vercmp(const char *version1, alpm_depmod_t mod,
-		const char *version2)
-{
-	int equal = 0;
-
-	if(mod == ALPM_DEP_MOD_ANY) {
-		equal = 1;
-	} else {
-		int cmp = alpm_pkg_vercmp(version1, version2);
-		switch(mod) {
-			case ALPM_DEP_MOD_EQ: equal = (cmp == 0); break;
-			case ALPM_DEP_MOD_GE: equal = (cmp >= 0); break;
-			case ALPM_DEP_MOD_LE: equal = (cmp <= 0); break;
-			case ALPM_DEP_MOD_LT: equal = (cmp < 0); break;
-			case ALPM_DEP_MOD_GT: equal = (cmp > 0); break;
-			default: equal = 1; break;
-		}
-	}
-	return equal;
-}
-
 alpm_pkg_t *
 pk_alpm_pkg_replaces (alpm_db_t *db, alpm_pkg_t *pkg)
 {
@@ -364,7 +397,7 @@ pk_alpm_pkg_replaces (alpm_db_t *db, alpm_pkg_t *pkg)
 	for (alpm_list_t *list = alpm_pkg_get_replaces (pkg); list != NULL && !ret; list = list->next) {
 		alpm_depend_t *depend = list->data;
 		alpm_pkg_t *deppkg = alpm_db_get_pkg(db, depend->name);
-		if (deppkg && dep_vercmp(alpm_pkg_get_version(deppkg), depend->mod, depend->version)) {
+		if (deppkg && pk_alpm_dep_vercmp(alpm_pkg_get_version(deppkg), depend->mod, depend->version)) {
 			return deppkg;
 		}
 	}
@@ -424,19 +457,26 @@ pk_backend_get_updates_thread (PkBackendJob *job, GVariant* params, gpointer p)
 	int stored_count;
 	alpm_handle_t* old_handle = priv->alpm;
 	alpm_handle_t* handle = priv->alpm_check ? priv->alpm_check : pk_alpm_configure (backend, PK_BACKEND_CONFIG_FILE, TRUE, &error);
+	guint cache_age = pk_backend_job_get_cache_age (job);
 
-	alpm_logaction (handle, PK_LOG_PREFIX, "synchronizing package lists\n");
-	pk_backend_job_set_status (job, PK_STATUS_ENUM_DOWNLOAD_PACKAGELIST);
-
-	/* set total size to minus the number of databases */
 	i = alpm_get_syncdbs (handle);
 
-	// swap around the handles since the refresh database will grab
-	// the main system handle and not the check update handle otherwise
-	priv->alpm = handle;
-	pk_alpm_refresh_databases (job, TRUE, i, &error);
-	priv->alpm = old_handle;
-	priv->alpm_check = handle;
+	/* the check handle is still loaded and young enough for the caller */
+	if (priv->alpm_check != NULL && pk_alpm_update_dbs_are_fresh (old_handle, handle, cache_age)) {
+		g_debug ("databases are younger than %u seconds, not synchronizing", cache_age);
+	} else {
+		alpm_logaction (handle, PK_LOG_PREFIX, "synchronizing package lists\n");
+		pk_backend_job_set_status (job, PK_STATUS_ENUM_DOWNLOAD_PACKAGELIST);
+
+		// swap around the handles since the refresh database will grab
+		// the main system handle and not the check update handle otherwise
+		priv->alpm = handle;
+		if (!pk_alpm_update_sync_databases (job, FALSE, i, &error))
+			g_debug ("failed to synchronize databases: %s", error->message);
+		g_clear_error (&error);
+		priv->alpm = old_handle;
+		priv->alpm_check = handle;
+	}
 
 	if (pk_backend_job_get_role (job) == PK_ROLE_ENUM_GET_UPDATES) {
 		g_variant_get (params, "(t)", &filters);
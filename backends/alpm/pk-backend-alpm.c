@@ -32,6 +32,7 @@
 #include "pk-alpm-config.h"
 #include "pk-alpm-databases.h"
 #include "pk-alpm-error.h"
+#include "pk-alpm-files.h"
 #include "pk-alpm-groups.h"
 #include "pk-alpm-transaction.h"
 #include "pk-alpm-environment.h"
@@ -147,6 +148,11 @@ pk_backend_initialize (GKeyFile *conf, PkBackend *backend)
 	priv = g_new0 (PkBackendAlpmPrivate, 1);
 	pk_backend_set_user_data (backend, priv);
 
+	if (conf != NULL) {
+		priv->conf = g_key_file_ref (conf);
+		priv->sync_files = g_key_file_get_boolean (conf, "Daemon", "SyncFileLists", NULL);
+	}
+
 	if (!pk_alpm_initialize (backend, &error))
 		g_error ("Failed to initialize alpm: %s", error->message);
 	if (!pk_alpm_initialize_databases (backend, &error))
@@ -176,6 +182,9 @@ pk_backend_destroy (PkBackend *backend)
 
 	FREELIST (priv->syncfirsts);
 	FREELIST (priv->holdpkgs);
+	g_clear_pointer (&priv->provides, g_hash_table_unref);
+	g_clear_pointer (&priv->files, pk_alpm_files_free);
+	g_clear_pointer (&priv->conf, g_key_file_unref);
 	g_free (priv);
 }
 
@@ -204,8 +213,10 @@ pk_alpm_run (PkBackendJob *job, PkStatusEnum status, PkBackendJobThreadFunc func
 	g_return_if_fail (func != NULL);
 
 	if (priv->localdb_changed) {
+		g_autoptr(GKeyFile) conf = priv->conf != NULL ? g_key_file_ref (priv->conf) : NULL;
+
 		pk_backend_destroy (backend);
-		pk_backend_initialize (NULL, backend);
+		pk_backend_initialize (conf, backend);
 		pk_backend_installed_db_changed (backend);
 	}
 
@@ -34,6 +34,10 @@ typedef struct {
 	GFileMonitor    *monitor;
 	alpm_list_t     *configured_repos; /* list of configured repos */
 	gboolean	localdb_changed;
+	GHashTable	*provides;	/* alpm_db_t → PkAlpmProvides */
+	struct _PkAlpmFiles *files;
+	GKeyFile	*conf;
+	gboolean	sync_files;	/* also sync the .files databases */
 } PkBackendAlpmPrivate;
 
 void		 pk_alpm_run		(PkBackendJob *job, PkStatusEnum status,
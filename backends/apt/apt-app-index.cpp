@@ -0,0 +1,186 @@
+/* apt-app-index.cpp - Index of the packages which ship applications
+ *
+ * Copyright (c) 2026 PackageKit Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "apt-app-index.h"
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+#include <appstream.h>
+#include <apt-pkg/configuration.h>
+
+#include "apt-utils.h"
+
+#define APT_APP_INDEX_DPKG_INFO_DIR "/var/lib/dpkg/info"
+#define APT_APP_INDEX_VERSION	    "PK-APPLICATIONS 1"
+
+// the mtime of @path in microseconds, or 0 if it does not exist
+static guint64 appIndexGetStamp(const std::string &path)
+{
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+        return 0;
+    return (guint64)st.st_mtim.tv_sec * G_USEC_PER_SEC + st.st_mtim.tv_nsec / 1000;
+}
+
+AptAppIndex::AptAppIndex()
+    : m_installedLoaded(false),
+      m_availableLoaded(false)
+{
+}
+
+bool AptAppIndex::isApplication(const std::string &pkgName, bool installed)
+{
+    if (installed) {
+        ensureInstalled();
+        return m_installed.contains(pkgName);
+    }
+    ensureAvailable();
+    return m_available.contains(pkgName);
+}
+
+bool AptAppIndex::loadNames(const std::string &path, guint64 stamp, std::unordered_set<std::string> &names)
+{
+    std::ifstream in(path);
+    std::string line;
+
+    if (!in)
+        return false;
+    if (!getline(in, line) || line != APT_APP_INDEX_VERSION)
+        return false;
+    if (!getline(in, line) || line != std::to_string(stamp))
+        return false;
+
+    names.clear();
+    while (getline(in, line)) {
+        if (!line.empty())
+            names.insert(line);
+    }
+    return true;
+}
+
+bool AptAppIndex::saveNames(const std::string &path, guint64 stamp, const std::unordered_set<std::string> &names)
+{
+    g_autoptr(GError) error = nullptr;
+    std::ostringstream out;
+
+    out << APT_APP_INDEX_VERSION << "\n" << stamp << "\n";
+    for (const std::string &name : names)
+        out << name << "\n";
+
+    const std::string data = out.str();
+    if (!g_file_set_contents_full(
+            path.c_str(),
+            data.data(),
+            data.size(),
+            G_FILE_SET_CONTENTS_CONSISTENT,
+            0644,
+            &error)) {
+        g_debug("failed to write application index %s: %s", path.c_str(), error->message);
+        return false;
+    }
+    return true;
+}
+
+void AptAppIndex::ensureInstalled()
+{
+    g_autoptr(GDir) dir = nullptr;
+    const gchar *fn;
+
+    if (m_installedLoaded)
+        return;
+    m_installedLoaded = true;
+
+    const guint64 stamp = appIndexGetStamp(_config->FindFile("Dir::State::status"));
+    const std::string path = _config->FindDir("Dir::Cache") + "pk-applications-installed";
+    if (stamp != 0 && loadNames(path, stamp, m_installed))
+        return;
+
+    // look for a .desktop file in the file list of every installed package
+    dir = g_dir_open(APT_APP_INDEX_DPKG_INFO_DIR, 0, nullptr);
+    if (dir == nullptr)
+        return;
+    while ((fn = g_dir_read_name(dir)) != nullptr) {
+        std::string name = fn;
+        if (!ends_with(name, ".list"))
+            continue;
+        name.resize(name.size() - strlen(".list"));
+
+        std::ifstream in(std::string(APT_APP_INDEX_DPKG_INFO_DIR "/") + fn);
+        std::string line;
+        while (getline(in, line)) {
+            if (ends_with(line, ".desktop")) {
+                // strip the :arch of multi-arch packages
+                m_installed.insert(name.substr(0, name.find(':')));
+                break;
+            }
+        }
+    }
+    g_debug("found %zu installed applications", m_installed.size());
+
+    if (stamp != 0)
+        saveNames(path, stamp, m_installed);
+}
+
+void AptAppIndex::ensureAvailable()
+{
+    g_autoptr(AsPool) pool = nullptr;
+    g_autoptr(GError) error = nullptr;
+
+    if (m_availableLoaded)
+        return;
+    m_availableLoaded = true;
+
+    // the AppStream catalog is downloaded together with the lists
+    const guint64 stamp = appIndexGetStamp(_config->FindDir("Dir::State::lists"));
+    const std::string path = _config->FindDir("Dir::Cache") + "pk-applications-available";
+    if (stamp != 0 && loadNames(path, stamp, m_available))
+        return;
+
+    pool = as_pool_new();
+
+    /* don't monitor cache locations or load Flatpak data */
+    as_pool_remove_flags(pool, AS_POOL_FLAG_MONITOR);
+    as_pool_remove_flags(pool, AS_POOL_FLAG_LOAD_FLATPAK);
+
+    if (!as_pool_load(pool, nullptr, &error)) {
+        g_warning("Failed to load AppStream metadata: %s", error->message);
+        return;
+    }
+
+#if AS_CHECK_VERSION(1, 0, 0)
+    g_autoptr(AsComponentBox) result = as_pool_get_components_by_kind(pool, AS_COMPONENT_KIND_DESKTOP_APP);
+    for (guint i = 0; i < as_component_box_len(result); i++) {
+        AsComponent *cpt = as_component_box_index(result, i);
+#else
+    g_autoptr(GPtrArray) result = as_pool_get_components_by_kind(pool, AS_COMPONENT_KIND_DESKTOP_APP);
+    for (guint i = 0; i < result->len; i++) {
+        AsComponent *cpt = AS_COMPONENT(g_ptr_array_index(result, i));
+#endif
+        gchar **pkgnames = as_component_get_pkgnames(cpt);
+        for (guint j = 0; pkgnames != nullptr && pkgnames[j] != nullptr; j++)
+            m_available.insert(pkgnames[j]);
+    }
+    g_debug("found %zu available applications", m_available.size());
+
+    if (stamp != 0)
+        saveNames(path, stamp, m_available);
+}
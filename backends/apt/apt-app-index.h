@@ -0,0 +1,75 @@
+/* apt-app-index.h - Index of the packages which ship applications
+ *
+ * Copyright (c) 2026 PackageKit Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef APT_APP_INDEX_H
+#define APT_APP_INDEX_H
+
+#include <glib.h>
+
+#include <string>
+#include <unordered_set>
+
+/**
+ * Knows which packages are applications, for the application filters.
+ *
+ * An installed package is an application if it ships a .desktop file,
+ * according to its dpkg file list. A package which is not installed is an
+ * application if the AppStream catalog has a desktop-application component
+ * for it.
+ *
+ * Both sets are stored in the APT cache directory together with the mtime
+ * of what they were built from, which is the dpkg status file and the lists
+ * directory respectively. They are only rebuilt once that changes, i.e.
+ * after packages were installed or removed, or the metadata was refreshed.
+ */
+class AptAppIndex
+{
+public:
+    AptAppIndex();
+
+    /**
+     * @returns true if the package with this name is an application
+     * @param installed whether to check the installed package, or the
+     * available one
+     */
+    bool isApplication(const std::string &pkgName, bool installed);
+
+    /**
+     * Reads a set from a file written by saveNames(), if it was built from
+     * sources with the given mtime.
+     */
+    static bool loadNames(const std::string &path, guint64 stamp, std::unordered_set<std::string> &names);
+
+    /**
+     * Writes a set, replacing @path atomically.
+     */
+    static bool saveNames(const std::string &path, guint64 stamp, const std::unordered_set<std::string> &names);
+
+private:
+    void ensureInstalled();
+    void ensureAvailable();
+
+    std::unordered_set<std::string> m_installed;
+    std::unordered_set<std::string> m_available;
+    bool m_installedLoaded;
+    bool m_availableLoaded;
+};
+
+#endif // APT_APP_INDEX_H
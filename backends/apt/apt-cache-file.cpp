@@ -24,7 +24,11 @@
 #include <sstream>
 #include <cstdio>
 #include <vector>
+#include <algorithm>
+#include <sys/stat.h>
 #include <apt-pkg/algorithms.h>
+#include <apt-pkg/aptconfiguration.h>
+#include <apt-pkg/configuration.h>
 #include <apt-pkg/progress.h>
 #include <apt-pkg/upgrade.h>
 
@@ -34,7 +38,8 @@
 using namespace APT;
 
 AptCacheFile::AptCacheFile(PkBackendJob *job)
-    : m_job(job)
+    : m_summaryCacheChecked(false),
+      m_job(job)
 {
 }
 
@@ -52,6 +57,9 @@ bool AptCacheFile::Open(bool withLock)
 void AptCacheFile::Close()
 {
     m_packageRecords.reset();
+    m_summaryCache.close();
+    m_summaryCacheChecked = false;
+    m_originIds.clear();
 
     pkgCacheFile::Close();
 
@@ -337,11 +345,13 @@ bool AptCacheFile::isRemovingEssentialPackages()
 
 PkgInfo AptCacheFile::resolvePkgID(const gchar *packageId)
 {
-    g_auto(GStrv) parts = nullptr;
+    PkPackageIdView view;
     pkgCache::PkgIterator pkg;
 
-    parts = pk_package_id_split(packageId);
-    pkg = (*this)->FindPkg(parts[PK_PACKAGE_ID_NAME], parts[PK_PACKAGE_ID_ARCH]);
+    if (!pk_package_id_parse(packageId, &view))
+        return PkgInfo(pkgCache::VerIterator());
+    pkg = (*this)->FindPkg(APT::StringView(view.sections[PK_PACKAGE_ID_NAME], view.lengths[PK_PACKAGE_ID_NAME]),
+                           APT::StringView(view.sections[PK_PACKAGE_ID_ARCH], view.lengths[PK_PACKAGE_ID_ARCH]));
 
     // Ignore packages that could not be found or that exist only due to dependencies.
     if (pkg.end() || (pkg.VersionList().end() && pkg.ProvidesList().end()))
@@ -349,20 +359,20 @@ PkgInfo AptCacheFile::resolvePkgID(const gchar *packageId)
 
     // check if any intended action was encoded in this package-ID
     auto piAction = PkgAction::NONE;
-    if (g_str_has_prefix(parts[PK_PACKAGE_ID_DATA], "+auto:"))
+    if (g_str_has_prefix(view.sections[PK_PACKAGE_ID_DATA], "+auto:"))
         piAction = PkgAction::INSTALL_AUTO;
-    else if (g_str_has_prefix(parts[PK_PACKAGE_ID_DATA], "+manual:"))
+    else if (g_str_has_prefix(view.sections[PK_PACKAGE_ID_DATA], "+manual:"))
         piAction = PkgAction::INSTALL_MANUAL;
 
     const pkgCache::VerIterator &ver = findVer(pkg);
     // check to see if the provided package isn't virtual too
-    if (!ver.end() && strcmp(ver.VerStr(), parts[PK_PACKAGE_ID_VERSION]) == 0)
+    if (!ver.end() && pk_package_id_view_equal(&view, PK_PACKAGE_ID_VERSION, ver.VerStr()))
         return PkgInfo(ver, piAction);
 
     // check to see if the provided package isn't virtual too
     // also iterate through all available past versions
     for (auto candidateVer = findCandidateVer(pkg); !candidateVer.end(); candidateVer++) {
-        if (strcmp(candidateVer.VerStr(), parts[PK_PACKAGE_ID_VERSION]) == 0)
+        if (pk_package_id_view_equal(&view, PK_PACKAGE_ID_VERSION, candidateVer.VerStr()))
             return PkgInfo(candidateVer, piAction);
     }
 
@@ -389,7 +399,7 @@ gchar *AptCacheFile::buildPackageId(const pkgCache::VerIterator &ver)
         if (State.NewInstall())
             data = isAuto ? "+auto:" : "+manual:";
     }
-    data += utilBuildPackageOriginId(vf);
+    data += getOriginId(vf);
 
     return pk_package_id_build(ver.ParentPkg().Name(), ver.VerStr(), ver.Arch(), data.c_str());
 }
@@ -417,9 +427,107 @@ pkgCache::VerIterator AptCacheFile::findCandidateVer(const pkgCache::PkgIterator
     return (*this)[pkg].CandidateVerIter(*this);
 }
 
+std::string AptCacheFile::getOriginId(const pkgCache::VerFileIterator &vf)
+{
+    if (vf.end())
+        return utilBuildPackageOriginId(vf);
+
+    // there are only a few package files, but building the ID is slow
+    if (m_originIds.empty())
+        m_originIds.resize(GetPkgCache()->Head().PackageFileCount);
+    const pkgCache::PkgFileIterator file = vf.File();
+    if (file->ID >= m_originIds.size())
+        return utilBuildPackageOriginId(vf);
+
+    std::string &originId = m_originIds[file->ID];
+    if (originId.empty())
+        originId = utilBuildPackageOriginId(vf);
+    return originId;
+}
+
+bool AptCacheFile::getSummaryCacheKey(std::string &path, AptSummaryCache::Key &key)
+{
+    struct stat st;
+    std::string languages;
+
+    // the cache is only kept in memory
+    const std::string cachePath = _config->FindFile("Dir::Cache::pkgcache");
+    if (cachePath.empty() || stat(cachePath.c_str(), &st) != 0)
+        return false;
+
+    // these decide which translation of the description is used
+    for (const std::string &lang : APT::Configuration::getLanguages())
+        languages += lang + ",";
+
+    path = cachePath + ".pk-summaries";
+    key.cacheMtime = (uint64_t)st.st_mtim.tv_sec * G_USEC_PER_SEC + st.st_mtim.tv_nsec / 1000;
+    key.cacheSize = st.st_size;
+    key.versionCount = GetPkgCache()->Head().VersionCount;
+    key.languagesHash = g_str_hash(languages.c_str());
+    return true;
+}
+
+bool AptCacheFile::loadSummaryCache(bool build)
+{
+    std::string path;
+    AptSummaryCache::Key key;
+
+    if (m_summaryCache.isOpen())
+        return true;
+    if (m_summaryCacheChecked && !build)
+        return false;
+    m_summaryCacheChecked = true;
+
+    if (!getSummaryCacheKey(path, key))
+        return false;
+    if (m_summaryCache.open(path, key))
+        return true;
+    if (!build)
+        return false;
+
+    // look the records up in the order they are in the files
+    std::vector<std::pair<std::pair<unsigned long, unsigned long>, pkgCache::VerIterator>> sorted;
+    sorted.reserve(key.versionCount);
+    for (pkgCache::PkgIterator pkg = (*this)->PkgBegin(); !pkg.end(); ++pkg) {
+        for (pkgCache::VerIterator ver = pkg.VersionList(); !ver.end(); ++ver) {
+            pkgCache::DescIterator di = ver.TranslatedDescription();
+            pkgCache::DescFileIterator df = di.end() ? pkgCache::DescFileIterator() : di.FileList();
+            if (df.end())
+                sorted.push_back({{0, 0}, ver});
+            else
+                sorted.push_back({{df.File()->ID, df->Offset}, ver});
+        }
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const auto &a, const auto &b) {
+        return a.first < b.first;
+    });
+
+    g_debug("building summary cache for %zu versions", sorted.size());
+    std::vector<std::string> summaries(key.versionCount);
+    for (const auto &entry : sorted) {
+        if (entry.second->ID < summaries.size())
+            summaries[entry.second->ID] = getShortDescription(entry.second);
+    }
+
+    if (!AptSummaryCache::write(path, key, summaries))
+        return false;
+    return m_summaryCache.open(path, key);
+}
+
 std::string AptCacheFile::getShortDescription(const pkgCache::VerIterator &ver)
 {
-    if (ver.end() || ver.FileList().end() || GetPkgRecords() == 0) {
+    if (ver.end() || ver.FileList().end()) {
+        return {};
+    }
+
+    // use the table of summaries if there is one for this cache
+    if (!m_summaryCacheChecked)
+        loadSummaryCache(false);
+    const char *summary = m_summaryCache.lookup(ver->ID);
+    if (summary != nullptr)
+        return summary;
+
+    if (GetPkgRecords() == 0) {
         return {};
     }
 
@@ -29,6 +29,7 @@
 #include <apt-pkg/progress.h>
 #include <pk-backend.h>
 
+#include "apt-summary-cache.h"
 #include "pkg-list.h"
 
 class pkgProblemResolver;
@@ -151,6 +152,15 @@ public:
      */
     std::string getShortDescription(const pkgCache::VerIterator &ver);
 
+    /**
+     * Maps the table of summaries for this cache, so that getShortDescription()
+     * does not have to parse the package record.
+     * @param build build the table if there is none for this cache yet, which
+     * costs about as much as looking up the summary of every package once
+     * @returns true if the table is available
+     */
+    bool loadSummaryCache(bool build);
+
     /** \return a short description string corresponding to the given
      *  version.
      */
@@ -172,9 +182,14 @@ public:
 
 private:
     void buildPkgRecords();
+    bool getSummaryCacheKey(std::string &path, AptSummaryCache::Key &key);
+    std::string getOriginId(const pkgCache::VerFileIterator &vf);
     static std::string debParser(std::string descr);
 
     std::unique_ptr<pkgRecords> m_packageRecords;
+    AptSummaryCache m_summaryCache;
+    bool m_summaryCacheChecked;
+    std::vector<std::string> m_originIds;
     PkBackendJob *m_job;
 };
 
@@ -50,7 +50,9 @@
 #include <fstream>
 #include <dirent.h>
 
+#include "apt-app-index.h"
 #include "apt-cache-file.h"
+#include "apt-package-filter.h"
 #include "apt-utils.h"
 #include "gst-matcher.h"
 #include "apt-messages.h"
@@ -61,6 +63,9 @@ using namespace APT;
 
 #define RAMFS_MAGIC 0x858458f6
 
+// emitting at least this many packages builds the summary cache if needed
+#define SUMMARY_CACHE_BUILD_THRESHOLD 1000
+
 AptJob::AptJob(PkBackendJob *job)
     : m_job(job),
       m_cancel(false),
@@ -243,73 +248,39 @@ PkBackendJob *AptJob::pkJob() const
     return m_job;
 }
 
-static bool isDevelopmentName(const std::string &pkgName, const std::string &section)
-{
-    return ends_with(pkgName, "-dev") || ends_with(pkgName, "-dbg") || ends_with(pkgName, "-dbgsym")
-           || section == "devel" || section == "libdevel";
-}
-
-static bool isGuiSection(const std::string &section)
-{
-    return section == "x11" || section == "gnome" || section == "kde" || section == "graphics";
-}
-
-static bool isFreeComponent(const std::string &component)
-{
-    return component == "main" || component == "universe";
-}
-
 bool AptJob::matchPackage(const pkgCache::VerIterator &ver, PkBitfield filters)
 {
     if (filters == 0)
         return true;
 
+    // compiled once for the filters of the job
+    if (!m_packageFilter || m_packageFilter->filters() != filters)
+        m_packageFilter = std::make_unique<AptPackageFilter>(filters, m_isMultiArch);
+
     const pkgCache::PkgIterator &pkg = ver.ParentPkg();
     const bool installed = (pkg->CurrentState == pkgCache::State::Installed && pkg.CurrentVer() == ver);
 
-    // if we are on multiarch check also the arch filter
-    if (m_isMultiArch && pk_bitfield_contain(filters, PK_FILTER_ENUM_ARCH)) {
-        // don't emit the package if it does not match the native architecture
-        if (strcmp(ver.Arch(), "all") != 0 && strcmp(ver.Arch(), _config->Find("APT::Architecture").c_str()) != 0)
-            return false;
-    }
-
     if (pk_bitfield_contain(filters, PK_FILTER_ENUM_NOT_INSTALLED) && installed)
         return false;
     if (pk_bitfield_contain(filters, PK_FILTER_ENUM_INSTALLED) && !installed)
         return false;
 
-    const std::string sectionRaw = ver.Section() == nullptr ? "" : ver.Section();
-    const size_t slash = sectionRaw.find_last_of('/');
-    const std::string section = sectionRaw.substr(slash == std::string::npos ? 0 : slash + 1);
-    const std::string component = slash == std::string::npos ? "main" : sectionRaw.substr(0, slash);
-    const std::string pkgName = pkg.Name();
-
-    if (pk_bitfield_contain(filters, PK_FILTER_ENUM_DEVELOPMENT) && !isDevelopmentName(pkgName, section))
-        return false;
-    if (pk_bitfield_contain(filters, PK_FILTER_ENUM_NOT_DEVELOPMENT) && isDevelopmentName(pkgName, section))
-        return false;
-
-    if (pk_bitfield_contain(filters, PK_FILTER_ENUM_GUI) && !isGuiSection(section))
-        return false;
-    if (pk_bitfield_contain(filters, PK_FILTER_ENUM_NOT_GUI) && isGuiSection(section))
-        return false;
-
-    if (pk_bitfield_contain(filters, PK_FILTER_ENUM_FREE) && !isFreeComponent(component))
-        return false;
-    if (pk_bitfield_contain(filters, PK_FILTER_ENUM_NOT_FREE) && isFreeComponent(component))
+    // the architecture, development, GUI and free filters
+    if (!m_packageFilter->match(ver))
         return false;
 
-    if (pk_bitfield_contain(filters, PK_FILTER_ENUM_SUPPORTED) && !packageIsSupported(ver, component))
+    if (pk_bitfield_contain(filters, PK_FILTER_ENUM_SUPPORTED)
+        && !packageIsSupported(ver, m_packageFilter->section(ver).component))
         return false;
-    if (pk_bitfield_contain(filters, PK_FILTER_ENUM_NOT_SUPPORTED) && packageIsSupported(ver, component))
+    if (pk_bitfield_contain(filters, PK_FILTER_ENUM_NOT_SUPPORTED)
+        && packageIsSupported(ver, m_packageFilter->section(ver).component))
         return false;
 
-    // Check for applications, if they have files with .desktop. We do not support checking
-    // if it is an Application when not installed.
-    if (pk_bitfield_contain(filters, PK_FILTER_ENUM_APPLICATION) && (!installed || !isApplication(ver)))
+    // Check for applications, using the .desktop files of installed packages
+    // and the AppStream catalog for the others
+    if (pk_bitfield_contain(filters, PK_FILTER_ENUM_APPLICATION) && !isApplication(ver, installed))
         return false;
-    if (pk_bitfield_contain(filters, PK_FILTER_ENUM_NOT_APPLICATION) && (!installed || isApplication(ver)))
+    if (pk_bitfield_contain(filters, PK_FILTER_ENUM_NOT_APPLICATION) && isApplication(ver, installed))
         return false;
 
     return true;
@@ -449,6 +420,9 @@ void AptJob::emitPackages(PkgList &output, PkBitfield filters, PkInfoEnum state,
     // apply filter
     output = filterPackages(output, filters);
 
+    // avoid parsing a package record for each summary
+    m_cache->loadSummaryCache(output.size() >= SUMMARY_CACHE_BUILD_THRESHOLD);
+
     // create array of PK package data to emit
     g_autoptr(GPtrArray) pkgArray = g_ptr_array_new_full(output.size(), (GDestroyNotify)g_object_unref);
 
@@ -501,6 +475,9 @@ void AptJob::emitUpdates(PkgList &output, PkBitfield filters)
     // filter
     output = filterPackages(output, filters);
 
+    // avoid parsing a package record for each summary
+    m_cache->loadSummaryCache(output.size() >= SUMMARY_CACHE_BUILD_THRESHOLD);
+
     // create array of PK package data to emit
     g_autoptr(GPtrArray) pkgArray = g_ptr_array_new_full(output.size(), (GDestroyNotify)g_object_unref);
 
@@ -1456,27 +1433,11 @@ void AptJob::providesMimeType(PkgList &output, gchar **values)
     }
 }
 
-bool AptJob::isApplication(const pkgCache::VerIterator &ver)
+bool AptJob::isApplication(const pkgCache::VerIterator &ver, bool installed)
 {
-    auto fileName = std::format("/var/lib/dpkg/info/{}:{}.list", ver.ParentPkg().Name(), ver.Arch());
-    if (!FileExists(fileName)) {
-        // if the file was not found, try without the arch field
-        fileName = std::format("/var/lib/dpkg/info/{}.list", ver.ParentPkg().Name());
-    }
-
-    if (!FileExists(fileName))
-        return false;
-
-    std::ifstream in(fileName.c_str());
-    if (!in)
-        return false;
-
-    std::string line;
-    while (getline(in, line)) {
-        if (ends_with(line, ".desktop"))
-            return true;
-    }
-    return false;
+    if (!m_appIndex)
+        m_appIndex = std::make_unique<AptAppIndex>();
+    return m_appIndex->isApplication(ver.ParentPkg().Name(), installed);
 }
 
 // used to emit files it reads the info directly from the files
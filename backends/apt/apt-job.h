@@ -42,6 +42,8 @@
 class pkgProblemResolver;
 class Matcher;
 class AptCacheFile;
+class AptAppIndex;
+class AptPackageFilter;
 class AptJob
 {
 public:
@@ -273,7 +275,7 @@ private:
     void setEnvLocaleFromJob();
     bool checkTrusted(pkgAcquire &fetcher, PkBitfield flags);
     bool packageIsSupported(const pkgCache::VerIterator &verIter, std::string component);
-    bool isApplication(const pkgCache::VerIterator &verIter);
+    bool isApplication(const pkgCache::VerIterator &verIter, bool installed);
     bool matchesQueries(const std::vector<std::string> &queries, std::string s);
     bool dpkgHasForceConfFileSet();
     PkInfoEnum packageStateFromVer(const pkgCache::VerIterator &ver) const;
@@ -313,6 +315,8 @@ private:
     pkgCache::VerIterator findTransactionPackage(const std::string &name);
 
     std::unique_ptr<AptCacheFile> m_cache;
+    std::unique_ptr<AptAppIndex> m_appIndex;
+    std::unique_ptr<AptPackageFilter> m_packageFilter;
     PkBackendJob *m_job;
     bool m_cancel;
     struct stat m_restartStat;
@@ -0,0 +1,116 @@
+/* apt-package-filter.cpp - The package filters which only need the cache
+ *
+ * Copyright (c) 2026 PackageKit Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "apt-package-filter.h"
+
+#include <cstring>
+#include <apt-pkg/configuration.h>
+
+AptPackageFilter::AptPackageFilter(PkBitfield filters, bool multiArch)
+    : m_filters(filters),
+      m_checkArch(multiArch && pk_bitfield_contain(filters, PK_FILTER_ENUM_ARCH)),
+      m_nativeArch(_config->Find("APT::Architecture")),
+      m_development(pk_bitfield_contain(filters, PK_FILTER_ENUM_DEVELOPMENT)),
+      m_notDevelopment(pk_bitfield_contain(filters, PK_FILTER_ENUM_NOT_DEVELOPMENT)),
+      m_gui(pk_bitfield_contain(filters, PK_FILTER_ENUM_GUI)),
+      m_notGui(pk_bitfield_contain(filters, PK_FILTER_ENUM_NOT_GUI)),
+      m_free(pk_bitfield_contain(filters, PK_FILTER_ENUM_FREE)),
+      m_notFree(pk_bitfield_contain(filters, PK_FILTER_ENUM_NOT_FREE)),
+      m_cache(nullptr)
+{
+    m_needSection = m_development || m_notDevelopment || m_gui || m_notGui || m_free || m_notFree;
+}
+
+PkBitfield AptPackageFilter::filters() const
+{
+    return m_filters;
+}
+
+static bool nameEndsWith(const char *name, size_t length, const char *end)
+{
+    const size_t endLength = strlen(end);
+    return length >= endLength && memcmp(name + length - endLength, end, endLength) == 0;
+}
+
+bool AptPackageFilter::isDevelopmentName(const char *pkgName)
+{
+    const size_t length = strlen(pkgName);
+    return nameEndsWith(pkgName, length, "-dev") || nameEndsWith(pkgName, length, "-dbg")
+           || nameEndsWith(pkgName, length, "-dbgsym");
+}
+
+AptPackageFilter::Section AptPackageFilter::classifySection(const char *sectionRaw)
+{
+    Section ret;
+    const char *slash = sectionRaw == nullptr ? nullptr : strrchr(sectionRaw, '/');
+    const std::string section = slash == nullptr ? (sectionRaw == nullptr ? "" : sectionRaw) : slash + 1;
+
+    ret.component = slash == nullptr ? "main" : std::string(sectionRaw, slash - sectionRaw);
+    ret.development = section == "devel" || section == "libdevel";
+    ret.gui = section == "x11" || section == "gnome" || section == "kde" || section == "graphics";
+    ret.free = ret.component == "main" || ret.component == "universe";
+    return ret;
+}
+
+const AptPackageFilter::Section &AptPackageFilter::section(const pkgCache::VerIterator &ver)
+{
+    // the offsets are only meaningful within one cache
+    if (ver.Cache() != m_cache) {
+        m_sections.clear();
+        m_cache = ver.Cache();
+    }
+
+    auto it = m_sections.find(ver->Section);
+    if (it == m_sections.end())
+        it = m_sections.emplace(ver->Section, classifySection(ver.Section())).first;
+    return it->second;
+}
+
+bool AptPackageFilter::match(const pkgCache::VerIterator &ver)
+{
+    // don't emit the package if it does not match the native architecture
+    if (m_checkArch && strcmp(ver.Arch(), "all") != 0 && strcmp(ver.Arch(), m_nativeArch.c_str()) != 0)
+        return false;
+
+    if (!m_needSection)
+        return true;
+
+    const Section &info = section(ver);
+
+    if (m_development || m_notDevelopment) {
+        const bool development = info.development || isDevelopmentName(ver.ParentPkg().Name());
+        if (m_development && !development)
+            return false;
+        if (m_notDevelopment && development)
+            return false;
+    }
+
+    if (m_gui && !info.gui)
+        return false;
+    if (m_notGui && info.gui)
+        return false;
+
+    if (m_free && !info.free)
+        return false;
+    if (m_notFree && info.free)
+        return false;
+
+    return true;
+}
@@ -0,0 +1,92 @@
+/* apt-package-filter.h - The package filters which only need the cache
+ *
+ * Copyright (c) 2026 PackageKit Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef APT_PACKAGE_FILTER_H
+#define APT_PACKAGE_FILTER_H
+
+#include <apt-pkg/pkgcache.h>
+#include <pk-backend.h>
+
+#include <string>
+#include <unordered_map>
+
+/**
+ * The architecture, development, GUI and free filters, compiled once for a
+ * set of filters.
+ *
+ * The APT cache stores every section string once, so the offset of the
+ * section of a version identifies it. What a section is classified as is
+ * worked out the first time it is seen, and kept for as long as versions of
+ * the same cache are matched, so matching a version does not copy or split
+ * any strings.
+ */
+class AptPackageFilter
+{
+public:
+    struct Section {
+        std::string component;
+        bool development;
+        bool gui;
+        bool free;
+    };
+
+    AptPackageFilter(PkBitfield filters, bool multiArch);
+
+    PkBitfield filters() const;
+
+    /**
+     * @returns true if the version passes the filters this handles, the
+     * others are ignored
+     */
+    bool match(const pkgCache::VerIterator &ver);
+
+    /**
+     * @returns what the section of the version is classified as
+     */
+    const Section &section(const pkgCache::VerIterator &ver);
+
+    /**
+     * Splits a Section field such as "universe/libs" and classifies it.
+     */
+    static Section classifySection(const char *sectionRaw);
+
+    /**
+     * @returns true if the package name is the one of a development or
+     * debugging package
+     */
+    static bool isDevelopmentName(const char *pkgName);
+
+private:
+    PkBitfield m_filters;
+    bool m_checkArch;
+    std::string m_nativeArch;
+    bool m_development;
+    bool m_notDevelopment;
+    bool m_gui;
+    bool m_notGui;
+    bool m_free;
+    bool m_notFree;
+    bool m_needSection;
+
+    const pkgCache *m_cache;
+    std::unordered_map<map_stringitem_t, Section> m_sections;
+};
+
+#endif // APT_PACKAGE_FILTER_H
@@ -0,0 +1,177 @@
+/* apt-summary-cache.cpp - Package summaries indexed by cache version ID
+ *
+ * Copyright (c) 2026 PackageKit Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "apt-summary-cache.h"
+
+#include <cstring>
+#include <unordered_map>
+
+// The file is only ever read by the machine that wrote it, so everything
+// is in native byte order. It starts with this header, followed by an
+// offset into the string pool for every version, followed by the string
+// pool of NUL-terminated summaries.
+#define APT_SUMMARY_CACHE_MAGIC "PKSUMRY1"
+
+typedef struct {
+    char magic[8];
+    uint32_t versionCount;
+    uint32_t languagesHash;
+    uint64_t cacheMtime;
+    uint64_t cacheSize;
+    uint32_t stringsSize;
+    uint32_t padding;
+} AptSummaryCacheHeader;
+
+AptSummaryCache::AptSummaryCache()
+    : m_file(nullptr),
+      m_offsets(nullptr),
+      m_strings(nullptr),
+      m_count(0),
+      m_stringsSize(0)
+{
+}
+
+AptSummaryCache::~AptSummaryCache()
+{
+    close();
+}
+
+bool AptSummaryCache::open(const std::string &path, const Key &key)
+{
+    g_autoptr(GError) error = nullptr;
+    const AptSummaryCacheHeader *header;
+    gsize size;
+
+    close();
+
+    m_file = g_mapped_file_new(path.c_str(), FALSE, &error);
+    if (m_file == nullptr) {
+        if (!g_error_matches(error, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+            g_debug("failed to map summary cache %s: %s", path.c_str(), error->message);
+        return false;
+    }
+
+    // check this was written for the cache we have open
+    size = g_mapped_file_get_length(m_file);
+    header = (const AptSummaryCacheHeader *)g_mapped_file_get_contents(m_file);
+    if (size < sizeof(AptSummaryCacheHeader) || memcmp(header->magic, APT_SUMMARY_CACHE_MAGIC, 8) != 0
+        || header->versionCount != key.versionCount || header->languagesHash != key.languagesHash
+        || header->cacheMtime != key.cacheMtime || header->cacheSize != key.cacheSize
+        || size != sizeof(AptSummaryCacheHeader) + (gsize)header->versionCount * sizeof(uint32_t)
+                       + header->stringsSize
+        || header->stringsSize == 0) {
+        g_debug("summary cache %s is out of date", path.c_str());
+        close();
+        return false;
+    }
+
+    m_count = header->versionCount;
+    m_stringsSize = header->stringsSize;
+    m_offsets = (const uint32_t *)(header + 1);
+    m_strings = (const char *)(m_offsets + m_count);
+
+    // so that a corrupt offset can never run off the end of the map
+    if (m_strings[m_stringsSize - 1] != '\0') {
+        g_debug("summary cache %s is corrupt", path.c_str());
+        close();
+        return false;
+    }
+    return true;
+}
+
+void AptSummaryCache::close()
+{
+    g_clear_pointer(&m_file, g_mapped_file_unref);
+    m_offsets = nullptr;
+    m_strings = nullptr;
+    m_count = 0;
+    m_stringsSize = 0;
+}
+
+bool AptSummaryCache::isOpen() const
+{
+    return m_file != nullptr;
+}
+
+const char *AptSummaryCache::lookup(uint32_t versionId) const
+{
+    if (m_file == nullptr || versionId >= m_count)
+        return nullptr;
+    if (m_offsets[versionId] >= m_stringsSize)
+        return nullptr;
+    return m_strings + m_offsets[versionId];
+}
+
+bool AptSummaryCache::write(const std::string &path, const Key &key, const std::vector<std::string> &summaries)
+{
+    g_autoptr(GError) error = nullptr;
+    AptSummaryCacheHeader header = {};
+    std::vector<uint32_t> offsets;
+    std::string strings;
+    std::string data;
+    std::unordered_map<std::string, uint32_t> seen;
+
+    if (summaries.size() != key.versionCount) {
+        g_warning("summary cache has %zu entries, but %u versions", summaries.size(), key.versionCount);
+        return false;
+    }
+
+    // different versions of a package usually share a summary
+    offsets.reserve(summaries.size());
+    strings.push_back('\0');
+    for (const std::string &summary : summaries) {
+        if (summary.empty()) {
+            offsets.push_back(0);
+            continue;
+        }
+        auto it = seen.find(summary);
+        if (it != seen.end()) {
+            offsets.push_back(it->second);
+            continue;
+        }
+        offsets.push_back(strings.size());
+        seen.emplace(summary, strings.size());
+        strings.append(summary.c_str(), strlen(summary.c_str()) + 1);
+    }
+
+    memcpy(header.magic, APT_SUMMARY_CACHE_MAGIC, sizeof(header.magic));
+    header.versionCount = key.versionCount;
+    header.languagesHash = key.languagesHash;
+    header.cacheMtime = key.cacheMtime;
+    header.cacheSize = key.cacheSize;
+    header.stringsSize = strings.size();
+
+    data.reserve(sizeof(header) + offsets.size() * sizeof(uint32_t) + strings.size());
+    data.append((const char *)&header, sizeof(header));
+    data.append((const char *)offsets.data(), offsets.size() * sizeof(uint32_t));
+    data.append(strings);
+
+    if (!g_file_set_contents_full(
+            path.c_str(),
+            data.data(),
+            data.size(),
+            G_FILE_SET_CONTENTS_CONSISTENT,
+            0644,
+            &error)) {
+        g_warning("failed to write summary cache %s: %s", path.c_str(), error->message);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,87 @@
+/* apt-summary-cache.h - Package summaries indexed by cache version ID
+ *
+ * Copyright (c) 2026 PackageKit Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef APT_SUMMARY_CACHE_H
+#define APT_SUMMARY_CACHE_H
+
+#include <glib.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * A table of the short description of every version in the APT cache,
+ * indexed by pkgCache::Version::ID and stored in a file next to pkgcache.bin.
+ *
+ * Looking a summary up is an array access into the mapped file, rather than
+ * a pkgRecords::Lookup() and a parse of the Packages or Translation record.
+ * The table is only valid for the cache and the description languages it was
+ * built for, which is recorded in its header.
+ */
+class AptSummaryCache
+{
+public:
+    /**
+     * Identifies the cache generation a table was built for
+     */
+    struct Key {
+        uint64_t cacheMtime;
+        uint64_t cacheSize;
+        uint32_t versionCount;
+        uint32_t languagesHash;
+    };
+
+    AptSummaryCache();
+    ~AptSummaryCache();
+
+    /**
+     * Maps the table at @path, if it was built for @key
+     */
+    bool open(const std::string &path, const Key &key);
+
+    /**
+     * Unmaps the table
+     */
+    void close();
+
+    bool isOpen() const;
+
+    /**
+     * @returns the summary of the version with the given ID, or nullptr
+     * if it is not in the table
+     */
+    const char *lookup(uint32_t versionId) const;
+
+    /**
+     * Writes a new table for @key, replacing @path atomically.
+     * @summaries is indexed by version ID.
+     */
+    static bool write(const std::string &path, const Key &key, const std::vector<std::string> &summaries);
+
+private:
+    GMappedFile *m_file;
+    const uint32_t *m_offsets;
+    const char *m_strings;
+    uint32_t m_count;
+    uint32_t m_stringsSize;
+};
+
+#endif // APT_SUMMARY_CACHE_H
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2026 PackageKit Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*
+ * Compares the time taken to apply the development, GUI and free filters to
+ * every version in the APT cache of the system, using the previous
+ * implementation of AptJob::matchPackage() and AptPackageFilter. The number
+ * of rounds is set using the PK_BENCH_ITERATIONS environment variable.
+ */
+
+#include <apt-pkg/cachefile.h>
+#include <apt-pkg/init.h>
+#include <apt-pkg/pkgsystem.h>
+#include <glib.h>
+
+#include <string>
+#include <vector>
+
+#include "apt-package-filter.h"
+
+#define APT_BENCH_DEFAULT_ITERATIONS 10
+
+static bool endsWith(const std::string &str, const std::string &end)
+{
+    return str.size() >= end.size() && str.compare(str.size() - end.size(), end.size(), end) == 0;
+}
+
+// the implementation this replaced, kept as a reference point
+static bool matchPackageOld(const pkgCache::VerIterator &ver, PkBitfield filters)
+{
+    const std::string sectionRaw = ver.Section() == nullptr ? "" : ver.Section();
+    const size_t slash = sectionRaw.find_last_of('/');
+    const std::string section = sectionRaw.substr(slash == std::string::npos ? 0 : slash + 1);
+    const std::string component = slash == std::string::npos ? "main" : sectionRaw.substr(0, slash);
+    const std::string pkgName = ver.ParentPkg().Name();
+
+    const bool development = endsWith(pkgName, "-dev") || endsWith(pkgName, "-dbg")
+                             || endsWith(pkgName, "-dbgsym") || section == "devel" || section == "libdevel";
+    const bool gui = section == "x11" || section == "gnome" || section == "kde" || section == "graphics";
+    const bool free = component == "main" || component == "universe";
+
+    if (pk_bitfield_contain(filters, PK_FILTER_ENUM_DEVELOPMENT) && !development)
+        return false;
+    if (pk_bitfield_contain(filters, PK_FILTER_ENUM_NOT_DEVELOPMENT) && development)
+        return false;
+    if (pk_bitfield_contain(filters, PK_FILTER_ENUM_GUI) && !gui)
+        return false;
+    if (pk_bitfield_contain(filters, PK_FILTER_ENUM_NOT_GUI) && gui)
+        return false;
+    if (pk_bitfield_contain(filters, PK_FILTER_ENUM_FREE) && !free)
+        return false;
+    if (pk_bitfield_contain(filters, PK_FILTER_ENUM_NOT_FREE) && free)
+        return false;
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    guint iterations = APT_BENCH_DEFAULT_ITERATIONS;
+    const gchar *iterations_str = g_getenv("PK_BENCH_ITERATIONS");
+    const PkBitfield filters =
+        pk_bitfield_from_enums(PK_FILTER_ENUM_NOT_DEVELOPMENT, PK_FILTER_ENUM_GUI, PK_FILTER_ENUM_FREE, -1);
+    std::vector<pkgCache::VerIterator> versions;
+    guint matchesOld = 0;
+    guint matchesNew = 0;
+    gint64 start;
+    gint64 elapsedOld;
+    gint64 elapsedNew;
+
+    if (iterations_str != nullptr)
+        iterations = MAX(g_ascii_strtoull(iterations_str, nullptr, 10), 1);
+
+    if (!pkgInitConfig(*_config) || !pkgInitSystem(*_config, _system)) {
+        g_printerr("failed to initialize APT\n");
+        return EXIT_FAILURE;
+    }
+
+    pkgCacheFile cacheFile;
+    if (cacheFile.GetPkgCache() == nullptr) {
+        g_printerr("failed to open the APT cache\n");
+        return EXIT_FAILURE;
+    }
+    for (pkgCache::PkgIterator pkg = cacheFile.GetPkgCache()->PkgBegin(); !pkg.end(); ++pkg) {
+        for (pkgCache::VerIterator ver = pkg.VersionList(); !ver.end(); ++ver)
+            versions.push_back(ver);
+    }
+
+    start = g_get_monotonic_time();
+    for (guint i = 0; i < iterations; i++) {
+        for (const auto &ver : versions)
+            matchesOld += matchPackageOld(ver, filters);
+    }
+    elapsedOld = g_get_monotonic_time() - start;
+
+    start = g_get_monotonic_time();
+    for (guint i = 0; i < iterations; i++) {
+        // compiled once per job, like AptJob::matchPackage()
+        AptPackageFilter filter(filters, false);
+        for (const auto &ver : versions)
+            matchesNew += filter.match(ver);
+    }
+    elapsedNew = g_get_monotonic_time() - start;
+
+    g_print("%zu versions, %u matching\n", versions.size(), matchesNew / iterations);
+    g_print("old: %" G_GINT64_FORMAT " ms\n", elapsedOld / 1000);
+    g_print("new: %" G_GINT64_FORMAT " ms\n", elapsedNew / 1000);
+
+    if (matchesOld != matchesNew) {
+        g_printerr("old and new matched %u and %u versions\n", matchesOld, matchesNew);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
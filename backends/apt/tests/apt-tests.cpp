@@ -23,7 +23,10 @@
 #include <apt-pkg/configuration.h>
 
 #include "deb822.h"
+#include "apt-app-index.h"
+#include "apt-package-filter.h"
 #include "apt-sourceslist.h"
+#include "apt-summary-cache.h"
 #include "apt-utils.h"
 #include "gst-matcher.h"
 
@@ -506,6 +509,110 @@ static void apt_test_changelog_date(void)
     }
 }
 
+static void apt_test_summary_cache(void)
+{
+    g_autoptr(GError) error = nullptr;
+    g_autofree gchar *tmpdir = nullptr;
+    AptSummaryCache cache;
+    AptSummaryCache::Key key = {1234567, 89, 4, 42};
+    const std::vector<std::string> summaries = {"GStreamer plugins", "", "Shell", "GStreamer plugins"};
+
+    tmpdir = g_dir_make_tmp("pk-apt-summaries-XXXXXX", &error);
+    g_assert_no_error(error);
+    const std::string path = std::string(tmpdir) + "/pkgcache.bin.pk-summaries";
+
+    // nothing there yet
+    g_assert_false(cache.open(path, key));
+    g_assert_false(cache.isOpen());
+    g_assert_null(cache.lookup(0));
+
+    g_assert_true(AptSummaryCache::write(path, key, summaries));
+    g_assert_true(cache.open(path, key));
+    g_assert_cmpstr(cache.lookup(0), ==, "GStreamer plugins");
+    g_assert_cmpstr(cache.lookup(1), ==, "");
+    g_assert_cmpstr(cache.lookup(2), ==, "Shell");
+    g_assert_cmpstr(cache.lookup(3), ==, "GStreamer plugins");
+    g_assert_null(cache.lookup(4));
+
+    // not valid for a different cache or description language
+    key.cacheMtime++;
+    g_assert_false(cache.open(path, key));
+    key.cacheMtime--;
+    key.languagesHash++;
+    g_assert_false(cache.open(path, key));
+    key.languagesHash--;
+    g_assert_true(cache.open(path, key));
+
+    cache.close();
+    g_assert_false(cache.isOpen());
+    fs::remove_all(tmpdir);
+}
+
+static void apt_test_app_index(void)
+{
+    g_autoptr(GError) error = nullptr;
+    g_autofree gchar *tmpdir = nullptr;
+    std::unordered_set<std::string> names;
+
+    tmpdir = g_dir_make_tmp("pk-apt-apps-XXXXXX", &error);
+    g_assert_no_error(error);
+    const std::string path = std::string(tmpdir) + "/pk-applications-installed";
+
+    g_assert_false(AptAppIndex::loadNames(path, 42, names));
+
+    g_assert_true(AptAppIndex::saveNames(path, 42, {"gnome-calculator", "firefox-esr"}));
+    g_assert_true(AptAppIndex::loadNames(path, 42, names));
+    g_assert_cmpint(names.size(), ==, 2);
+    g_assert_cmpint(names.count("gnome-calculator"), ==, 1);
+    g_assert_cmpint(names.count("firefox-esr"), ==, 1);
+
+    // built from something that has changed since
+    g_assert_false(AptAppIndex::loadNames(path, 43, names));
+
+    fs::remove_all(tmpdir);
+}
+
+static void apt_test_package_filter(void)
+{
+    AptPackageFilter::Section section;
+
+    // no component means main
+    section = AptPackageFilter::classifySection("devel");
+    g_assert_cmpstr(section.component.c_str(), ==, "main");
+    g_assert_true(section.development);
+    g_assert_false(section.gui);
+    g_assert_true(section.free);
+
+    section = AptPackageFilter::classifySection("universe/kde");
+    g_assert_cmpstr(section.component.c_str(), ==, "universe");
+    g_assert_false(section.development);
+    g_assert_true(section.gui);
+    g_assert_true(section.free);
+
+    section = AptPackageFilter::classifySection("non-free/libdevel");
+    g_assert_cmpstr(section.component.c_str(), ==, "non-free");
+    g_assert_true(section.development);
+    g_assert_false(section.free);
+
+    // only the last slash separates the section
+    section = AptPackageFilter::classifySection("restricted/x/graphics");
+    g_assert_cmpstr(section.component.c_str(), ==, "restricted/x");
+    g_assert_true(section.gui);
+    g_assert_false(section.free);
+
+    section = AptPackageFilter::classifySection(nullptr);
+    g_assert_cmpstr(section.component.c_str(), ==, "main");
+    g_assert_false(section.development);
+    g_assert_false(section.gui);
+
+    g_assert_true(AptPackageFilter::isDevelopmentName("libglib2.0-dev"));
+    g_assert_true(AptPackageFilter::isDevelopmentName("packagekit-dbg"));
+    g_assert_true(AptPackageFilter::isDevelopmentName("packagekit-dbgsym"));
+    g_assert_false(AptPackageFilter::isDevelopmentName("devscripts"));
+    g_assert_false(AptPackageFilter::isDevelopmentName("dev"));
+    g_assert_false(AptPackageFilter::isDevelopmentName(""));
+}
+
 int main(int argc, char **argv)
 {
     if (argc == 0)
@@ -530,6 +637,9 @@ int main(int argc, char **argv)
     g_test_add_func("/apt/sources/write", apt_test_sources_write);
     g_test_add_func("/apt/sources/source-record-assign", apt_test_source_record_assign);
     g_test_add_func("/apt/utils/changelog-date", apt_test_changelog_date);
+    g_test_add_func("/apt/summary-cache", apt_test_summary_cache);
+    g_test_add_func("/apt/app-index", apt_test_app_index);
+    g_test_add_func("/apt/package-filter", apt_test_package_filter);
 
     return g_test_run();
 }
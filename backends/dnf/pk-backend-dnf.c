@@ -24,6 +24,7 @@
 #include <gmodule.h>
 #include <glib.h>
 #include <glib/gstdio.h>
+#include <gio/gio.h>
 #include <string.h>
 
 #include <pk-backend.h>
@@ -47,6 +48,8 @@
 #include "pk-backend-dnf-common.h"
 
 #define DNF_SACK_MAX_AGE 600 /* seconds */
+#define DNF_REFRESH_PARALLELISM 4
+#define DNF_REFRESH_PARALLELISM_PER_HOST 2
 
 typedef struct
 {
@@ -60,10 +63,18 @@ typedef struct
 	GKeyFile *conf;
 	DnfContext *context;
 	GHashTable *sack_cache; /* of DnfSackCacheItem */
+	GHashTable *sack_building; /* of cache key, for sacks being loaded */
 	GMutex sack_mutex;
+	GCond sack_cond;
+	guint sack_generation;
 	GTimer *repos_timer;
 	gchar *release_ver;
 	guint sack_expire_id;
+	guint sack_prewarm_id;
+	GThread *sack_prewarm_thread;
+	gboolean sack_prewarm_running;
+	gboolean sack_prewarm_again;
+	GCancellable *sack_prewarm_cancellable;
 } PkBackendDnfPrivate;
 
 typedef struct
@@ -76,11 +87,12 @@ typedef struct
 	HyGoal goal;
 } PkBackendDnfJobData;
 
-static GPtrArray *pk_backend_find_refresh_repos (PkBackendJob *job,
-						 DnfState *state,
+static GPtrArray *pk_backend_find_refresh_repos (DnfState *state,
 						 GPtrArray *repos,
+						 guint cache_age,
 						 gboolean force,
 						 GError **error);
+static void pk_backend_sack_prewarm_queue (PkBackend *backend);
 
 const gchar *
 pk_backend_get_description (PkBackend *backend)
@@ -127,9 +139,11 @@ pk_backend_sack_cache_invalidate (PkBackend *backend, const gchar *why)
 	PkBackendDnfPrivate *priv = pk_backend_get_user_data (backend);
 	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&priv->sack_mutex);
 
-	/* remove all cached sacks */
+	/* remove all cached sacks, and make sure that any sacks still being
+	 * loaded from the old metadata do not get added when they complete */
 	g_debug ("removing all dnf sack caches");
 	g_hash_table_remove_all (priv->sack_cache);
+	priv->sack_generation++;
 }
 
 static void
@@ -274,23 +288,44 @@ pk_backend_initialize (GKeyFile *conf, PkBackend *backend)
 	 *   modify state or if the repos or rpmdb are changed
 	 */
 	g_mutex_init (&priv->sack_mutex);
+	g_cond_init (&priv->sack_cond);
 	priv->sack_cache = g_hash_table_new_full (g_str_hash,
 						  g_str_equal,
 						  g_free,
 						  (GDestroyNotify) dnf_sack_cache_item_free);
+	priv->sack_building = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	priv->sack_prewarm_cancellable = g_cancellable_new ();
 
 	priv->sack_expire_id = g_timeout_add_seconds (DNF_SACK_MAX_AGE / 2,
 						      pk_backend_sack_expire,
 						      priv);
 
-	if (!pk_backend_ensure_default_dnf_context (backend, &error))
+	if (!pk_backend_ensure_default_dnf_context (backend, &error)) {
 		g_warning ("failed to setup context: %s", error->message);
+		return;
+	}
+
+	/* load the common sacks in the background so the first query is fast */
+	if (g_key_file_get_boolean (conf, "Daemon", "PrewarmCacheOnStartup", NULL))
+		pk_backend_sack_prewarm_queue (backend);
 }
 
 void
 pk_backend_destroy (PkBackend *backend)
 {
 	PkBackendDnfPrivate *priv = pk_backend_get_user_data (backend);
+
+	/* abort any background sack loading */
+	g_cancellable_cancel (priv->sack_prewarm_cancellable);
+	g_mutex_lock (&priv->sack_mutex);
+	if (priv->sack_prewarm_id > 0)
+		g_source_remove (priv->sack_prewarm_id);
+	priv->sack_prewarm_id = 0;
+	g_mutex_unlock (&priv->sack_mutex);
+	if (priv->sack_prewarm_thread != NULL)
+		g_thread_join (priv->sack_prewarm_thread);
+	g_object_unref (priv->sack_prewarm_cancellable);
+
 	if (priv->conf != NULL)
 		g_key_file_unref (priv->conf);
 	if (priv->context != NULL)
@@ -299,7 +334,9 @@ pk_backend_destroy (PkBackend *backend)
 		g_source_remove (priv->sack_expire_id);
 	g_timer_destroy (priv->repos_timer);
 	g_mutex_clear (&priv->sack_mutex);
+	g_cond_clear (&priv->sack_cond);
 	g_hash_table_unref (priv->sack_cache);
+	g_hash_table_unref (priv->sack_building);
 	g_free (priv->release_ver);
 	g_free (priv);
 }
@@ -471,13 +508,13 @@ pk_backend_stop_job (PkBackend *backend, PkBackendJob *job)
 }
 
 static gboolean
-dnf_utils_add_remote (PkBackendJob *job,
+dnf_utils_add_remote (DnfContext *context,
 		      DnfSack *sack,
 		      DnfSackAddFlags flags,
+		      guint cache_age,
 		      DnfState *state,
 		      GError **error)
 {
-	PkBackendDnfJobData *job_data = pk_backend_job_get_user_data (job);
 	gboolean ret;
 	DnfState *state_local;
 	g_autoptr(GPtrArray) repos = NULL;
@@ -494,7 +531,7 @@ dnf_utils_add_remote (PkBackendJob *job,
 		return FALSE;
 
 	/* ask the context's repo loader for new repos, forcing it to reload them */
-	repos = dnf_repo_loader_get_repos (dnf_context_get_repo_loader (job_data->context), error);
+	repos = dnf_repo_loader_get_repos (dnf_context_get_repo_loader (context), error);
 	if (repos == NULL)
 		return FALSE;
 
@@ -508,9 +545,9 @@ dnf_utils_add_remote (PkBackendJob *job,
 	 * the call to dnf_repo_check() inside dnf_sack_add_repos() - in this case we'll end up
 	 * with stale appstream data until the next metadata refresh.
 	 */
-	refresh_repos = pk_backend_find_refresh_repos (job,
-						       state,
+	refresh_repos = pk_backend_find_refresh_repos (state,
 						       repos,
+						       cache_age,
 						       FALSE /* !force */,
 						       error);
 	if (refresh_repos == NULL)
@@ -520,7 +557,7 @@ dnf_utils_add_remote (PkBackendJob *job,
 	state_local = dnf_state_get_child (state);
 	ret = dnf_sack_add_repos (sack,
 				  repos,
-				  pk_backend_job_get_cache_age (job),
+				  cache_age,
 				  flags,
 				  state_local,
 				  error);
@@ -588,6 +625,140 @@ dnf_utils_real_path (const gchar *path)
 	return real;
 }
 
+static DnfSack *
+dnf_utils_load_sack (DnfContext *context,
+		     DnfSackAddFlags flags,
+		     guint cache_age,
+		     DnfState *state,
+		     GError **error)
+{
+	gboolean ret;
+	DnfState *state_local;
+	g_autofree gchar *install_root = NULL;
+	g_autofree gchar *solv_dir = NULL;
+	g_autoptr(DnfSack) sack = NULL;
+
+	/* set state */
+	if ((flags & DNF_SACK_ADD_FLAG_REMOTE) > 0) {
+		ret = dnf_state_set_steps (state,
+					   error,
+					   8,  /* add installed */
+					   92, /* add remote */
+					   -1);
+		if (!ret)
+			return NULL;
+	} else {
+		dnf_state_set_number_steps (state, 1);
+	}
+
+	/* create empty sack */
+	solv_dir = dnf_utils_real_path (dnf_context_get_solv_dir (context));
+	install_root = dnf_utils_real_path (dnf_context_get_install_root (context));
+	sack = dnf_sack_new ();
+	dnf_sack_set_cachedir (sack, solv_dir);
+	dnf_sack_set_rootdir (sack, install_root);
+	ret = dnf_sack_setup (sack, DNF_SACK_SETUP_FLAG_MAKE_CACHE_DIR, error);
+	if (!ret) {
+		g_prefix_error (error,
+				"failed to create sack in %s for %s: ",
+				dnf_context_get_solv_dir (context),
+				dnf_context_get_install_root (context));
+		return NULL;
+	}
+
+	/* add installed packages */
+	ret = dnf_sack_load_system_repo (sack, NULL, DNF_SACK_LOAD_FLAG_BUILD_CACHE, error);
+	if (!ret) {
+		g_prefix_error (error, "Failed to load system repo: ");
+		return NULL;
+	}
+
+	/* done */
+	ret = dnf_state_done (state, error);
+	if (!ret)
+		return NULL;
+
+	/* add remote packages */
+	if ((flags & DNF_SACK_ADD_FLAG_REMOTE) > 0) {
+		state_local = dnf_state_get_child (state);
+		ret = dnf_utils_add_remote (context, sack, flags, cache_age, state_local, error);
+		if (!ret)
+			return NULL;
+
+		/* done */
+		ret = dnf_state_done (state, error);
+		if (!ret)
+			return NULL;
+	}
+
+	dnf_sack_filter_modules (sack,
+				 dnf_context_get_repos (context),
+				 install_root,
+				 NULL);
+
+	return g_steal_pointer (&sack);
+}
+
+/* must be called with sack_mutex held */
+static DnfSack *
+pk_backend_sack_cache_lookup_locked (PkBackendDnfPrivate *priv,
+				     const gchar *cache_key,
+				     GCancellable *cancellable)
+{
+	DnfSackCacheItem *cache_item;
+
+	/* another thread is already loading this sack, so wait for that
+	 * rather than loading the same metadata twice */
+	if (g_hash_table_contains (priv->sack_building, cache_key))
+		g_debug ("waiting for in-flight sack %s", cache_key);
+	while (g_hash_table_contains (priv->sack_building, cache_key)) {
+		gint64 end_time = g_get_monotonic_time () + G_TIME_SPAN_SECOND;
+		if (g_cancellable_is_cancelled (cancellable))
+			return NULL;
+		g_cond_wait_until (&priv->sack_cond, &priv->sack_mutex, end_time);
+	}
+
+	cache_item = g_hash_table_lookup (priv->sack_cache, cache_key);
+	if (cache_item == NULL || cache_item->sack == NULL)
+		return NULL;
+	g_debug ("using cached sack %s", cache_key);
+	g_timer_start (cache_item->timer);
+	return g_object_ref (cache_item->sack);
+}
+
+static void
+pk_backend_sack_cache_insert (PkBackendDnfPrivate *priv,
+			      const gchar *cache_key,
+			      DnfSack *sack,
+			      guint generation,
+			      gboolean building)
+{
+	DnfSackCacheItem *cache_item;
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&priv->sack_mutex);
+
+	/* wake up anything waiting for this sack, even on failure */
+	if (building) {
+		g_hash_table_remove (priv->sack_building, cache_key);
+		g_cond_broadcast (&priv->sack_cond);
+	}
+	if (sack == NULL)
+		return;
+
+	/* the metadata changed while we were loading it */
+	if (generation != priv->sack_generation) {
+		g_debug ("not caching sack %s as invalidated", cache_key);
+		return;
+	}
+
+	/* save in cache */
+	cache_item = g_slice_new (DnfSackCacheItem);
+	cache_item->key = g_strdup (cache_key);
+	cache_item->sack = g_object_ref (sack);
+	cache_item->timer = g_timer_new ();
+	g_debug ("created cached sack %s", cache_item->key);
+	g_hash_table_insert (priv->sack_cache, g_strdup (cache_key), cache_item);
+}
+
 static DnfSack *
 dnf_utils_create_sack_for_filters (PkBackendJob *job,
 				   PkBitfield filters,
@@ -595,16 +766,13 @@ dnf_utils_create_sack_for_filters (PkBackendJob *job,
 				   DnfState *state,
 				   GError **error)
 {
-	gboolean ret;
 	DnfSackAddFlags flags = DNF_SACK_ADD_FLAG_FILELISTS;
-	DnfSackCacheItem *cache_item = NULL;
-	DnfState *state_local;
 	PkBackend *backend = pk_backend_job_get_backend (job);
 	PkBackendDnfJobData *job_data = pk_backend_job_get_user_data (job);
 	PkBackendDnfPrivate *priv = pk_backend_get_user_data (backend);
+	gboolean building = FALSE;
+	guint generation;
 	g_autofree gchar *cache_key = NULL;
-	g_autofree gchar *install_root = NULL;
-	g_autofree gchar *solv_dir = NULL;
 	g_autoptr(DnfSack) sack = NULL;
 
 	/* don't add if we're going to filter out anyway */
@@ -649,88 +817,184 @@ dnf_utils_create_sack_for_filters (PkBackendJob *job,
 	/* do we have anything in the cache */
 	cache_key = dnf_utils_create_cache_key (dnf_context_get_release_ver (job_data->context),
 						flags);
+	g_mutex_lock (&priv->sack_mutex);
 	if ((create_flags & DNF_CREATE_SACK_FLAG_USE_CACHE) > 0) {
-		g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&priv->sack_mutex);
-		cache_item = g_hash_table_lookup (priv->sack_cache, cache_key);
-		if (cache_item != NULL && cache_item->sack != NULL) {
-			g_debug ("using cached sack %s", cache_key);
-			g_timer_start (cache_item->timer);
-			return g_object_ref (cache_item->sack);
+		sack = pk_backend_sack_cache_lookup_locked (priv,
+							    cache_key,
+							    pk_backend_job_get_cancellable (job));
+		if (sack != NULL) {
+			g_mutex_unlock (&priv->sack_mutex);
+			return g_steal_pointer (&sack);
+		}
+		if (g_cancellable_set_error_if_cancelled (pk_backend_job_get_cancellable (job), error)) {
+			g_mutex_unlock (&priv->sack_mutex);
+			return NULL;
 		}
 	}
 
+	/* let other jobs wait for this sack rather than loading it again */
+	if (!g_hash_table_contains (priv->sack_building, cache_key)) {
+		g_hash_table_add (priv->sack_building, g_strdup (cache_key));
+		building = TRUE;
+	}
+	generation = priv->sack_generation;
+	g_mutex_unlock (&priv->sack_mutex);
+
 	/* update status */
 	dnf_state_action_start (state, DNF_STATE_ACTION_QUERY, NULL);
 
-	/* set state */
-	if ((flags & DNF_SACK_ADD_FLAG_REMOTE) > 0) {
-		ret = dnf_state_set_steps (state,
-					   error,
-					   8,  /* add installed */
-					   92, /* add remote */
-					   -1);
-		if (!ret)
-			return NULL;
-	} else {
-		dnf_state_set_number_steps (state, 1);
+	sack = dnf_utils_load_sack (job_data->context,
+				    flags,
+				    pk_backend_job_get_cache_age (job),
+				    state,
+				    error);
+	pk_backend_sack_cache_insert (priv, cache_key, sack, generation, building);
+	return g_steal_pointer (&sack);
+}
+
+static const DnfSackAddFlags pk_backend_sack_prewarm_flags[] = {
+	/* installed only */
+	DNF_SACK_ADD_FLAG_FILELISTS,
+	/* GetPackages, and the sack created when refreshing */
+	DNF_SACK_ADD_FLAG_FILELISTS | DNF_SACK_ADD_FLAG_REMOTE,
+	/* Resolve, GetDetails and searches */
+	DNF_SACK_ADD_FLAG_FILELISTS | DNF_SACK_ADD_FLAG_REMOTE | DNF_SACK_ADD_FLAG_UNAVAILABLE,
+	/* GetUpdates and GetUpdateDetail */
+	DNF_SACK_ADD_FLAG_FILELISTS | DNF_SACK_ADD_FLAG_REMOTE | DNF_SACK_ADD_FLAG_UPDATEINFO,
+};
+
+static gboolean
+pk_backend_sack_prewarm_one (PkBackendDnfPrivate *priv,
+			     DnfContext *context,
+			     DnfSackAddFlags flags,
+			     GError **error)
+{
+	guint generation;
+	g_autofree gchar *cache_key = NULL;
+	g_autoptr(DnfSack) sack = NULL;
+	g_autoptr(DnfState) state = NULL;
+	g_autoptr(GPtrArray) refresh_repos = NULL;
+
+	/* already loaded, or somebody else is loading it */
+	cache_key = dnf_utils_create_cache_key (dnf_context_get_release_ver (context), flags);
+	g_mutex_lock (&priv->sack_mutex);
+	if (g_hash_table_contains (priv->sack_cache, cache_key) ||
+	    g_hash_table_contains (priv->sack_building, cache_key)) {
+		g_mutex_unlock (&priv->sack_mutex);
+		return TRUE;
 	}
+	g_hash_table_add (priv->sack_building, g_strdup (cache_key));
+	generation = priv->sack_generation;
+	g_mutex_unlock (&priv->sack_mutex);
 
-	/* create empty sack */
-	solv_dir = dnf_utils_real_path (dnf_context_get_solv_dir (job_data->context));
-	install_root = dnf_utils_real_path (dnf_context_get_install_root (job_data->context));
-	sack = dnf_sack_new ();
-	dnf_sack_set_cachedir (sack, solv_dir);
-	dnf_sack_set_rootdir (sack, install_root);
-	ret = dnf_sack_setup (sack, DNF_SACK_SETUP_FLAG_MAKE_CACHE_DIR, error);
-	if (!ret) {
-		g_prefix_error (error,
-				"failed to create sack in %s for %s: ",
-				dnf_context_get_solv_dir (job_data->context),
-				dnf_context_get_install_root (job_data->context));
-		return NULL;
+	state = dnf_state_new ();
+	dnf_state_set_cancellable (state, priv->sack_prewarm_cancellable);
+	dnf_state_set_number_steps (state, 2);
+
+	/* loading the sack downloads any metadata which is not on disk yet,
+	 * which is for the next job to do, as this does not check the network */
+	refresh_repos = pk_backend_find_refresh_repos (dnf_state_get_child (state),
+						       dnf_context_get_repos (context),
+						       G_MAXUINT,
+						       FALSE /* !force */,
+						       error);
+	if (refresh_repos == NULL || !dnf_state_done (state, error)) {
+		pk_backend_sack_cache_insert (priv, cache_key, NULL, generation, TRUE);
+		return FALSE;
+	}
+	if (refresh_repos->len > 0) {
+		g_debug ("not pre-loading sack %s as %u repos have no metadata",
+			 cache_key, refresh_repos->len);
+		pk_backend_sack_cache_insert (priv, cache_key, NULL, generation, TRUE);
+		return TRUE;
 	}
 
-	/* add installed packages */
-	ret = dnf_sack_load_system_repo (sack, NULL, DNF_SACK_LOAD_FLAG_BUILD_CACHE, error);
-	if (!ret) {
-		g_prefix_error (error, "Failed to load system repo: ");
+	g_debug ("pre-loading sack %s", cache_key);
+	sack = dnf_utils_load_sack (context, flags, G_MAXUINT, dnf_state_get_child (state), error);
+	pk_backend_sack_cache_insert (priv, cache_key, sack, generation, TRUE);
+	return sack != NULL;
+}
+
+static gpointer
+pk_backend_sack_prewarm_thread (gpointer user_data)
+{
+	PkBackend *backend = PK_BACKEND (user_data);
+	PkBackendDnfPrivate *priv = pk_backend_get_user_data (backend);
+	g_autoptr(DnfContext) context = NULL;
+	g_autoptr(GError) error = NULL;
+
+	/* use our own context so we do not race with the running job */
+	context = dnf_context_new ();
+	if (!pk_backend_setup_dnf_context (context, priv->conf, priv->release_ver, &error)) {
+		g_warning ("failed to setup context for sack pre-loading: %s", error->message);
+		g_mutex_lock (&priv->sack_mutex);
+		priv->sack_prewarm_running = FALSE;
+		g_mutex_unlock (&priv->sack_mutex);
 		return NULL;
 	}
 
-	/* done */
-	ret = dnf_state_done (state, error);
-	if (!ret)
-		return NULL;
+	g_mutex_lock (&priv->sack_mutex);
+	do {
+		priv->sack_prewarm_again = FALSE;
+		g_mutex_unlock (&priv->sack_mutex);
+		for (guint i = 0; i < G_N_ELEMENTS (pk_backend_sack_prewarm_flags); i++) {
+			if (g_cancellable_is_cancelled (priv->sack_prewarm_cancellable))
+				break;
+			if (!pk_backend_sack_prewarm_one (priv,
+							  context,
+							  pk_backend_sack_prewarm_flags[i],
+							  &error)) {
+				g_debug ("failed to pre-load sack: %s", error->message);
+				g_clear_error (&error);
+			}
+		}
+		g_mutex_lock (&priv->sack_mutex);
+	} while (priv->sack_prewarm_again &&
+		 !g_cancellable_is_cancelled (priv->sack_prewarm_cancellable));
+	priv->sack_prewarm_running = FALSE;
+	g_mutex_unlock (&priv->sack_mutex);
+	return NULL;
+}
 
-	/* add remote packages */
-	if ((flags & DNF_SACK_ADD_FLAG_REMOTE) > 0) {
-		state_local = dnf_state_get_child (state);
-		ret = dnf_utils_add_remote (job, sack, flags, state_local, error);
-		if (!ret)
-			return NULL;
+static gboolean
+pk_backend_sack_prewarm_idle_cb (gpointer user_data)
+{
+	PkBackend *backend = PK_BACKEND (user_data);
+	PkBackendDnfPrivate *priv = pk_backend_get_user_data (backend);
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&priv->sack_mutex);
 
-		/* done */
-		ret = dnf_state_done (state, error);
-		if (!ret)
-			return NULL;
+	priv->sack_prewarm_id = 0;
+
+	/* already running, so just make it go round again */
+	if (priv->sack_prewarm_running) {
+		priv->sack_prewarm_again = TRUE;
+		return G_SOURCE_REMOVE;
 	}
 
-	dnf_sack_filter_modules (sack,
-				 dnf_context_get_repos (job_data->context),
-				 install_root,
-				 NULL);
+	/* the last thread has already finished, so this does not block */
+	if (priv->sack_prewarm_thread != NULL)
+		g_thread_join (priv->sack_prewarm_thread);
+	priv->sack_prewarm_running = TRUE;
+	priv->sack_prewarm_thread = g_thread_new ("PK-DnfSack",
+						  pk_backend_sack_prewarm_thread,
+						  backend);
+	return G_SOURCE_REMOVE;
+}
 
-	/* save in cache */
-	g_mutex_lock (&priv->sack_mutex);
-	cache_item = g_slice_new (DnfSackCacheItem);
-	cache_item->key = g_strdup (cache_key);
-	cache_item->sack = g_object_ref (sack);
-	cache_item->timer = g_timer_new ();
-	g_debug ("created cached sack %s", cache_item->key);
-	g_hash_table_insert (priv->sack_cache, g_strdup (cache_key), cache_item);
-	g_mutex_unlock (&priv->sack_mutex);
+/* can be called from any thread */
+static void
+pk_backend_sack_prewarm_queue (PkBackend *backend)
+{
+	PkBackendDnfPrivate *priv = pk_backend_get_user_data (backend);
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&priv->sack_mutex);
 
-	return g_steal_pointer (&sack);
+	/* wait until the daemon is otherwise idle */
+	if (priv->sack_prewarm_id > 0)
+		return;
+	priv->sack_prewarm_id = g_idle_add_full (G_PRIORITY_LOW,
+						 pk_backend_sack_prewarm_idle_cb,
+						 backend,
+						 NULL);
 }
 
 static GPtrArray *
@@ -1535,9 +1799,9 @@ pk_backend_refresh_subman (PkBackendJob *job)
 }
 
 static GPtrArray *
-pk_backend_find_refresh_repos (PkBackendJob *job,
-			       DnfState *state,
+pk_backend_find_refresh_repos (DnfState *state,
 			       GPtrArray *repos,
+			       guint cache_age,
 			       gboolean force,
 			       GError **error)
 {
@@ -1577,7 +1841,7 @@ pk_backend_find_refresh_repos (PkBackendJob *job,
 		/* is the repo up to date? */
 		state_loop = dnf_state_get_child (state_local);
 		repo_okay = dnf_repo_check (repo,
-					    pk_backend_job_get_cache_age (job),
+					    cache_age,
 					    state_loop,
 					    NULL);
 		if (!repo_okay || force)
@@ -1595,6 +1859,200 @@ pk_backend_find_refresh_repos (PkBackendJob *job,
 	return g_steal_pointer (&refresh_repos);
 }
 
+typedef struct
+{
+	PkBackendJob *job;
+	DnfState *state;
+	GPtrArray *queue; /* of PkBackendDnfRefreshItem, not started yet */
+	GHashTable *hosts; /* host -> number of refreshes running */
+	gchar *max_cache_age;
+	guint running;
+	guint max_running;
+	guint max_per_host;
+	GError *error;
+} PkBackendDnfRefresh;
+
+typedef struct
+{
+	PkBackendDnfRefresh *refresh;
+	DnfRepo *repo;
+	gchar *host;
+} PkBackendDnfRefreshItem;
+
+static void
+pk_backend_refresh_item_free (PkBackendDnfRefreshItem *item)
+{
+	g_free (item->host);
+	g_free (item);
+}
+
+/* the server the metadata of the repo comes from, or "" if not known */
+static gchar *
+pk_backend_refresh_repo_host (DnfRepo *repo)
+{
+	const gchar *keys[] = { "baseurl", "metalink", "mirrorlist", NULL };
+	g_autoptr(GKeyFile) keyfile = g_key_file_new ();
+
+	if (!g_key_file_load_from_file (keyfile, dnf_repo_get_filename (repo), G_KEY_FILE_NONE, NULL))
+		return g_strdup ("");
+	for (guint i = 0; keys[i] != NULL; i++) {
+		g_autofree gchar *value = NULL;
+		g_auto(GStrv) urls = NULL;
+		gchar *host = NULL;
+
+		value = g_key_file_get_string (keyfile, dnf_repo_get_id (repo), keys[i], NULL);
+		if (value == NULL)
+			continue;
+
+		/* baseurl can be a list, in which case the first one is tried first */
+		urls = g_strsplit_set (g_strstrip (value), " ,\n", 2);
+		if (g_uri_split (urls[0], G_URI_FLAGS_NONE, NULL, NULL, &host,
+				 NULL, NULL, NULL, NULL, NULL) && host != NULL)
+			return host;
+		g_free (host);
+	}
+	return g_strdup ("");
+}
+
+static void pk_backend_refresh_repos_start (PkBackendDnfRefresh *refresh);
+
+static void
+pk_backend_refresh_repo_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	PkBackendDnfRefreshItem *item = user_data;
+	PkBackendDnfRefresh *refresh = item->refresh;
+	GSubprocess *subprocess = G_SUBPROCESS (source);
+	guint host_running;
+	g_autoptr(GError) error = NULL;
+
+	if (!g_subprocess_wait_finish (subprocess, res, &error)) {
+		g_debug ("stopped refreshing %s: %s", dnf_repo_get_id (item->repo), error->message);
+		g_subprocess_force_exit (subprocess);
+	}
+	g_object_unref (subprocess);
+
+	host_running = GPOINTER_TO_UINT (g_hash_table_lookup (refresh->hosts, item->host));
+	g_hash_table_insert (refresh->hosts, g_strdup (item->host), GUINT_TO_POINTER (host_running - 1));
+	refresh->running--;
+
+	/* the metadata was parsed by the helper, so this repo is done */
+	if (refresh->error == NULL)
+		dnf_state_done (refresh->state, &refresh->error);
+	pk_backend_refresh_item_free (item);
+
+	pk_backend_refresh_repos_start (refresh);
+}
+
+/* starts as many of the queued refreshes as the limits allow */
+static void
+pk_backend_refresh_repos_start (PkBackendDnfRefresh *refresh)
+{
+	PkBackendDnfPrivate *priv = pk_backend_get_user_data (pk_backend_job_get_backend (refresh->job));
+
+	/* cancelled or failed, so do not start any more */
+	if (refresh->error != NULL) {
+		g_ptr_array_set_size (refresh->queue, 0);
+		return;
+	}
+
+	for (guint i = 0; i < refresh->queue->len && refresh->running < refresh->max_running; ) {
+		PkBackendDnfRefreshItem *item = g_ptr_array_index (refresh->queue, i);
+		guint host_running = GPOINTER_TO_UINT (g_hash_table_lookup (refresh->hosts, item->host));
+		const gchar *argv[5];
+		GSubprocess *subprocess;
+		g_autoptr(GError) error = NULL;
+
+		/* wait for a refresh from the same server to finish */
+		if (host_running >= refresh->max_per_host) {
+			i++;
+			continue;
+		}
+		g_ptr_array_steal_index (refresh->queue, i);
+
+		/* check and download */
+		argv[0] = LIBEXECDIR "/packagekit-dnf-refresh-repo";
+		argv[1] = refresh->max_cache_age;
+		argv[2] = dnf_repo_get_id (item->repo);
+		argv[3] = priv->release_ver;
+		argv[4] = NULL;
+		subprocess = g_subprocess_newv (argv, G_SUBPROCESS_FLAGS_NONE, &error);
+		if (subprocess == NULL) {
+			pk_backend_job_error_code (refresh->job,
+						   error->code,
+						   "failed to refresh %s: %s",
+						   dnf_repo_get_id (item->repo),
+						   error->message);
+			pk_backend_refresh_item_free (item);
+			if (refresh->error == NULL)
+				dnf_state_done (refresh->state, &refresh->error);
+			continue;
+		}
+
+		g_debug ("refreshing %s from %s", dnf_repo_get_id (item->repo), item->host);
+		g_hash_table_insert (refresh->hosts, g_strdup (item->host), GUINT_TO_POINTER (host_running + 1));
+		refresh->running++;
+		g_subprocess_wait_async (subprocess,
+					 pk_backend_job_get_cancellable (refresh->job),
+					 pk_backend_refresh_repo_cb,
+					 item);
+	}
+}
+
+/*
+ * Refreshes the repos in separate helper processes, a few at a time and
+ * only a couple from the same server, so that the time is not dominated by
+ * the latency of each server. Each helper also parses the metadata as soon
+ * as it has been downloaded.
+ */
+static gboolean
+pk_backend_refresh_repos (PkBackendJob *job, GPtrArray *refresh_repos, DnfState *state, GError **error)
+{
+	PkBackend *backend = pk_backend_job_get_backend (job);
+	PkBackendDnfPrivate *priv = pk_backend_get_user_data (backend);
+	PkBackendDnfRefresh refresh = { 0 };
+	g_autoptr(GMainContext) context = g_main_context_new ();
+	g_autoptr(GPtrArray) queue = NULL;
+	g_autoptr(GHashTable) hosts = NULL;
+	g_autofree gchar *max_cache_age = NULL;
+	gint max_running;
+	gint max_per_host;
+
+	max_running = g_key_file_get_integer (priv->conf, "Daemon", "RefreshParallelism", NULL);
+	max_per_host = g_key_file_get_integer (priv->conf, "Daemon", "RefreshParallelismPerHost", NULL);
+	max_cache_age = g_strdup_printf ("%u", pk_backend_job_get_cache_age (job));
+
+	queue = g_ptr_array_new_with_free_func ((GDestroyNotify) pk_backend_refresh_item_free);
+	for (guint i = 0; i < refresh_repos->len; i++) {
+		PkBackendDnfRefreshItem *item = g_new0 (PkBackendDnfRefreshItem, 1);
+		item->refresh = &refresh;
+		item->repo = g_ptr_array_index (refresh_repos, i);
+		item->host = pk_backend_refresh_repo_host (item->repo);
+		g_ptr_array_add (queue, item);
+	}
+	hosts = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+	refresh.job = job;
+	refresh.state = state;
+	refresh.queue = queue;
+	refresh.hosts = hosts;
+	refresh.max_cache_age = max_cache_age;
+	refresh.max_running = max_running > 0 ? (guint) max_running : DNF_REFRESH_PARALLELISM;
+	refresh.max_per_host = max_per_host > 0 ? (guint) max_per_host : DNF_REFRESH_PARALLELISM_PER_HOST;
+
+	dnf_state_set_number_steps (state, refresh_repos->len);
+	g_main_context_push_thread_default (context);
+	pk_backend_refresh_repos_start (&refresh);
+	while (refresh.running > 0)
+		g_main_context_iteration (context, TRUE);
+	g_main_context_pop_thread_default (context);
+
+	if (refresh.error != NULL) {
+		g_propagate_error (error, refresh.error);
+		return FALSE;
+	}
+	return TRUE;
+}
+
 static void
 pk_backend_refresh_cache_thread (PkBackendJob *job, GVariant *params, gpointer user_data)
 {
@@ -1610,7 +2068,6 @@ pk_backend_refresh_cache_thread (PkBackendJob *job, GVariant *params, gpointer u
 	g_autoptr(GError) error = NULL;
 	g_autoptr(GPtrArray) refresh_repos = NULL;
 	g_autoptr(GPtrArray) repos = NULL;
-	g_autofree gchar *max_cache_age = NULL;
 
 	/* set state */
 	dnf_state_set_steps (job_data->state,
@@ -1636,7 +2093,11 @@ pk_backend_refresh_cache_thread (PkBackendJob *job, GVariant *params, gpointer u
 	}
 
 	/* figure out which repos need refreshing */
-	refresh_repos = pk_backend_find_refresh_repos (job, job_data->state, repos, force, &error);
+	refresh_repos = pk_backend_find_refresh_repos (job_data->state,
+						       repos,
+						       pk_backend_job_get_cache_age (job),
+						       force,
+						       &error);
 	if (refresh_repos == NULL) {
 		pk_backend_job_error_code (job, error->code, "%s", error->message);
 		return;
@@ -1649,54 +2110,24 @@ pk_backend_refresh_cache_thread (PkBackendJob *job, GVariant *params, gpointer u
 		return;
 	}
 
-	/* refresh each repo */
-	state_local = dnf_state_get_child (job_data->state);
-	dnf_state_set_number_steps (state_local, refresh_repos->len);
-	max_cache_age = g_strdup_printf ("%u", pk_backend_job_get_cache_age (job));
-	for (i = 0; i < refresh_repos->len; i++) {
-		gint wait_status;
-		const gchar *refresh[5];
+	/* delete content even if up to date */
+	for (i = 0; force && i < refresh_repos->len; i++) {
 		repo = g_ptr_array_index (refresh_repos, i);
-
-		/* delete content even if up to date */
-		if (force) {
-			g_debug ("Deleting contents of %s as forced", dnf_repo_get_id (repo));
-			ret = dnf_repo_clean (repo, &error);
-			if (!ret) {
-				pk_backend_job_error_code (job, error->code, "%s", error->message);
-				return;
-			}
-		}
-
-		/* check and download */
-		refresh[0] = LIBEXECDIR "/packagekit-dnf-refresh-repo";
-		refresh[1] = max_cache_age;
-		refresh[2] = dnf_repo_get_id (repo);
-		refresh[3] = priv->release_ver;
-		refresh[4] = NULL;
-		if (!g_spawn_sync (NULL,
-				   (gchar **) refresh,
-				   NULL,
-				   G_SPAWN_DEFAULT,
-				   NULL,
-				   NULL,
-				   NULL,
-				   NULL,
-				   &wait_status,
-				   &error))
-			pk_backend_job_error_code (job,
-						   error->code,
-						   "%s",
-						   "unkown error in pk_backend_refresh_repo");
-
-		/* done */
-		ret = dnf_state_done (state_local, &error);
+		g_debug ("Deleting contents of %s as forced", dnf_repo_get_id (repo));
+		ret = dnf_repo_clean (repo, &error);
 		if (!ret) {
 			pk_backend_job_error_code (job, error->code, "%s", error->message);
 			return;
 		}
 	}
 
+	/* refresh the repos */
+	state_local = dnf_state_get_child (job_data->state);
+	if (!pk_backend_refresh_repos (job, refresh_repos, state_local, &error)) {
+		pk_backend_job_error_code (job, error->code, "%s", error->message);
+		return;
+	}
+
 	/* done */
 	ret = dnf_state_done (job_data->state, &error);
 	if (!ret) {
@@ -1728,6 +2159,9 @@ pk_backend_refresh_cache_thread (PkBackendJob *job, GVariant *params, gpointer u
 		pk_backend_job_error_code (job, error->code, "%s", error->message);
 		return;
 	}
+
+	/* load the other commonly used sacks before anyone asks for them */
+	pk_backend_sack_prewarm_queue (backend);
 }
 
 void
@@ -2029,6 +2463,7 @@ backend_get_details_thread (PkBackendJob *job, GVariant *params, gpointer user_d
 	g_autoptr(DnfSack) sack = NULL;
 	g_autoptr(GError) error = NULL;
 	g_autoptr(GHashTable) hash = NULL;
+	g_autoptr(GPtrArray) details = NULL;
 
 	g_variant_get (params, "(^a&s)", &package_ids);
 
@@ -2074,7 +2509,9 @@ backend_get_details_thread (PkBackendJob *job, GVariant *params, gpointer user_d
 	}
 
 	/* emit details */
+	details = g_ptr_array_new_with_free_func (g_object_unref);
 	for (i = 0; package_ids[i] != NULL; i++) {
+		PkDetails *item;
 		guint64 download_size;
 		pkg = g_hash_table_lookup (hash, package_ids[i]);
 		if (pkg == NULL)
@@ -2104,16 +2541,20 @@ backend_get_details_thread (PkBackendJob *job, GVariant *params, gpointer user_d
 			}
 		}
 
-		pk_backend_job_details (job,
-					package_ids[i],
-					dnf_package_get_summary (pkg),
-					dnf_package_get_license (pkg),
-					PK_GROUP_ENUM_UNKNOWN,
-					dnf_package_get_description (pkg),
-					dnf_package_get_url (pkg),
-					(gulong) dnf_package_get_installsize (pkg),
-					download_size);
+		item = pk_details_new ();
+		g_object_set (item,
+			      "package-id", package_ids[i],
+			      "summary", dnf_package_get_summary (pkg),
+			      "license", dnf_package_get_license (pkg),
+			      "group", PK_GROUP_ENUM_UNKNOWN,
+			      "description", dnf_package_get_description (pkg),
+			      "url", dnf_package_get_url (pkg),
+			      "size", dnf_package_get_installsize (pkg),
+			      "download-size", download_size,
+			      NULL);
+		g_ptr_array_add (details, item);
 	}
+	pk_backend_job_details_list (job, details);
 
 	/* done */
 	if (!dnf_state_done (job_data->state, &error)) {
@@ -2314,6 +2755,23 @@ pk_backend_get_files_local (PkBackend *backend, PkBackendJob *job, gchar **files
 	pk_backend_job_thread_create (job, backend_get_files_local_thread, NULL, NULL);
 }
 
+/* the key of the package in the download cache of the daemon */
+static gchar *
+pk_backend_dnf_package_checksum (DnfPackage *pkg)
+{
+	const unsigned char *chksum;
+	int type;
+	g_autofree gchar *hex = NULL;
+
+	chksum = dnf_package_get_chksum (pkg, &type);
+	if (chksum == NULL)
+		return NULL;
+	hex = hy_chksum_str (chksum, type);
+	if (hex == NULL)
+		return NULL;
+	return g_strdup_printf ("%s:%s", hy_chksum_name (type), hex);
+}
+
 static void
 pk_backend_download_packages_thread (PkBackendJob *job, GVariant *params, gpointer user_data)
 {
@@ -2326,6 +2784,7 @@ pk_backend_download_packages_thread (PkBackendJob *job, GVariant *params, gpoint
 	DnfState *state_loop;
 	DnfPackage *pkg;
 	PkBackendDnfJobData *job_data = pk_backend_job_get_user_data (job);
+	PkBackend *backend = pk_backend_job_get_backend (job);
 	PkBitfield filters = pk_bitfield_value (PK_FILTER_ENUM_NOT_INSTALLED);
 	g_autofree gchar **package_ids = NULL;
 	g_autoptr(DnfSack) sack = NULL;
@@ -2388,6 +2847,8 @@ pk_backend_download_packages_thread (PkBackendJob *job, GVariant *params, gpoint
 	state_local = dnf_state_get_child (job_data->state);
 	dnf_state_set_number_steps (state_local, g_strv_length (package_ids));
 	for (i = 0; package_ids[i] != NULL; i++) {
+		g_autofree gchar *checksum = NULL;
+
 		pkg = g_hash_table_lookup (hash, package_ids[i]);
 		if (pkg == NULL) {
 			pk_backend_job_error_code (job,
@@ -2399,6 +2860,23 @@ pk_backend_download_packages_thread (PkBackendJob *job, GVariant *params, gpoint
 
 		dnf_emit_package (job, PK_INFO_ENUM_DOWNLOADING, pkg);
 
+		/* downloaded already for an earlier transaction */
+		if (directory != NULL) {
+			g_autofree gchar *basename = g_path_get_basename (dnf_package_get_location (pkg));
+
+			checksum = pk_backend_dnf_package_checksum (pkg);
+			tmp = g_build_filename (directory, basename, NULL);
+			if (pk_backend_download_cache_link (backend, checksum, tmp)) {
+				g_ptr_array_add (files, tmp);
+				if (!dnf_state_done (state_local, &error)) {
+					pk_backend_job_error_code (job, error->code, "%s", error->message);
+					return;
+				}
+				continue;
+			}
+			g_free (tmp);
+		}
+
 		/* get correct package repo */
 		repo = dnf_repo_loader_get_repo_by_id (
 		    dnf_context_get_repo_loader (job_data->context),
@@ -2419,6 +2897,8 @@ pk_backend_download_packages_thread (PkBackendJob *job, GVariant *params, gpoint
 			pk_backend_job_error_code (job, error->code, "%s", error->message);
 			return;
 		}
+		if (checksum != NULL)
+			pk_backend_download_cache_add (backend, checksum, tmp);
 
 		/* add to download list */
 		g_ptr_array_add (files, tmp);
@@ -3758,10 +4238,12 @@ pk_backend_get_files_thread (PkBackendJob *job, GVariant *params, gpointer user_
 	DnfPackage *pkg;
 	PkBackendDnfJobData *job_data = pk_backend_job_get_user_data (job);
 	PkBitfield filters;
+	PkFiles *item;
 	g_autofree gchar **package_ids = NULL;
 	g_autoptr(DnfSack) sack = NULL;
 	g_autoptr(GError) error = NULL;
 	g_autoptr(GHashTable) hash = NULL;
+	g_autoptr(GPtrArray) files_list = NULL;
 
 	/* set state */
 	ret = dnf_state_set_steps (job_data->state,
@@ -3806,6 +4288,7 @@ pk_backend_get_files_thread (PkBackendJob *job, GVariant *params, gpointer user_
 	}
 
 	/* emit details */
+	files_list = g_ptr_array_new_with_free_func (g_object_unref);
 	for (i = 0; package_ids[i] != NULL; i++) {
 		pkg = g_hash_table_lookup (hash, package_ids[i]);
 		if (pkg == NULL) {
@@ -3818,6 +4301,7 @@ pk_backend_get_files_thread (PkBackendJob *job, GVariant *params, gpointer user_
 
 		/* sort and list according to name */
 		files_array = dnf_package_get_files (pkg);
+		item = pk_files_new ();
 		if (FALSE) {
 			g_autoptr(GPtrArray) files = NULL;
 			files = g_ptr_array_new ();
@@ -3825,12 +4309,20 @@ pk_backend_get_files_thread (PkBackendJob *job, GVariant *params, gpointer user_
 				g_ptr_array_add (files, files_array[j]);
 			g_ptr_array_sort (files, (GCompareFunc) pk_backend_sort_string_cb);
 			g_ptr_array_add (files, NULL);
-			pk_backend_job_files (job, package_ids[i], (gchar **) files->pdata);
+			g_object_set (item,
+				      "package-id", package_ids[i],
+				      "files", (gchar **) files->pdata,
+				      NULL);
 		} else {
-			pk_backend_job_files (job, package_ids[i], files_array);
+			g_object_set (item,
+				      "package-id", package_ids[i],
+				      "files", files_array,
+				      NULL);
 		}
+		g_ptr_array_add (files_list, item);
 		g_strfreev (files_array);
 	}
+	pk_backend_job_files_list (job, files_list);
 
 	/* done */
 	if (!dnf_state_done (job_data->state, &error)) {
@@ -0,0 +1,115 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2026 PackageKit Authors
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "dnf5-backend-emit.hpp"
+#include <algorithm>
+
+/* Every getter of libdnf5::rpm::Package returns a new std::string, so each
+ * of these is only fetched once per package rather than on every comparison */
+typedef struct {
+	std::size_t index;
+	std::string name;
+	std::string arch;
+	std::string evr;
+	bool installed;
+} Dnf5EmitItem;
+
+static void
+dnf5_append_package_id (std::string &package_id,
+			const libdnf5::rpm::Package &pkg,
+			const std::string &name,
+			const std::string &evr,
+			const std::string &arch,
+			bool installed)
+{
+	package_id.append(name).append(";").append(evr).append(";").append(arch).append(";");
+	if (installed) {
+		std::string from_repo = pkg.get_from_repo_id();
+		package_id.append("installed");
+		if (!from_repo.empty())
+			package_id.append(":").append(from_repo);
+	} else {
+		package_id.append(pkg.get_repo_id());
+	}
+}
+
+std::string
+dnf5_package_id (const libdnf5::rpm::Package &pkg)
+{
+	std::string package_id;
+	std::string name = pkg.get_name();
+	std::string evr = pkg.get_evr();
+	std::string arch = pkg.get_arch();
+
+	package_id.reserve(name.size() + evr.size() + arch.size() + 64);
+	dnf5_append_package_id(package_id, pkg, name, evr, arch, pkg.get_install_time() > 0);
+	return package_id;
+}
+
+/*
+ * Sorts the packages with the installed ones first and then by name, arch
+ * and EVR, drops the duplicate NEVRAs and returns them as an array of
+ * PkPackage for pk_backend_job_packages().
+ */
+GPtrArray *
+dnf5_sort_and_stage (const std::vector<libdnf5::rpm::Package> &pkgs)
+{
+	std::vector<Dnf5EmitItem> items;
+	std::string package_id;
+	GPtrArray *array;
+
+	items.reserve(pkgs.size());
+	for (std::size_t i = 0; i < pkgs.size(); i++) {
+		const auto &pkg = pkgs[i];
+		items.push_back({i, pkg.get_name(), pkg.get_arch(), pkg.get_evr(), pkg.get_install_time() > 0});
+	}
+
+	/* the same NEVRA is next to each other, with the installed one first */
+	std::sort(items.begin(), items.end(), [](const Dnf5EmitItem &a, const Dnf5EmitItem &b) {
+		if (int cmp = a.name.compare(b.name); cmp != 0) return cmp < 0;
+		if (int cmp = a.arch.compare(b.arch); cmp != 0) return cmp < 0;
+		if (int cmp = a.evr.compare(b.evr); cmp != 0) return cmp < 0;
+		return a.installed && !b.installed;
+	});
+	items.erase(std::unique(items.begin(), items.end(), [](const Dnf5EmitItem &a, const Dnf5EmitItem &b) {
+		return a.name == b.name && a.arch == b.arch && a.evr == b.evr;
+	}), items.end());
+	std::stable_partition(items.begin(), items.end(), [](const Dnf5EmitItem &item) {
+		return item.installed;
+	});
+
+	array = g_ptr_array_new_full(items.size(), (GDestroyNotify) g_object_unref);
+	for (const auto &item : items) {
+		const auto &pkg = pkgs[item.index];
+		g_autoptr(PkPackage) package = pk_package_new();
+		g_autoptr(GError) error = NULL;
+
+		package_id.clear();
+		dnf5_append_package_id(package_id, pkg, item.name, item.evr, item.arch, item.installed);
+		if (!pk_package_set_id(package, package_id.c_str(), &error)) {
+			g_warning("package_id %s invalid and cannot be processed: %s", package_id.c_str(), error->message);
+			continue;
+		}
+		pk_package_set_info(package, item.installed ? PK_INFO_ENUM_INSTALLED : PK_INFO_ENUM_AVAILABLE);
+		pk_package_set_summary(package, pkg.get_summary().c_str());
+		g_ptr_array_add(array, g_steal_pointer(&package));
+	}
+	return array;
+}
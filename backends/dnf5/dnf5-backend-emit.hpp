@@ -0,0 +1,32 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2026 PackageKit Authors
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+/* These do not use the backend job, so that they can be benchmarked on their own */
+
+#include <pk-backend.h>
+#include <libdnf5/rpm/package.hpp>
+#include <glib.h>
+#include <string>
+#include <vector>
+
+std::string dnf5_package_id(const libdnf5::rpm::Package &pkg);
+GPtrArray *dnf5_sort_and_stage(const std::vector<libdnf5::rpm::Package> &pkgs);
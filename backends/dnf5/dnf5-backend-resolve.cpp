@@ -0,0 +1,124 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2026 PackageKit Authors
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "dnf5-backend-resolve.hpp"
+#include <libdnf5/rpm/arch.hpp>
+#include <libdnf5/rpm/package_query.hpp>
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+static void
+dnf5_resolve_package_name(libdnf5::Base &base, const gchar *name, std::vector<libdnf5::rpm::Package> &pkgs)
+{
+	// Simple package name - search by name and get latest available
+	try {
+		g_debug("Resolving simple package name: %s", name);
+		libdnf5::rpm::PackageQuery query(base);
+		query.filter_name(std::string(name), libdnf5::sack::QueryCmp::EQ);
+		query.filter_available();
+		query.filter_latest_evr();
+		query.filter_arch(libdnf5::rpm::get_supported_arches());
+
+		for (auto pkg : query) {
+			g_debug("Found package: name=%s, evr=%s, arch=%s, repo=%s",
+				pkg.get_name().c_str(), pkg.get_evr().c_str(),
+				pkg.get_arch().c_str(), pkg.get_repo_id().c_str());
+			pkgs.push_back(pkg);
+			return; // Take the first match
+		}
+		g_debug("No available package found for name: %s", name);
+	} catch (const std::exception &e) {
+		g_debug("Exception resolving package name %s: %s", name, e.what());
+	}
+}
+
+/*
+ * Resolves the package IDs in one query for all of the names rather than a
+ * query for each ID, which has to go over the whole pool every time. The
+ * packages are returned in the order of the IDs, and the IDs which could not
+ * be resolved are skipped.
+ */
+std::vector<libdnf5::rpm::Package>
+dnf5_resolve_package_ids(libdnf5::Base &base, gchar **package_ids)
+{
+	std::vector<libdnf5::rpm::Package> pkgs;
+	std::vector<PkPackageIdView> views;
+	std::vector<std::string> names;
+	std::unordered_map<std::string, std::vector<libdnf5::rpm::Package>> by_nevra;
+	std::string nevra;
+
+	if (!package_ids) return pkgs;
+
+	views.resize(g_strv_length(package_ids));
+	for (guint i = 0; package_ids[i] != NULL; i++) {
+		// Simple package names are resolved on their own
+		if (strchr(package_ids[i], ';') == NULL)
+			continue;
+		if (!pk_package_id_parse(package_ids[i], &views[i])) {
+			views[i] = PkPackageIdView();
+			continue;
+		}
+		names.emplace_back(views[i].sections[PK_PACKAGE_ID_NAME], views[i].lengths[PK_PACKAGE_ID_NAME]);
+	}
+
+	if (!names.empty()) {
+		try {
+			libdnf5::rpm::PackageQuery query(base);
+			query.filter_name(names, libdnf5::sack::QueryCmp::EQ);
+			for (const auto &pkg : query) {
+				nevra = pkg.get_name() + ";" + pkg.get_evr() + ";" + pkg.get_arch();
+				by_nevra[nevra].push_back(pkg);
+			}
+		} catch (const std::exception &e) {
+			g_debug("Exception resolving package IDs: %s", e.what());
+		}
+	}
+
+	for (guint i = 0; package_ids[i] != NULL; i++) {
+		const PkPackageIdView &view = views[i];
+
+		if (strchr(package_ids[i], ';') == NULL) {
+			dnf5_resolve_package_name(base, package_ids[i], pkgs);
+			continue;
+		}
+		if (view.lengths[PK_PACKAGE_ID_NAME] == 0)
+			continue;
+
+		// name;evr;arch is the package_id without the data
+		nevra.assign(package_ids[i], view.sections[PK_PACKAGE_ID_DATA] - 1 - package_ids[i]);
+		auto it = by_nevra.find(nevra);
+		if (it == by_nevra.end()) {
+			g_debug("No exact match for ID: %s", package_ids[i]);
+			continue;
+		}
+
+		const gchar *repo_id = view.sections[PK_PACKAGE_ID_DATA];
+		bool installed = g_str_has_prefix(repo_id, "installed");
+		auto match = std::find_if(it->second.begin(), it->second.end(), [&](const libdnf5::rpm::Package &pkg) {
+			return installed ? pkg.is_installed() : pkg.get_repo_id() == repo_id;
+		});
+		if (match != it->second.end())
+			pkgs.push_back(*match);
+		else
+			g_debug("No exact match for ID: %s", package_ids[i]);
+	}
+	return pkgs;
+}
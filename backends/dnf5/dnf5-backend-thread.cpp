@@ -20,6 +20,7 @@
 
 #include "dnf5-backend-thread.hpp"
 #include "dnf5-backend-utils.hpp"
+#include "dnf5-backend-resolve.hpp"
 #include <libdnf5/base/goal.hpp>
 #include <libdnf5/comps/environment/query.hpp>
 #include <libdnf5/comps/group/query.hpp>
@@ -132,12 +133,9 @@ dnf5_query_thread (PkBackendJob *job, GVariant *params, gpointer user_data)
 			
 			auto input_pkgs = dnf5_resolve_package_ids(*priv->base, package_ids);
 			std::vector<libdnf5::rpm::Package> results;
-			for (const auto &pkg : input_pkgs) {
-				auto deps = dnf5_process_dependency(*priv->base, pkg, role, recursive);
-				for (auto dep : deps) {
-					if (dnf5_package_filter(dep, filters))
-						results.push_back(dep);
-				}
+			for (auto dep : dnf5_process_dependency(*priv->base, input_pkgs, role, recursive)) {
+				if (dnf5_package_filter(dep, filters))
+					results.push_back(dep);
 			}
 			dnf5_sort_and_emit(job, results);
 
@@ -205,20 +203,31 @@ dnf5_query_thread (PkBackendJob *job, GVariant *params, gpointer user_data)
 				auto pkgs = dnf5_resolve_package_ids(*priv->base, package_ids);
 				libdnf5::repo::PackageDownloader downloader(*priv->base);
 				uint64_t total_download_size = 0;
-				for (const auto &pkg : pkgs) total_download_size += pkg.get_download_size();
-				
-				priv->base->set_download_callbacks(std::make_unique<Dnf5DownloadCallbacks>(job, total_download_size));
+				std::vector<std::string> paths;
+				std::vector<std::pair<std::string, std::string>> downloaded;
 				for (auto &pkg : pkgs) {
 					dnf5_emit_pkg(job, pkg, PK_INFO_ENUM_DOWNLOADING);
+					auto checksum = pkg.get_checksum();
+					std::string checksum_str = checksum.get_type_str() + ":" + checksum.get_checksum();
+					std::string path = (std::filesystem::path(directory) / std::filesystem::path(pkg.get_location()).filename()).string();
+					paths.push_back(path);
+					
+					// downloaded already for an earlier transaction
+					if (pk_backend_download_cache_link (backend, checksum_str.c_str(), path.c_str()))
+						continue;
 					downloader.add(pkg, directory);
+					downloaded.emplace_back(checksum_str, path);
+					total_download_size += pkg.get_download_size();
 				}
+				
+				priv->base->set_download_callbacks(std::make_unique<Dnf5DownloadCallbacks>(job, total_download_size));
 				downloader.download();
+				for (const auto &[checksum, path] : downloaded)
+					pk_backend_download_cache_add (backend, checksum.c_str(), path.c_str());
 				
 				std::vector<char*> files_c;
-				for (auto &pkg : pkgs) {
-					std::string path = pkg.get_package_path();
-					if (!path.empty()) files_c.push_back(g_strdup(path.c_str()));
-				}
+				for (const auto &path : paths)
+					files_c.push_back(g_strdup(path.c_str()));
 				files_c.push_back(nullptr);
 				pk_backend_job_files (job, NULL, files_c.data());
 				for (auto p : files_c) g_free(p);
@@ -391,9 +400,9 @@ dnf5_transaction_thread (PkBackendJob *job, GVariant *params, gpointer user_data
 
 		libdnf5::Goal goal(*priv->base);
 		PkBitfield transaction_flags = 0;
+		g_auto(GStrv) package_ids = NULL;
 		
 		if (role == PK_ROLE_ENUM_INSTALL_PACKAGES || role == PK_ROLE_ENUM_UPDATE_PACKAGES || role == PK_ROLE_ENUM_REMOVE_PACKAGES) {
-			g_auto(GStrv) package_ids = NULL;
 			if (role == PK_ROLE_ENUM_REMOVE_PACKAGES) {
 				gboolean allow_deps, autoremove;
 				g_variant_get (params, "(t^asbb)", &transaction_flags, &package_ids, &allow_deps, &autoremove);
@@ -402,7 +411,15 @@ dnf5_transaction_thread (PkBackendJob *job, GVariant *params, gpointer user_data
 				g_variant_get (params, "(t^as)", &transaction_flags, &package_ids);
 			}
 			
-			auto pkgs = dnf5_resolve_package_ids(*priv->base, package_ids);
+			/* the prepared offline update was already depsolved when it was downloaded */
+			bool replay = role == PK_ROLE_ENUM_UPDATE_PACKAGES &&
+				      !pk_bitfield_contain (transaction_flags, PK_TRANSACTION_FLAG_ENUM_ONLY_DOWNLOAD) &&
+				      !pk_bitfield_contain (transaction_flags, PK_TRANSACTION_FLAG_ENUM_SIMULATE) &&
+				      dnf5_add_prepared_plan (*priv->base, goal, package_ids);
+
+			std::vector<libdnf5::rpm::Package> pkgs;
+			if (!replay)
+				pkgs = dnf5_resolve_package_ids(*priv->base, package_ids);
 			if (pkgs.empty() && role != PK_ROLE_ENUM_UPDATE_PACKAGES) {
 				pk_backend_job_error_code (job, PK_ERROR_ENUM_PACKAGE_NOT_FOUND, "No packages found");
 				pk_backend_job_finished (job);
@@ -414,7 +431,7 @@ dnf5_transaction_thread (PkBackendJob *job, GVariant *params, gpointer user_data
 				else if (role == PK_ROLE_ENUM_REMOVE_PACKAGES) goal.add_rpm_remove(pkg);
 				else if (role == PK_ROLE_ENUM_UPDATE_PACKAGES) goal.add_rpm_upgrade(pkg);
 			}
-			if (role == PK_ROLE_ENUM_UPDATE_PACKAGES && pkgs.empty()) {
+			if (role == PK_ROLE_ENUM_UPDATE_PACKAGES && pkgs.empty() && !replay) {
 				if (dnf5_force_distupgrade_on_upgrade (*priv->base))
 					goal.add_rpm_distro_sync();
 				else
@@ -530,6 +547,10 @@ dnf5_transaction_thread (PkBackendJob *job, GVariant *params, gpointer user_data
 		trans.download();
 
 		if (pk_bitfield_contain (transaction_flags, PK_TRANSACTION_FLAG_ENUM_ONLY_DOWNLOAD)) {
+			// Save the solution so that installing the prepared update does not have to redo it
+			if (role == PK_ROLE_ENUM_UPDATE_PACKAGES)
+				dnf5_save_prepared_plan (*priv->base, trans, package_ids);
+
 			// Iterate over transaction items and report them as if they were being processed
 			for (const auto &item : trans.get_transaction_packages()) {
 				auto action = item.get_action();
@@ -561,8 +582,10 @@ dnf5_transaction_thread (PkBackendJob *job, GVariant *params, gpointer user_data
 			priv->last_notification_timestamp = g_get_monotonic_time ();
 		}
 
-		// Post-transaction base re-initialization to ensure state consistency
-		dnf5_setup_base (priv);
+		// Post-transaction base re-initialization to ensure state consistency,
+		// only the installed packages changed so the cached metadata is reused
+		priv->base = dnf5_create_base_installed (priv);
+		g_atomic_int_inc (&priv->base_generation);
 		
 	} catch (const std::exception &e) {
 		pk_backend_job_error_code (job, PK_ERROR_ENUM_TRANSACTION_ERROR, "%s", e.what());
@@ -19,7 +19,9 @@
  */
 
 #include "dnf5-backend-utils.hpp"
+#include "dnf5-backend-emit.hpp"
 #include <pk-common-private.h>
+#include <pk-offline-private.h>
 #include <pk-update-detail.h>
 #include <libdnf5/conf/config_parser.hpp>
 #include <libdnf5/conf/const.hpp>
@@ -32,21 +34,20 @@
 #include <libdnf5/base/transaction.hpp>
 #include <rpm/rpmlib.h>
 #include <glib/gstdio.h>
+#include <sys/stat.h>
 #include <algorithm>
-#include <set>
-#include <queue>
 #include <filesystem>
 #include <map>
 #include "dnf5-backend-vendor.hpp"
 
-void
-dnf5_setup_base (PkBackendDnf5Private *priv, gboolean refresh, gboolean force, const char *releasever, gboolean online)
+std::unique_ptr<libdnf5::Base>
+dnf5_create_base (PkBackendDnf5Private *priv, gboolean refresh, gboolean force, const char *releasever, gboolean online)
 {
-	priv->base = std::make_unique<libdnf5::Base>();
+	auto base = std::make_unique<libdnf5::Base>();
 
-	priv->base->load_config();
+	base->load_config();
 
-	auto &config = priv->base->get_config();
+	auto &config = base->get_config();
 	if (priv->conf != NULL) {
 		g_autofree gchar *destdir = g_key_file_get_string (priv->conf, "Daemon", "DestDir", NULL);
 		if (destdir != NULL) {
@@ -65,7 +66,7 @@ dnf5_setup_base (PkBackendDnf5Private *priv, gboolean refresh, gboolean force, c
 		}
 
 		if (distro_version != NULL) {
-			priv->base->get_vars()->set("releasever", distro_version);
+			base->get_vars()->set("releasever", distro_version);
 			const char *root = (destdir != NULL) ? destdir : "/";
 			g_autofree gchar *cache_dir = g_build_filename (root, "/var/cache/PackageKit", distro_version, "metadata", NULL);
 			g_debug("Using cachedir: %s", cache_dir);
@@ -92,7 +93,7 @@ dnf5_setup_base (PkBackendDnf5Private *priv, gboolean refresh, gboolean force, c
 		config.get_assumeyes_option().set(libdnf5::Option::Priority::COMMANDLINE, true);
 	}
 
-	priv->base->setup();
+	base->setup();
 
 	// Ensure releasever is set AFTER setup() because setup() might run auto-detection and overwrite it.
 	if (priv->conf != NULL) {
@@ -104,7 +105,7 @@ dnf5_setup_base (PkBackendDnf5Private *priv, gboolean refresh, gboolean force, c
 			distro_version = g_strdup(releasever);
 		}
 		if (distro_version != NULL) {
-			priv->base->get_vars()->set("releasever", distro_version);
+			base->get_vars()->set("releasever", distro_version);
 		}
 	}
 
@@ -115,12 +116,12 @@ dnf5_setup_base (PkBackendDnf5Private *priv, gboolean refresh, gboolean force, c
 		config.get_cacheonly_option().set(libdnf5::Option::Priority::RUNTIME, "all");
 	}
 
-	auto repo_sack = priv->base->get_repo_sack();
+	auto repo_sack = base->get_repo_sack();
 	repo_sack->create_repos_from_system_configuration();
 	repo_sack->get_system_repo();
 
 	if (refresh && force) {
-		libdnf5::repo::RepoQuery query(*priv->base);
+		libdnf5::repo::RepoQuery query(*base);
 		for (auto repo : query) {
 			if (repo->is_enabled()) {
 				g_debug("Expiring repository metadata: %s", repo->get_id().c_str());
@@ -132,11 +133,32 @@ dnf5_setup_base (PkBackendDnf5Private *priv, gboolean refresh, gboolean force, c
 	g_debug("Loading repositories");
 	repo_sack->load_repos();
 
-	libdnf5::repo::RepoQuery query(*priv->base);
+	libdnf5::repo::RepoQuery query(*base);
 	query.filter_enabled(true);
 	for (auto repo : query) {
 		g_debug("Enabled repository: %s", repo->get_id().c_str());
 	}
+	return base;
+}
+
+void
+dnf5_setup_base (PkBackendDnf5Private *priv, gboolean refresh, gboolean force, const char *releasever, gboolean online)
+{
+	priv->base = dnf5_create_base (priv, refresh, force, releasever, online);
+	g_atomic_int_inc (&priv->base_generation);
+}
+
+/* When only the installed packages changed, the metadata of the repos is the
+ * same, so it is loaded from the cache without checking whether it expired */
+std::unique_ptr<libdnf5::Base>
+dnf5_create_base_installed (PkBackendDnf5Private *priv)
+{
+	try {
+		return dnf5_create_base (priv, FALSE, FALSE, nullptr, FALSE);
+	} catch (const std::exception &e) {
+		g_debug ("Failed to load the cached metadata, loading it again: %s", e.what());
+	}
+	return dnf5_create_base (priv);
 }
 
 void
@@ -200,6 +222,66 @@ dnf5_force_distupgrade_on_upgrade (libdnf5::Base &base)
 	return !query.empty();
 }
 
+/*
+ * A prepared plan is only valid while the installed packages are unchanged,
+ * so it is stamped with the mtime and size of the rpmdb.
+ */
+static std::string
+dnf5_get_rpmdb_stamp (libdnf5::Base &base)
+{
+	std::filesystem::path root = base.get_config().get_installroot_option().get_value();
+	const char *paths[] = { "usr/lib/sysimage/rpm/rpmdb.sqlite", "var/lib/rpm/rpmdb.sqlite", "var/lib/rpm/Packages" };
+
+	for (const char *path : paths) {
+		struct stat st;
+		if (stat ((root / path).c_str(), &st) != 0)
+			continue;
+		return std::to_string(st.st_mtim.tv_sec) + "." + std::to_string(st.st_mtim.tv_nsec) + ":" + std::to_string(st.st_size);
+	}
+	return "";
+}
+
+void
+dnf5_save_prepared_plan (libdnf5::Base &base, const libdnf5::base::Transaction &trans, gchar **package_ids)
+{
+	g_autoptr(GError) error = NULL;
+	std::string stamp = dnf5_get_rpmdb_stamp(base);
+
+	if (stamp.empty()) {
+		g_debug ("no rpmdb found, not saving the offline update plan");
+		return;
+	}
+	std::string data = trans.serialize();
+	if (!pk_offline_auth_set_prepared_plan ("dnf5", stamp.c_str(), package_ids, data.c_str(), &error))
+		g_warning ("failed to write offline update plan: %s", error->message);
+}
+
+bool
+dnf5_add_prepared_plan (libdnf5::Base &base, libdnf5::Goal &goal, gchar **package_ids)
+{
+	g_autoptr(GError) error = NULL;
+	g_autofree gchar *data = NULL;
+	std::string stamp = dnf5_get_rpmdb_stamp(base);
+
+	if (stamp.empty())
+		return false;
+	data = pk_offline_get_prepared_plan ("dnf5", stamp.c_str(), package_ids, &error);
+	if (data == NULL) {
+		g_debug ("not using the offline update plan: %s", error->message);
+		return false;
+	}
+
+	/* the goal reads the transaction back from a file */
+	std::filesystem::path path = std::filesystem::path(base.get_config().get_cachedir_option().get_value()) / "prepared-update-plan.json";
+	if (!g_file_set_contents (path.c_str(), data, -1, &error)) {
+		g_warning ("failed to write %s: %s", path.c_str(), error->message);
+		return false;
+	}
+	g_debug ("replaying the offline update plan from %s", path.c_str());
+	goal.add_serialized_transaction(path);
+	return true;
+}
+
 bool
 dnf5_repo_is_devel (const libdnf5::repo::Repo &repo)
 {
@@ -286,42 +368,53 @@ dnf5_package_filter (const libdnf5::rpm::Package &pkg, PkBitfield filters)
 	return true;
 }
 
+/*
+ * Walks the dependencies breadth first. All the reldeps of one level are
+ * resolved with a single query, and the packages already seen are tracked
+ * in a PackageSet, which is a bitmap of solvable IDs.
+ */
 std::vector<libdnf5::rpm::Package>
-dnf5_process_dependency (libdnf5::Base &base, const libdnf5::rpm::Package &pkg, PkRoleEnum role, gboolean recursive)
+dnf5_process_dependency (libdnf5::Base &base, const std::vector<libdnf5::rpm::Package> &pkgs, PkRoleEnum role, gboolean recursive)
 {
 	std::vector<libdnf5::rpm::Package> results;
-	std::set<std::string> visited;
-	std::queue<libdnf5::rpm::Package> queue;
-	queue.push(pkg);
-	visited.insert(pkg.get_name() + ";" + pkg.get_evr() + ";" + pkg.get_arch());
-	
-	while (!queue.empty()) {
-		auto curr = queue.front();
-		queue.pop();
+	libdnf5::rpm::PackageSet visited(base);
+	libdnf5::rpm::PackageSet level(base);
+
+	// only the supported architectures, shared by every level
+	libdnf5::rpm::PackageQuery candidates(base);
+	candidates.filter_arch(libdnf5::rpm::get_supported_arches());
+
+	for (const auto &pkg : pkgs) {
+		visited.add(pkg);
+		level.add(pkg);
+	}
+
+	while (!level.empty()) {
 		libdnf5::rpm::ReldepList reldeps(base);
-		if (role == PK_ROLE_ENUM_DEPENDS_ON) reldeps = curr.get_requires();
-		else reldeps = curr.get_provides();
-		
-		for (const auto &reldep : reldeps) {
-			std::string req = reldep.to_string();
-			libdnf5::rpm::PackageQuery query(base);
-			if (role == PK_ROLE_ENUM_DEPENDS_ON) query.filter_provides(req);
-			else query.filter_requires(req);
-			
-			// Filter for latest version and supported architectures to avoid duplicates
-			// for available packages
-			query.filter_latest_evr();
-			query.filter_arch(libdnf5::rpm::get_supported_arches());
-			
-			for (const auto &res : query) {
-				std::string res_nevra = res.get_name() + ";" + res.get_evr() + ";" + res.get_arch();
-				if (visited.find(res_nevra) == visited.end()) {
-					visited.insert(res_nevra);
-					results.push_back(res);
-					if (recursive) queue.push(res);
-				}
-			}
+		for (const auto &curr : level) {
+			auto deps = role == PK_ROLE_ENUM_DEPENDS_ON ? curr.get_requires() : curr.get_provides();
+			reldeps.append(deps);
 		}
+		if (reldeps.size() == 0)
+			break;
+
+		libdnf5::rpm::PackageQuery query(candidates);
+		if (role == PK_ROLE_ENUM_DEPENDS_ON)
+			query.filter_provides(reldeps);
+		else
+			query.filter_requires(reldeps);
+
+		// Filter for latest version to avoid duplicates for available packages
+		query.filter_latest_evr();
+		query -= visited;
+
+		for (const auto &res : query)
+			results.push_back(res);
+		visited |= query;
+
+		if (!recursive)
+			break;
+		level = query;
 	}
 	return results;
 }
@@ -335,19 +428,8 @@ dnf5_emit_pkg (PkBackendJob *job, const libdnf5::rpm::Package &pkg, PkInfoEnum i
 			info = PK_INFO_ENUM_INSTALLED;
 		}
 	}
-	
-	std::string evr = pkg.get_evr();
-	std::string repo_id = pkg.get_repo_id();
-	if (pkg.get_install_time() > 0) {
-		std::string from_repo = pkg.get_from_repo_id();
-		if (!from_repo.empty()) {
-			repo_id = "installed:" + from_repo;
-		} else {
-			repo_id = "installed";
-		}
-	}
-	
-	std::string package_id = pkg.get_name() + ";" + evr + ";" + pkg.get_arch() + ";" + repo_id;
+
+	std::string package_id = dnf5_package_id(pkg);
 	if (severity != PK_INFO_ENUM_UNKNOWN) {
 		pk_backend_job_package_full (job, info, package_id.c_str(), pkg.get_summary().c_str(), severity);
 	} else {
@@ -358,23 +440,9 @@ dnf5_emit_pkg (PkBackendJob *job, const libdnf5::rpm::Package &pkg, PkInfoEnum i
 void
 dnf5_sort_and_emit (PkBackendJob *job, std::vector<libdnf5::rpm::Package> &pkgs)
 {
-	std::sort(pkgs.begin(), pkgs.end(), [](const libdnf5::rpm::Package &a, const libdnf5::rpm::Package &b) {
-		bool a_installed = (a.get_install_time() > 0);
-		bool b_installed = (b.get_install_time() > 0);
-		if (a_installed != b_installed) return a_installed; 
-		if (a.get_name() != b.get_name()) return a.get_name() < b.get_name();
-		if (a.get_arch() != b.get_arch()) return a.get_arch() < b.get_arch();
-		return a.get_evr() < b.get_evr();
-	});
-
-	std::set<std::string> seen_nevras;
-	for (auto &pkg : pkgs) {
-		std::string nevra = pkg.get_name() + ";" + pkg.get_evr() + ";" + pkg.get_arch();
-		if (seen_nevras.find(nevra) == seen_nevras.end()) {
-			dnf5_emit_pkg(job, pkg);
-			seen_nevras.insert(nevra);
-		}
-	}
+	g_autoptr(GPtrArray) array = dnf5_sort_and_stage(pkgs);
+	if (array->len > 0)
+		pk_backend_job_packages (job, array);
 }
 
 void
@@ -406,83 +474,6 @@ dnf5_apply_filters (libdnf5::Base &base, libdnf5::rpm::PackageQuery &query, PkBi
 	}
 }
 
-std::vector<libdnf5::rpm::Package>
-dnf5_resolve_package_ids(libdnf5::Base &base, gchar **package_ids)
-{
-	std::vector<libdnf5::rpm::Package> pkgs;
-	if (!package_ids) return pkgs;
-	
-	for (int i = 0; package_ids[i] != NULL; i++) {
-		// Check if this is a simple package name (no semicolons) or a full package ID
-		if (strchr(package_ids[i], ';') == NULL) {
-			// Simple package name - search by name and get latest available
-			try {
-				g_debug("Resolving simple package name: %s", package_ids[i]);
-				libdnf5::rpm::PackageQuery query(base);
-				query.filter_name(std::string(package_ids[i]), libdnf5::sack::QueryCmp::EQ);
-				query.filter_available();
-				query.filter_latest_evr();
-				query.filter_arch(libdnf5::rpm::get_supported_arches());
-
-				
-				if (!query.empty()) {
-					for (auto pkg : query) {
-						g_debug("Found package: name=%s, evr=%s, arch=%s, repo=%s",
-							pkg.get_name().c_str(), pkg.get_evr().c_str(), 
-							pkg.get_arch().c_str(), pkg.get_repo_id().c_str());
-						pkgs.push_back(pkg);
-						break; // Take the first match
-					}
-				} else {
-					g_debug("No available package found for name: %s", package_ids[i]);
-				}
-			} catch (const std::exception &e) {
-				g_debug("Exception resolving package name %s: %s", package_ids[i], e.what());
-			}
-			continue;
-		}
-		
-		// Full package ID - use existing logic
-		g_auto(GStrv) split = pk_package_id_split(package_ids[i]);
-		if (!split) continue;
-		
-		try {
-			libdnf5::rpm::PackageQuery query(base);
-			g_debug("Resolving package ID: name=%s, version=%s, arch=%s, repo=%s",
-				split[PK_PACKAGE_ID_NAME], split[PK_PACKAGE_ID_VERSION],
-				split[PK_PACKAGE_ID_ARCH], split[PK_PACKAGE_ID_DATA]);
-			query.filter_name(split[PK_PACKAGE_ID_NAME]);
-			query.filter_evr(split[PK_PACKAGE_ID_VERSION]);
-			query.filter_arch(split[PK_PACKAGE_ID_ARCH]);
-			
-			if (g_str_has_prefix(split[PK_PACKAGE_ID_DATA], "installed")) {
-				query.filter_installed();
-			} else {
-				 query.filter_repo_id(split[PK_PACKAGE_ID_DATA]);
-			}
-			
-			if (query.empty()) {
-				g_debug("No exact match for ID: %s. Listing similar packages...", package_ids[i]);
-				libdnf5::rpm::PackageQuery fallback(base);
-				fallback.filter_name(split[PK_PACKAGE_ID_NAME]);
-				for (const auto &p : fallback) {
-					g_debug("Found similar package: name=%s, evr=%s, arch=%s, repo=%s",
-						p.get_name().c_str(), p.get_evr().c_str(), p.get_arch().c_str(), p.get_repo_id().c_str());
-				}
-			}
-
-			for (auto pkg : query) {
-				pkgs.push_back(pkg);
-				break;
-			}
-		} catch (const std::exception &e) {
-			g_debug("Exception resolving package ID %s: %s", package_ids[i], e.what());
-		}
-	}
-	return pkgs;
-}
-
-
 void
 dnf5_remove_old_cache_directories (PkBackend *backend, const gchar *release_ver)
 {
@@ -22,6 +22,8 @@
 
 #include <pk-backend.h>
 #include <libdnf5/base/base.hpp>
+#include <libdnf5/base/goal.hpp>
+#include <libdnf5/base/transaction.hpp>
 #include <libdnf5/rpm/package_query.hpp>
 #include <libdnf5/repo/repo_query.hpp>
 #include <libdnf5/repo/download_callbacks.hpp>
@@ -38,25 +40,36 @@ typedef struct {
 	GKeyFile *conf;
 	GMutex mutex;
 	gint64 last_notification_timestamp;
+	/* the base is rebuilt in a thread and swapped in when ready */
+	GMutex rebuild_mutex;
+	GCond rebuild_cond;
+	gboolean rebuild_running;
+	gboolean rebuild_pending;
+	/* bumped whenever base is replaced, so a rebuild can tell that its
+	 * base is older than the one a job put there meanwhile */
+	gint base_generation;
 } PkBackendDnf5Private;
 
+std::unique_ptr<libdnf5::Base> dnf5_create_base(PkBackendDnf5Private *priv, gboolean refresh = FALSE, gboolean force = FALSE, const char *releasever = nullptr, gboolean online = TRUE);
+std::unique_ptr<libdnf5::Base> dnf5_create_base_installed(PkBackendDnf5Private *priv);
 void dnf5_setup_base(PkBackendDnf5Private *priv, gboolean refresh = FALSE, gboolean force = FALSE, const char *releasever = nullptr, gboolean online = TRUE);
 void dnf5_update_network_state(PkBackendDnf5Private *priv, gboolean online);
 void dnf5_refresh_cache(PkBackendDnf5Private *priv, gboolean force);
 PkInfoEnum dnf5_advisory_kind_to_info_enum(const std::string &type);
 PkInfoEnum dnf5_update_severity_to_enum(const std::string &severity);
 bool dnf5_force_distupgrade_on_upgrade(libdnf5::Base &base);
+void dnf5_save_prepared_plan(libdnf5::Base &base, const libdnf5::base::Transaction &trans, gchar **package_ids);
+bool dnf5_add_prepared_plan(libdnf5::Base &base, libdnf5::Goal &goal, gchar **package_ids);
 bool dnf5_repo_is_devel(const libdnf5::repo::Repo &repo);
 bool dnf5_repo_is_source(const libdnf5::repo::Repo &repo);
 bool dnf5_repo_is_supported(const libdnf5::repo::Repo &repo);
 bool dnf5_backend_pk_repo_filter(const libdnf5::repo::Repo &repo, PkBitfield filters);
 bool dnf5_package_is_gui(const libdnf5::rpm::Package &pkg);
 bool dnf5_package_filter(const libdnf5::rpm::Package &pkg, PkBitfield filters);
-std::vector<libdnf5::rpm::Package> dnf5_process_dependency(libdnf5::Base &base, const libdnf5::rpm::Package &pkg, PkRoleEnum role, gboolean recursive);
+std::vector<libdnf5::rpm::Package> dnf5_process_dependency(libdnf5::Base &base, const std::vector<libdnf5::rpm::Package> &pkgs, PkRoleEnum role, gboolean recursive);
 void dnf5_emit_pkg(PkBackendJob *job, const libdnf5::rpm::Package &pkg, PkInfoEnum info = PK_INFO_ENUM_UNKNOWN, PkInfoEnum severity = PK_INFO_ENUM_UNKNOWN);
 void dnf5_sort_and_emit(PkBackendJob *job, std::vector<libdnf5::rpm::Package> &pkgs);
 void dnf5_apply_filters(libdnf5::Base &base, libdnf5::rpm::PackageQuery &query, PkBitfield filters);
-std::vector<libdnf5::rpm::Package> dnf5_resolve_package_ids(libdnf5::Base &base, gchar **package_ids);
 void dnf5_remove_old_cache_directories(PkBackend *backend, const gchar *release_ver);
 
 class Dnf5DownloadCallbacks : public libdnf5::repo::DownloadCallbacks {
@@ -0,0 +1,153 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2026 PackageKit Authors
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Compares the time taken to sort, deduplicate and convert a list of
+ * packages into PkPackage objects, using the previous implementation of
+ * dnf5_sort_and_emit() and dnf5_sort_and_stage(). The packages come from a
+ * synthetic libsolv testcase repository, the size of which is set using the
+ * PK_BENCH_PACKAGES environment variable.
+ */
+
+#include "dnf5-backend-emit.hpp"
+#include <libdnf5/base/base.hpp>
+#include <libdnf5/rpm/package_query.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <set>
+
+#define DNF5_BENCH_DEFAULT_PACKAGES	100000
+
+/* the implementation this replaced, kept as a reference point */
+static GPtrArray *
+dnf5_bench_sort_and_stage_old (std::vector<libdnf5::rpm::Package> &pkgs)
+{
+	GPtrArray *array = g_ptr_array_new_with_free_func((GDestroyNotify) g_object_unref);
+
+	std::sort(pkgs.begin(), pkgs.end(), [](const libdnf5::rpm::Package &a, const libdnf5::rpm::Package &b) {
+		bool a_installed = (a.get_install_time() > 0);
+		bool b_installed = (b.get_install_time() > 0);
+		if (a_installed != b_installed) return a_installed;
+		if (a.get_name() != b.get_name()) return a.get_name() < b.get_name();
+		if (a.get_arch() != b.get_arch()) return a.get_arch() < b.get_arch();
+		return a.get_evr() < b.get_evr();
+	});
+
+	std::set<std::string> seen_nevras;
+	for (auto &pkg : pkgs) {
+		std::string nevra = pkg.get_name() + ";" + pkg.get_evr() + ";" + pkg.get_arch();
+		if (seen_nevras.find(nevra) != seen_nevras.end())
+			continue;
+		seen_nevras.insert(nevra);
+
+		std::string repo_id = pkg.get_repo_id();
+		if (pkg.get_install_time() > 0) {
+			std::string from_repo = pkg.get_from_repo_id();
+			repo_id = from_repo.empty() ? "installed" : "installed:" + from_repo;
+		}
+		std::string package_id = pkg.get_name() + ";" + pkg.get_evr() + ";" + pkg.get_arch() + ";" + repo_id;
+		g_autoptr(PkPackage) package = pk_package_new();
+		if (!pk_package_set_id(package, package_id.c_str(), NULL))
+			continue;
+		pk_package_set_info(package, pkg.get_install_time() > 0 ? PK_INFO_ENUM_INSTALLED : PK_INFO_ENUM_AVAILABLE);
+		pk_package_set_summary(package, pkg.get_summary().c_str());
+		g_ptr_array_add(array, g_steal_pointer(&package));
+	}
+	return array;
+}
+
+static void
+dnf5_bench_write_testcase (const std::string &path, guint count)
+{
+	std::ofstream out(path);
+
+	out << "=Ver: 3.0\n";
+	for (guint i = 0; i < count; i++) {
+		/* a few versions of each name, in no particular order */
+		out << "=Pkg: package" << (i * 7919) % count / 3 << " " << 1 + i % 3 << ".0 1 x86_64\n";
+		out << "=Sum: Synthetic package number " << i << "\n";
+	}
+}
+
+int
+main (int argc, char *argv[])
+{
+	g_autoptr(GError) error = NULL;
+	g_autofree gchar *tmpdir = NULL;
+	g_autofree gchar *testcase = NULL;
+	guint count = DNF5_BENCH_DEFAULT_PACKAGES;
+	const gchar *count_str = g_getenv("PK_BENCH_PACKAGES");
+	gint64 start;
+	gint64 elapsed_old;
+	gint64 elapsed_new;
+	guint len_old;
+	guint len_new;
+
+	if (count_str != NULL)
+		count = MAX(g_ascii_strtoull(count_str, NULL, 10), 1);
+
+	tmpdir = g_dir_make_tmp("pk-dnf5-bench-XXXXXX", &error);
+	if (tmpdir == NULL) {
+		g_printerr("failed to create a temporary directory: %s\n", error->message);
+		return EXIT_FAILURE;
+	}
+	testcase = g_build_filename(tmpdir, "synthetic.repo", NULL);
+	dnf5_bench_write_testcase(testcase, count);
+
+	libdnf5::Base base;
+	base.get_config().get_installroot_option().set(tmpdir);
+	base.get_config().get_cachedir_option().set(tmpdir);
+	base.setup();
+	base.get_repo_sack()->create_repo_from_libsolv_testcase("synthetic", testcase);
+
+	std::vector<libdnf5::rpm::Package> pkgs;
+	libdnf5::rpm::PackageQuery query(base);
+	pkgs.reserve(query.size() + query.size() / 10);
+	for (const auto &pkg : query)
+		pkgs.push_back(pkg);
+
+	/* results which were merged from several queries contain duplicates */
+	for (std::size_t i = 0; i < query.size(); i += 10)
+		pkgs.push_back(pkgs[i]);
+
+	std::vector<libdnf5::rpm::Package> pkgs_old = pkgs;
+	start = g_get_monotonic_time();
+	g_autoptr(GPtrArray) array_old = dnf5_bench_sort_and_stage_old(pkgs_old);
+	elapsed_old = g_get_monotonic_time() - start;
+	len_old = array_old->len;
+
+	start = g_get_monotonic_time();
+	g_autoptr(GPtrArray) array_new = dnf5_sort_and_stage(pkgs);
+	elapsed_new = g_get_monotonic_time() - start;
+	len_new = array_new->len;
+
+	g_print("%zu packages, %u unique\n", pkgs.size(), len_new);
+	g_print("old: %" G_GINT64_FORMAT " ms\n", elapsed_old / 1000);
+	g_print("new: %" G_GINT64_FORMAT " ms\n", elapsed_new / 1000);
+
+	std::filesystem::remove_all(tmpdir);
+
+	if (len_old != len_new) {
+		g_printerr("old and new emitted %u and %u packages\n", len_old, len_new);
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,134 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2026 PackageKit Authors
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Compares the time taken to resolve package IDs using the previous
+ * implementation of dnf5_resolve_package_ids(), which ran a query for each
+ * ID. What the IDs resolve to is checked by dnf5-test-resolve. The packages
+ * come from a synthetic libsolv testcase repository, the size of which is
+ * set using the PK_BENCH_PACKAGES environment variable.
+ */
+
+#include "dnf5-backend-emit.hpp"
+#include "dnf5-backend-resolve.hpp"
+#include <libdnf5/rpm/package_query.hpp>
+#include <filesystem>
+#include <fstream>
+
+#define DNF5_BENCH_DEFAULT_PACKAGES	10000
+
+/* the implementation this replaced, kept as a reference point */
+static std::vector<libdnf5::rpm::Package>
+dnf5_bench_resolve_package_ids_old (libdnf5::Base &base, gchar **package_ids)
+{
+	std::vector<libdnf5::rpm::Package> pkgs;
+
+	for (int i = 0; package_ids[i] != NULL; i++) {
+		g_auto(GStrv) split = pk_package_id_split(package_ids[i]);
+		if (!split) continue;
+
+		libdnf5::rpm::PackageQuery query(base);
+		query.filter_name(split[PK_PACKAGE_ID_NAME]);
+		query.filter_evr(split[PK_PACKAGE_ID_VERSION]);
+		query.filter_arch(split[PK_PACKAGE_ID_ARCH]);
+		if (g_str_has_prefix(split[PK_PACKAGE_ID_DATA], "installed"))
+			query.filter_installed();
+		else
+			query.filter_repo_id(split[PK_PACKAGE_ID_DATA]);
+		for (auto pkg : query) {
+			pkgs.push_back(pkg);
+			break;
+		}
+	}
+	return pkgs;
+}
+
+static void
+dnf5_bench_write_testcase (const std::string &path, guint count)
+{
+	std::ofstream out(path);
+
+	out << "=Ver: 3.0\n";
+	for (guint i = 0; i < count; i++) {
+		/* a few versions and arches of each name */
+		out << "=Pkg: package" << i / 4 << " " << 1 + i % 2 << ".0 1 " << (i % 4 < 2 ? "x86_64" : "noarch") << "\n";
+		out << "=Sum: Synthetic package number " << i << "\n";
+	}
+}
+
+int
+main (int argc, char *argv[])
+{
+	g_autoptr(GError) error = NULL;
+	g_autofree gchar *tmpdir = NULL;
+	g_autofree gchar *testcase = NULL;
+	g_autoptr(GPtrArray) package_ids = g_ptr_array_new_with_free_func(g_free);
+	guint count = DNF5_BENCH_DEFAULT_PACKAGES;
+	const gchar *count_str = g_getenv("PK_BENCH_PACKAGES");
+	gint64 start;
+	gint64 elapsed_old;
+	gint64 elapsed_new;
+
+	if (count_str != NULL)
+		count = MAX(g_ascii_strtoull(count_str, NULL, 10), 1);
+
+	tmpdir = g_dir_make_tmp("pk-dnf5-bench-XXXXXX", &error);
+	if (tmpdir == NULL) {
+		g_printerr("failed to create a temporary directory: %s\n", error->message);
+		return EXIT_FAILURE;
+	}
+	testcase = g_build_filename(tmpdir, "synthetic.repo", NULL);
+	dnf5_bench_write_testcase(testcase, count);
+
+	libdnf5::Base base;
+	base.get_config().get_installroot_option().set(tmpdir);
+	base.get_config().get_cachedir_option().set(tmpdir);
+	base.setup();
+	base.get_repo_sack()->create_repo_from_libsolv_testcase("synthetic", testcase);
+
+	/* every other package, and some which do not exist */
+	libdnf5::rpm::PackageQuery query(base);
+	guint i = 0;
+	for (const auto &pkg : query) {
+		if (i++ % 2 == 0)
+			g_ptr_array_add(package_ids, g_strdup(dnf5_package_id(pkg).c_str()));
+	}
+	g_ptr_array_add(package_ids, g_strdup("package0;9.0-1;x86_64;synthetic"));
+	g_ptr_array_add(package_ids, g_strdup("package0;1.0-1;x86_64;other"));
+	g_ptr_array_add(package_ids, g_strdup("package0;1.0-1;x86_64;installed"));
+	g_ptr_array_add(package_ids, g_strdup("missing;1.0-1;x86_64;synthetic"));
+	g_ptr_array_add(package_ids, g_strdup("invalid;1.0-1"));
+	g_ptr_array_add(package_ids, NULL);
+
+	start = g_get_monotonic_time();
+	auto pkgs_old = dnf5_bench_resolve_package_ids_old(base, (gchar **) package_ids->pdata);
+	elapsed_old = g_get_monotonic_time() - start;
+
+	start = g_get_monotonic_time();
+	auto pkgs_new = dnf5_resolve_package_ids(base, (gchar **) package_ids->pdata);
+	elapsed_new = g_get_monotonic_time() - start;
+
+	g_print("%u package IDs, %zu resolved\n", package_ids->len - 1, pkgs_new.size());
+	g_print("old: %" G_GINT64_FORMAT " ms\n", elapsed_old / 1000);
+	g_print("new: %" G_GINT64_FORMAT " ms\n", elapsed_new / 1000);
+
+	std::filesystem::remove_all(tmpdir);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,103 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2026 PackageKit Authors
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "dnf5-backend-emit.hpp"
+#include "dnf5-backend-resolve.hpp"
+#include <filesystem>
+#include <fstream>
+
+static void
+dnf5_test_write_testcase (const std::string &path, const gchar *contents)
+{
+	std::ofstream out(path);
+	out << "=Ver: 3.0\n" << contents;
+}
+
+static void
+dnf5_test_resolve (void)
+{
+	g_autoptr(GError) error = NULL;
+	g_autofree gchar *tmpdir = NULL;
+	g_autofree gchar *testcase_synthetic = NULL;
+	g_autofree gchar *testcase_other = NULL;
+	const gchar *package_ids[] = {
+		"hello;2.0-1;x86_64;synthetic",
+		/* the same name and version in a different repo */
+		"world;2.0-1;x86_64;other",
+		/* in a repo, but not in this one */
+		"world;1.0-1;x86_64;other",
+		/* not installed */
+		"hello;1.0-1;x86_64;installed",
+		/* no such version, or no such package */
+		"hello;9.0-1;x86_64;synthetic",
+		"missing;1.0-1;x86_64;synthetic",
+		/* not a package ID */
+		"invalid;1.0-1",
+		";1.0-1;x86_64;synthetic",
+		"hello;1.0-1;noarch;synthetic",
+		NULL,
+	};
+	const gchar *expected[] = {
+		"hello;2.0-1;x86_64;synthetic",
+		"world;2.0-1;x86_64;other",
+		"hello;1.0-1;noarch;synthetic",
+	};
+
+	tmpdir = g_dir_make_tmp("pk-dnf5-test-XXXXXX", &error);
+	g_assert_no_error(error);
+	testcase_synthetic = g_build_filename(tmpdir, "synthetic.repo", NULL);
+	dnf5_test_write_testcase(testcase_synthetic,
+				 "=Pkg: hello 1.0 1 x86_64\n"
+				 "=Pkg: hello 2.0 1 x86_64\n"
+				 "=Pkg: hello 1.0 1 noarch\n"
+				 "=Pkg: world 1.0 1 x86_64\n"
+				 "=Pkg: world 2.0 1 x86_64\n");
+	testcase_other = g_build_filename(tmpdir, "other.repo", NULL);
+	dnf5_test_write_testcase(testcase_other, "=Pkg: world 2.0 1 x86_64\n");
+
+	libdnf5::Base base;
+	base.get_config().get_installroot_option().set(tmpdir);
+	base.get_config().get_cachedir_option().set(tmpdir);
+	base.setup();
+	base.get_repo_sack()->create_repo_from_libsolv_testcase("synthetic", testcase_synthetic);
+	base.get_repo_sack()->create_repo_from_libsolv_testcase("other", testcase_other);
+
+	/* the ones which match exactly, in the order they were asked for */
+	auto pkgs = dnf5_resolve_package_ids(base, (gchar **) package_ids);
+	g_assert_cmpuint(pkgs.size(), ==, G_N_ELEMENTS(expected));
+	for (guint i = 0; i < G_N_ELEMENTS(expected); i++)
+		g_assert_cmpstr(dnf5_package_id(pkgs[i]).c_str(), ==, expected[i]);
+
+	/* nothing to resolve */
+	g_assert_true(dnf5_resolve_package_ids(base, NULL).empty());
+
+	std::filesystem::remove_all(tmpdir);
+}
+
+int
+main (int argc, char *argv[])
+{
+	g_test_init(&argc, &argv, NULL);
+
+	/* tests go here */
+	g_test_add_func("/dnf5/resolve", dnf5_test_resolve);
+
+	return g_test_run();
+}
@@ -102,6 +102,50 @@ pk_backend_dnf5_inhibit_notify (PkBackend *backend)
 	return 0;
 }
 
+static void
+pk_backend_dnf5_rebuild_thread (GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable)
+{
+	PkBackendDnf5Private *priv = (PkBackendDnf5Private *) task_data;
+
+	while (TRUE) {
+		std::unique_ptr<libdnf5::Base> base;
+		gint generation = g_atomic_int_get (&priv->base_generation);
+
+		/* queries keep using the old base while this one is built */
+		try {
+			base = dnf5_create_base_installed (priv);
+		} catch (const std::exception &e) {
+			g_warning ("Failed to invalidate dnf5 base: %s", e.what());
+		}
+
+		if (base) {
+			g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&priv->mutex);
+
+			/* a transaction or RefreshCache replaced it meanwhile, and
+			 * that base is at least as new as this one */
+			if (g_atomic_int_get (&priv->base_generation) == generation) {
+				priv->base.swap (base);
+				g_atomic_int_inc (&priv->base_generation);
+				priv->last_notification_timestamp = g_get_monotonic_time ();
+			} else {
+				g_debug ("dropping the rebuilt dnf5 base, it was replaced meanwhile");
+			}
+		}
+
+		/* the old base is freed here, outside of the lock */
+		base.reset ();
+
+		/* the rpmdb changed again while the base was built */
+		g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&priv->rebuild_mutex);
+		if (!priv->rebuild_pending) {
+			priv->rebuild_running = FALSE;
+			g_cond_broadcast (&priv->rebuild_cond);
+			break;
+		}
+		priv->rebuild_pending = FALSE;
+	}
+}
+
 static void
 pk_backend_context_invalidate_cb (PkBackend *backend, PkBackend *backend_data)
 {
@@ -112,14 +156,17 @@ pk_backend_context_invalidate_cb (PkBackend *backend, PkBackend *backend_data)
 	if (pk_backend_dnf5_inhibit_notify (backend)) return;
 
 	PkBackendDnf5Private *priv = (PkBackendDnf5Private *) pk_backend_get_user_data (backend);
-	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&priv->mutex);
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&priv->rebuild_mutex);
 
-	try {
-		dnf5_setup_base (priv);
-		priv->last_notification_timestamp = g_get_monotonic_time ();
-	} catch (const std::exception &e) {
-		g_warning ("Failed to invalidate dnf5 base: %s", e.what());
+	if (priv->rebuild_running) {
+		priv->rebuild_pending = TRUE;
+		return;
 	}
+	priv->rebuild_running = TRUE;
+
+	g_autoptr(GTask) task = g_task_new (backend, NULL, NULL, NULL);
+	g_task_set_task_data (task, priv, NULL);
+	g_task_run_in_thread (task, pk_backend_dnf5_rebuild_thread);
 }
 
 void
@@ -140,6 +187,8 @@ pk_backend_initialize (GKeyFile *conf, PkBackend *backend)
 		 LIBDNF5_VERSION_PATCH);
 
 	g_mutex_init (&priv->mutex);
+	g_mutex_init (&priv->rebuild_mutex);
+	g_cond_init (&priv->rebuild_cond);
 	priv->conf = g_key_file_ref (conf);
 	priv->last_notification_timestamp = 0;
 
@@ -166,10 +215,20 @@ void
 pk_backend_destroy (PkBackend *backend)
 {
 	PkBackendDnf5Private *priv = (PkBackendDnf5Private *) pk_backend_get_user_data (backend);
+
+	/* wait for a rebuild of the base to finish */
+	g_mutex_lock (&priv->rebuild_mutex);
+	priv->rebuild_pending = FALSE;
+	while (priv->rebuild_running)
+		g_cond_wait (&priv->rebuild_cond, &priv->rebuild_mutex);
+	g_mutex_unlock (&priv->rebuild_mutex);
+
 	priv->base.reset();
 	if (priv->conf != NULL)
 		g_key_file_unref (priv->conf);
 	g_mutex_clear (&priv->mutex);
+	g_mutex_clear (&priv->rebuild_mutex);
+	g_cond_clear (&priv->rebuild_cond);
 	g_free (priv);
 }
 
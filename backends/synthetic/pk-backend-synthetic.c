@@ -0,0 +1,483 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2026 PackageKit Authors
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * This backend generates large result sets as fast as it can, without any
+ * artificial delays, so that the overhead of the daemon and of the client
+ * library can be measured on their own. The size of the result sets is set
+ * using environment variables when the daemon is started:
+ *
+ *  PK_SYNTHETIC_PACKAGES:	the number of packages in the fake database
+ *  PK_SYNTHETIC_FILES:		the number of files in each package
+ *  PK_SYNTHETIC_BATCHED:	if 0, emit packages, details and files one at a time
+ *
+ * Packages with an even index are installed, and packages with an index
+ * divisible by four have an update available.
+ */
+
+#include <gmodule.h>
+#include <glib.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include <pk-backend.h>
+#include <pk-backend-job.h>
+
+#define PK_SYNTHETIC_DEFAULT_PACKAGES	1000
+#define PK_SYNTHETIC_DEFAULT_FILES	10
+#define PK_SYNTHETIC_NAME_PREFIX	"synthetic-"
+
+typedef struct
+{
+	guint n_packages;
+	guint n_files;
+	gboolean batched;
+} PkBackendSyntheticPrivate;
+
+static PkBackendSyntheticPrivate *priv;
+
+static guint
+pk_backend_synthetic_get_env_uint (const gchar *key, guint default_value)
+{
+	const gchar *tmp = g_getenv (key);
+	guint64 value;
+
+	if (tmp == NULL)
+		return default_value;
+	if (!g_ascii_string_to_unsigned (tmp, 10, 0, G_MAXUINT, &value, NULL)) {
+		g_warning ("ignoring invalid value %s for %s", tmp, key);
+		return default_value;
+	}
+	return (guint) value;
+}
+
+void
+pk_backend_initialize (GKeyFile *conf, PkBackend *backend)
+{
+	priv = g_new0 (PkBackendSyntheticPrivate, 1);
+	priv->n_packages = pk_backend_synthetic_get_env_uint ("PK_SYNTHETIC_PACKAGES",
+							      PK_SYNTHETIC_DEFAULT_PACKAGES);
+	priv->n_files = pk_backend_synthetic_get_env_uint ("PK_SYNTHETIC_FILES",
+							   PK_SYNTHETIC_DEFAULT_FILES);
+	priv->batched = pk_backend_synthetic_get_env_uint ("PK_SYNTHETIC_BATCHED", 1) > 0;
+	g_debug ("synthetic backend with %u packages of %u files",
+		 priv->n_packages,
+		 priv->n_files);
+}
+
+void
+pk_backend_destroy (PkBackend *backend)
+{
+	g_free (priv);
+}
+
+PkBitfield
+pk_backend_get_groups (PkBackend *backend)
+{
+	return pk_bitfield_from_enums (PK_GROUP_ENUM_SYSTEM, -1);
+}
+
+PkBitfield
+pk_backend_get_filters (PkBackend *backend)
+{
+	return pk_bitfield_from_enums (PK_FILTER_ENUM_INSTALLED, -1);
+}
+
+gchar **
+pk_backend_get_mime_types (PkBackend *backend)
+{
+	const gchar *mime_types[] = { NULL };
+	return g_strdupv ((gchar **) mime_types);
+}
+
+static gboolean
+pk_backend_synthetic_is_installed (guint idx)
+{
+	return idx % 2 == 0;
+}
+
+static gboolean
+pk_backend_synthetic_has_update (guint idx)
+{
+	return idx % 4 == 0;
+}
+
+static gchar *
+pk_backend_synthetic_build_package_id (guint idx, gboolean update)
+{
+	return g_strdup_printf (PK_SYNTHETIC_NAME_PREFIX "%06u;1.%u-%u;x86_64;%s",
+				idx,
+				idx % 100,
+				update ? 2 : 1,
+				!update && pk_backend_synthetic_is_installed (idx) ? "installed" : "synthetic");
+}
+
+/* accepts both a package name and a package-id */
+static gboolean
+pk_backend_synthetic_parse_index (const gchar *value, guint *idx)
+{
+	guint64 tmp;
+	gchar *endptr = NULL;
+
+	if (!g_str_has_prefix (value, PK_SYNTHETIC_NAME_PREFIX))
+		return FALSE;
+	value += strlen (PK_SYNTHETIC_NAME_PREFIX);
+	tmp = g_ascii_strtoull (value, &endptr, 10);
+	if (endptr == value || (*endptr != '\0' && *endptr != ';'))
+		return FALSE;
+	if (tmp >= priv->n_packages)
+		return FALSE;
+	*idx = (guint) tmp;
+	return TRUE;
+}
+
+static gboolean
+pk_backend_synthetic_filter_match (PkBitfield filters, guint idx)
+{
+	gboolean installed = pk_backend_synthetic_is_installed (idx);
+	if (pk_bitfield_contain (filters, PK_FILTER_ENUM_INSTALLED) && !installed)
+		return FALSE;
+	if (pk_bitfield_contain (filters, PK_FILTER_ENUM_NOT_INSTALLED) && installed)
+		return FALSE;
+	return TRUE;
+}
+
+typedef struct {
+	PkBackendJob *job;
+	GPtrArray *packages;
+} PkBackendSyntheticEmitter;
+
+static void
+pk_backend_synthetic_emitter_init (PkBackendSyntheticEmitter *emitter, PkBackendJob *job)
+{
+	emitter->job = job;
+	emitter->packages = priv->batched ? g_ptr_array_new_with_free_func (g_object_unref) : NULL;
+}
+
+static void
+pk_backend_synthetic_emitter_add (PkBackendSyntheticEmitter *emitter,
+				  guint idx,
+				  PkInfoEnum info,
+				  gboolean update)
+{
+	g_autofree gchar *package_id = pk_backend_synthetic_build_package_id (idx, update);
+	g_autofree gchar *summary = g_strdup_printf ("Synthetic package number %u", idx);
+	PkPackage *package;
+
+	if (emitter->packages == NULL) {
+		pk_backend_job_package (emitter->job, info, package_id, summary);
+		return;
+	}
+	package = pk_package_new ();
+	pk_package_set_id (package, package_id, NULL);
+	pk_package_set_info (package, info);
+	pk_package_set_summary (package, summary);
+	g_ptr_array_add (emitter->packages, package);
+}
+
+static void
+pk_backend_synthetic_emitter_flush (PkBackendSyntheticEmitter *emitter)
+{
+	if (emitter->packages == NULL)
+		return;
+	if (emitter->packages->len > 0)
+		pk_backend_job_packages (emitter->job, emitter->packages);
+	g_ptr_array_unref (emitter->packages);
+	emitter->packages = NULL;
+}
+
+static void
+pk_backend_synthetic_add_installed_or_available (PkBackendSyntheticEmitter *emitter, guint idx)
+{
+	pk_backend_synthetic_emitter_add (emitter,
+					  idx,
+					  pk_backend_synthetic_is_installed (idx) ? PK_INFO_ENUM_INSTALLED
+										  : PK_INFO_ENUM_AVAILABLE,
+					  FALSE);
+}
+
+static void
+pk_backend_synthetic_get_packages_thread (PkBackendJob *job, GVariant *params, gpointer user_data)
+{
+	PkBackendSyntheticEmitter emitter;
+	PkBitfield filters;
+
+	g_variant_get (params, "(t)", &filters);
+	pk_backend_job_set_status (job, PK_STATUS_ENUM_QUERY);
+	pk_backend_synthetic_emitter_init (&emitter, job);
+	for (guint i = 0; i < priv->n_packages; i++) {
+		if (!pk_backend_synthetic_filter_match (filters, i))
+			continue;
+		pk_backend_synthetic_add_installed_or_available (&emitter, i);
+	}
+	pk_backend_synthetic_emitter_flush (&emitter);
+}
+
+void
+pk_backend_get_packages (PkBackend *backend, PkBackendJob *job, PkBitfield filters)
+{
+	pk_backend_job_thread_create (job, pk_backend_synthetic_get_packages_thread, NULL, NULL);
+}
+
+/* used for Resolve, and the search roles, where any value that contains
+ * the search term matches */
+static void
+pk_backend_synthetic_search_thread (PkBackendJob *job, GVariant *params, gpointer user_data)
+{
+	PkBackendSyntheticEmitter emitter;
+	PkBitfield filters;
+	PkRoleEnum role = pk_backend_job_get_role (job);
+	g_autofree gchar **values = NULL;
+
+	g_variant_get (params, "(t^a&s)", &filters, &values);
+	pk_backend_job_set_status (job, PK_STATUS_ENUM_QUERY);
+	pk_backend_synthetic_emitter_init (&emitter, job);
+
+	/* exact matches only */
+	if (role == PK_ROLE_ENUM_RESOLVE) {
+		for (guint j = 0; values[j] != NULL; j++) {
+			guint idx;
+			if (!pk_backend_synthetic_parse_index (values[j], &idx))
+				continue;
+			if (!pk_backend_synthetic_filter_match (filters, idx))
+				continue;
+			pk_backend_synthetic_add_installed_or_available (&emitter, idx);
+		}
+		pk_backend_synthetic_emitter_flush (&emitter);
+		return;
+	}
+
+	for (guint i = 0; i < priv->n_packages; i++) {
+		g_autofree gchar *name = NULL;
+		gboolean matches = FALSE;
+
+		if (!pk_backend_synthetic_filter_match (filters, i))
+			continue;
+		name = g_strdup_printf (PK_SYNTHETIC_NAME_PREFIX "%06u", i);
+		for (guint j = 0; values[j] != NULL && !matches; j++)
+			matches = strstr (name, values[j]) != NULL;
+		if (matches)
+			pk_backend_synthetic_add_installed_or_available (&emitter, i);
+	}
+	pk_backend_synthetic_emitter_flush (&emitter);
+}
+
+void
+pk_backend_resolve (PkBackend *backend, PkBackendJob *job, PkBitfield filters, gchar **package_ids)
+{
+	pk_backend_job_thread_create (job, pk_backend_synthetic_search_thread, NULL, NULL);
+}
+
+void
+pk_backend_search_names (PkBackend *backend, PkBackendJob *job, PkBitfield filters, gchar **values)
+{
+	pk_backend_job_thread_create (job, pk_backend_synthetic_search_thread, NULL, NULL);
+}
+
+void
+pk_backend_search_details (PkBackend *backend, PkBackendJob *job, PkBitfield filters, gchar **values)
+{
+	pk_backend_job_thread_create (job, pk_backend_synthetic_search_thread, NULL, NULL);
+}
+
+void
+pk_backend_search_files (PkBackend *backend, PkBackendJob *job, PkBitfield filters, gchar **values)
+{
+	pk_backend_job_thread_create (job, pk_backend_synthetic_search_thread, NULL, NULL);
+}
+
+static void
+pk_backend_synthetic_get_updates_thread (PkBackendJob *job, GVariant *params, gpointer user_data)
+{
+	PkBackendSyntheticEmitter emitter;
+
+	pk_backend_job_set_status (job, PK_STATUS_ENUM_QUERY);
+	pk_backend_synthetic_emitter_init (&emitter, job);
+	for (guint i = 0; i < priv->n_packages; i++) {
+		if (!pk_backend_synthetic_has_update (i))
+			continue;
+		pk_backend_synthetic_emitter_add (&emitter, i, PK_INFO_ENUM_NORMAL, TRUE);
+	}
+	pk_backend_synthetic_emitter_flush (&emitter);
+}
+
+void
+pk_backend_get_updates (PkBackend *backend, PkBackendJob *job, PkBitfield filters)
+{
+	pk_backend_job_thread_create (job, pk_backend_synthetic_get_updates_thread, NULL, NULL);
+}
+
+static void
+pk_backend_synthetic_get_details_thread (PkBackendJob *job, GVariant *params, gpointer user_data)
+{
+	g_autofree gchar **package_ids = NULL;
+	g_autoptr(GPtrArray) details = NULL;
+
+	g_variant_get (params, "(^a&s)", &package_ids);
+	pk_backend_job_set_status (job, PK_STATUS_ENUM_QUERY);
+	details = g_ptr_array_new_with_free_func (g_object_unref);
+	for (guint i = 0; package_ids[i] != NULL; i++) {
+		g_autofree gchar *summary = NULL;
+		g_autofree gchar *description = NULL;
+		PkDetails *item;
+		guint idx;
+
+		if (!pk_backend_synthetic_parse_index (package_ids[i], &idx))
+			continue;
+		summary = g_strdup_printf ("Synthetic package number %u", idx);
+		description = g_strdup_printf ("This is synthetic package number %u, which is "
+					       "used to measure the performance of PackageKit.",
+					       idx);
+		if (!priv->batched) {
+			pk_backend_job_details (job,
+						package_ids[i],
+						summary,
+						"GPL-2.0-or-later",
+						PK_GROUP_ENUM_SYSTEM,
+						description,
+						"https://www.freedesktop.org/software/PackageKit/",
+						1024 * (idx + 1),
+						512 * (idx + 1));
+			continue;
+		}
+		item = pk_details_new ();
+		g_object_set (item,
+			      "package-id", package_ids[i],
+			      "summary", summary,
+			      "license", "GPL-2.0-or-later",
+			      "group", PK_GROUP_ENUM_SYSTEM,
+			      "description", description,
+			      "url", "https://www.freedesktop.org/software/PackageKit/",
+			      "size", (guint64) 1024 * (idx + 1),
+			      "download-size", (guint64) 512 * (idx + 1),
+			      NULL);
+		g_ptr_array_add (details, item);
+	}
+	pk_backend_job_details_list (job, details);
+}
+
+void
+pk_backend_get_details (PkBackend *backend, PkBackendJob *job, gchar **package_ids)
+{
+	pk_backend_job_thread_create (job, pk_backend_synthetic_get_details_thread, NULL, NULL);
+}
+
+static void
+pk_backend_synthetic_get_files_thread (PkBackendJob *job, GVariant *params, gpointer user_data)
+{
+	g_autofree gchar **package_ids = NULL;
+	g_autoptr(GPtrArray) files_array = NULL;
+
+	g_variant_get (params, "(^a&s)", &package_ids);
+	pk_backend_job_set_status (job, PK_STATUS_ENUM_QUERY);
+	files_array = g_ptr_array_new_with_free_func (g_object_unref);
+	for (guint i = 0; package_ids[i] != NULL; i++) {
+		g_auto(GStrv) files = NULL;
+		PkFiles *item;
+		guint idx;
+
+		if (!pk_backend_synthetic_parse_index (package_ids[i], &idx))
+			continue;
+		files = g_new0 (gchar *, priv->n_files + 1);
+		for (guint j = 0; j < priv->n_files; j++)
+			files[j] = g_strdup_printf ("/usr/share/synthetic/%06u/file-%u", idx, j);
+		if (!priv->batched) {
+			pk_backend_job_files (job, package_ids[i], files);
+			continue;
+		}
+		item = pk_files_new ();
+		g_object_set (item, "package-id", package_ids[i], "files", files, NULL);
+		g_ptr_array_add (files_array, item);
+	}
+	pk_backend_job_files_list (job, files_array);
+}
+
+void
+pk_backend_get_files (PkBackend *backend, PkBackendJob *job, gchar **package_ids)
+{
+	pk_backend_job_thread_create (job, pk_backend_synthetic_get_files_thread, NULL, NULL);
+}
+
+static void
+pk_backend_synthetic_get_update_detail_thread (PkBackendJob *job, GVariant *params, gpointer user_data)
+{
+	g_autofree gchar **package_ids = NULL;
+	g_autoptr(GPtrArray) update_details = NULL;
+
+	g_variant_get (params, "(^a&s)", &package_ids);
+	pk_backend_job_set_status (job, PK_STATUS_ENUM_QUERY);
+	update_details = g_ptr_array_new_with_free_func (g_object_unref);
+	for (guint i = 0; package_ids[i] != NULL; i++) {
+		g_autofree gchar *update_text = NULL;
+		g_autofree gchar *updates_id = NULL;
+		gchar *updates[2] = { NULL, NULL };
+		PkUpdateDetail *item;
+		guint idx;
+
+		if (!pk_backend_synthetic_parse_index (package_ids[i], &idx))
+			continue;
+		updates_id = pk_backend_synthetic_build_package_id (idx, FALSE);
+		updates[0] = updates_id;
+		update_text = g_strdup_printf ("Update for synthetic package number %u", idx);
+		item = pk_update_detail_new ();
+		g_object_set (item,
+			      "package-id", package_ids[i],
+			      "updates", updates,
+			      "restart", PK_RESTART_ENUM_NONE,
+			      "update-text", update_text,
+			      "state", PK_UPDATE_STATE_ENUM_STABLE,
+			      NULL);
+		g_ptr_array_add (update_details, item);
+	}
+	pk_backend_job_update_details (job, update_details);
+}
+
+void
+pk_backend_get_update_detail (PkBackend *backend, PkBackendJob *job, gchar **package_ids)
+{
+	pk_backend_job_thread_create (job, pk_backend_synthetic_get_update_detail_thread, NULL, NULL);
+}
+
+void
+pk_backend_get_repo_list (PkBackend *backend, PkBackendJob *job, PkBitfield filters)
+{
+	pk_backend_job_set_status (job, PK_STATUS_ENUM_QUERY);
+	pk_backend_job_repo_detail (job, "synthetic", "Synthetic packages", TRUE);
+	pk_backend_job_finished (job);
+}
+
+gboolean
+pk_backend_supports_parallelization (PkBackend *backend)
+{
+	return TRUE;
+}
+
+const gchar *
+pk_backend_get_description (PkBackend *backend)
+{
+	return "Synthetic";
+}
+
+const gchar *
+pk_backend_get_author (PkBackend *backend)
+{
+	return "PackageKit Authors";
+}
@@ -47,6 +47,7 @@
 #include <pk-common-private.h>
 #include <pk-enum.h>
 
+#include <zypp/Date.h>
 #include <zypp/Digest.h>
 #include <zypp/KeyRing.h>
 #include <zypp/Locks.h>
@@ -164,6 +165,9 @@ guint _dl_status = 0;
 
 gint _preload_progress = 0;
 
+/* The modification time of the rpmdb when the target was loaded */
+static Date _rpmdb_timestamp;
+
 /**
  * Build a package_id from the specified resolvable.  The returned
  * gchar * should be freed with g_free ().
@@ -766,32 +770,37 @@ zypp_is_valid_repo (PkBackendJob *job, RepoInfo repo)
 	return TRUE;
 }
 
+/**
+ * Load the installed resolvables into the pool, unless they are there
+ * already and the rpmdb has not changed since they were loaded.
+ */
+static void
+zypp_load_target (ZYpp::Ptr zypp)
+{
+	Target_Ptr target = zypp->target ();
+	Date timestamp = target->rpmDb ().timestamp ();
+
+	if (timestamp == _rpmdb_timestamp &&
+	    !sat::Pool::instance ().reposFind (sat::Pool::systemRepoAlias ()).solvablesEmpty ())
+		return;
+
+	MIL << "loading the target, rpmdb changed at " << timestamp << endl;
+	target->load ();
+	_rpmdb_timestamp = timestamp;
+}
+
 /**
  * Build and return a ResPool that contains all local resolvables
- * and ones found in the enabled repositories.
+ * and ones found in the enabled repositories. The local resolvables
+ * stay in the pool, callers only wanting the available ones filter
+ * them out.
  */
 static ResPool
-zypp_build_pool (ZYpp::Ptr zypp, gboolean include_local)
+zypp_build_pool (ZYpp::Ptr zypp)
 {
 	static gboolean repos_loaded = FALSE;
 
-	// the target is loaded or unloaded on request
-	if (include_local) {
-		// FIXME have to wait for fix in zypp (repeated loading of target)
-		if (sat::Pool::instance().reposFind( sat::Pool::systemRepoAlias() ).solvablesEmpty ())
-		{
-			// Add local resolvables
-			Target_Ptr target = zypp->target ();
-			target->load ();
-		}
-	} else {
-		if (!sat::Pool::instance().reposFind( sat::Pool::systemRepoAlias() ).solvablesEmpty ())
-		{
-			// Remove local resolvables
-			Repository repository = sat::Pool::instance ().reposFind (sat::Pool::systemRepoAlias());
-			repository.eraseFromPool ();
-		}
-	}
+	zypp_load_target (zypp);
 
 	// we only load repositories once.
 	if (!repos_loaded) {
@@ -941,7 +950,7 @@ zypp_get_packages_by_file (ZYpp::Ptr zypp,
 			   const gchar *search_file,
 			   vector<sat::Solvable> &ret)
 {
-	ResPool pool = zypp_build_pool (zypp, TRUE);
+	ResPool pool = zypp_build_pool (zypp);
 
 	string file (search_file);
 
@@ -992,25 +1001,26 @@ zypp_package_is_local (const gchar *package_id)
 static sat::Solvable
 zypp_get_package_by_id (const gchar *package_id)
 {
+	PkPackageIdView view;
+
 	MIL << package_id << endl;
-	if (!pk_package_id_check(package_id)) {
+	if (!pk_package_id_parse(package_id, &view)) {
 		// TODO: Do we need to do something more for this error?
 		return sat::Solvable::noSolvable;
 	}
 
-	gchar **id_parts = pk_package_id_split(package_id);
-	const gchar *arch = id_parts[PK_PACKAGE_ID_ARCH];
-	if (!arch)
-		arch = "noarch";
-	bool want_source = !g_strcmp0 (arch, "source");
+	const string name (view.sections[PK_PACKAGE_ID_NAME], view.lengths[PK_PACKAGE_ID_NAME]);
+	const gchar *data = view.sections[PK_PACKAGE_ID_DATA];
+	bool want_installed = g_str_has_prefix (data, "installed");
+	bool want_source = pk_package_id_view_equal (&view, PK_PACKAGE_ID_ARCH, "source");
 
 	sat::Solvable package;
 
 	ResPool pool = ResPool::instance();
 
 	// Iterate over the resolvables and mark the one we want to check its dependencies
-	for (ResPool::byName_iterator it = pool.byNameBegin (id_parts[PK_PACKAGE_ID_NAME]);
-	     it != pool.byNameEnd (id_parts[PK_PACKAGE_ID_NAME]); ++it) {
+	for (ResPool::byName_iterator it = pool.byNameBegin (name);
+	     it != pool.byNameEnd (name); ++it) {
 
 		sat::Solvable pkg = it->satSolvable();
 		//MIL << "match " << package_id << " " << pkg << endl;
@@ -1020,27 +1030,28 @@ zypp_get_package_by_id (const gchar *package_id)
 			continue;
 		}
 
-		if (!want_source && (isKind<SrcPackage>(pkg) || g_strcmp0 (pkg.arch().c_str(), arch))) {
+		if (!want_source && (isKind<SrcPackage>(pkg) ||
+				     !pk_package_id_view_equal (&view, PK_PACKAGE_ID_ARCH, pkg.arch().c_str()))) {
 			//MIL << "not a matching arch\n";
 			continue;
 		}
 
 		const string &ver = pkg.edition ().asString();
-		if (g_strcmp0 (ver.c_str (), id_parts[PK_PACKAGE_ID_VERSION])) {
+		if (!pk_package_id_view_equal (&view, PK_PACKAGE_ID_VERSION, ver.c_str ())) {
 			//MIL << "not a matching version\n";
 			continue;
 		}
 
 		if (!pkg.isSystem()) {
-			if (!strncmp(id_parts[PK_PACKAGE_ID_DATA], "installed", 9)) {
+			if (want_installed) {
 				//MIL << "pkg is not installed\n";
 				continue;
 			}
-			if (g_strcmp0(pkg.repository().alias().c_str(), id_parts[PK_PACKAGE_ID_DATA])) {
+			if (g_strcmp0(pkg.repository().alias().c_str(), data)) {
 				//MIL << "repo does not match\n";
 				continue;
 			}
-		} else if (strncmp(id_parts[PK_PACKAGE_ID_DATA], "installed", 9)) {
+		} else if (!want_installed) {
 			//MIL << "pkg installed\n";
 			continue;
 		}
@@ -1050,7 +1061,6 @@ zypp_get_package_by_id (const gchar *package_id)
 		break;
 	}
 
-	g_strfreev (id_parts);
 	return package;
 }
 
@@ -1693,6 +1703,10 @@ zypp_perform_execution (PkBackendJob *job, ZYpp::Ptr zypp, PerformType type, gbo
 			goto exit;
 		}
 
+		// the pool was synced with the rpmdb after the commit
+		if (!only_download)
+			_rpmdb_timestamp = zypp->target ()->rpmDb ().timestamp ();
+
 		pk_backend_job_set_percentage(job, 100);
 		ret = TRUE;
 	} catch (const repo::RepoNotFoundException &ex) {
@@ -1766,7 +1780,7 @@ zypp_refresh_cache (PkBackendJob *job, ZYpp::Ptr zypp, gboolean force)
 		target->rpmDb ().exportTrustedKeysInZyppKeyRing ();
 	}
 	// load installed packages to pool
-	target->load ();
+	zypp_load_target (zypp);
 
 	pk_backend_job_set_status (job, PK_STATUS_ENUM_REFRESH_CACHE);
 	pk_backend_job_set_percentage (job, 0);
@@ -1969,7 +1983,7 @@ backend_required_by_thread (PkBackendJob *job, GVariant *params, gpointer user_d
 
 	pk_backend_job_set_percentage (job, 10);
 
-	ResPool pool = zypp_build_pool (zypp, true);
+	ResPool pool = zypp_build_pool (zypp);
 	PoolStatusSaver saver;
 	for (uint i = 0; package_ids[i]; i++) {
 		sat::Solvable solvable = zypp_get_package_by_id (package_ids[i]);
@@ -2232,7 +2246,7 @@ backend_get_details_thread (PkBackendJob *job, GVariant *params, gpointer user_d
 		return;
 	}
 
-	zypp_build_pool (zypp, true);
+	zypp_build_pool (zypp);
 
 	pk_backend_job_set_status (job, PK_STATUS_ENUM_QUERY);
 
@@ -2546,7 +2560,7 @@ backend_get_updates_thread (PkBackendJob *job, GVariant *params, gpointer user_d
 		return;
 	}
 
-	ResPool pool = zypp_build_pool (zypp, TRUE);
+	ResPool pool = zypp_build_pool (zypp);
 	pk_backend_job_set_percentage (job, 40);
 
 	set<PoolItem> candidates;
@@ -2666,7 +2680,7 @@ backend_install_files_thread (PkBackendJob *job, GVariant *params, gpointer user
 			  job, PK_ERROR_ENUM_INTERNAL_ERROR, "Can't refresh repositories");
 			return;
 		}
-		zypp_build_pool (zypp, true);
+		zypp_build_pool (zypp);
 
 	} catch (const Exception &ex) {
 		zypp_backend_finished_error (
@@ -2725,7 +2739,7 @@ backend_get_update_detail_thread (PkBackendJob *job, GVariant *params, gpointer
 	}
 	pk_backend_job_set_status (job, PK_STATUS_ENUM_QUERY);
 
-	zypp_build_pool (zypp, TRUE);
+	zypp_build_pool (zypp);
 
 	for (uint i = 0; package_ids[i]; i++) {
 		sat::Solvable solvable = zypp_get_package_by_id (package_ids[i]);
@@ -2832,7 +2846,7 @@ backend_install_packages_thread (PkBackendJob *job, GVariant *params, gpointer u
 
 	try
 	{
-		ResPool pool = zypp_build_pool (zypp, TRUE);
+		ResPool pool = zypp_build_pool (zypp);
 		PoolStatusSaver saver;
 		pk_backend_job_set_percentage (job, 10);
 		vector<PoolItem> items;
@@ -2998,7 +3012,6 @@ backend_remove_packages_thread (PkBackendJob *job, GVariant *params, gpointer us
 	pk_backend_job_set_status (job, PK_STATUS_ENUM_REMOVE);
 	pk_backend_job_set_percentage (job, 0);
 
-	Target_Ptr target;
 	ZyppJob zjob(job);
 	ZYpp::Ptr zypp = zjob.get_zypp();
 
@@ -3007,10 +3020,8 @@ backend_remove_packages_thread (PkBackendJob *job, GVariant *params, gpointer us
 	}
 	zypp->resolver()->setCleandepsOnRemove(autoremove);
 
-	target = zypp->target ();
-
 	// Load all the local system "resolvables" (packages)
-	target->load ();
+	zypp_load_target (zypp);
 	pk_backend_job_set_percentage (job, 10);
 
 	PoolStatusSaver saver;
@@ -3094,7 +3105,7 @@ backend_resolve_thread (PkBackendJob *job, GVariant *params, gpointer user_data)
 
 	pk_backend_job_set_status (job, PK_STATUS_ENUM_QUERY);
 
-	zypp_build_pool (zypp, TRUE);
+	zypp_build_pool (zypp);
 
 	for (uint i = 0; search[i]; i++) {
 		MIL << search[i] << " " << pk_filter_bitfield_to_string(_filters) << endl;
@@ -3215,7 +3226,7 @@ backend_find_packages_thread (PkBackendJob *job, GVariant *params, gpointer user
 
 	switch (role) {
 	case PK_ROLE_ENUM_SEARCH_NAME:
-		zypp_build_pool (zypp, TRUE); // seems to be necessary?
+		zypp_build_pool (zypp); // seems to be necessary?
 		q.addKind( ResKind::package );
 		q.addKind( ResKind::srcpackage );
 		q.addAttribute( sat::SolvAttr::name );
@@ -3224,7 +3235,7 @@ backend_find_packages_thread (PkBackendJob *job, GVariant *params, gpointer user
 		// two separate queries.
 		break;
 	case PK_ROLE_ENUM_SEARCH_DETAILS:
-		zypp_build_pool (zypp, TRUE); // seems to be necessary?
+		zypp_build_pool (zypp); // seems to be necessary?
 		q.addKind( ResKind::package );
 		//q.addKind( ResKind::srcpackage );
 		q.addAttribute( sat::SolvAttr::name );
@@ -3235,7 +3246,7 @@ backend_find_packages_thread (PkBackendJob *job, GVariant *params, gpointer user
 	case PK_ROLE_ENUM_SEARCH_FILE: {
 		q.setCaseSensitive( true ); // [<>] But we probably want case sensitive search for the file searches.
 
-		zypp_build_pool (zypp, TRUE);
+		zypp_build_pool (zypp);
 		q.addKind( ResKind::package );
 		q.addAttribute( sat::SolvAttr::name );
 		q.addAttribute( sat::SolvAttr::description );
@@ -3296,7 +3307,7 @@ backend_search_group_thread (PkBackendJob *job, GVariant *params, gpointer user_
 	pk_backend_job_set_status (job, PK_STATUS_ENUM_QUERY);
 	pk_backend_job_set_percentage (job, 0);
 
-	ResPool pool = zypp_build_pool (zypp, true);
+	ResPool pool = zypp_build_pool (zypp);
 
 	pk_backend_job_set_percentage (job, 30);
 
@@ -3434,7 +3445,7 @@ backend_get_files_thread (PkBackendJob *job, GVariant *params, gpointer user_dat
 		return;
 	}
 
-	zypp_build_pool (zypp, true);
+	zypp_build_pool (zypp);
 
 	for (uint i = 0; package_ids[i]; i++) {
 		pk_backend_job_set_status (job, PK_STATUS_ENUM_QUERY);
@@ -3506,7 +3517,7 @@ backend_get_packages_thread (PkBackendJob *job, GVariant *params, gpointer user_
 
 	vector<sat::Solvable> v;
 
-	zypp_build_pool (zypp, TRUE);
+	zypp_build_pool (zypp);
 	ResPool pool = ResPool::instance ();
 	for (ResPool::byKind_iterator it = pool.byKindBegin (ResKind::package); it != pool.byKindEnd (ResKind::package); ++it) {
 		v.push_back (it->satSolvable ());
@@ -3572,7 +3583,7 @@ backend_update_packages_thread (PkBackendJob *job, GVariant *params, gpointer us
 		return;
 	}
 
-	ResPool pool = zypp_build_pool (zypp, TRUE);
+	ResPool pool = zypp_build_pool (zypp);
 	PkRestartEnum restart = PK_RESTART_ENUM_NONE;
 	PoolStatusSaver saver;
 
@@ -3644,7 +3655,7 @@ pk_backend_upgrade_system_thread (PkBackendJob *job,
 		return;
 	}
 
-	ResPool pool = zypp_build_pool (zypp, TRUE);
+	ResPool pool = zypp_build_pool (zypp);
 	PoolStatusSaver saver;
 
 	if (is_tumbleweed ()) {
@@ -3864,7 +3875,7 @@ backend_what_provides_thread (PkBackendJob *job, GVariant *params, gpointer user
 	}
 	pk_backend_job_set_status (job, PK_STATUS_ENUM_QUERY);
 
-	ResPool pool = zypp_build_pool (zypp, true);
+	ResPool pool = zypp_build_pool (zypp);
 
 	if(g_ascii_strcasecmp("drivers_for_attached_hardware", values[0]) == 0) {
 		// solver run
@@ -3981,7 +3992,7 @@ backend_download_packages_thread (PkBackendJob *job, GVariant *params, gpointer
 
 	try
 	{
-		ResPool pool = zypp_build_pool (zypp, FALSE);
+		ResPool pool = zypp_build_pool (zypp);
 
 		pk_backend_job_set_status (job, PK_STATUS_ENUM_DOWNLOAD);
 		for (guint i = 0; package_ids[i]; i++) {
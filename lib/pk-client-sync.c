@@ -826,6 +826,69 @@ pk_client_get_old_transactions (PkClient *client,
 	return results;
 }
 
+/**
+ * pk_client_get_old_transactions_full:
+ * @client: a valid #PkClient instance
+ * @options: a #GVariant of type `a{sv}` with the transactions to return
+ * @cancellable: a #GCancellable or %NULL
+ * @progress_callback: (scope call): the function to run when the progress changes
+ * @progress_user_data: data to pass to @progress_callback
+ * @error: the #GError to store any failure, or %NULL
+ *
+ * Get the old transactions matching @options, see
+ * pk_client_get_old_transactions_full_async() for the supported options.
+ *
+ * Warning: this function is synchronous, and may block. Do not use it in GUI
+ * applications.
+ *
+ * Return value: (transfer full): a #PkResults object, or %NULL for error
+ *
+ * Since: 1.3.8
+ **/
+PkResults *
+pk_client_get_old_transactions_full (PkClient *client,
+				     GVariant *options,
+				     GCancellable *cancellable,
+				     PkProgressCallback progress_callback,
+				     gpointer progress_user_data,
+				     GError **error)
+{
+	PkClientHelper helper;
+	PkResults *results;
+
+	g_return_val_if_fail (PK_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	/* create temp object */
+	memset (&helper, 0, sizeof (PkClientHelper));
+	helper.context = g_main_context_new ();
+	helper.loop = g_main_loop_new (helper.context, FALSE);
+	helper.error = error;
+
+	g_main_context_push_thread_default (helper.context);
+
+	/* run async method */
+	pk_client_get_old_transactions_full_async (client,
+						   options,
+						   cancellable,
+						   progress_callback,
+						   progress_user_data,
+						   (GAsyncReadyCallback) pk_client_generic_finish_sync,
+						   &helper);
+
+	g_main_loop_run (helper.loop);
+
+	results = helper.results;
+
+	g_main_context_pop_thread_default (helper.context);
+
+	/* free temp object */
+	g_main_loop_unref (helper.loop);
+	g_main_context_unref (helper.context);
+
+	return results;
+}
+
 /**
  * pk_client_depends_on:
  * @client: a valid #PkClient instance
@@ -123,6 +123,13 @@ PkResults  *pk_client_get_old_transactions (PkClient	      *client,
 					    gpointer	       progress_user_data,
 					    GError	     **error);
 
+PkResults  *pk_client_get_old_transactions_full (PkClient	   *client,
+						 GVariant	   *options,
+						 GCancellable	   *cancellable,
+						 PkProgressCallback progress_callback,
+						 gpointer	   progress_user_data,
+						 GError		  **error);
+
 PkResults  *pk_client_depends_on (PkClient	    *client,
 				  PkBitfield	     filters,
 				  gchar		   **package_ids,
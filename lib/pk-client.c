@@ -29,15 +29,29 @@
  * https://www.freedesktop.org/software/PackageKit/gtk-doc/introduction-ideas-transactions.html
  */
 
+#define _GNU_SOURCE
+
 #include "config.h"
 
+#include <errno.h>
+#include <fcntl.h>
 #include <gio/gio.h>
+#include <gio/gunixfdlist.h>
+#include <gio/gunixinputstream.h>
 #include <glib-object.h>
+#include <glib/gstdio.h>
 #include <locale.h>
 #include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef HAVE_FICLONE
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#endif
 
 #include "pk-client.h"
 #include "pk-client-helper.h"
+#include "pk-client-private.h"
 #include "pk-common.h"
 #include "pk-control.h"
 #include "pk-debug.h"
@@ -49,6 +63,7 @@
 static void pk_client_finalize (GObject *object);
 
 #define PK_CLIENT_DBUS_METHOD_TIMEOUT G_MAXINT /* ms */
+#define PK_CLIENT_RESULT_CHANNEL_MAX_SIZE (128 * 1024 * 1024) /* bytes */
 
 /**
  * PkClientPrivate:
@@ -154,6 +169,7 @@ struct _PkClientState
 	gchar *value;
 	gpointer user_data;
 	guint number;
+	GVariant *options;
 	gulong cancellable_id;
 	GDBusProxy *proxy;
 	GCancellable *cancellable;
@@ -167,9 +183,16 @@ struct _PkClientState
 	PkSigTypeEnum type;
 	PkUpgradeKindEnum upgrade_kind;
 	gint remaining_files_to_copy;
+	guint n_files_to_copy;
 	PkClientHelper *client_helper;
 	gboolean waiting_for_finished;
 
+	/* private channel the daemon sends the signals over, if opened */
+	GInputStream *result_channel;
+	guint32 result_channel_size;
+	guint8 *result_channel_buffer;
+	GVariant *result_channel_finished; /* received before the method returned */
+
 	/* True if this PkClientState represents a peek at a transaction which
 	 * it doesn’t own, rather than being the owner of the transaction: */
 	gboolean querying_progress;
@@ -312,6 +335,10 @@ pk_client_state_finalize (GObject *object)
 	g_free (state->tid);
 	g_free (state->distro_id);
 	g_free (state->transaction_id);
+	g_clear_object (&state->result_channel);
+	g_free (state->result_channel_buffer);
+	g_clear_pointer (&state->result_channel_finished, g_variant_unref);
+	g_clear_pointer (&state->options, g_variant_unref);
 	g_strfreev (state->files);
 	g_strfreev (state->package_ids);
 	pk_client_state_unset_proxy (state);
@@ -817,6 +844,10 @@ pk_client_set_property_value (PkClientState *state, const char *key, GVariant *v
 		return;
 	}
 
+	/* only used for profiling */
+	if (g_strcmp0 (key, "Timings") == 0)
+		return;
+
 	g_warning ("unhandled property '%s'", key);
 }
 
@@ -953,32 +984,173 @@ pk_client_copy_finished_remove_old_files (PkClientState *state)
 	}
 }
 
+/*
+ * pk_client_copy_file_fast:
+ *
+ * Gives @destination the contents of @source without reading them into
+ * userspace: a reflink where the filesystem supports it, and then
+ * copy_file_range(). Returns %FALSE without setting @error if neither can
+ * be used here. This never hard links, as the caller must not be able to
+ * change the file the daemon keeps.
+ */
+static gboolean
+pk_client_copy_file_fast (const gchar *source, const gchar *destination, GError **error)
+{
+	struct stat st;
+	gint fd_src;
+	gint fd_dest;
+	gboolean ret = FALSE;
+
+	fd_src = open (source, O_RDONLY | O_CLOEXEC);
+	if (fd_src < 0)
+		return FALSE;
+	if (fstat (fd_src, &st) != 0) {
+		close (fd_src);
+		return FALSE;
+	}
+
+	fd_dest = open (destination, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, st.st_mode & 0777);
+	if (fd_dest < 0) {
+		close (fd_src);
+		return FALSE;
+	}
+
+#ifdef HAVE_FICLONE
+	/* the same extents, copied on write */
+	if (ioctl (fd_dest, FICLONE, fd_src) == 0) {
+		ret = TRUE;
+		goto out;
+	}
+#endif
+
+#ifdef HAVE_COPY_FILE_RANGE
+	/* copied by the kernel, or by the server for network filesystems */
+	for (off_t remaining = st.st_size; ; ) {
+		ssize_t len;
+
+		if (remaining == 0) {
+			ret = TRUE;
+			break;
+		}
+		len = copy_file_range (fd_src, NULL, fd_dest, NULL, remaining, 0);
+		if (len < 0) {
+			/* not supported between these files, so copy it ourselves */
+			if (remaining == st.st_size &&
+			    (errno == EXDEV || errno == ENOSYS || errno == EINVAL ||
+			     errno == EOPNOTSUPP || errno == EBADF))
+				break;
+			g_set_error (error,
+				     G_IO_ERROR,
+				     g_io_error_from_errno (errno),
+				     "failed to copy %s: %s",
+				     source,
+				     g_strerror (errno));
+			break;
+		}
+
+		/* the file was truncated */
+		if (len == 0)
+			break;
+		remaining -= len;
+	}
+#endif
+#ifdef HAVE_FICLONE
+out:
+#endif
+	close (fd_src);
+	close (fd_dest);
+	if (!ret)
+		g_unlink (destination);
+	return ret;
+}
+
+/*
+ * pk_client_copy_file:
+ *
+ * Copies a downloaded package, using pk_client_copy_file_fast() and then
+ * g_file_copy() if the files are on different filesystems.
+ */
+gboolean
+pk_client_copy_file (const gchar *source,
+		     const gchar *destination,
+		     GCancellable *cancellable,
+		     GError **error)
+{
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GFile) file_src = NULL;
+	g_autoptr(GFile) file_dest = NULL;
+
+	if (pk_client_copy_file_fast (source, destination, &error_local))
+		return TRUE;
+	if (error_local != NULL) {
+		g_propagate_error (error, g_steal_pointer (&error_local));
+		return FALSE;
+	}
+
+	/* across filesystems, or not supported by them */
+	file_src = g_file_new_for_path (source);
+	file_dest = g_file_new_for_path (destination);
+	return g_file_copy (file_src,
+			    file_dest,
+			    G_FILE_COPY_OVERWRITE,
+			    cancellable,
+			    NULL,
+			    NULL,
+			    error);
+}
+
+/*
+ * pk_client_copy_downloaded_thread:
+ */
+static void
+pk_client_copy_downloaded_thread (GTask *task,
+				  gpointer source_object,
+				  gpointer task_data,
+				  GCancellable *cancellable)
+{
+	gchar **paths = task_data;
+	g_autoptr(GError) error = NULL;
+
+	if (!pk_client_copy_file (paths[0], paths[1], cancellable, &error)) {
+		g_task_return_error (task, g_steal_pointer (&error));
+		return;
+	}
+	g_task_return_boolean (task, TRUE);
+}
+
 /*
  * pk_client_copy_downloaded_finished_cb:
  */
 static void
-pk_client_copy_downloaded_finished_cb (GFile *file, GAsyncResult *res, gpointer user_data)
+pk_client_copy_downloaded_finished_cb (GObject *source_object, GAsyncResult *res, gpointer user_data)
 {
-	g_autofree gchar *path = NULL;
+	gchar **paths = g_task_get_task_data (G_TASK (res));
+	gint remaining;
 	g_autoptr(GError) error = NULL;
 	g_autoptr(PkClientState) state = user_data;
 
 	/* debug */
-	path = g_file_get_path (file);
-	g_debug ("finished copy of %s", path);
+	g_debug ("finished copy of %s", paths[1]);
 
 	/* get the result */
-	if (!g_file_copy_finish (file, res, &error)) {
+	if (!g_task_propagate_boolean (G_TASK (res), &error)) {
 		pk_client_state_finish (state, g_steal_pointer (&error));
 		return;
 	}
 
 	/* no more copies pending? */
-	if (g_atomic_int_dec_and_test (&state->remaining_files_to_copy)) {
+	remaining = g_atomic_int_add (&state->remaining_files_to_copy, -1) - 1;
+	if (remaining == 0) {
 		pk_client_copy_finished_remove_old_files (state);
 		state->ret = TRUE;
 		pk_client_state_finish (state, NULL);
+		return;
 	}
+
+	/* save percentage */
+	pk_progress_set_status (state->progress, PK_STATUS_ENUM_COPY_FILES);
+	pk_progress_set_percentage (state->progress,
+				    100 * (state->n_files_to_copy - remaining) / state->n_files_to_copy);
 }
 
 /*
@@ -1014,7 +1186,7 @@ pk_client_copy_downloaded_file (PkClientState *state,
 	g_autofree gchar *basename = NULL;
 	g_autofree gchar *path = NULL;
 	g_autoptr(GFile) destination = NULL;
-	g_autoptr(GFile) source = NULL;
+	g_autoptr(GTask) task = NULL;
 	g_autoptr(PkFiles) item = NULL;
 	g_auto(GStrv) files = NULL;
 
@@ -1024,7 +1196,6 @@ pk_client_copy_downloaded_file (PkClientState *state,
 
 	/* copy async */
 	g_debug ("copy %s to %s", source_file, path);
-	source = g_file_new_for_path (source_file);
 	destination = g_file_new_for_path (path);
 	if (g_file_query_exists (destination, state->cancellable)) {
 		g_set_error (&error,
@@ -1035,15 +1206,15 @@ pk_client_copy_downloaded_file (PkClientState *state,
 		pk_client_state_finish (state, g_steal_pointer (&error));
 		return;
 	}
-	g_file_copy_async (source,
-			   destination,
-			   G_FILE_COPY_OVERWRITE,
-			   G_PRIORITY_DEFAULT,
+	task = g_task_new (NULL,
 			   state->cancellable,
-			   (GFileProgressCallback) pk_client_copy_progress_cb,
-			   state,
-			   (GAsyncReadyCallback) pk_client_copy_downloaded_finished_cb,
+			   pk_client_copy_downloaded_finished_cb,
 			   g_object_ref (state));
+	g_task_set_source_tag (task, pk_client_copy_downloaded_file);
+	g_task_set_task_data (task,
+			      g_strdupv ((gchar *[]) { (gchar *) source_file, path, NULL }),
+			      (GDestroyNotify) g_strfreev);
+	g_task_run_in_thread (task, pk_client_copy_downloaded_thread);
 
 	/* Add the result (as a GStrv) to the results set */
 	files = g_strsplit (path, ",", -1);
@@ -1091,6 +1262,7 @@ pk_client_copy_downloaded (PkClientState *state)
 	}
 
 	g_atomic_int_set (&state->remaining_files_to_copy, n_files_to_copy);
+	state->n_files_to_copy = n_files_to_copy;
 
 	/* get a cached value, as pk_client_copy_downloaded_file() adds items */
 	len = array->len;
@@ -1230,27 +1402,40 @@ results_add_update_detail_from_variant (PkResults *results,
 	pk_results_add_update_detail (results, item);
 }
 
+static void
+details_set_from_variant (PkDetails *item, GVariant *dictionary)
+{
+	GVariantIter iter;
+	const gchar *key;
+	GVariant *value;
+
+	g_variant_iter_init (&iter, dictionary);
+	while (g_variant_iter_loop (&iter, "{&sv}", &key, &value)) {
+		if (g_strcmp0 (key, "group") == 0)
+			g_object_set (item, "group", g_variant_get_uint32 (value), NULL);
+		else if (g_strcmp0 (key, "size") == 0)
+			g_object_set (item, "size", g_variant_get_uint64 (value), NULL);
+		else if (g_strcmp0 (key, "download-size") == 0)
+			g_object_set (item, "download-size", g_variant_get_uint64 (value), NULL);
+		else
+			g_object_set (item, key, g_variant_get_string (value, NULL), NULL);
+	}
+}
+
 /*
  * pk_client_signal_cb:
  **/
 static void
-pk_client_signal_cb (GDBusProxy *proxy,
-		     const gchar *sender_name,
-		     const gchar *signal_name,
-		     GVariant *parameters,
-		     gpointer user_data)
+pk_client_state_handle_signal (PkClientState *state,
+			       const gchar *signal_name,
+			       GVariant *parameters)
 {
-	GWeakRef *weak_ref = user_data;
-	g_autoptr(PkClientState) state = g_weak_ref_get (weak_ref);
 	gchar *tmp_str[12];
 	gboolean tmp_bool;
 	guint tmp_uint;
 	guint tmp_uint2;
 	guint tmp_uint3;
 
-	if (!state)
-		return;
-
 	if (g_strcmp0 (signal_name, "Finished") == 0) {
 		if (state->waiting_for_finished) {
 			g_variant_get (parameters, "(uu)", &tmp_uint2, &tmp_uint);
@@ -1285,37 +1470,12 @@ pk_client_signal_cb (GDBusProxy *proxy,
 		return;
 	}
 	if (g_strcmp0 (signal_name, "Details") == 0) {
-		gchar *key;
-		GVariantIter *dictionary;
-		GVariant *value;
 		g_autoptr(PkDetails) item = NULL;
 		item = pk_details_new ();
 
 		if (g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(a{sv})"))) {
-			g_variant_get_child (parameters, 0, "a{sv}", &dictionary);
-			while (g_variant_iter_loop (dictionary, "{sv}", &key, &value)) {
-				if (g_strcmp0 (key, "group") == 0)
-					g_object_set (item,
-						      "group",
-						      g_variant_get_uint32 (value),
-						      NULL);
-				else if (g_strcmp0 (key, "size") == 0)
-					g_object_set (item,
-						      "size",
-						      g_variant_get_uint64 (value),
-						      NULL);
-				else if (g_strcmp0 (key, "download-size") == 0)
-					g_object_set (item,
-						      "download-size",
-						      g_variant_get_uint64 (value),
-						      NULL);
-				else
-					g_object_set (item,
-						      key,
-						      g_variant_get_string (value, NULL),
-						      NULL);
-			}
-			g_variant_iter_free (dictionary);
+			g_autoptr(GVariant) dictionary = g_variant_get_child_value (parameters, 0);
+			details_set_from_variant (item, dictionary);
 		} else {
 			guint64 tmp_uint64;
 			g_variant_get (parameters,
@@ -1348,6 +1508,27 @@ pk_client_signal_cb (GDBusProxy *proxy,
 		pk_results_add_details (state->results, item);
 		return;
 	}
+	if (g_strcmp0 (signal_name, "DetailsList") == 0) {
+		g_autoptr(GVariantIter) iter = NULL;
+		g_autoptr(GVariant) dictionary = NULL;
+
+		g_variant_get (parameters, "(aa{sv})", &iter);
+
+		while ((dictionary = g_variant_iter_next_value (iter))) {
+			g_autoptr(PkDetails) item = pk_details_new ();
+			details_set_from_variant (item, dictionary);
+			g_object_set (item,
+				      "role",
+				      state->role,
+				      "transaction-id",
+				      state->transaction_id,
+				      NULL);
+			pk_results_add_details (state->results, item);
+			g_clear_pointer (&dictionary, g_variant_unref);
+		}
+
+		return;
+	}
 	if (g_strcmp0 (signal_name, "UpdateDetail") == 0) {
 		results_add_update_detail_from_variant (state->results,
 							parameters,
@@ -1492,6 +1673,31 @@ pk_client_signal_cb (GDBusProxy *proxy,
 		pk_results_add_files (state->results, item);
 		return;
 	}
+	if (g_strcmp0 (signal_name, "FilesList") == 0) {
+		g_autoptr(GVariantIter) iter = NULL;
+		const gchar *package_id;
+		gchar **files;
+
+		g_variant_get (parameters, "(a(sas))", &iter);
+
+		while (g_variant_iter_next (iter, "(&s^a&s)", &package_id, &files)) {
+			g_autoptr(PkFiles) item = pk_files_new ();
+			g_object_set (item,
+				      "package-id",
+				      package_id,
+				      "files",
+				      files,
+				      "role",
+				      state->role,
+				      "transaction-id",
+				      state->transaction_id,
+				      NULL);
+			pk_results_add_files (state->results, item);
+			g_free (files);
+		}
+
+		return;
+	}
 	if (g_strcmp0 (signal_name, "RepoSignatureRequired") == 0) {
 		g_autoptr(PkRepoSignatureRequired) item = NULL;
 		g_variant_get (parameters,
@@ -1641,6 +1847,134 @@ pk_client_signal_cb (GDBusProxy *proxy,
 	}
 }
 
+static void
+pk_client_signal_cb (GDBusProxy *proxy,
+		     const gchar *sender_name,
+		     const gchar *signal_name,
+		     GVariant *parameters,
+		     gpointer user_data)
+{
+	GWeakRef *weak_ref = user_data;
+	g_autoptr(PkClientState) state = g_weak_ref_get (weak_ref);
+
+	if (!state)
+		return;
+
+	/* everything comes over the result channel instead */
+	if (state->result_channel != NULL)
+		return;
+
+	pk_client_state_handle_signal (state, signal_name, parameters);
+}
+
+static void pk_client_result_channel_read (PkClientState *state);
+
+static void
+pk_client_result_channel_closed (PkClientState *state, GError *error)
+{
+	g_autoptr(GError) error_owned = error;
+
+	/* the daemon closes the channel after ::Finished() */
+	if (pk_client_state_is_finished (state) || state->result_channel_finished != NULL)
+		return;
+	if (error_owned != NULL && g_error_matches (error_owned, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+		return;
+	if (error_owned == NULL) {
+		error_owned = g_error_new_literal (PK_CLIENT_ERROR,
+						   PK_CLIENT_ERROR_FAILED,
+						   "PackageKit result channel closed unexpectedly");
+	}
+	pk_client_state_finish (state, g_steal_pointer (&error_owned));
+}
+
+static void
+pk_client_result_channel_read_message_cb (GObject *source_object,
+					  GAsyncResult *res,
+					  gpointer user_data)
+{
+	g_autoptr(PkClientState) state = PK_CLIENT_STATE (user_data);
+	g_autoptr(GBytes) bytes = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GVariant) message = NULL;
+	g_autoptr(GVariant) parameters = NULL;
+	const gchar *signal_name;
+	gsize bytes_read = 0;
+
+	bytes = g_bytes_new_take (g_steal_pointer (&state->result_channel_buffer),
+				  state->result_channel_size);
+	if (!g_input_stream_read_all_finish (G_INPUT_STREAM (source_object), res, &bytes_read, &error)) {
+		pk_client_result_channel_closed (state, g_steal_pointer (&error));
+		return;
+	}
+	if (bytes_read != state->result_channel_size) {
+		pk_client_result_channel_closed (state, NULL);
+		return;
+	}
+
+	message = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE ("(sv)"), bytes, FALSE));
+	g_variant_get (message, "(&sv)", &signal_name, &parameters);
+	if (!g_variant_is_of_type (parameters, G_VARIANT_TYPE_TUPLE)) {
+		g_warning ("invalid parameters for %s on result channel", signal_name);
+	} else if (g_strcmp0 (signal_name, "Finished") == 0 && !state->waiting_for_finished) {
+		/* the method has not returned yet, so finish when it does */
+		state->result_channel_finished = g_steal_pointer (&parameters);
+		return;
+	} else {
+		pk_client_state_handle_signal (state, signal_name, parameters);
+	}
+
+	if (!pk_client_state_is_finished (state))
+		pk_client_result_channel_read (state);
+}
+
+static void
+pk_client_result_channel_read_size_cb (GObject *source_object,
+				       GAsyncResult *res,
+				       gpointer user_data)
+{
+	g_autoptr(PkClientState) state = PK_CLIENT_STATE (user_data);
+	g_autoptr(GError) error = NULL;
+	gsize bytes_read = 0;
+
+	if (!g_input_stream_read_all_finish (G_INPUT_STREAM (source_object), res, &bytes_read, &error)) {
+		pk_client_result_channel_closed (state, g_steal_pointer (&error));
+		return;
+	}
+	if (bytes_read != sizeof (state->result_channel_size)) {
+		pk_client_result_channel_closed (state, NULL);
+		return;
+	}
+	if (state->result_channel_size > PK_CLIENT_RESULT_CHANNEL_MAX_SIZE) {
+		error = g_error_new (PK_CLIENT_ERROR,
+				     PK_CLIENT_ERROR_FAILED,
+				     "PackageKit result channel message too large: %u bytes",
+				     state->result_channel_size);
+		pk_client_result_channel_closed (state, g_steal_pointer (&error));
+		return;
+	}
+
+	state->result_channel_buffer = g_malloc (state->result_channel_size);
+	g_input_stream_read_all_async (state->result_channel,
+				       state->result_channel_buffer,
+				       state->result_channel_size,
+				       G_PRIORITY_DEFAULT,
+				       state->cancellable,
+				       pk_client_result_channel_read_message_cb,
+				       g_object_ref (state));
+}
+
+static void
+pk_client_result_channel_read (PkClientState *state)
+{
+	g_input_stream_read_all_async (state->result_channel,
+				       &state->result_channel_size,
+				       sizeof (state->result_channel_size),
+				       G_PRIORITY_DEFAULT,
+				       state->cancellable,
+				       pk_client_result_channel_read_size_cb,
+				       g_object_ref (state));
+}
+
 static void
 pk_client_notify_name_owner_cb (GObject *obj, GParamSpec *pspec, gpointer user_data)
 {
@@ -1723,6 +2057,12 @@ pk_client_method_cb (GObject *source_object, GAsyncResult *res, gpointer user_da
 
 	/* wait for ::Finished() or ::Destroy() or notify::g-name-owner (if the daemon disappears) */
 	state->waiting_for_finished = TRUE;
+
+	/* the result channel may have already had everything */
+	if (state->result_channel_finished != NULL) {
+		g_autoptr(GVariant) parameters = g_steal_pointer (&state->result_channel_finished);
+		pk_client_state_handle_signal (state, "Finished", parameters);
+	}
 }
 
 /*
@@ -1735,6 +2075,59 @@ pk_client_set_role (PkClientState *state, PkRoleEnum role)
 	pk_progress_set_role (state->progress, role);
 }
 
+static void pk_client_call_role_method (PkClientState *state);
+
+static gboolean
+pk_client_role_use_result_channel (PkRoleEnum role)
+{
+	return role == PK_ROLE_ENUM_GET_PACKAGES ||
+	       role == PK_ROLE_ENUM_GET_DETAILS ||
+	       role == PK_ROLE_ENUM_GET_FILES ||
+	       role == PK_ROLE_ENUM_SEARCH_DETAILS ||
+	       role == PK_ROLE_ENUM_SEARCH_FILE;
+}
+
+/*
+ * pk_client_open_result_channel_cb:
+ **/
+static void
+pk_client_open_result_channel_cb (GObject *source_object, GAsyncResult *res, gpointer user_data)
+{
+	GDBusProxy *proxy = G_DBUS_PROXY (source_object);
+	g_autoptr(PkClientState) state = PK_CLIENT_STATE (g_steal_pointer (&user_data));
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GUnixFDList) fd_list = NULL;
+	g_autoptr(GVariant) value = NULL;
+	gint32 fd_index = -1;
+	gint fd;
+
+	/* get the result */
+	value = g_dbus_proxy_call_with_unix_fd_list_finish (proxy, &fd_list, res, &error);
+	if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+		pk_client_state_finish (state, g_steal_pointer (&error));
+		return;
+	}
+	if (value == NULL) {
+		/* an older daemon, so just use the bus */
+		g_debug ("failed to open result channel: %s", error->message);
+		pk_client_call_role_method (state);
+		return;
+	}
+
+	g_variant_get (value, "(h)", &fd_index);
+	fd = fd_list != NULL ? g_unix_fd_list_get (fd_list, fd_index, &error) : -1;
+	if (fd < 0) {
+		g_debug ("failed to get result channel: %s",
+			 error != NULL ? error->message : "no fd");
+		pk_client_call_role_method (state);
+		return;
+	}
+
+	state->result_channel = g_unix_input_stream_new (fd, TRUE);
+	pk_client_result_channel_read (state);
+	pk_client_call_role_method (state);
+}
+
 /*
  * pk_client_set_hints_cb:
  **/
@@ -1776,6 +2169,30 @@ pk_client_set_hints_cb (GObject *source_object, GAsyncResult *res, gpointer user
 		      state->transaction_flags,
 		      NULL);
 
+	/* roles which can return a lot of results get them over a private
+	 * channel rather than the bus, if the daemon supports it */
+	if (pk_client_role_use_result_channel (state->role)) {
+		g_dbus_proxy_call_with_unix_fd_list (state->proxy,
+						     "OpenResultChannel",
+						     NULL,
+						     G_DBUS_CALL_FLAGS_NONE,
+						     PK_CLIENT_DBUS_METHOD_TIMEOUT,
+						     NULL,
+						     state->cancellable,
+						     pk_client_open_result_channel_cb,
+						     g_object_ref (state));
+		return;
+	}
+
+	pk_client_call_role_method (state);
+}
+
+/*
+ * pk_client_call_role_method:
+ **/
+static void
+pk_client_call_role_method (PkClientState *state)
+{
 	/* do this async, although this should be pretty fast anyway */
 	if (state->role == PK_ROLE_ENUM_RESOLVE) {
 		g_dbus_proxy_call (state->proxy,
@@ -1863,6 +2280,15 @@ pk_client_set_hints_cb (GObject *source_object, GAsyncResult *res, gpointer user
 				   pk_client_method_cb,
 				   g_object_ref (state));
 		g_object_set (state->results, "inputs", g_strv_length (state->package_ids), NULL);
+	} else if (state->role == PK_ROLE_ENUM_GET_OLD_TRANSACTIONS && state->options != NULL) {
+		g_dbus_proxy_call (state->proxy,
+				   "GetOldTransactionsFull",
+				   g_variant_new ("(@a{sv})", state->options),
+				   G_DBUS_CALL_FLAGS_NONE,
+				   PK_CLIENT_DBUS_METHOD_TIMEOUT,
+				   state->cancellable,
+				   pk_client_method_cb,
+				   g_object_ref (state));
 	} else if (state->role == PK_ROLE_ENUM_GET_OLD_TRANSACTIONS) {
 		g_dbus_proxy_call (state->proxy,
 				   "GetOldTransactions",
@@ -3162,6 +3588,72 @@ pk_client_get_old_transactions_async (PkClient *client,
 				  g_steal_pointer (&state));
 }
 
+/**
+ * pk_client_get_old_transactions_full_async: (finish-func pk_client_generic_finish):
+ * @client: a valid #PkClient instance
+ * @options: a #GVariant of type `a{sv}` with the transactions to return
+ * @cancellable: a #GCancellable or %NULL
+ * @progress_callback: (scope notified): the function to run when the progress changes
+ * @progress_user_data: data to pass to @progress_callback
+ * @callback_ready: the function to run on completion
+ * @user_data: the data to pass to @callback_ready
+ *
+ * Get the old transactions matching @options, which can contain `limit` (u),
+ * `since-tid` (s), `before-tid` (s), `since-timespec` (s), `role` (u),
+ * `uid` (u), `succeeded` (b) and `data` (b).
+ *
+ * Using `since-tid` with the newest transaction already known, or `before-tid`
+ * with the oldest, allows a history to be refreshed or paged through without
+ * fetching every transaction again. Setting `data` to %FALSE omits the list of
+ * packages of each transaction.
+ *
+ * Since: 1.3.8
+ **/
+void
+pk_client_get_old_transactions_full_async (PkClient *client,
+					   GVariant *options,
+					   GCancellable *cancellable,
+					   PkProgressCallback progress_callback,
+					   gpointer progress_user_data,
+					   GAsyncReadyCallback callback_ready,
+					   gpointer user_data)
+{
+	PkClientPrivate *priv = GET_PRIVATE(client);
+	g_autoptr(PkClientState) state = NULL;
+	g_autoptr(GError) error = NULL;
+
+	g_return_if_fail (PK_IS_CLIENT (client));
+	g_return_if_fail (options != NULL);
+	g_return_if_fail (g_variant_is_of_type (options, G_VARIANT_TYPE_VARDICT));
+	g_return_if_fail (callback_ready != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	/* save state */
+	state = pk_client_state_new (client,
+				     callback_ready,
+				     user_data,
+				     pk_client_get_old_transactions_full_async,
+				     PK_ROLE_ENUM_GET_OLD_TRANSACTIONS,
+				     cancellable);
+	state->options = g_variant_ref_sink (options);
+	state->progress = pk_progress_new_with_callback (progress_callback, progress_user_data);
+
+	/* check not already cancelled */
+	if (g_cancellable_set_error_if_cancelled (cancellable, &error)) {
+		pk_client_state_finish (state, g_steal_pointer (&error));
+		return;
+	}
+
+	/* identify */
+	pk_client_set_role (state, state->role);
+
+	/* get tid */
+	pk_control_get_tid_async (priv->control,
+				  cancellable,
+				  (GAsyncReadyCallback) pk_client_get_tid_cb,
+				  g_steal_pointer (&state));
+}
+
 /**
  * pk_client_depends_on_async: (finish-func pk_client_generic_finish):
  * @client: a valid #PkClient instance
@@ -217,6 +217,14 @@ void	     pk_client_get_old_transactions_async (PkClient	      *client,
 						   GAsyncReadyCallback callback_ready,
 						   gpointer	       user_data);
 
+void	     pk_client_get_old_transactions_full_async (PkClient	   *client,
+							GVariant	   *options,
+							GCancellable	   *cancellable,
+							PkProgressCallback  progress_callback,
+							gpointer	    progress_user_data,
+							GAsyncReadyCallback callback_ready,
+							gpointer	    user_data);
+
 void	     pk_client_depends_on_async (PkClient	    *client,
 					 PkBitfield	     filters,
 					 gchar		   **package_ids,
@@ -291,6 +291,13 @@ pk_control_set_property_value (PkControl *control, const gchar *key, GVariant *v
 		g_object_notify_by_pspec (G_OBJECT(control), obj_properties[PROP_DISTRO_ID]);
 		return;
 	}
+
+	/* only used for profiling */
+	if (g_strcmp0 (key, "ResultCacheHits") == 0 ||
+	    g_strcmp0 (key, "ResultCacheMisses") == 0 ||
+	    g_strcmp0 (key, "QueueWaitTimes") == 0)
+		return;
+
 	g_warning ("unhandled property '%s'", key);
 }
 
@@ -0,0 +1,104 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2026 PackageKit Authors
+#
+# Licensed under the GNU Lesser General Public License Version 2.1
+#
+# Generates the lookup indexes for the PkEnumMatch tables in pk-enum.c,
+# so that converting between an enum and its string does not have to scan
+# the table. For every table this writes:
+#
+#  - an array indexed by the enum value, holding the position of the value
+#    in the table, used by the *_to_string() functions
+#  - a perfect hash of the strings, holding the position of each string in
+#    the table, used by the *_from_string() functions
+#
+# Positions are stored plus one, so that zero means not in the table.
+#
+# Usage: pk-enum-gen.py pk-enum.c pk-enum-tables.h
+
+import re
+import sys
+
+# must match pk_enum_hash() in pk-enum.c
+def pk_enum_hash(seed, string):
+    h = (2166136261 ^ seed) & 0xffffffff
+    for b in string.encode('utf-8'):
+        h ^= b
+        h = (h * 16777619) & 0xffffffff
+    return h
+
+def find_seed(strings):
+    size = 1
+    while size < 2 * len(strings):
+        size *= 2
+    while True:
+        for seed in range(4096):
+            slots = set()
+            for string in strings:
+                slot = pk_enum_hash(seed, string) & (size - 1)
+                if slot in slots:
+                    break
+                slots.add(slot)
+            else:
+                return size, seed
+        size *= 2
+
+def parse_tables(source):
+    tables = []
+    for match in re.finditer(r'static const PkEnumMatch (enum_\w+)\[\] = \{(.*?)\n\};', source, re.S):
+        entries = re.findall(r'\{\s*(\w+),\s*"([^"]*)"\s*\}', match.group(2))
+        if len(entries) == 0 or len(entries) > 255:
+            raise SystemExit('%s: unsupported number of entries' % match.group(1))
+        tables.append((match.group(1), entries))
+    if len(tables) == 0:
+        raise SystemExit('no PkEnumMatch tables found')
+    return tables
+
+def write_index(out, name, entries):
+    strings = [string for _, string in entries]
+    if len(set(strings)) != len(strings):
+        raise SystemExit('%s: duplicate strings' % name)
+    size, seed = find_seed(strings)
+
+    # the first entry wins if a value is listed twice, like pk_enum_find_string()
+    seen = set()
+    out.write('static const guint8 %s_by_value[] = {\n' % name)
+    for i, (value, _) in enumerate(entries):
+        if value in seen:
+            continue
+        seen.add(value)
+        out.write('\t[%s] = %i,\n' % (value, i + 1))
+    out.write('};\n\n')
+
+    slots = [0] * size
+    for i, string in enumerate(strings):
+        slots[pk_enum_hash(seed, string) & (size - 1)] = i + 1
+    out.write('static const guint8 %s_by_hash[%i] = {\n' % (name, size))
+    for i in range(0, size, 16):
+        out.write('\t%s,\n' % ', '.join(str(slot) for slot in slots[i:i + 16]))
+    out.write('};\n\n')
+
+    out.write('static const PkEnumIndex %s_index = {\n' % name)
+    out.write('\t%s,\n' % name)
+    out.write('\t%s_by_value,\n' % name)
+    out.write('\tG_N_ELEMENTS (%s_by_value),\n' % name)
+    out.write('\t%s_by_hash,\n' % name)
+    out.write('\t%i,\n' % (size - 1))
+    out.write('\t%iu,\n' % seed)
+    out.write('};\n\n')
+
+def main(argv):
+    if len(argv) != 3:
+        raise SystemExit('usage: %s pk-enum.c pk-enum-tables.h' % argv[0])
+    with open(argv[1], encoding='utf-8') as f:
+        tables = parse_tables(f.read())
+    with open(argv[2], 'w', encoding='utf-8') as out:
+        out.write('/* Generated by pk-enum-gen.py from pk-enum.c, do not edit */\n\n')
+        out.write('/* clang-format off */\n')
+        for name, entries in tables:
+            write_index(out, name, entries)
+        out.write('/* clang-format on */\n')
+
+if __name__ == '__main__':
+    main(sys.argv)
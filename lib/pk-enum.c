@@ -392,6 +392,56 @@ static const PkEnumMatch enum_transaction_flag[] = {
 };
 /* clang-format on */
 
+/* Lookup indexes for the tables above, see pk-enum-gen.py */
+typedef struct {
+	const PkEnumMatch	*table;
+	const guint8		*by_value;
+	guint			 by_value_len;
+	const guint8		*by_hash;
+	guint32			 hash_mask;
+	guint32			 hash_seed;
+} PkEnumIndex;
+
+#include "pk-enum-tables.h"
+
+/* FNV-1a, which must match pk_enum_hash() in pk-enum-gen.py */
+static inline guint32
+pk_enum_hash (guint32 seed, const gchar *string)
+{
+	guint32 hash = 2166136261u ^ seed;
+	for (const guchar *p = (const guchar *) string; *p != '\0'; p++) {
+		hash ^= *p;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+static guint
+pk_enum_index_find_value (const PkEnumIndex *idx, const gchar *string)
+{
+	guint8 pos;
+
+	/* return the first entry on non-found or error */
+	if (string == NULL)
+		return idx->table[0].value;
+	pos = idx->by_hash[pk_enum_hash (idx->hash_seed, string) & idx->hash_mask];
+	if (pos != 0 && strcmp (string, idx->table[pos - 1].string) == 0)
+		return idx->table[pos - 1].value;
+	return idx->table[0].value;
+}
+
+static const gchar *
+pk_enum_index_find_string (const PkEnumIndex *idx, guint value)
+{
+	guint8 pos = 0;
+
+	if (value < idx->by_value_len)
+		pos = idx->by_value[value];
+	if (pos != 0)
+		return idx->table[pos - 1].string;
+	return idx->table[0].string;
+}
+
 /**
  * pk_enum_find_value:
  * @table: A #PkEnumMatch enum table of values
@@ -460,7 +510,7 @@ pk_enum_find_string (const PkEnumMatch *table, guint value)
 PkSigTypeEnum
 pk_sig_type_enum_from_string (const gchar *sig_type)
 {
-	return pk_enum_find_value (enum_sig_type, sig_type);
+	return pk_enum_index_find_value (&enum_sig_type_index, sig_type);
 }
 
 /**
@@ -476,7 +526,7 @@ pk_sig_type_enum_from_string (const gchar *sig_type)
 const gchar *
 pk_sig_type_enum_to_string (PkSigTypeEnum sig_type)
 {
-	return pk_enum_find_string (enum_sig_type, sig_type);
+	return pk_enum_index_find_string (&enum_sig_type_index, sig_type);
 }
 
 /**
@@ -492,7 +542,7 @@ pk_sig_type_enum_to_string (PkSigTypeEnum sig_type)
 PkDistroUpgradeEnum
 pk_distro_upgrade_enum_from_string (const gchar *upgrade)
 {
-	return pk_enum_find_value (enum_upgrade, upgrade);
+	return pk_enum_index_find_value (&enum_upgrade_index, upgrade);
 }
 
 /**
@@ -508,7 +558,7 @@ pk_distro_upgrade_enum_from_string (const gchar *upgrade)
 const gchar *
 pk_distro_upgrade_enum_to_string (PkDistroUpgradeEnum upgrade)
 {
-	return pk_enum_find_string (enum_upgrade, upgrade);
+	return pk_enum_index_find_string (&enum_upgrade_index, upgrade);
 }
 
 /**
@@ -524,7 +574,7 @@ pk_distro_upgrade_enum_to_string (PkDistroUpgradeEnum upgrade)
 PkInfoEnum
 pk_info_enum_from_string (const gchar *info)
 {
-	return pk_enum_find_value (enum_info, info);
+	return pk_enum_index_find_value (&enum_info_index, info);
 }
 
 /**
@@ -540,7 +590,7 @@ pk_info_enum_from_string (const gchar *info)
 const gchar *
 pk_info_enum_to_string (PkInfoEnum info)
 {
-	return pk_enum_find_string (enum_info, info);
+	return pk_enum_index_find_string (&enum_info_index, info);
 }
 
 /**
@@ -556,7 +606,7 @@ pk_info_enum_to_string (PkInfoEnum info)
 PkExitEnum
 pk_exit_enum_from_string (const gchar *exit_text)
 {
-	return pk_enum_find_value (enum_exit, exit_text);
+	return pk_enum_index_find_value (&enum_exit_index, exit_text);
 }
 
 /**
@@ -572,7 +622,7 @@ pk_exit_enum_from_string (const gchar *exit_text)
 const gchar *
 pk_exit_enum_to_string (PkExitEnum exit_enum)
 {
-	return pk_enum_find_string (enum_exit, exit_enum);
+	return pk_enum_index_find_string (&enum_exit_index, exit_enum);
 }
 
 /**
@@ -588,7 +638,7 @@ pk_exit_enum_to_string (PkExitEnum exit_enum)
 PkNetworkEnum
 pk_network_enum_from_string (const gchar *network)
 {
-	return pk_enum_find_value (enum_network, network);
+	return pk_enum_index_find_value (&enum_network_index, network);
 }
 
 /**
@@ -604,7 +654,7 @@ pk_network_enum_from_string (const gchar *network)
 const gchar *
 pk_network_enum_to_string (PkNetworkEnum network)
 {
-	return pk_enum_find_string (enum_network, network);
+	return pk_enum_index_find_string (&enum_network_index, network);
 }
 
 /**
@@ -620,7 +670,7 @@ pk_network_enum_to_string (PkNetworkEnum network)
 PkStatusEnum
 pk_status_enum_from_string (const gchar *status)
 {
-	return pk_enum_find_value (enum_status, status);
+	return pk_enum_index_find_value (&enum_status_index, status);
 }
 
 /**
@@ -636,7 +686,7 @@ pk_status_enum_from_string (const gchar *status)
 const gchar *
 pk_status_enum_to_string (PkStatusEnum status)
 {
-	return pk_enum_find_string (enum_status, status);
+	return pk_enum_index_find_string (&enum_status_index, status);
 }
 
 /**
@@ -652,7 +702,7 @@ pk_status_enum_to_string (PkStatusEnum status)
 PkRoleEnum
 pk_role_enum_from_string (const gchar *role)
 {
-	return pk_enum_find_value (enum_role, role);
+	return pk_enum_index_find_value (&enum_role_index, role);
 }
 
 /**
@@ -668,7 +718,7 @@ pk_role_enum_from_string (const gchar *role)
 const gchar *
 pk_role_enum_to_string (PkRoleEnum role)
 {
-	return pk_enum_find_string (enum_role, role);
+	return pk_enum_index_find_string (&enum_role_index, role);
 }
 
 /**
@@ -684,7 +734,7 @@ pk_role_enum_to_string (PkRoleEnum role)
 PkErrorEnum
 pk_error_enum_from_string (const gchar *code)
 {
-	return pk_enum_find_value (enum_error, code);
+	return pk_enum_index_find_value (&enum_error_index, code);
 }
 
 /**
@@ -700,7 +750,7 @@ pk_error_enum_from_string (const gchar *code)
 const gchar *
 pk_error_enum_to_string (PkErrorEnum code)
 {
-	return pk_enum_find_string (enum_error, code);
+	return pk_enum_index_find_string (&enum_error_index, code);
 }
 
 /**
@@ -716,7 +766,7 @@ pk_error_enum_to_string (PkErrorEnum code)
 PkRestartEnum
 pk_restart_enum_from_string (const gchar *restart)
 {
-	return pk_enum_find_value (enum_restart, restart);
+	return pk_enum_index_find_value (&enum_restart_index, restart);
 }
 
 /**
@@ -732,7 +782,7 @@ pk_restart_enum_from_string (const gchar *restart)
 const gchar *
 pk_restart_enum_to_string (PkRestartEnum restart)
 {
-	return pk_enum_find_string (enum_restart, restart);
+	return pk_enum_index_find_string (&enum_restart_index, restart);
 }
 
 /**
@@ -748,7 +798,7 @@ pk_restart_enum_to_string (PkRestartEnum restart)
 PkGroupEnum
 pk_group_enum_from_string (const gchar *group)
 {
-	return pk_enum_find_value (enum_group, group);
+	return pk_enum_index_find_value (&enum_group_index, group);
 }
 
 /**
@@ -764,7 +814,7 @@ pk_group_enum_from_string (const gchar *group)
 const gchar *
 pk_group_enum_to_string (PkGroupEnum group)
 {
-	return pk_enum_find_string (enum_group, group);
+	return pk_enum_index_find_string (&enum_group_index, group);
 }
 
 /**
@@ -780,7 +830,7 @@ pk_group_enum_to_string (PkGroupEnum group)
 PkUpdateStateEnum
 pk_update_state_enum_from_string (const gchar *update_state)
 {
-	return pk_enum_find_value (enum_update_state, update_state);
+	return pk_enum_index_find_value (&enum_update_state_index, update_state);
 }
 
 /**
@@ -796,7 +846,7 @@ pk_update_state_enum_from_string (const gchar *update_state)
 const gchar *
 pk_update_state_enum_to_string (PkUpdateStateEnum update_state)
 {
-	return pk_enum_find_string (enum_update_state, update_state);
+	return pk_enum_index_find_string (&enum_update_state_index, update_state);
 }
 
 /**
@@ -812,7 +862,7 @@ pk_update_state_enum_to_string (PkUpdateStateEnum update_state)
 PkFilterEnum
 pk_filter_enum_from_string (const gchar *filter)
 {
-	return pk_enum_find_value (enum_filter, filter);
+	return pk_enum_index_find_value (&enum_filter_index, filter);
 }
 
 /**
@@ -828,7 +878,7 @@ pk_filter_enum_from_string (const gchar *filter)
 const gchar *
 pk_filter_enum_to_string (PkFilterEnum filter)
 {
-	return pk_enum_find_string (enum_filter, filter);
+	return pk_enum_index_find_string (&enum_filter_index, filter);
 }
 
 /**
@@ -844,7 +894,7 @@ pk_filter_enum_to_string (PkFilterEnum filter)
 PkMediaTypeEnum
 pk_media_type_enum_from_string (const gchar *media_type)
 {
-	return pk_enum_find_value (enum_media_type, media_type);
+	return pk_enum_index_find_value (&enum_media_type_index, media_type);
 }
 
 /**
@@ -860,7 +910,7 @@ pk_media_type_enum_from_string (const gchar *media_type)
 const gchar *
 pk_media_type_enum_to_string (PkMediaTypeEnum media_type)
 {
-	return pk_enum_find_string (enum_media_type, media_type);
+	return pk_enum_index_find_string (&enum_media_type_index, media_type);
 }
 
 /**
@@ -876,7 +926,7 @@ pk_media_type_enum_to_string (PkMediaTypeEnum media_type)
 PkAuthorizeEnum
 pk_authorize_type_enum_from_string (const gchar *authorize_type)
 {
-	return pk_enum_find_value (enum_authorize_type, authorize_type);
+	return pk_enum_index_find_value (&enum_authorize_type_index, authorize_type);
 }
 
 /**
@@ -892,7 +942,7 @@ pk_authorize_type_enum_from_string (const gchar *authorize_type)
 const gchar *
 pk_authorize_type_enum_to_string (PkAuthorizeEnum authorize_type)
 {
-	return pk_enum_find_string (enum_authorize_type, authorize_type);
+	return pk_enum_index_find_string (&enum_authorize_type_index, authorize_type);
 }
 
 /**
@@ -908,7 +958,7 @@ pk_authorize_type_enum_to_string (PkAuthorizeEnum authorize_type)
 PkUpgradeKindEnum
 pk_upgrade_kind_enum_from_string (const gchar *upgrade_kind)
 {
-	return pk_enum_find_value (enum_upgrade_kind, upgrade_kind);
+	return pk_enum_index_find_value (&enum_upgrade_kind_index, upgrade_kind);
 }
 
 /**
@@ -924,7 +974,7 @@ pk_upgrade_kind_enum_from_string (const gchar *upgrade_kind)
 const gchar *
 pk_upgrade_kind_enum_to_string (PkUpgradeKindEnum upgrade_kind)
 {
-	return pk_enum_find_string (enum_upgrade_kind, upgrade_kind);
+	return pk_enum_index_find_string (&enum_upgrade_kind_index, upgrade_kind);
 }
 
 /**
@@ -940,7 +990,7 @@ pk_upgrade_kind_enum_to_string (PkUpgradeKindEnum upgrade_kind)
 PkTransactionFlagEnum
 pk_transaction_flag_enum_from_string (const gchar *transaction_flag)
 {
-	return pk_enum_find_value (enum_transaction_flag, transaction_flag);
+	return pk_enum_index_find_value (&enum_transaction_flag_index, transaction_flag);
 }
 
 /**
@@ -956,7 +1006,7 @@ pk_transaction_flag_enum_from_string (const gchar *transaction_flag)
 const gchar *
 pk_transaction_flag_enum_to_string (PkTransactionFlagEnum transaction_flag)
 {
-	return pk_enum_find_string (enum_transaction_flag, transaction_flag);
+	return pk_enum_index_find_string (&enum_transaction_flag_index, transaction_flag);
 }
 
 /**
@@ -181,6 +181,7 @@ pk_offline_auth_invalidate (GError **error)
 	g_autoptr(GError) error_local = NULL;
 	g_autoptr(GFile) file1 = NULL;
 	g_autoptr(GFile) file2 = NULL;
+	g_autoptr(GFile) file3 = NULL;
 
 	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
@@ -212,6 +213,18 @@ pk_offline_auth_invalidate (GError **error)
 		return FALSE;
 	}
 
+	/* delete the plan for the prepared update */
+	file3 = g_file_new_for_path (PK_OFFLINE_PREPARED_PLAN_FILENAME);
+	if (g_file_query_exists (file3, NULL) && !g_file_delete (file3, NULL, &error_local)) {
+		g_set_error (error,
+			     PK_OFFLINE_ERROR,
+			     PK_OFFLINE_ERROR_FAILED,
+			     "Cannot delete %s: %s",
+			     PK_OFFLINE_PREPARED_PLAN_FILENAME,
+			     error_local->message);
+		return FALSE;
+	}
+
 	return TRUE;
 }
 
@@ -324,6 +337,128 @@ pk_offline_auth_set_prepared_ids (gchar **package_ids, GError **error)
 	return g_key_file_save_to_file (keyfile, PK_OFFLINE_PREPARED_FILENAME, error);
 }
 
+/*
+ * pk_offline_auth_set_prepared_plan:
+ * @backend: Name of the backend which made the plan, e.g. "dnf5"
+ * @stamp: The generation of the package database the plan was made against
+ * @package_ids: The package-ids the plan was made for
+ * @data: The plan, in a format only known to the backend
+ * @error: A #GError or %NULL
+ *
+ * Saves the depsolved transaction for a prepared update, so that the backend
+ * does not have to solve it again when the update is installed.
+ *
+ * Return value: %TRUE for success, else %FALSE and @error set
+ *
+ * Since: 1.3.8
+ **/
+gboolean
+pk_offline_auth_set_prepared_plan (const gchar *backend,
+				   const gchar *stamp,
+				   gchar **package_ids,
+				   const gchar *data,
+				   GError **error)
+{
+	const gchar *empty[] = { NULL };
+	g_autoptr(GKeyFile) keyfile = NULL;
+
+	g_return_val_if_fail (backend != NULL, FALSE);
+	g_return_val_if_fail (stamp != NULL, FALSE);
+	g_return_val_if_fail (data != NULL, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	if (package_ids == NULL)
+		package_ids = (gchar **) empty;
+
+	keyfile = g_key_file_new ();
+	g_key_file_set_list_separator (keyfile, ',');
+	g_key_file_set_string (keyfile, "plan", "backend", backend);
+	g_key_file_set_string (keyfile, "plan", "stamp", stamp);
+	g_key_file_set_string_list (keyfile,
+				    "plan",
+				    "prepared_ids",
+				    (const gchar **) package_ids,
+				    g_strv_length (package_ids));
+	g_key_file_set_string (keyfile, "plan", "data", data);
+	return g_key_file_save_to_file (keyfile, PK_OFFLINE_PREPARED_PLAN_FILENAME, error);
+}
+
+/*
+ * pk_offline_get_prepared_plan:
+ * @backend: Name of the backend asking for the plan
+ * @stamp: The current generation of the package database
+ * @package_ids: The package-ids about to be updated
+ * @error: A #GError or %NULL
+ *
+ * Gets the depsolved transaction saved by pk_offline_auth_set_prepared_plan(),
+ * but only if it was made by the same backend, against the same package
+ * database and for the same package-ids.
+ *
+ * Return value: (transfer full): the plan, or %NULL with @error set
+ *
+ * Since: 1.3.8
+ **/
+gchar *
+pk_offline_get_prepared_plan (const gchar *backend,
+			      const gchar *stamp,
+			      gchar **package_ids,
+			      GError **error)
+{
+	const gchar *empty[] = { NULL };
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GKeyFile) keyfile = NULL;
+	g_autofree gchar *backend_tmp = NULL;
+	g_autofree gchar *stamp_tmp = NULL;
+	g_auto(GStrv) package_ids_tmp = NULL;
+
+	g_return_val_if_fail (backend != NULL, NULL);
+	g_return_val_if_fail (stamp != NULL, NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	if (package_ids == NULL)
+		package_ids = (gchar **) empty;
+
+	keyfile = g_key_file_new ();
+	g_key_file_set_list_separator (keyfile, ',');
+	if (!g_key_file_load_from_file (keyfile,
+					PK_OFFLINE_PREPARED_PLAN_FILENAME,
+					G_KEY_FILE_NONE,
+					&error_local)) {
+		if (g_error_matches (error_local, G_FILE_ERROR, G_FILE_ERROR_NOENT)) {
+			g_set_error (error,
+				     PK_OFFLINE_ERROR,
+				     PK_OFFLINE_ERROR_NO_DATA,
+				     "No offline update plan has been prepared");
+			return NULL;
+		}
+		g_set_error (error,
+			     PK_OFFLINE_ERROR,
+			     PK_OFFLINE_ERROR_FAILED,
+			     "Failed to read %s: %s",
+			     PK_OFFLINE_PREPARED_PLAN_FILENAME,
+			     error_local->message);
+		return NULL;
+	}
+
+	/* only valid for the state it was made against */
+	backend_tmp = g_key_file_get_string (keyfile, "plan", "backend", NULL);
+	stamp_tmp = g_key_file_get_string (keyfile, "plan", "stamp", NULL);
+	package_ids_tmp = g_key_file_get_string_list (keyfile, "plan", "prepared_ids", NULL, NULL);
+	if (package_ids_tmp == NULL)
+		package_ids_tmp = g_new0 (gchar *, 1);
+	if (g_strcmp0 (backend_tmp, backend) != 0 ||
+	    g_strcmp0 (stamp_tmp, stamp) != 0 ||
+	    !g_strv_equal ((const gchar * const *) package_ids_tmp,
+			   (const gchar * const *) package_ids)) {
+		g_set_error (error,
+			     PK_OFFLINE_ERROR,
+			     PK_OFFLINE_ERROR_INVALID_VALUE,
+			     "The offline update plan is out of date");
+		return NULL;
+	}
+	return g_key_file_get_string (keyfile, "plan", "data", error);
+}
+
 /*
  * pk_offline_auth_set_prepared_upgrade:
  * @name: Distro name to upgrade to
@@ -47,6 +47,9 @@ G_BEGIN_DECLS
 #define PK_OFFLINE_PREPARED_UPGRADE_FILENAME \
 	PK_OFFLINE_DESTDIR "/var/lib/PackageKit/prepared-upgrade"
 
+/* the depsolved transaction for the prepared update, written by the backend */
+#define PK_OFFLINE_PREPARED_PLAN_FILENAME PK_OFFLINE_DESTDIR "/var/lib/PackageKit/prepared-update-plan"
+
 /* the trigger file that systemd uses to start a different boot target */
 #define PK_OFFLINE_TRIGGER_FILENAME PK_OFFLINE_DESTDIR "/system-update"
 
@@ -69,6 +72,15 @@ gboolean pk_offline_auth_trigger_upgrade (PkOfflineAction action,
 					  GError	**error);
 gboolean pk_offline_auth_set_prepared_ids (gchar  **package_ids,
 					   GError **error);
+gboolean pk_offline_auth_set_prepared_plan (const gchar *backend,
+					    const gchar *stamp,
+					    gchar      **package_ids,
+					    const gchar *data,
+					    GError     **error);
+gchar *pk_offline_get_prepared_plan (const gchar *backend,
+				     const gchar *stamp,
+				     gchar	**package_ids,
+				     GError	**error);
 gboolean pk_offline_auth_set_prepared_upgrade (const gchar *name,
 					       const gchar *release_ver,
 					       GError	  **error);
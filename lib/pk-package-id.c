@@ -27,6 +27,7 @@
 
 #include "config.h"
 
+#include <string.h>
 #include <glib.h>
 
 #include "pk-package-id.h"
@@ -63,6 +64,74 @@ out:
 	return NULL;
 }
 
+/**
+ * pk_package_id_parse:
+ * @package_id: the ; delimited PackageID to parse
+ * @view: (out caller-allocates): the sections of the PackageID
+ *
+ * Finds the sections of a PackageID without copying them, checking the
+ * same things as pk_package_id_split(). This is meant for backends which
+ * look up many PackageIDs at once, as nothing is allocated.
+ *
+ * The sections are only valid for as long as @package_id is.
+ *
+ * Return value: %TRUE if the PackageID was well formed
+ *
+ * Since: 1.3.8
+ **/
+gboolean
+pk_package_id_parse (const gchar *package_id, PkPackageIdView *view)
+{
+	const gchar *start = package_id;
+
+	g_return_val_if_fail (view != NULL, FALSE);
+
+	if (package_id == NULL)
+		return FALSE;
+
+	for (guint i = 0; i < PK_PACKAGE_ID_DATA; i++) {
+		const gchar *end = strchr (start, ';');
+		if (end == NULL)
+			return FALSE;
+		view->sections[i] = start;
+		view->lengths[i] = end - start;
+		start = end + 1;
+	}
+
+	/* the data is the rest, which cannot have another delimiter */
+	if (strchr (start, ';') != NULL)
+		return FALSE;
+	view->sections[PK_PACKAGE_ID_DATA] = start;
+	view->lengths[PK_PACKAGE_ID_DATA] = strlen (start);
+
+	/* name has to be valid */
+	return view->lengths[PK_PACKAGE_ID_NAME] > 0;
+}
+
+/**
+ * pk_package_id_view_equal:
+ * @view: the sections found by pk_package_id_parse()
+ * @section: the section, e.g. %PK_PACKAGE_ID_NAME
+ * @value: (nullable): the string to compare with
+ *
+ * Compares a section of a parsed PackageID with a string.
+ *
+ * Return value: %TRUE if the section is the same as @value
+ *
+ * Since: 1.3.8
+ **/
+gboolean
+pk_package_id_view_equal (const PkPackageIdView *view, guint section, const gchar *value)
+{
+	g_return_val_if_fail (view != NULL, FALSE);
+	g_return_val_if_fail (section <= PK_PACKAGE_ID_DATA, FALSE);
+
+	if (value == NULL)
+		return FALSE;
+	return strncmp (view->sections[section], value, view->lengths[section]) == 0 &&
+	       value[view->lengths[section]] == '\0';
+}
+
 /**
  * pk_package_id_check:
  * @package_id: the PackageID to check
@@ -76,7 +145,7 @@ out:
 gboolean
 pk_package_id_check (const gchar *package_id)
 {
-	g_auto(GStrv) sections = NULL;
+	PkPackageIdView view;
 	gboolean ret;
 
 	/* NULL check */
@@ -89,10 +158,7 @@ pk_package_id_check (const gchar *package_id)
 		return FALSE;
 
 	/* correct number of sections */
-	sections = pk_package_id_split (package_id);
-	if (sections == NULL)
-		return FALSE;
-	return TRUE;
+	return pk_package_id_parse (package_id, &view);
 }
 
 /**
@@ -58,12 +58,33 @@ G_BEGIN_DECLS
  */
 #define PK_PACKAGE_ID_DATA 3
 
+/**
+ * PkPackageIdView:
+ * @sections: the start of each section, indexed by %PK_PACKAGE_ID_NAME and so on
+ * @lengths: the length of each section in bytes
+ *
+ * The sections of a PackageID as found by pk_package_id_parse(). They point
+ * into the PackageID rather than being copies of it, so apart from the data
+ * they are not nul terminated.
+ *
+ * Since: 1.3.8
+ */
+typedef struct {
+	const gchar	*sections[4];
+	gsize		 lengths[4];
+} PkPackageIdView;
+
 gchar	*pk_package_id_build (const gchar *name,
 			      const gchar *version,
 			      const gchar *arch,
 			      const gchar *data);
 gboolean pk_package_id_check (const gchar *package_id);
 gchar  **pk_package_id_split (const gchar *package_id);
+gboolean pk_package_id_parse (const gchar	*package_id,
+			      PkPackageIdView	*view);
+gboolean pk_package_id_view_equal (const PkPackageIdView	*view,
+				   guint			 section,
+				   const gchar			*value);
 gchar	*pk_package_id_to_printable (const gchar *package_id);
 gboolean pk_package_id_equal_fuzzy_arch (const gchar *package_id1,
 					 const gchar *package_id2);
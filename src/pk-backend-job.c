@@ -65,6 +65,22 @@ typedef struct
 	gpointer user_data;
 } PkBackendJobVFuncItem;
 
+typedef enum {
+	PK_BACKEND_JOB_PROGRESS_PERCENTAGE = 1 << 0,
+	PK_BACKEND_JOB_PROGRESS_SPEED = 1 << 1,
+	PK_BACKEND_JOB_PROGRESS_DOWNLOAD_SIZE_REMAINING = 1 << 2,
+} PkBackendJobProgressFlags;
+
+/* progress for which only the latest value matters */
+typedef struct
+{
+	PkBackendJobProgressFlags changed;
+	guint percentage;
+	guint speed;
+	guint64 download_size_remaining;
+	GPtrArray *items; /* (element-type PkItemProgress) (nullable) */
+} PkBackendJobProgress;
+
 struct _PkBackendJob
 {
 	GObject parent;
@@ -108,7 +124,15 @@ struct _PkBackendJob
 	PkRoleEnum role;
 	PkStatusEnum status;
 	GTimer *timer;
+	gint64 finished_time;
 	gboolean started;
+	GPtrArray *subscribers; /* of PkBackendJob */
+
+	/* progress not yet sent to the main thread, protected by progress_mutex */
+	GMutex progress_mutex;
+	PkBackendJobProgress progress;
+	gboolean progress_scheduled;
+	guint progress_generation;
 };
 
 G_DEFINE_TYPE (PkBackendJob, pk_backend_job, G_TYPE_OBJECT)
@@ -551,6 +575,20 @@ pk_backend_job_get_runtime (PkBackendJob *job)
 	return g_timer_elapsed (job->timer, NULL) * 1000;
 }
 
+/**
+ * pk_backend_job_get_finished_time:
+ *
+ * Return value: the monotonic time in us when the backend called
+ * pk_backend_job_finished(), or 0 if it has not yet done so
+ */
+gint64
+pk_backend_job_get_finished_time (PkBackendJob *job)
+{
+	g_return_val_if_fail (PK_IS_BACKEND_JOB (job), 0);
+
+	return job->finished_time;
+}
+
 gboolean
 pk_backend_job_get_is_finished (PkBackendJob *job)
 {
@@ -623,6 +661,10 @@ pk_backend_job_signal_to_string (PkBackendJobSignal id)
 		return "UpdateDetails";
 	if (id == PK_BACKEND_SIGNAL_CATEGORY)
 		return "Category";
+	if (id == PK_BACKEND_SIGNAL_DETAILS_LIST)
+		return "DetailsList";
+	if (id == PK_BACKEND_SIGNAL_FILES_LIST)
+		return "FilesList";
 	return NULL;
 }
 
@@ -635,23 +677,201 @@ pk_backend_job_vfunc_event_free (PkBackendJobVFuncHelper *helper)
 	g_free (helper);
 }
 
-static gboolean
-pk_backend_job_call_vfunc_idle_cb (gpointer user_data)
+/* calls the vfunc of a job which is following another one */
+static void
+pk_backend_job_forward_vfunc (PkBackendJob *job,
+			      PkBackendJobSignal signal_kind,
+			      gpointer object)
 {
-	PkBackendJobVFuncHelper *helper = (PkBackendJobVFuncHelper *) user_data;
 	PkBackendJobVFuncItem *item;
 
+	switch (signal_kind) {
+	/* the subscriber handles these itself */
+	case PK_BACKEND_SIGNAL_ALLOW_CANCEL:
+	case PK_BACKEND_SIGNAL_FINISHED:
+	case PK_BACKEND_SIGNAL_LOCKED_CHANGED:
+		return;
+	/* the job is going to be retried */
+	case PK_BACKEND_SIGNAL_ERROR_CODE:
+		if (pk_error_get_code ((PkError *) object) == PK_ERROR_ENUM_LOCK_REQUIRED)
+			return;
+		break;
+	default:
+		break;
+	}
+
+	item = &job->vfunc_items[signal_kind];
+	if (item->enabled && item->vfunc != NULL)
+		item->vfunc (job, object, item->user_data);
+}
+
+/* calls the vfunc of a job and its subscribers, in the main thread */
+static void
+pk_backend_job_dispatch_vfunc (PkBackendJob *job,
+			       PkBackendJobSignal signal_kind,
+			       gpointer object)
+{
+	PkBackendJobVFuncItem *item;
+	g_autoptr(GPtrArray) subscribers = NULL;
+
 	/* call transaction vfunc on main thread */
-	item = &helper->job->vfunc_items[helper->signal_kind];
+	item = &job->vfunc_items[signal_kind];
 	if (item != NULL && item->vfunc != NULL) {
-		item->vfunc (helper->job, helper->object, item->user_data);
+		item->vfunc (job, object, item->user_data);
 	} else {
 		g_warning ("tried to do signal %s when no longer connected",
-			   pk_backend_job_signal_to_string (helper->signal_kind));
+			   pk_backend_job_signal_to_string (signal_kind));
+	}
+
+	/* and for the jobs that are following this one, which the vfuncs can
+	 * remove from the array while we walk it */
+	subscribers = g_ptr_array_copy (job->subscribers, (GCopyFunc) g_object_ref, NULL);
+	for (guint i = 0; i < subscribers->len; i++) {
+		PkBackendJob *subscriber = g_ptr_array_index (subscribers, i);
+		if (!g_ptr_array_find (job->subscribers, subscriber, NULL))
+			continue;
+		pk_backend_job_forward_vfunc (subscriber, signal_kind, object);
+	}
+}
+
+static gboolean
+pk_backend_job_call_vfunc_idle_cb (gpointer user_data)
+{
+	PkBackendJobVFuncHelper *helper = (PkBackendJobVFuncHelper *) user_data;
+
+	pk_backend_job_dispatch_vfunc (helper->job, helper->signal_kind, helper->object);
+	return FALSE;
+}
+
+/* used to send the progress to the main thread */
+typedef struct
+{
+	PkBackendJob *job;
+	guint generation;
+	gboolean taken;
+	PkBackendJobProgress progress;
+} PkBackendJobProgressHelper;
+
+static void
+pk_backend_job_progress_helper_free (PkBackendJobProgressHelper *helper)
+{
+	g_clear_pointer (&helper->progress.items, g_ptr_array_unref);
+	g_clear_object (&helper->job);
+	g_free (helper);
+}
+
+/* must be called with progress_mutex held */
+static void
+pk_backend_job_progress_take (PkBackendJob *job, PkBackendJobProgress *progress)
+{
+	*progress = job->progress;
+	job->progress.changed = 0;
+	job->progress.items = NULL;
+	job->progress_scheduled = FALSE;
+	job->progress_generation++;
+}
+
+static gboolean
+pk_backend_job_progress_idle_cb (gpointer user_data)
+{
+	PkBackendJobProgressHelper *helper = (PkBackendJobProgressHelper *) user_data;
+	PkBackendJob *job = helper->job;
+	PkBackendJobProgress *progress = &helper->progress;
+
+	/* get the latest values, unless they were sent ahead of another signal */
+	if (!helper->taken) {
+		g_mutex_lock (&job->progress_mutex);
+		if (helper->generation == job->progress_generation)
+			pk_backend_job_progress_take (job, progress);
+		g_mutex_unlock (&job->progress_mutex);
+	}
+
+	if (progress->changed & PK_BACKEND_JOB_PROGRESS_PERCENTAGE) {
+		pk_backend_job_dispatch_vfunc (job,
+					       PK_BACKEND_SIGNAL_PERCENTAGE,
+					       GUINT_TO_POINTER (progress->percentage));
+	}
+	if (progress->changed & PK_BACKEND_JOB_PROGRESS_SPEED) {
+		pk_backend_job_dispatch_vfunc (job,
+					       PK_BACKEND_SIGNAL_SPEED,
+					       GUINT_TO_POINTER (progress->speed));
+	}
+	if (progress->changed & PK_BACKEND_JOB_PROGRESS_DOWNLOAD_SIZE_REMAINING) {
+		pk_backend_job_dispatch_vfunc (job,
+					       PK_BACKEND_SIGNAL_DOWNLOAD_SIZE_REMAINING,
+					       &progress->download_size_remaining);
+	}
+	for (guint i = 0; progress->items != NULL && i < progress->items->len; i++) {
+		pk_backend_job_dispatch_vfunc (job,
+					       PK_BACKEND_SIGNAL_ITEM_PROGRESS,
+					       g_ptr_array_index (progress->items, i));
 	}
 	return FALSE;
 }
 
+static void
+pk_backend_job_progress_attach (PkBackendJobProgressHelper *helper)
+{
+	g_autoptr(GSource) source = g_idle_source_new ();
+
+	g_source_set_priority (source, G_PRIORITY_DEFAULT_IDLE);
+	g_source_set_callback (source,
+			       pk_backend_job_progress_idle_cb,
+			       helper,
+			       (GDestroyNotify) pk_backend_job_progress_helper_free);
+	g_source_set_name (source, "[PkBackendJob] progress_idle_cb");
+	g_source_attach (source, NULL);
+}
+
+/*
+ * Backends can set the progress many thousands of times a second, so rather
+ * than waking the main thread for each value only the latest one is kept,
+ * and a single idle sends everything that changed since it was scheduled.
+ *
+ * Must be called with progress_mutex held.
+ */
+static void
+pk_backend_job_progress_schedule (PkBackendJob *job)
+{
+	PkBackendJobProgressHelper *helper;
+
+	if (job->progress_scheduled)
+		return;
+	job->progress_scheduled = TRUE;
+
+	helper = g_new0 (PkBackendJobProgressHelper, 1);
+	helper->job = g_object_ref (job);
+	helper->generation = job->progress_generation;
+	pk_backend_job_progress_attach (helper);
+}
+
+/* sends the progress which is waiting now, so it stays ahead of any other
+ * signal which is being queued */
+static void
+pk_backend_job_progress_flush (PkBackendJob *job)
+{
+	PkBackendJobProgressHelper *helper = NULL;
+
+	g_mutex_lock (&job->progress_mutex);
+	if (job->progress_scheduled) {
+		helper = g_new0 (PkBackendJobProgressHelper, 1);
+		helper->job = g_object_ref (job);
+		helper->taken = TRUE;
+		pk_backend_job_progress_take (job, &helper->progress);
+	}
+	g_mutex_unlock (&job->progress_mutex);
+
+	if (helper != NULL)
+		pk_backend_job_progress_attach (helper);
+}
+
+static gboolean
+pk_backend_job_vfunc_is_connected (PkBackendJob *job, PkBackendJobSignal signal_kind)
+{
+	PkBackendJobVFuncItem *item = &job->vfunc_items[signal_kind];
+	return item->enabled && item->vfunc != NULL;
+}
+
 /**
  * pk_backend_job_call_vfunc:
  *
@@ -674,6 +894,9 @@ pk_backend_job_call_vfunc (PkBackendJob *job,
 	if (!item->enabled || item->vfunc == NULL)
 		return;
 
+	/* progress set before this has to be sent before it */
+	pk_backend_job_progress_flush (job);
+
 	/* order this last if others are still pending */
 	if (signal_kind == PK_BACKEND_SIGNAL_FINISHED)
 		priority = G_PRIORITY_LOW;
@@ -694,6 +917,34 @@ pk_backend_job_call_vfunc (PkBackendJob *job,
 	g_source_attach (source, NULL);
 }
 
+/**
+ * pk_backend_job_add_subscriber:
+ * @job: A valid PkBackendJob
+ * @subscriber: A job which wants the same results as @job
+ *
+ * Everything @job emits from now on is also sent to the vfuncs of
+ * @subscriber, apart from ::Finished(), which the caller has to handle.
+ **/
+void
+pk_backend_job_add_subscriber (PkBackendJob *job, PkBackendJob *subscriber)
+{
+	g_return_if_fail (PK_IS_BACKEND_JOB (job));
+	g_return_if_fail (PK_IS_BACKEND_JOB (subscriber));
+	g_return_if_fail (pk_is_thread_default ());
+
+	g_ptr_array_add (job->subscribers, g_object_ref (subscriber));
+}
+
+void
+pk_backend_job_remove_subscriber (PkBackendJob *job, PkBackendJob *subscriber)
+{
+	g_return_if_fail (PK_IS_BACKEND_JOB (job));
+	g_return_if_fail (PK_IS_BACKEND_JOB (subscriber));
+	g_return_if_fail (pk_is_thread_default ());
+
+	g_ptr_array_remove (job->subscribers, subscriber);
+}
+
 /**
  * pk_backend_job_set_vfunc:
  * @job: A valid PkBackendJob
@@ -863,10 +1114,13 @@ pk_backend_job_set_percentage (PkBackendJob *job, guint percentage)
 
 	/* save in case we need this from coldplug */
 	job->percentage = percentage;
-	pk_backend_job_call_vfunc (job,
-				   PK_BACKEND_SIGNAL_PERCENTAGE,
-				   GUINT_TO_POINTER (percentage),
-				   NULL);
+	if (!pk_backend_job_vfunc_is_connected (job, PK_BACKEND_SIGNAL_PERCENTAGE))
+		return;
+	g_mutex_lock (&job->progress_mutex);
+	job->progress.percentage = percentage;
+	job->progress.changed |= PK_BACKEND_JOB_PROGRESS_PERCENTAGE;
+	pk_backend_job_progress_schedule (job);
+	g_mutex_unlock (&job->progress_mutex);
 }
 
 void
@@ -886,13 +1140,18 @@ pk_backend_job_set_speed (PkBackendJob *job, guint speed)
 
 	/* set new value */
 	job->speed = speed;
-	pk_backend_job_call_vfunc (job, PK_BACKEND_SIGNAL_SPEED, GUINT_TO_POINTER (speed), NULL);
+	if (!pk_backend_job_vfunc_is_connected (job, PK_BACKEND_SIGNAL_SPEED))
+		return;
+	g_mutex_lock (&job->progress_mutex);
+	job->progress.speed = speed;
+	job->progress.changed |= PK_BACKEND_JOB_PROGRESS_SPEED;
+	pk_backend_job_progress_schedule (job);
+	g_mutex_unlock (&job->progress_mutex);
 }
 
 void
 pk_backend_job_set_download_size_remaining (PkBackendJob *job, guint64 download_size_remaining)
 {
-	guint64 *tmp;
 	g_return_if_fail (PK_IS_BACKEND_JOB (job));
 
 	/* have we already set an error? */
@@ -907,11 +1166,13 @@ pk_backend_job_set_download_size_remaining (PkBackendJob *job, guint64 download_
 
 	/* set new value */
 	job->download_size_remaining = download_size_remaining;
-
-	/* we can't squash a 64bit value into a pointer on a 32bit arch */
-	tmp = g_new0 (guint64, 1);
-	*tmp = download_size_remaining;
-	pk_backend_job_call_vfunc (job, PK_BACKEND_SIGNAL_DOWNLOAD_SIZE_REMAINING, tmp, g_free);
+	if (!pk_backend_job_vfunc_is_connected (job, PK_BACKEND_SIGNAL_DOWNLOAD_SIZE_REMAINING))
+		return;
+	g_mutex_lock (&job->progress_mutex);
+	job->progress.download_size_remaining = download_size_remaining;
+	job->progress.changed |= PK_BACKEND_JOB_PROGRESS_DOWNLOAD_SIZE_REMAINING;
+	pk_backend_job_progress_schedule (job);
+	g_mutex_unlock (&job->progress_mutex);
 }
 
 void
@@ -920,7 +1181,8 @@ pk_backend_job_set_item_progress (PkBackendJob *job,
 				  PkStatusEnum status,
 				  guint percentage)
 {
-	PkItemProgress *item;
+	GPtrArray *items;
+	g_autoptr(PkItemProgress) item = NULL;
 	g_return_if_fail (PK_IS_BACKEND_JOB (job));
 
 	/* have we already set an error? */
@@ -935,7 +1197,10 @@ pk_backend_job_set_item_progress (PkBackendJob *job,
 		return;
 	}
 
-	/* emit */
+	if (!pk_backend_job_vfunc_is_connected (job, PK_BACKEND_SIGNAL_ITEM_PROGRESS))
+		return;
+
+	/* sent to the main thread with the other progress */
 	item = g_object_new (PK_TYPE_ITEM_PROGRESS,
 			     "package-id",
 			     package_id,
@@ -944,11 +1209,26 @@ pk_backend_job_set_item_progress (PkBackendJob *job,
 			     "percentage",
 			     percentage,
 			     NULL);
-	pk_backend_job_call_vfunc (job,
-				   PK_BACKEND_SIGNAL_ITEM_PROGRESS,
-				   g_object_ref (item),
-				   g_object_unref);
-	g_object_unref (item);
+	g_mutex_lock (&job->progress_mutex);
+	if (job->progress.items == NULL)
+		job->progress.items = g_ptr_array_new_with_free_func (g_object_unref);
+	items = job->progress.items;
+
+	/* replace the last update of the package, unless it changed status */
+	for (guint i = items->len; i > 0; i--) {
+		PkItemProgress *item_tmp = g_ptr_array_index (items, i - 1);
+		if (g_strcmp0 (pk_item_progress_get_package_id (item_tmp), package_id) != 0)
+			continue;
+		if (pk_item_progress_get_status (item_tmp) == status) {
+			g_ptr_array_index (items, i - 1) = g_steal_pointer (&item);
+			g_object_unref (item_tmp);
+		}
+		break;
+	}
+	if (item != NULL)
+		g_ptr_array_add (items, g_steal_pointer (&item));
+	pk_backend_job_progress_schedule (job);
+	g_mutex_unlock (&job->progress_mutex);
 }
 
 void
@@ -1326,6 +1606,29 @@ pk_backend_job_details (PkBackendJob *job,
 				   g_object_unref);
 }
 
+void
+pk_backend_job_details_list (PkBackendJob *job,
+			     GPtrArray *details /* (element-type PkDetails) */)
+{
+	g_return_if_fail (PK_IS_BACKEND_JOB (job));
+	g_return_if_fail (details != NULL);
+
+	/* have we already set an error? */
+	if (job->set_error) {
+		g_warning ("already set error: details-list");
+		return;
+	}
+
+	/* emit; this relies on the @details array having ownership of all its
+	 * elements, as the job is asynchronous so they may be freed in their
+	 * original calling context */
+	if (details->len > 0)
+		pk_backend_job_call_vfunc (job,
+					   PK_BACKEND_SIGNAL_DETAILS_LIST,
+					   g_ptr_array_ref (details),
+					   (GDestroyNotify) g_ptr_array_unref);
+}
+
 /**
  * pk_backend_job_files:
  *
@@ -1367,6 +1670,42 @@ pk_backend_job_files (PkBackendJob *job, const gchar *package_id, gchar **files)
 	job->download_files++;
 }
 
+void
+pk_backend_job_files_list (PkBackendJob *job,
+			   GPtrArray *files /* (element-type PkFiles) */)
+{
+	g_return_if_fail (PK_IS_BACKEND_JOB (job));
+	g_return_if_fail (files != NULL);
+
+	/* have we already set an error? */
+	if (job->set_error) {
+		g_warning ("already set error: files-list");
+		return;
+	}
+
+	/* check we are valid */
+	for (guint i = 0; i < files->len; i++) {
+		PkFiles *item = g_ptr_array_index (files, i);
+		const gchar *package_id = pk_files_get_package_id (item);
+		if (package_id != NULL && !pk_package_id_check (package_id)) {
+			g_warning ("package_id invalid and cannot be processed: %s", package_id);
+			return;
+		}
+	}
+
+	/* emit; this relies on the @files array having ownership of all its
+	 * elements, as the job is asynchronous so they may be freed in their
+	 * original calling context */
+	if (files->len > 0)
+		pk_backend_job_call_vfunc (job,
+					   PK_BACKEND_SIGNAL_FILES_LIST,
+					   g_ptr_array_ref (files),
+					   (GDestroyNotify) g_ptr_array_unref);
+
+	/* success */
+	job->download_files += files->len;
+}
+
 void
 pk_backend_job_distro_upgrade (PkBackendJob *job,
 			       PkDistroUpgradeEnum state,
@@ -1798,6 +2137,7 @@ pk_backend_job_finished (PkBackendJob *job)
 
 	/* we can't ever be re-used */
 	job->finished = TRUE;
+	job->finished_time = g_get_monotonic_time ();
 
 	/* this wasn't set otherwise, assume success */
 	if (job->exit == PK_EXIT_ENUM_UNKNOWN)
@@ -1832,6 +2172,9 @@ pk_backend_job_finalize (GObject *object)
 	g_clear_pointer (&job->locale, g_free);
 	g_clear_pointer (&job->frontend_socket, g_free);
 	g_clear_pointer (&job->emitted, g_hash_table_unref);
+	g_clear_pointer (&job->subscribers, g_ptr_array_unref);
+	g_clear_pointer (&job->progress.items, g_ptr_array_unref);
+	g_mutex_clear (&job->progress_mutex);
 	g_clear_pointer (&job->params, g_variant_unref);
 	g_clear_pointer (&job->timer, g_timer_destroy);
 	g_clear_pointer (&job->conf, g_key_file_unref);
@@ -1863,6 +2206,8 @@ pk_backend_job_init (PkBackendJob *job)
 					      g_str_equal,
 					      g_free,
 					      (GDestroyNotify) g_object_unref);
+	job->subscribers = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	g_mutex_init (&job->progress_mutex);
 }
 
 /**
@@ -65,12 +65,18 @@ typedef enum {
 	PK_BACKEND_SIGNAL_UPDATE_DETAIL,
 	PK_BACKEND_SIGNAL_UPDATE_DETAILS,
 	PK_BACKEND_SIGNAL_CATEGORY,
+	PK_BACKEND_SIGNAL_DETAILS_LIST,
+	PK_BACKEND_SIGNAL_FILES_LIST,
 	PK_BACKEND_SIGNAL_LAST
 } PkBackendJobSignal;
 
 PkBackendJob *pk_backend_job_new (GKeyFile *conf);
 
 void	      pk_backend_job_disconnect_vfuncs (PkBackendJob *job);
+void	      pk_backend_job_add_subscriber (PkBackendJob *job,
+					     PkBackendJob *subscriber);
+void	      pk_backend_job_remove_subscriber (PkBackendJob *job,
+						PkBackendJob *subscriber);
 gpointer      pk_backend_job_get_backend (PkBackendJob *job);
 void	      pk_backend_job_set_backend (PkBackendJob *job,
 					  gpointer	backend);
@@ -102,6 +108,7 @@ void	      pk_backend_job_set_exit_code (PkBackendJob *job,
 					    PkExitEnum	  exit);
 gboolean      pk_backend_job_has_set_error_code (PkBackendJob *job);
 guint	      pk_backend_job_get_runtime (PkBackendJob *job);
+gint64	      pk_backend_job_get_finished_time (PkBackendJob *job);
 gboolean      pk_backend_job_get_is_finished (PkBackendJob *job);
 gboolean      pk_backend_job_get_is_error_set (PkBackendJob *job);
 gboolean      pk_backend_job_get_allow_cancel (PkBackendJob *job);
@@ -203,9 +210,13 @@ void	 pk_backend_job_details (PkBackendJob *job,
 				 const gchar  *url,
 				 gulong	       size,
 				 guint64       download_size);
+void	 pk_backend_job_details_list (PkBackendJob *job,
+				      GPtrArray    *details);
 void	 pk_backend_job_files (PkBackendJob *job,
 			       const gchar  *package_id,
 			       gchar	   **files);
+void	 pk_backend_job_files_list (PkBackendJob *job,
+				    GPtrArray	 *files);
 void	 pk_backend_job_distro_upgrade (PkBackendJob	   *job,
 					PkDistroUpgradeEnum type,
 					const gchar	   *name,
@@ -21,12 +21,15 @@
 
 #include <config.h>
 
+#include <errno.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <unistd.h>
 
 #include <glib/gi18n.h>
 #include <glib.h>
+#include <glib/gstdio.h>
 #include <gmodule.h>
 #include <pk-offline-private.h>
 #include <pk-package-id.h>
@@ -177,8 +180,23 @@ struct _PkBackend
 	guint repo_list_changed_id;
 	guint installed_db_changed_id;
 	guint updates_changed_id;
+	gboolean result_cache_enabled;
+	GHashTable *result_cache;
+	GMutex result_cache_mutex;
+	guint result_cache_generation;
+	guint64 result_cache_hits;
+	guint64 result_cache_misses;
+	gchar *download_cache_directory;
 };
 
+/* the cache is simply emptied when it is full */
+#define PK_BACKEND_RESULT_CACHE_MAX_ENTRIES	64
+
+typedef struct {
+	PkResults *results;
+	gint64 ctime;
+} PkBackendResultCacheItem;
+
 G_DEFINE_TYPE (PkBackend, pk_backend, G_TYPE_OBJECT)
 
 enum {
@@ -600,6 +618,9 @@ pk_backend_repo_list_changed (PkBackend *backend)
 	g_return_if_fail (PK_IS_BACKEND (backend));
 	g_return_if_fail (backend->loaded);
 
+	/* do not answer any more queries with the old results */
+	pk_backend_result_cache_invalidate (backend);
+
 	/* already scheduled */
 	if (backend->repo_list_changed_id != 0)
 		return;
@@ -613,6 +634,8 @@ pk_backend_updates_changed (PkBackend *backend)
 	g_return_val_if_fail (PK_IS_BACKEND (backend), FALSE);
 	g_return_val_if_fail (pk_is_thread_default (), FALSE);
 
+	pk_backend_result_cache_invalidate (backend);
+
 	g_debug ("emitting updates-changed");
 	g_signal_emit (backend, signals[SIGNAL_UPDATES_CHANGED], 0);
 	return TRUE;
@@ -682,6 +705,9 @@ pk_backend_installed_db_changed (PkBackend *backend)
 	g_return_if_fail (PK_IS_BACKEND (backend));
 	g_return_if_fail (backend->loaded);
 
+	/* do not answer any more queries with the old results */
+	pk_backend_result_cache_invalidate (backend);
+
 	/* already scheduled */
 	if (backend->installed_db_changed_id != 0)
 		return;
@@ -690,6 +716,150 @@ pk_backend_installed_db_changed (PkBackend *backend)
 	backend->installed_db_changed_id = g_idle_add (pk_backend_installed_db_changed_cb, backend);
 }
 
+static void
+pk_backend_result_cache_item_free (PkBackendResultCacheItem *item)
+{
+	g_object_unref (item->results);
+	g_free (item);
+}
+
+/**
+ * pk_backend_result_cache_lookup:
+ * @key: a string describing the query, including everything that may change
+ * the results
+ * @max_age: the maximum age of the results in seconds, or %G_MAXUINT
+ *
+ * Finds the results of an earlier query which can be replayed to the client
+ * rather than asking the backend again.
+ *
+ * Return value: (transfer full): the #PkResults, or %NULL if not found
+ **/
+PkResults *
+pk_backend_result_cache_lookup (PkBackend *backend, const gchar *key, guint max_age)
+{
+	PkBackendResultCacheItem *item;
+	PkResults *results = NULL;
+
+	g_return_val_if_fail (PK_IS_BACKEND (backend), NULL);
+	g_return_val_if_fail (key != NULL, NULL);
+
+	if (!backend->result_cache_enabled)
+		return NULL;
+
+	g_mutex_lock (&backend->result_cache_mutex);
+	item = g_hash_table_lookup (backend->result_cache, key);
+	if (item != NULL && max_age != G_MAXUINT &&
+	    g_get_monotonic_time () - item->ctime > (gint64) max_age * G_USEC_PER_SEC) {
+		g_debug ("cached results for %s are too old", key);
+		item = NULL;
+	}
+	if (item != NULL) {
+		results = g_object_ref (item->results);
+		backend->result_cache_hits++;
+	} else {
+		backend->result_cache_misses++;
+	}
+	g_mutex_unlock (&backend->result_cache_mutex);
+	return results;
+}
+
+/**
+ * pk_backend_result_cache_add:
+ * @generation: the value of pk_backend_result_cache_get_generation() when
+ * the query was started
+ *
+ * Saves the results of a query. The results are dropped if the cache has
+ * been invalidated since the query was started, as they may already be out
+ * of date.
+ **/
+void
+pk_backend_result_cache_add (PkBackend *backend,
+			     const gchar *key,
+			     guint generation,
+			     PkResults *results)
+{
+	PkBackendResultCacheItem *item;
+
+	g_return_if_fail (PK_IS_BACKEND (backend));
+	g_return_if_fail (key != NULL);
+	g_return_if_fail (PK_IS_RESULTS (results));
+
+	if (!backend->result_cache_enabled)
+		return;
+
+	g_mutex_lock (&backend->result_cache_mutex);
+	if (generation != backend->result_cache_generation) {
+		g_debug ("not caching results for %s as they may be stale", key);
+		g_mutex_unlock (&backend->result_cache_mutex);
+		return;
+	}
+	if (g_hash_table_size (backend->result_cache) >= PK_BACKEND_RESULT_CACHE_MAX_ENTRIES)
+		g_hash_table_remove_all (backend->result_cache);
+	item = g_new0 (PkBackendResultCacheItem, 1);
+	item->results = g_object_ref (results);
+	item->ctime = g_get_monotonic_time ();
+	g_hash_table_insert (backend->result_cache, g_strdup (key), item);
+	g_mutex_unlock (&backend->result_cache_mutex);
+}
+
+/**
+ * pk_backend_result_cache_invalidate:
+ *
+ * Drops all the cached results, and the results of any queries which are
+ * still running.
+ *
+ * This function can be called on any thread.
+ **/
+void
+pk_backend_result_cache_invalidate (PkBackend *backend)
+{
+	g_return_if_fail (PK_IS_BACKEND (backend));
+
+	g_mutex_lock (&backend->result_cache_mutex);
+	backend->result_cache_generation++;
+	g_hash_table_remove_all (backend->result_cache);
+	g_mutex_unlock (&backend->result_cache_mutex);
+}
+
+guint
+pk_backend_result_cache_get_generation (PkBackend *backend)
+{
+	guint generation;
+
+	g_return_val_if_fail (PK_IS_BACKEND (backend), 0);
+
+	g_mutex_lock (&backend->result_cache_mutex);
+	generation = backend->result_cache_generation;
+	g_mutex_unlock (&backend->result_cache_mutex);
+	return generation;
+}
+
+guint64
+pk_backend_result_cache_get_hits (PkBackend *backend)
+{
+	guint64 hits;
+
+	g_return_val_if_fail (PK_IS_BACKEND (backend), 0);
+
+	g_mutex_lock (&backend->result_cache_mutex);
+	hits = backend->result_cache_hits;
+	g_mutex_unlock (&backend->result_cache_mutex);
+	return hits;
+}
+
+guint64
+pk_backend_result_cache_get_misses (PkBackend *backend)
+{
+	guint64 misses;
+
+	g_return_val_if_fail (PK_IS_BACKEND (backend), 0);
+
+	g_mutex_lock (&backend->result_cache_mutex);
+	misses = backend->result_cache_misses;
+	g_mutex_unlock (&backend->result_cache_mutex);
+	return misses;
+}
+
 /**
  * pk_backend_transaction_inhibit_start:
  *
@@ -971,6 +1141,201 @@ pk_backend_get_accepted_eula_string (PkBackend *backend)
 	return g_string_free (string, FALSE);
 }
 
+/* the downloads of earlier transactions, by the checksum of the package */
+static gchar *
+pk_backend_download_cache_path (PkBackend *backend, const gchar *checksum)
+{
+	if (g_key_file_get_integer (backend->conf, "Daemon", "DownloadCacheAge", NULL) <= 0)
+		return NULL;
+
+	/* the checksum is used as the file name */
+	if (checksum == NULL || checksum[0] == '\0' || strlen (checksum) > 255)
+		return NULL;
+	for (guint i = 0; checksum[i] != '\0'; i++) {
+		if (!g_ascii_isalnum (checksum[i]) && strchr (":-_", checksum[i]) == NULL)
+			return NULL;
+	}
+	return g_build_filename (backend->download_cache_directory, checksum, NULL);
+}
+
+/* only packages we can verify are cached, see pk_backend_download_cache_verify() */
+static gboolean
+pk_backend_download_cache_checksum_type (const gchar *checksum, GChecksumType *type)
+{
+	const struct {
+		const gchar	*name;
+		GChecksumType	 type;
+	} types[] = {
+		{ "md5:",	G_CHECKSUM_MD5 },
+		{ "sha1:",	G_CHECKSUM_SHA1 },
+		{ "sha256:",	G_CHECKSUM_SHA256 },
+		{ "sha384:",	G_CHECKSUM_SHA384 },
+		{ "sha512:",	G_CHECKSUM_SHA512 },
+	};
+
+	for (guint i = 0; i < G_N_ELEMENTS (types); i++) {
+		if (g_str_has_prefix (checksum, types[i].name)) {
+			*type = types[i].type;
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+static gboolean
+pk_backend_download_cache_verify (const gchar *checksum, const gchar *filename)
+{
+	GChecksumType type;
+	gssize len;
+	guchar buf[64 * 1024];
+	g_autoptr(GChecksum) hash = NULL;
+	g_autoptr(GFileInputStream) stream = NULL;
+	g_autoptr(GFile) file = NULL;
+
+	if (!pk_backend_download_cache_checksum_type (checksum, &type))
+		return FALSE;
+	file = g_file_new_for_path (filename);
+	stream = g_file_read (file, NULL, NULL);
+	if (stream == NULL)
+		return FALSE;
+	hash = g_checksum_new (type);
+	while ((len = g_input_stream_read (G_INPUT_STREAM (stream), buf, sizeof (buf), NULL, NULL)) > 0)
+		g_checksum_update (hash, buf, len);
+	if (len < 0)
+		return FALSE;
+	return g_ascii_strcasecmp (strchr (checksum, ':') + 1, g_checksum_get_string (hash)) == 0;
+}
+
+/**
+ * pk_backend_set_download_cache_directory:
+ * @backend: a #PkBackend
+ * @directory: where to keep downloaded packages
+ *
+ * Overrides the directory used by pk_backend_download_cache_link(), which
+ * is only useful for the self tests.
+ **/
+void
+pk_backend_set_download_cache_directory (PkBackend *backend, const gchar *directory)
+{
+	g_return_if_fail (PK_IS_BACKEND (backend));
+	g_return_if_fail (directory != NULL);
+
+	g_free (backend->download_cache_directory);
+	backend->download_cache_directory = g_strdup (directory);
+}
+
+/**
+ * pk_backend_download_cache_link:
+ * @backend: a #PkBackend
+ * @checksum: the checksum of the package, e.g. "sha256:0123…"
+ * @filename: where DownloadPackages should put the package
+ *
+ * Hard links a package which was downloaded for an earlier transaction to
+ * @filename, so that it does not have to be downloaded again. This only
+ * works for the directory passed to pk_backend_download_packages(), which
+ * is on the same filesystem as the cache.
+ *
+ * The cached file is checked against @checksum first, and removed from the
+ * cache if it does not match.
+ *
+ * Return value: %TRUE if the package was in the cache
+ **/
+gboolean
+pk_backend_download_cache_link (PkBackend *backend, const gchar *checksum, const gchar *filename)
+{
+	g_autofree gchar *path = NULL;
+
+	g_return_val_if_fail (PK_IS_BACKEND (backend), FALSE);
+	g_return_val_if_fail (filename != NULL, FALSE);
+
+	path = pk_backend_download_cache_path (backend, checksum);
+	if (path == NULL)
+		return FALSE;
+	if (!g_file_test (path, G_FILE_TEST_IS_REGULAR))
+		return FALSE;
+	if (!pk_backend_download_cache_verify (checksum, path)) {
+		g_warning ("removing %s from the download cache, it does not match", checksum);
+		g_unlink (path);
+		return FALSE;
+	}
+
+	/* this also updates the ctime, which is what expiry looks at, so
+	 * the files delivered by earlier transactions are not changed */
+	if (link (path, filename) != 0)
+		return FALSE;
+	g_debug ("using %s from the download cache", checksum);
+	return TRUE;
+}
+
+/**
+ * pk_backend_download_cache_add:
+ * @backend: a #PkBackend
+ * @checksum: the checksum of the package, e.g. "sha256:0123…"
+ * @filename: the package which was downloaded
+ *
+ * Adds a downloaded package to the cache used by
+ * pk_backend_download_cache_link(), if the cache is enabled using the
+ * DownloadCacheAge config key.
+ **/
+void
+pk_backend_download_cache_add (PkBackend *backend, const gchar *checksum, const gchar *filename)
+{
+	GChecksumType type;
+	g_autofree gchar *path = NULL;
+
+	g_return_if_fail (PK_IS_BACKEND (backend));
+	g_return_if_fail (filename != NULL);
+
+	path = pk_backend_download_cache_path (backend, checksum);
+	if (path == NULL)
+		return;
+	if (!pk_backend_download_cache_checksum_type (checksum, &type))
+		return;
+	if (g_mkdir_with_parents (backend->download_cache_directory, 0755) != 0) {
+		g_warning ("cannot create %s: %s",
+			   backend->download_cache_directory, g_strerror (errno));
+		return;
+	}
+	if (link (filename, path) != 0 && errno != EEXIST)
+		g_debug ("cannot add %s to the download cache: %s", filename, g_strerror (errno));
+}
+
+/**
+ * pk_backend_download_cache_expire:
+ * @backend: a #PkBackend
+ *
+ * Removes the packages which have not been used for DownloadCacheAge
+ * seconds from the download cache, or all of them if it is disabled.
+ **/
+void
+pk_backend_download_cache_expire (PkBackend *backend)
+{
+	const gchar *name;
+	gint age;
+	gint64 now = g_get_real_time () / G_USEC_PER_SEC;
+	g_autoptr(GDir) dir = NULL;
+
+	g_return_if_fail (PK_IS_BACKEND (backend));
+
+	dir = g_dir_open (backend->download_cache_directory, 0, NULL);
+	if (dir == NULL)
+		return;
+	age = g_key_file_get_integer (backend->conf, "Daemon", "DownloadCacheAge", NULL);
+	while ((name = g_dir_read_name (dir)) != NULL) {
+		g_autofree gchar *path = g_build_filename (backend->download_cache_directory, name, NULL);
+		GStatBuf st;
+
+		if (g_stat (path, &st) != 0)
+			continue;
+
+		/* every link() in and out of the cache changes the ctime */
+		if (age > 0 && now - st.st_ctime < age)
+			continue;
+		g_debug ("removing %s from the download cache", name);
+		g_unlink (path);
+	}
+}
+
 gpointer
 pk_backend_get_user_data (PkBackend *backend)
 {
@@ -1049,6 +1414,9 @@ pk_backend_finalize (GObject *object)
 	g_mutex_clear (&backend->eulas_mutex);
 	g_mutex_clear (&backend->thread_hash_mutex);
 	g_hash_table_unref (backend->thread_hash);
+	g_mutex_clear (&backend->result_cache_mutex);
+	g_hash_table_unref (backend->result_cache);
+	g_free (backend->download_cache_directory);
 	g_free (backend->desc);
 
 	if (backend->monitor != NULL)
@@ -1639,6 +2007,11 @@ pk_backend_init (PkBackend *backend)
 	backend->thread_hash = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, g_free);
 	g_mutex_init (&backend->eulas_mutex);
 	g_mutex_init (&backend->thread_hash_mutex);
+	backend->result_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+						       (GDestroyNotify) pk_backend_result_cache_item_free);
+	g_mutex_init (&backend->result_cache_mutex);
+	backend->download_cache_directory = g_build_filename (LOCALSTATEDIR, "cache", "PackageKit",
+							      "download-cache", NULL);
 }
 
 PkBackend *
@@ -1647,5 +2020,6 @@ pk_backend_new (GKeyFile *conf)
 	PkBackend *backend;
 	backend = g_object_new (PK_TYPE_BACKEND, NULL);
 	backend->conf = g_key_file_ref (conf);
+	backend->result_cache_enabled = g_key_file_get_boolean (conf, "Daemon", "CacheResults", NULL);
 	return PK_BACKEND (backend);
 }
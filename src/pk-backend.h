@@ -35,6 +35,7 @@
 #include <pk-package-ids.h>
 #include <pk-bitfield.h>
 #include <pk-update-detail.h>
+#include <pk-results.h>
 
 #include "pk-backend.h"
 #include "pk-backend-job.h"
@@ -68,6 +69,18 @@ gboolean     pk_backend_updates_changed (PkBackend *backend);
 gboolean     pk_backend_updates_changed_delay (PkBackend *backend,
 					       guint	  timeout);
 
+PkResults   *pk_backend_result_cache_lookup (PkBackend	 *backend,
+					     const gchar *key,
+					     guint	  max_age);
+void	     pk_backend_result_cache_add (PkBackend	*backend,
+					  const gchar	*key,
+					  guint		 generation,
+					  PkResults	*results);
+void	     pk_backend_result_cache_invalidate (PkBackend *backend);
+guint	     pk_backend_result_cache_get_generation (PkBackend *backend);
+guint64	     pk_backend_result_cache_get_hits (PkBackend *backend);
+guint64	     pk_backend_result_cache_get_misses (PkBackend *backend);
+
 void	     pk_backend_transaction_inhibit_start (PkBackend *backend);
 void	     pk_backend_transaction_inhibit_end (PkBackend *backend);
 gboolean     pk_backend_is_transaction_inhibited (PkBackend *backend);
@@ -234,6 +247,17 @@ gpointer     pk_backend_get_user_data (PkBackend *backend);
 void	     pk_backend_set_user_data (PkBackend *backend,
 				       gpointer	  user_data);
 
+/* packages downloaded by earlier transactions */
+gboolean     pk_backend_download_cache_link (PkBackend	 *backend,
+					     const gchar *checksum,
+					     const gchar *filename);
+void	     pk_backend_download_cache_add (PkBackend	*backend,
+					    const gchar *checksum,
+					    const gchar *filename);
+void	     pk_backend_download_cache_expire (PkBackend *backend);
+void	     pk_backend_set_download_cache_directory (PkBackend	  *backend,
+						      const gchar *directory);
+
 G_END_DECLS
 
 #endif /* __PK_BACKEND_H */
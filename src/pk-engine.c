@@ -982,6 +982,9 @@ pk_engine_load_backend (PkEngine *engine, GError **error)
 	if (!pk_backend_load (engine->backend, error))
 		return FALSE;
 
+	/* drop the packages which have not been downloaded for a while */
+	pk_backend_download_cache_expire (engine->backend);
+
 	/* load anything that can fail */
 	engine->authority = polkit_authority_get_sync (NULL, error);
 	if (engine->authority == NULL)
@@ -1073,6 +1076,22 @@ pk_engine_offline_get_property (GDBusConnection *connection_,
 	return NULL;
 }
 
+static GVariant *
+pk_engine_get_queue_wait_times (PkEngine *engine)
+{
+	GVariantBuilder builder;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{s(tt)}"));
+	for (guint i = 0; i < PK_SCHEDULER_PRIORITY_LAST; i++) {
+		guint64 transactions = 0;
+		guint64 total = pk_scheduler_get_queue_wait (engine->scheduler, i, &transactions);
+		g_variant_builder_add (&builder, "{s(tt)}",
+				       pk_scheduler_priority_to_string (i),
+				       transactions, total);
+	}
+	return g_variant_builder_end (&builder);
+}
+
 static GVariant *
 pk_engine_daemon_get_property (GDBusConnection *connection_,
 			       const gchar *sender,
@@ -1115,6 +1134,12 @@ pk_engine_daemon_get_property (GDBusConnection *connection_,
 		return g_variant_new_uint32 (engine->network_state);
 	if (g_strcmp0 (property_name, "DistroId") == 0)
 		return _g_variant_new_maybe_string (engine->distro_id);
+	if (g_strcmp0 (property_name, "ResultCacheHits") == 0)
+		return g_variant_new_uint64 (pk_backend_result_cache_get_hits (engine->backend));
+	if (g_strcmp0 (property_name, "ResultCacheMisses") == 0)
+		return g_variant_new_uint64 (pk_backend_result_cache_get_misses (engine->backend));
+	if (g_strcmp0 (property_name, "QueueWaitTimes") == 0)
+		return pk_engine_get_queue_wait_times (engine);
 
 	/* return an error */
 	g_set_error (error,
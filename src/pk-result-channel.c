@@ -0,0 +1,276 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2026 PackageKit Authors
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * A result channel is one end of a socket pair which is handed to the client
+ * using OpenResultChannel(), so that the transaction signals can be streamed
+ * to it directly rather than being routed through the bus daemon.
+ *
+ * Each signal is sent as a native-endian guint32 length, followed by that
+ * many bytes of a serialized GVariant of type (sv), holding the signal name
+ * and the signal parameters. The socket is non-blocking, and anything the
+ * client has not read yet is buffered here, so a slow client never blocks
+ * the daemon. A client that does not read at all is cut off once the buffer
+ * is full, as the bus daemon would do for a client that stops reading.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <glib-unix.h>
+#include <gio/gio.h>
+
+#include "pk-result-channel.h"
+
+/* the same as the most the client accepts */
+#define PK_RESULT_CHANNEL_MAX_SIZE (128 * 1024 * 1024) /* bytes */
+
+struct _PkResultChannel
+{
+	GObject parent;
+
+	gint fd;
+	GByteArray *buffer;
+	gsize offset; /* into @buffer of the first unsent byte */
+	guint watch_id;
+	gboolean closing;
+	gsize max_size; /* of the unsent data */
+};
+
+G_DEFINE_TYPE (PkResultChannel, pk_result_channel, G_TYPE_OBJECT)
+
+/**
+ * pk_result_channel_shutdown:
+ *
+ * Closes the channel straight away, dropping anything the client has not
+ * read yet, so the client sees the end of the stream without ::Finished.
+ **/
+void
+pk_result_channel_shutdown (PkResultChannel *channel)
+{
+	g_return_if_fail (PK_IS_RESULT_CHANNEL (channel));
+
+	if (channel->watch_id > 0) {
+		g_source_remove (channel->watch_id);
+		channel->watch_id = 0;
+	}
+	if (channel->fd >= 0) {
+		close (channel->fd);
+		channel->fd = -1;
+	}
+	g_byte_array_set_size (channel->buffer, 0);
+	channel->offset = 0;
+}
+
+static gboolean pk_result_channel_writable_cb (gint fd, GIOCondition condition, gpointer user_data);
+
+/* returns FALSE if the client has gone away */
+static gboolean
+pk_result_channel_flush (PkResultChannel *channel)
+{
+	while (channel->offset < channel->buffer->len) {
+		gssize wrote = send (channel->fd,
+				     channel->buffer->data + channel->offset,
+				     channel->buffer->len - channel->offset,
+				     MSG_NOSIGNAL);
+		if (wrote < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				if (channel->watch_id == 0) {
+					channel->watch_id = g_unix_fd_add_full (G_PRIORITY_DEFAULT,
+										channel->fd,
+										G_IO_OUT,
+										pk_result_channel_writable_cb,
+										g_object_ref (channel),
+										g_object_unref);
+				}
+				return TRUE;
+			}
+			g_debug ("failed to write to result channel: %s", g_strerror (errno));
+			pk_result_channel_shutdown (channel);
+			return FALSE;
+		}
+		channel->offset += wrote;
+	}
+
+	/* everything has been sent */
+	g_byte_array_set_size (channel->buffer, 0);
+	channel->offset = 0;
+	if (channel->closing)
+		pk_result_channel_shutdown (channel);
+	return TRUE;
+}
+
+static gboolean
+pk_result_channel_writable_cb (gint fd, GIOCondition condition, gpointer user_data)
+{
+	/* flushing may close the channel, which removes this source */
+	g_autoptr(PkResultChannel) channel = g_object_ref (PK_RESULT_CHANNEL (user_data));
+
+	pk_result_channel_flush (channel);
+	if (channel->fd >= 0 && channel->offset < channel->buffer->len)
+		return G_SOURCE_CONTINUE;
+	channel->watch_id = 0;
+	return G_SOURCE_REMOVE;
+}
+
+/**
+ * pk_result_channel_emit:
+ *
+ * Queues a signal to be sent to the client.
+ *
+ * Return value: %FALSE if the channel is no longer usable, in which case the
+ * caller should fall back to emitting the signal on the bus
+ **/
+gboolean
+pk_result_channel_emit (PkResultChannel *channel, const gchar *signal_name, GVariant *parameters)
+{
+	g_autoptr(GVariant) message = NULL;
+	guint32 size;
+
+	g_return_val_if_fail (PK_IS_RESULT_CHANNEL (channel), FALSE);
+	g_return_val_if_fail (signal_name != NULL, FALSE);
+
+	if (channel->fd < 0 || channel->closing)
+		return FALSE;
+
+	message = g_variant_ref_sink (g_variant_new ("(sv)",
+						     signal_name,
+						     parameters != NULL ? parameters : g_variant_new ("()")));
+	size = g_variant_get_size (message);
+
+	/* compact the buffer rather than letting it grow without bound */
+	if (channel->offset > 0 && channel->offset >= channel->buffer->len / 2) {
+		g_byte_array_remove_range (channel->buffer, 0, channel->offset);
+		channel->offset = 0;
+	}
+
+	/* the client is not reading, don't keep queueing for it */
+	if (channel->buffer->len - channel->offset + sizeof (size) + size > channel->max_size) {
+		g_debug ("result channel client is not reading, closing it");
+		pk_result_channel_shutdown (channel);
+		return FALSE;
+	}
+
+	g_byte_array_append (channel->buffer, (const guint8 *) &size, sizeof (size));
+	g_byte_array_set_size (channel->buffer, channel->buffer->len + size);
+	g_variant_store (message, channel->buffer->data + channel->buffer->len - size);
+
+	/* we're already waiting for the client to read */
+	if (channel->watch_id > 0)
+		return TRUE;
+	return pk_result_channel_flush (channel);
+}
+
+/**
+ * pk_result_channel_close:
+ *
+ * Closes the channel once everything that has been queued has been sent.
+ **/
+void
+pk_result_channel_close (PkResultChannel *channel)
+{
+	g_return_if_fail (PK_IS_RESULT_CHANNEL (channel));
+
+	channel->closing = TRUE;
+	if (channel->watch_id == 0)
+		pk_result_channel_shutdown (channel);
+}
+
+/**
+ * pk_result_channel_set_max_size:
+ *
+ * Sets how much unsent data is buffered before the client is cut off.
+ **/
+void
+pk_result_channel_set_max_size (PkResultChannel *channel, gsize max_size)
+{
+	g_return_if_fail (PK_IS_RESULT_CHANNEL (channel));
+	channel->max_size = max_size;
+}
+
+static void
+pk_result_channel_finalize (GObject *object)
+{
+	PkResultChannel *channel = PK_RESULT_CHANNEL (object);
+
+	pk_result_channel_shutdown (channel);
+	g_byte_array_unref (channel->buffer);
+
+	G_OBJECT_CLASS (pk_result_channel_parent_class)->finalize (object);
+}
+
+static void
+pk_result_channel_class_init (PkResultChannelClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	object_class->finalize = pk_result_channel_finalize;
+}
+
+static void
+pk_result_channel_init (PkResultChannel *channel)
+{
+	channel->fd = -1;
+	channel->buffer = g_byte_array_new ();
+	channel->max_size = PK_RESULT_CHANNEL_MAX_SIZE;
+}
+
+/**
+ * pk_result_channel_new:
+ * @client_fd: (out): the end of the socket pair to hand to the client
+ *
+ * Return value: a new #PkResultChannel, or %NULL on error
+ **/
+PkResultChannel *
+pk_result_channel_new (gint *client_fd, GError **error)
+{
+	gint fds[2];
+	g_autoptr(PkResultChannel) channel = NULL;
+
+	g_return_val_if_fail (client_fd != NULL, NULL);
+
+	if (socketpair (AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) < 0) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     g_io_error_from_errno (errno),
+			     "failed to create socket pair: %s",
+			     g_strerror (errno));
+		return NULL;
+	}
+
+	/* the client reads from this end */
+	if (shutdown (fds[1], SHUT_WR) < 0)
+		g_debug ("failed to shut down the client end: %s", g_strerror (errno));
+
+	if (!g_unix_set_fd_nonblocking (fds[0], TRUE, error)) {
+		close (fds[0]);
+		close (fds[1]);
+		return NULL;
+	}
+
+	channel = g_object_new (PK_TYPE_RESULT_CHANNEL, NULL);
+	channel->fd = fds[0];
+	*client_fd = fds[1];
+	return g_steal_pointer (&channel);
+}
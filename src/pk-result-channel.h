@@ -0,0 +1,46 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2026 PackageKit Authors
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __PK_RESULT_CHANNEL_H
+#define __PK_RESULT_CHANNEL_H
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define PK_TYPE_RESULT_CHANNEL (pk_result_channel_get_type ())
+G_DECLARE_FINAL_TYPE (PkResultChannel, pk_result_channel, PK, RESULT_CHANNEL, GObject)
+
+PkResultChannel	*pk_result_channel_new		(gint		*client_fd,
+						 GError		**error);
+gboolean	 pk_result_channel_emit		(PkResultChannel *channel,
+						 const gchar	*signal_name,
+						 GVariant	*parameters);
+void		 pk_result_channel_close	(PkResultChannel *channel);
+void		 pk_result_channel_shutdown	(PkResultChannel *channel);
+
+/* only here for the self test program to use */
+void		 pk_result_channel_set_max_size	(PkResultChannel *channel,
+						 gsize		 max_size);
+
+G_END_DECLS
+
+#endif /* __PK_RESULT_CHANNEL_H */
@@ -23,7 +23,12 @@
  * Transaction Commit Logic:
  *
  * State = COMMIT
- * Transaction.Run()
+ * Priority = INTERACTIVE for short queries, BACKGROUND if requested, else NORMAL
+ * IF an identical read-only transaction is queued or running
+ * 	Follow it, getting the results it already has and the ones still to come
+ * 	Finish when it finishes, or run on our own if it was cancelled
+ * ELSE
+ * 	Transaction.Run()
  * WHEN transaction finished:
  * 	IF error = LOCK_REQUIRED
  * 		IF number_of_tries > 4
@@ -36,11 +41,11 @@
  * 			Leave transaction in the FIFO queue
  *	ELSE
  * 		State = Finished
- * 		IF Transaction.Exclusive
- * 			Take the first PK_TRANSACTION_STATE_READY transaction which has Transaction.Exclusive == TRUE
- * 			from the list and run it. If there's none, just do nothing
- * 		ELSE
- * 			Do nothing
+ * 		Take the PK_TRANSACTION_STATE_READY transaction that can be run with
+ * 		the best priority, raised by one level for each PK_SCHEDULER_AGING_INTERVAL
+ * 		it has been waiting. Between equal priorities take the one whose user has
+ * 		waited longest since one of their transactions was run, then the oldest.
+ * 		If there's none, just do nothing
  * 		Transaction.Destroy()
 **/
 
@@ -84,11 +89,19 @@ static void pk_scheduler_finalize (GObject *object);
 /* maximum number of requests a given user is able to request and queue */
 #define PK_SCHEDULER_SIMULTANEOUS_TRANSACTIONS_FOR_UID 500
 
+/* how long a transaction waits before it is treated as one priority higher */
+#define PK_SCHEDULER_AGING_INTERVAL 10 /* s */
+
 struct _PkScheduler
 {
 	GObject parent;
 
 	GPtrArray *array;
+	GHashTable *items; /* tid:PkSchedulerItem */
+	GHashTable *uid_run_seq; /* uid:run_seq when one of theirs was last run */
+	guint run_seq;
+	guint64 wait_count[PK_SCHEDULER_PRIORITY_LAST];
+	guint64 wait_total[PK_SCHEDULER_PRIORITY_LAST]; /* us */
 	guint unwedge_id;
 	GKeyFile *conf;
 	PkBackend *backend;
@@ -108,6 +121,8 @@ typedef struct
 	gulong allow_cancel_changed_id;
 	guint uid;
 	guint tries;
+	PkSchedulerPriority priority;
+	gint64 ready_time;
 } PkSchedulerItem;
 
 enum {
@@ -125,23 +140,12 @@ G_DEFINE_TYPE (PkScheduler, pk_scheduler, G_TYPE_OBJECT)
 static PkSchedulerItem *
 pk_scheduler_get_from_tid (PkScheduler *scheduler, const gchar *tid)
 {
-	guint i;
-	GPtrArray *array;
-	PkSchedulerItem *item;
-	const gchar *tmptid;
-
 	g_return_val_if_fail (scheduler != NULL, NULL);
 	g_return_val_if_fail (PK_IS_SCHEDULER (scheduler), NULL);
 
-	/* find the runner with the transaction ID */
-	array = scheduler->array;
-	for (i = 0; i < array->len; i++) {
-		item = (PkSchedulerItem *) g_ptr_array_index (array, i);
-		tmptid = pk_transaction_get_tid (item->transaction);
-		if (g_strcmp0 (tmptid, tid) == 0)
-			return item;
-	}
-	return NULL;
+	if (tid == NULL)
+		return NULL;
+	return g_hash_table_lookup (scheduler->items, tid);
 }
 
 PkTransaction *
@@ -213,6 +217,24 @@ pk_scheduler_item_free_cb (PkSchedulerItem *item, gpointer user_data)
 	pk_scheduler_item_free (item);
 }
 
+static guint
+pk_scheduler_get_number_transactions_for_uid (PkScheduler *scheduler, guint uid)
+{
+	guint i;
+	GPtrArray *array;
+	PkSchedulerItem *item;
+	guint count = 0;
+
+	/* find all the transactions in progress */
+	array = scheduler->array;
+	for (i = 0; i < array->len; i++) {
+		item = (PkSchedulerItem *) g_ptr_array_index (array, i);
+		if (item->uid == uid)
+			count++;
+	}
+	return count;
+}
+
 static gboolean
 pk_scheduler_remove_internal (PkScheduler *scheduler, PkSchedulerItem *item)
 {
@@ -227,6 +249,11 @@ pk_scheduler_remove_internal (PkScheduler *scheduler, PkSchedulerItem *item)
 		g_warning ("could not remove %p as not present in list", item);
 		return FALSE;
 	}
+	g_hash_table_remove (scheduler->items, item->tid);
+
+	/* only the users with transactions have to take turns */
+	if (pk_scheduler_get_number_transactions_for_uid (scheduler, item->uid) == 0)
+		g_hash_table_remove (scheduler->uid_run_seq, GUINT_TO_POINTER (item->uid));
 
 	pk_scheduler_item_free (item);
 	return TRUE;
@@ -298,6 +325,17 @@ pk_scheduler_run_item (PkScheduler *scheduler, PkSchedulerItem *item)
 	/* we set this here so that we don't try starting more than one */
 	pk_transaction_set_state (item->transaction, PK_TRANSACTION_STATE_RUNNING);
 
+	/* the other users get the next turn */
+	g_hash_table_insert (scheduler->uid_run_seq,
+			     GUINT_TO_POINTER (item->uid),
+			     GUINT_TO_POINTER (++scheduler->run_seq));
+
+	/* only count the first time, not the retries after a lock error */
+	if (item->tries == 0 && item->ready_time > 0) {
+		scheduler->wait_count[item->priority]++;
+		scheduler->wait_total[item->priority] += g_get_monotonic_time () - item->ready_time;
+	}
+
 	/* add this idle, so that we don't have a deep out-of-order callchain */
 	item->idle_id = g_idle_add ((GSourceFunc) pk_scheduler_run_idle_cb, item);
 	g_source_set_name_by_id (item->idle_id, "[PkScheduler] run");
@@ -384,63 +422,121 @@ pk_scheduler_get_background_running (PkScheduler *scheduler)
 	return FALSE;
 }
 
+static PkSchedulerPriority
+pk_scheduler_get_priority_for_transaction (PkTransaction *transaction)
+{
+	if (pk_transaction_get_background (transaction))
+		return PK_SCHEDULER_PRIORITY_BACKGROUND;
+
+	/* a user is probably waiting for these to show something */
+	switch (pk_transaction_get_role (transaction)) {
+	case PK_ROLE_ENUM_DEPENDS_ON:
+	case PK_ROLE_ENUM_GET_CATEGORIES:
+	case PK_ROLE_ENUM_GET_DETAILS:
+	case PK_ROLE_ENUM_GET_DETAILS_LOCAL:
+	case PK_ROLE_ENUM_GET_FILES_LOCAL:
+	case PK_ROLE_ENUM_GET_OLD_TRANSACTIONS:
+	case PK_ROLE_ENUM_GET_REPO_LIST:
+	case PK_ROLE_ENUM_GET_UPDATE_DETAIL:
+	case PK_ROLE_ENUM_REQUIRED_BY:
+	case PK_ROLE_ENUM_RESOLVE:
+	case PK_ROLE_ENUM_SEARCH_DETAILS:
+	case PK_ROLE_ENUM_SEARCH_FILE:
+	case PK_ROLE_ENUM_SEARCH_GROUP:
+	case PK_ROLE_ENUM_SEARCH_NAME:
+	case PK_ROLE_ENUM_WHAT_PROVIDES:
+		return PK_SCHEDULER_PRIORITY_INTERACTIVE;
+	default:
+		return PK_SCHEDULER_PRIORITY_NORMAL;
+	}
+}
+
+/* the priority of @item, raised for each PK_SCHEDULER_AGING_INTERVAL it has waited */
+static PkSchedulerPriority
+pk_scheduler_get_effective_priority (PkSchedulerItem *item, gint64 now)
+{
+	gint64 steps;
+
+	if (item->ready_time == 0)
+		return item->priority;
+	steps = (now - item->ready_time) / (PK_SCHEDULER_AGING_INTERVAL * G_USEC_PER_SEC);
+	if (steps >= (gint64) item->priority)
+		return PK_SCHEDULER_PRIORITY_INTERACTIVE;
+	return item->priority - steps;
+}
+
 static PkSchedulerItem *
 pk_scheduler_get_next_item (PkScheduler *scheduler)
 {
-	PkSchedulerItem *item = NULL;
-	GPtrArray *array;
-	guint i;
-	PkTransactionState state;
+	PkSchedulerItem *best = NULL;
+	PkSchedulerPriority best_priority = PK_SCHEDULER_PRIORITY_LAST;
+	guint best_run_seq = 0;
 	gboolean exclusive_running;
-
-	array = scheduler->array;
+	gint64 now = g_get_monotonic_time ();
 
 	/* check for running exclusive transaction */
 	exclusive_running = pk_scheduler_get_exclusive_running (scheduler) > 0;
 
-	/* first try the waiting non-background transactions */
-	for (i = 0; i < array->len; i++) {
-		item = (PkSchedulerItem *) g_ptr_array_index (array, i);
-		state = pk_transaction_get_state (item->transaction);
+	for (guint i = 0; i < scheduler->array->len; i++) {
+		PkSchedulerItem *item = g_ptr_array_index (scheduler->array, i);
+		PkSchedulerPriority priority;
+		guint run_seq;
 
-		if ((state == PK_TRANSACTION_STATE_READY) &&
-		    (!pk_transaction_get_background (item->transaction))) {
-			/* check if we can run the transaction now or if we need to wait for lock release */
-			if (pk_transaction_is_exclusive (item->transaction)) {
-				if (!exclusive_running)
-					goto out;
-			} else {
-				goto out;
-			}
-		}
-	}
+		if (pk_transaction_get_state (item->transaction) != PK_TRANSACTION_STATE_READY)
+			continue;
+		if (pk_transaction_get_primary (item->transaction) != NULL)
+			continue;
 
-	/* then try the other waiting transactions (background tasks) */
-	for (i = 0; i < array->len; i++) {
-		item = (PkSchedulerItem *) g_ptr_array_index (array, i);
-		state = pk_transaction_get_state (item->transaction);
+		/* check if we can run the transaction now or if we need to wait for lock release */
+		if (exclusive_running && pk_transaction_is_exclusive (item->transaction))
+			continue;
 
-		if (state == PK_TRANSACTION_STATE_READY) {
-			/* check if we can run the transaction now or if we need to wait for lock release */
-			if (pk_transaction_is_exclusive (item->transaction)) {
-				if (!exclusive_running)
-					goto out;
-			} else {
-				goto out;
-			}
+		/* the array is in the order of creation, so the oldest wins a tie */
+		priority = pk_scheduler_get_effective_priority (item, now);
+		run_seq = GPOINTER_TO_UINT (g_hash_table_lookup (scheduler->uid_run_seq,
+								 GUINT_TO_POINTER (item->uid)));
+		if (best == NULL ||
+		    priority < best_priority ||
+		    (priority == best_priority && run_seq < best_run_seq)) {
+			best = item;
+			best_priority = priority;
+			best_run_seq = run_seq;
 		}
 	}
+	return best;
+}
 
-	/* nothing to run */
-	item = NULL;
-out:
-	return item;
+/**
+ * pk_scheduler_get_coalesce_target:
+ *
+ * Return value: a queued or running transaction which will produce the same
+ * results as @item, or %NULL
+ **/
+static PkSchedulerItem *
+pk_scheduler_get_coalesce_target (PkScheduler *scheduler, PkSchedulerItem *item)
+{
+	PkSchedulerItem *item_tmp;
+	PkTransactionState state;
+
+	for (guint i = 0; i < scheduler->array->len; i++) {
+		item_tmp = (PkSchedulerItem *) g_ptr_array_index (scheduler->array, i);
+		if (item_tmp == item)
+			continue;
+		state = pk_transaction_get_state (item_tmp->transaction);
+		if (state != PK_TRANSACTION_STATE_READY &&
+		    state != PK_TRANSACTION_STATE_RUNNING)
+			continue;
+		if (pk_transaction_can_coalesce (item->transaction, item_tmp->transaction))
+			return item_tmp;
+	}
+	return NULL;
 }
 
 static void
 pk_scheduler_commit (PkScheduler *scheduler, const gchar *tid)
 {
 	PkSchedulerItem *item;
+	PkSchedulerItem *primary;
 
 	g_return_if_fail (PK_IS_SCHEDULER (scheduler));
 	g_return_if_fail (tid != NULL);
@@ -451,6 +547,21 @@ pk_scheduler_commit (PkScheduler *scheduler, const gchar *tid)
 		return;
 	}
 
+	/* not reset when retrying after a lock error, so it keeps its place */
+	item->priority = pk_scheduler_get_priority_for_transaction (item->transaction);
+	if (item->ready_time == 0)
+		item->ready_time = g_get_monotonic_time ();
+
+	/* just follow an identical transaction rather than doing the work again */
+	primary = pk_scheduler_get_coalesce_target (scheduler, item);
+	if (primary != NULL) {
+		g_debug ("coalescing %s with %s", item->tid, primary->tid);
+		g_clear_handle_id (&item->commit_id, g_source_remove);
+		pk_transaction_subscribe (item->transaction, primary->transaction);
+		g_signal_emit (scheduler, signals[PK_SCHEDULER_CHANGED], 0);
+		return;
+	}
+
 	/* treat all transactions as exclusive if backend does not support parallelization */
 	if (!pk_backend_supports_parallelization (scheduler->backend))
 		pk_transaction_make_exclusive (item->transaction);
@@ -462,8 +573,10 @@ pk_scheduler_commit (PkScheduler *scheduler, const gchar *tid)
 	g_signal_emit (scheduler, signals[PK_SCHEDULER_CHANGED], 0);
 
 	/* is one of the current running transactions background, and this new
-	 * transaction foreground? */
+	 * transaction foreground? Short queries can just run alongside */
 	if (!pk_transaction_get_background (item->transaction) &&
+	    (item->priority != PK_SCHEDULER_PRIORITY_INTERACTIVE ||
+	     pk_transaction_is_exclusive (item->transaction)) &&
 	    pk_scheduler_get_background_running (scheduler)) {
 		g_debug ("cancelling running background transactions and instead running %s",
 			 item->tid);
@@ -501,6 +614,54 @@ pk_scheduler_transaction_state_changed_cb (PkTransaction *transaction,
 	}
 }
 
+/* finishes the transactions which were following @primary */
+static void
+pk_scheduler_release_subscribers (PkScheduler *scheduler, PkSchedulerItem *primary)
+{
+	PkExitEnum exit_enum;
+	PkSchedulerItem *item;
+	g_autoptr(GPtrArray) subscribers = g_ptr_array_new_with_free_func (g_free);
+
+	for (guint i = 0; i < scheduler->array->len; i++) {
+		item = (PkSchedulerItem *) g_ptr_array_index (scheduler->array, i);
+		if (pk_transaction_get_primary (item->transaction) == primary->transaction)
+			g_ptr_array_add (subscribers, g_strdup (item->tid));
+	}
+	if (subscribers->len == 0)
+		return;
+
+	exit_enum = pk_transaction_get_exit_code (primary->transaction);
+	for (guint i = 0; i < subscribers->len; i++) {
+		const gchar *tid = g_ptr_array_index (subscribers, i);
+
+		/* finishing may have removed it */
+		item = pk_scheduler_get_from_tid (scheduler, tid);
+		if (item == NULL)
+			continue;
+
+		/* the client has not seen any results, so just run it instead */
+		if ((exit_enum == PK_EXIT_ENUM_CANCELLED ||
+		     exit_enum == PK_EXIT_ENUM_CANCELLED_PRIORITY) &&
+		    pk_transaction_unsubscribe (item->transaction)) {
+			g_debug ("running %s as %s was cancelled", item->tid, primary->tid);
+			pk_scheduler_commit (scheduler, item->tid);
+			continue;
+		}
+		pk_transaction_finish_subscription (item->transaction, exit_enum);
+	}
+}
+
+/* the transactions following @primary get everything again when it is retried */
+static void
+pk_scheduler_reset_subscribers (PkScheduler *scheduler, PkSchedulerItem *primary)
+{
+	for (guint i = 0; i < scheduler->array->len; i++) {
+		PkSchedulerItem *item = g_ptr_array_index (scheduler->array, i);
+		if (pk_transaction_get_primary (item->transaction) == primary->transaction)
+			pk_transaction_reset_subscription (item->transaction);
+	}
+}
+
 static void
 pk_scheduler_transaction_finished_cb (PkTransaction *transaction, PkScheduler *scheduler)
 {
@@ -525,6 +686,7 @@ pk_scheduler_transaction_finished_cb (PkTransaction *transaction, PkScheduler *s
 
 	if (pk_transaction_is_finished_with_lock_required (item->transaction)) {
 		pk_transaction_reset_after_lock_error (item->transaction);
+		pk_scheduler_reset_subscribers (scheduler, item);
 
 		/* increase the number of tries */
 		item->tries++;
@@ -556,6 +718,9 @@ pk_scheduler_transaction_finished_cb (PkTransaction *transaction, PkScheduler *s
 							 pk_scheduler_remove_item_cb,
 							 item);
 		g_source_set_name_by_id (item->remove_id, "[PkScheduler] remove");
+
+		/* and any transactions that were following this one */
+		pk_scheduler_release_subscribers (scheduler, item);
 	}
 
 	/* try to run the next transaction, if possible */
@@ -581,24 +746,6 @@ pk_scheduler_no_commit_cb (gpointer user_data)
 	return FALSE;
 }
 
-static guint
-pk_scheduler_get_number_transactions_for_uid (PkScheduler *scheduler, guint uid)
-{
-	guint i;
-	GPtrArray *array;
-	PkSchedulerItem *item;
-	guint count = 0;
-
-	/* find all the transactions in progress */
-	array = scheduler->array;
-	for (i = 0; i < array->len; i++) {
-		item = (PkSchedulerItem *) g_ptr_array_index (array, i);
-		if (item->uid == uid)
-			count++;
-	}
-	return count;
-}
-
 gboolean
 pk_scheduler_create (PkScheduler *scheduler, const gchar *tid, const gchar *sender, GError **error)
 {
@@ -621,6 +768,7 @@ pk_scheduler_create (PkScheduler *scheduler, const gchar *tid, const gchar *send
 	item = g_new0 (PkSchedulerItem, 1);
 	item->scheduler = g_object_ref (scheduler);
 	item->tid = g_strdup (tid);
+	item->priority = PK_SCHEDULER_PRIORITY_NORMAL;
 	item->transaction = pk_transaction_new (scheduler->conf, scheduler->introspection);
 	item->finished_id = g_signal_connect_after (
 	    item->transaction,
@@ -691,6 +839,7 @@ pk_scheduler_create (PkScheduler *scheduler, const gchar *tid, const gchar *send
 
 	g_debug ("adding transaction %p", item->transaction);
 	g_ptr_array_add (scheduler->array, item);
+	g_hash_table_insert (scheduler->items, item->tid, item);
 	return TRUE;
 }
 
@@ -830,6 +979,67 @@ pk_scheduler_get_array (PkScheduler *scheduler)
 	return pk_ptr_array_to_strv (parray);
 }
 
+const gchar *
+pk_scheduler_priority_to_string (PkSchedulerPriority priority)
+{
+	if (priority == PK_SCHEDULER_PRIORITY_INTERACTIVE)
+		return "interactive";
+	if (priority == PK_SCHEDULER_PRIORITY_NORMAL)
+		return "normal";
+	if (priority == PK_SCHEDULER_PRIORITY_BACKGROUND)
+		return "background";
+	return "unknown";
+}
+
+/**
+ * pk_scheduler_get_queue_wait:
+ * @transactions: (out) (optional): the number of transactions that were run
+ *
+ * Return value: the total time transactions of @priority waited between
+ * being committed and being run, in microseconds
+ **/
+guint64
+pk_scheduler_get_queue_wait (PkScheduler *scheduler,
+			     PkSchedulerPriority priority,
+			     guint64 *transactions)
+{
+	g_return_val_if_fail (PK_IS_SCHEDULER (scheduler), 0);
+	g_return_val_if_fail (priority < PK_SCHEDULER_PRIORITY_LAST, 0);
+
+	if (transactions != NULL)
+		*transactions = scheduler->wait_count[priority];
+	return scheduler->wait_total[priority];
+}
+
+/* only here for the self test program to use, as every transaction it
+ * creates has the same sender */
+void
+pk_scheduler_set_uid (PkScheduler *scheduler, const gchar *tid, guint uid)
+{
+	PkSchedulerItem *item;
+
+	g_return_if_fail (PK_IS_SCHEDULER (scheduler));
+
+	item = pk_scheduler_get_from_tid (scheduler, tid);
+	g_return_if_fail (item != NULL);
+	item->uid = uid;
+}
+
+/* only here for the self test program to use, so it does not have to wait
+ * for PK_SCHEDULER_AGING_INTERVAL */
+void
+pk_scheduler_set_waited (PkScheduler *scheduler, const gchar *tid, guint seconds)
+{
+	PkSchedulerItem *item;
+
+	g_return_if_fail (PK_IS_SCHEDULER (scheduler));
+
+	item = pk_scheduler_get_from_tid (scheduler, tid);
+	g_return_if_fail (item != NULL);
+	g_return_if_fail (item->ready_time > 0);
+	item->ready_time = g_get_monotonic_time () - (gint64) seconds * G_USEC_PER_SEC;
+}
+
 guint
 pk_scheduler_get_size (PkScheduler *scheduler)
 {
@@ -864,13 +1074,15 @@ pk_scheduler_get_state (PkScheduler *scheduler)
 		role = pk_transaction_get_role (item->transaction);
 		g_string_append_printf (string,
 					"%0i\t%s\t%s\tstate[%s] "
-					"exclusive[%i] background[%i]\n",
+					"exclusive[%i] background[%i] priority[%s] uid[%u]\n",
 					i,
 					pk_role_enum_to_string (role),
 					item->tid,
 					pk_transaction_state_to_string (state),
 					pk_transaction_is_exclusive (item->transaction),
-					pk_transaction_get_background (item->transaction));
+					pk_transaction_get_background (item->transaction),
+					pk_scheduler_priority_to_string (item->priority),
+					item->uid);
 	}
 
 	/* nothing running */
@@ -1013,6 +1225,8 @@ static void
 pk_scheduler_init (PkScheduler *scheduler)
 {
 	scheduler->array = g_ptr_array_new ();
+	scheduler->items = g_hash_table_new (g_str_hash, g_str_equal);
+	scheduler->uid_run_seq = g_hash_table_new (g_direct_hash, g_direct_equal);
 	scheduler->introspection = pk_load_introspection (PK_DBUS_INTERFACE_TRANSACTION ".xml",
 							  NULL);
 	scheduler->unwedge_id = g_timeout_add_seconds (PK_TRANSACTION_WEDGE_CHECK,
@@ -1027,6 +1241,8 @@ pk_scheduler_finalize (GObject *object)
 	PkScheduler *scheduler = PK_SCHEDULER (object);
 
 	g_clear_handle_id (&scheduler->unwedge_id, g_source_remove);
+	g_clear_pointer (&scheduler->items, g_hash_table_unref);
+	g_clear_pointer (&scheduler->uid_run_seq, g_hash_table_unref);
 	g_ptr_array_foreach (scheduler->array, (GFunc) pk_scheduler_item_free_cb, NULL);
 	g_clear_pointer (&scheduler->array, g_ptr_array_unref);
 	g_clear_pointer (&scheduler->introspection, g_dbus_node_info_unref);
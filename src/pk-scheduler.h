@@ -35,6 +35,13 @@ G_DECLARE_FINAL_TYPE (PkScheduler, pk_scheduler, PK, SCHEDULER, GObject)
 #define PK_SCHEDULER_ERROR	(pk_scheduler_error_quark ())
 #define PK_SCHEDULER_TYPE_ERROR (pk_scheduler_error_get_type ())
 
+typedef enum {
+	PK_SCHEDULER_PRIORITY_INTERACTIVE,
+	PK_SCHEDULER_PRIORITY_NORMAL,
+	PK_SCHEDULER_PRIORITY_BACKGROUND,
+	PK_SCHEDULER_PRIORITY_LAST
+} PkSchedulerPriority;
+
 PkScheduler   *pk_scheduler_new (GKeyFile *conf);
 
 gboolean       pk_scheduler_create (PkScheduler *scheduler,
@@ -56,6 +63,18 @@ void	       pk_scheduler_cancel_background (PkScheduler *scheduler);
 void	       pk_scheduler_cancel_queued (PkScheduler *scheduler);
 void	       pk_scheduler_set_backend (PkScheduler *scheduler,
 					 PkBackend   *backend);
+const gchar   *pk_scheduler_priority_to_string (PkSchedulerPriority priority);
+guint64	       pk_scheduler_get_queue_wait (PkScheduler	       *scheduler,
+					    PkSchedulerPriority priority,
+					    guint64	       *transactions);
+
+/* only here for the self test program to use */
+void	       pk_scheduler_set_uid (PkScheduler *scheduler,
+				     const gchar *tid,
+				     guint	  uid);
+void	       pk_scheduler_set_waited (PkScheduler *scheduler,
+					const gchar *tid,
+					guint	     seconds);
 
 G_END_DECLS
 
@@ -71,61 +71,6 @@ typedef struct
 	gboolean set;
 } PkTransactionDbProxyItem;
 
-static gint
-pk_transaction_db_add_transaction_cb (void *data, gint argc, gchar **argv, gchar **col_name)
-{
-	PkTransactionPast *item;
-	GList **list = (GList **) data;
-	gint i;
-	gchar *col;
-	gchar *value;
-	guint temp;
-
-	item = pk_transaction_past_new ();
-	for (i = 0; i < argc; i++) {
-		col = col_name[i];
-		value = argv[i];
-		if (g_strcmp0 (col, "succeeded") == 0) {
-			if (!pk_strtouint (value, &temp)) {
-				g_warning ("failed to parse succeeded: %s", value);
-				continue;
-			}
-			if (temp == 1)
-				g_object_set (item, "succeeded", TRUE, NULL);
-			else
-				g_object_set (item, "succeeded", FALSE, NULL);
-		} else if (g_strcmp0 (col, "role") == 0) {
-			if (value != NULL)
-				g_object_set (item, "role", pk_role_enum_from_string (value), NULL);
-		} else if (g_strcmp0 (col, "transaction_id") == 0) {
-			if (value != NULL)
-				g_object_set (item, "tid", value, NULL);
-		} else if (g_strcmp0 (col, "timespec") == 0) {
-			if (value != NULL)
-				g_object_set (item, "timespec", value, NULL);
-		} else if (g_strcmp0 (col, "cmdline") == 0) {
-			if (value != NULL)
-				g_object_set (item, "cmdline", value, NULL);
-		} else if (g_strcmp0 (col, "data") == 0) {
-			if (value != NULL)
-				g_object_set (item, "data", value, NULL);
-		} else if (g_strcmp0 (col, "uid") == 0) {
-			if (pk_strtouint (value, &temp))
-				g_object_set (item, "uid", temp, NULL);
-		} else if (g_strcmp0 (col, "duration") == 0) {
-			if (pk_strtouint (value, &temp))
-				g_object_set (item, "duration", temp, NULL);
-		} else {
-			g_warning ("%s = %s", col, value);
-		}
-	}
-
-	/* add to start of the list */
-	*list = g_list_prepend (*list, item);
-
-	return 0;
-}
-
 static gboolean
 pk_transaction_db_sql_statement (PkTransactionDb *tdb, const gchar *sql)
 {
@@ -269,40 +214,6 @@ pk_transaction_db_action_time_reset (PkTransactionDb *tdb, PkRoleEnum role)
 	return TRUE;
 }
 
-GList *
-pk_transaction_db_get_list (PkTransactionDb *tdb, guint limit)
-{
-	gchar *error_msg = NULL;
-	gint rc;
-	GList *list = NULL;
-	g_autofree gchar *statement = NULL;
-
-	g_return_val_if_fail (PK_IS_TRANSACTION_DB (tdb), NULL);
-
-	/* clang-format off */
-	if (limit == 0) {
-		statement = g_strdup ("SELECT transaction_id, timespec, succeeded, duration, role, data, uid, cmdline "
-				      "FROM transactions ORDER BY timespec DESC");
-	} else {
-		statement = g_strdup_printf ("SELECT transaction_id, timespec, succeeded, duration, role, data, uid, cmdline "
-					     "FROM transactions ORDER BY timespec DESC LIMIT %i", limit);
-	}
-	/* clang-format on */
-
-	rc = sqlite3_exec (tdb->db,
-			   statement,
-			   pk_transaction_db_add_transaction_cb,
-			   &list,
-			   &error_msg);
-	if (rc != SQLITE_OK) {
-		g_warning ("SQL error: %s", error_msg);
-		sqlite3_free (error_msg);
-		goto out;
-	}
-out:
-	return list;
-}
-
 static gboolean
 pk_transaction_db_prepare (PkTransactionDb *tdb, const gchar *sql, sqlite3_stmt **statement)
 {
@@ -332,6 +243,128 @@ pk_transaction_db_step (sqlite3 *db, sqlite3_stmt *statement)
 	return TRUE;
 }
 
+static PkTransactionPast *
+pk_transaction_db_past_from_statement (sqlite3_stmt *statement, gboolean with_data)
+{
+	PkTransactionPast *item = pk_transaction_past_new ();
+	const gchar *role = (const gchar *) sqlite3_column_text (statement, 4);
+
+	g_object_set (item,
+		      "tid", (const gchar *) sqlite3_column_text (statement, 0),
+		      "timespec", (const gchar *) sqlite3_column_text (statement, 1),
+		      "succeeded", sqlite3_column_int (statement, 2) == 1,
+		      "duration", (guint) sqlite3_column_int (statement, 3),
+		      "role", role != NULL ? pk_role_enum_from_string (role) : PK_ROLE_ENUM_UNKNOWN,
+		      "uid", (guint) sqlite3_column_int (statement, 5),
+		      "cmdline", (const gchar *) sqlite3_column_text (statement, 6),
+		      NULL);
+	if (with_data)
+		g_object_set (item, "data", (const gchar *) sqlite3_column_text (statement, 7), NULL);
+	return item;
+}
+
+/**
+ * pk_transaction_db_get_list_filtered:
+ * @tdb: a #PkTransactionDb
+ * @filter: the transactions to return
+ *
+ * Gets the transactions matching @filter. The limit keeps the newest ones,
+ * or the ones right after @since_tid if that is set, so that the history
+ * can be paged through in both directions. The cursors @since_tid and
+ * @before_tid refer to the order the transactions were added in, and a
+ * transaction ID which is not in the database matches nothing.
+ *
+ * Return value: a list of #PkTransactionPast, with the oldest first
+ **/
+GList *
+pk_transaction_db_get_list_filtered (PkTransactionDb *tdb, const PkTransactionDbFilter *filter)
+{
+	GList *list = NULL;
+	gint idx = 1;
+	gint rc;
+	g_autoptr(GString) sql = NULL;
+	const gchar *where[6];
+	guint n_where = 0;
+	g_autoptr(sqlite3_stmt) statement = NULL;
+
+	g_return_val_if_fail (PK_IS_TRANSACTION_DB (tdb), NULL);
+	g_return_val_if_fail (tdb->db != NULL, NULL);
+	g_return_val_if_fail (filter != NULL, NULL);
+
+	/* the data is the largest column by far, so only read it when asked */
+	sql = g_string_new ("SELECT transaction_id, timespec, succeeded, duration, role, uid, cmdline");
+	if (filter->with_data)
+		g_string_append (sql, ", data");
+	g_string_append (sql, " FROM transactions");
+
+	/* the parameters are bound in the same order below */
+	if (filter->since_tid != NULL)
+		where[n_where++] = "rowid > (SELECT rowid FROM transactions WHERE transaction_id = ?)";
+	if (filter->before_tid != NULL)
+		where[n_where++] = "rowid < (SELECT rowid FROM transactions WHERE transaction_id = ?)";
+	if (filter->since_timespec != NULL)
+		where[n_where++] = "timespec > ?";
+	if (filter->role != PK_ROLE_ENUM_UNKNOWN)
+		where[n_where++] = "role = ?";
+	if (filter->uid != G_MAXUINT)
+		where[n_where++] = "uid = ?";
+	if (filter->succeeded >= 0)
+		where[n_where++] = "succeeded = ?";
+	for (guint i = 0; i < n_where; i++) {
+		g_string_append (sql, i == 0 ? " WHERE " : " AND ");
+		g_string_append (sql, where[i]);
+	}
+	if (filter->since_tid != NULL)
+		g_string_append (sql, " ORDER BY timespec ASC, rowid ASC");
+	else
+		g_string_append (sql, " ORDER BY timespec DESC, rowid DESC");
+	if (filter->limit > 0)
+		g_string_append (sql, " LIMIT ?");
+
+	if (!pk_transaction_db_prepare (tdb, sql->str, &statement))
+		return NULL;
+	rc = SQLITE_OK;
+	if (filter->since_tid != NULL && rc == SQLITE_OK)
+		rc = sqlite3_bind_text (statement, idx++, filter->since_tid, -1, SQLITE_STATIC);
+	if (filter->before_tid != NULL && rc == SQLITE_OK)
+		rc = sqlite3_bind_text (statement, idx++, filter->before_tid, -1, SQLITE_STATIC);
+	if (filter->since_timespec != NULL && rc == SQLITE_OK)
+		rc = sqlite3_bind_text (statement, idx++, filter->since_timespec, -1, SQLITE_STATIC);
+	if (filter->role != PK_ROLE_ENUM_UNKNOWN && rc == SQLITE_OK)
+		rc = sqlite3_bind_text (statement, idx++, pk_role_enum_to_string (filter->role), -1, SQLITE_STATIC);
+	if (filter->uid != G_MAXUINT && rc == SQLITE_OK)
+		rc = sqlite3_bind_int64 (statement, idx++, filter->uid);
+	if (filter->succeeded >= 0 && rc == SQLITE_OK)
+		rc = sqlite3_bind_int (statement, idx++, filter->succeeded > 0 ? 1 : 0);
+	if (filter->limit > 0 && rc == SQLITE_OK)
+		rc = sqlite3_bind_int64 (statement, idx++, filter->limit);
+	if (rc != SQLITE_OK) {
+		g_warning ("bind error: %d: %s", rc, sqlite3_errmsg (tdb->db));
+		return NULL;
+	}
+
+	/* add to start of the list */
+	while ((rc = sqlite3_step (statement)) == SQLITE_ROW) {
+		list = g_list_prepend (list,
+				       pk_transaction_db_past_from_statement (statement,
+									      filter->with_data));
+	}
+	if (rc != SQLITE_DONE)
+		g_warning ("SQL error: %d: %s", rc, sqlite3_errmsg (tdb->db));
+	if (filter->since_tid != NULL)
+		list = g_list_reverse (list);
+	return list;
+}
+
+GList *
+pk_transaction_db_get_list (PkTransactionDb *tdb, guint limit)
+{
+	PkTransactionDbFilter filter = PK_TRANSACTION_DB_FILTER_INIT;
+
+	filter.limit = limit;
+	return pk_transaction_db_get_list_filtered (tdb, &filter);
+}
+
 static gboolean
 pk_transaction_db_set_strings (PkTransactionDb *tdb,
 			       const gchar *sql,
@@ -958,6 +991,12 @@ pk_transaction_db_load (PkTransactionDb *tdb, GError **error)
 			return FALSE;
 	}
 
+	/* history is listed newest first and by role (since 1.3.8) */
+	statement = "CREATE INDEX IF NOT EXISTS transactions_timespec ON transactions (timespec);"
+		    "CREATE INDEX IF NOT EXISTS transactions_role ON transactions (role);";
+	if (!pk_transaction_db_execute (tdb, statement, error))
+		return FALSE;
+
 	/* check last_action (since 0.3.10) */
 	if (!pk_transaction_db_execute (tdb, "SELECT * FROM last_action LIMIT 1", &error_local)) {
 		g_debug ("adding last action details: %s", error_local->message);
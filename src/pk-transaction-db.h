@@ -30,6 +30,32 @@ G_BEGIN_DECLS
 #define PK_TYPE_TRANSACTION_DB (pk_transaction_db_get_type ())
 G_DECLARE_FINAL_TYPE (PkTransactionDb, pk_transaction_db, PK, TRANSACTION_DB, GObject)
 
+/**
+ * PkTransactionDbFilter:
+ * @limit: the maximum number of transactions, or 0 for no limit
+ * @since_tid: only transactions added after this one, or %NULL
+ * @before_tid: only transactions added before this one, or %NULL
+ * @since_timespec: only transactions started after this ISO8601 time, or %NULL
+ * @role: only transactions of this role, or %PK_ROLE_ENUM_UNKNOWN for any
+ * @uid: only transactions started by this user, or %G_MAXUINT for any
+ * @succeeded: only transactions which succeeded (1) or failed (0), or -1 for any
+ * @with_data: whether to return the list of packages of each transaction
+ *
+ * The restrictions for pk_transaction_db_get_list_filtered().
+ **/
+typedef struct {
+	guint		 limit;
+	const gchar	*since_tid;
+	const gchar	*before_tid;
+	const gchar	*since_timespec;
+	PkRoleEnum	 role;
+	guint		 uid;
+	gint		 succeeded;
+	gboolean	 with_data;
+} PkTransactionDbFilter;
+
+#define PK_TRANSACTION_DB_FILTER_INIT { 0, NULL, NULL, NULL, PK_ROLE_ENUM_UNKNOWN, G_MAXUINT, -1, TRUE }
+
 PkTransactionDb *pk_transaction_db_new (void);
 gboolean	 pk_transaction_db_load (PkTransactionDb *tdb,
 					 GError		**error);
@@ -55,6 +81,8 @@ gboolean	 pk_transaction_db_set_data (PkTransactionDb *tdb,
 					     const gchar     *data);
 GList		*pk_transaction_db_get_list (PkTransactionDb *tdb,
 					     guint	      limit);
+GList		*pk_transaction_db_get_list_filtered (PkTransactionDb		 *tdb,
+						      const PkTransactionDbFilter *filter);
 gboolean	 pk_transaction_db_action_time_reset (PkTransactionDb *tdb,
 						      PkRoleEnum       role);
 guint		 pk_transaction_db_action_time_since (PkTransactionDb *tdb,
@@ -40,6 +40,7 @@
 #include <glib/gstdio.h>
 #include <glib/gi18n.h>
 #include <gio/gio.h>
+#include <gio/gunixfdlist.h>
 #include <pk-common.h>
 #include <pk-common-private.h>
 #include <pk-enum.h>
@@ -51,6 +52,7 @@
 
 #include "pk-backend.h"
 #include "pk-dbus.h"
+#include "pk-result-channel.h"
 #include "pk-shared.h"
 #include "pk-transaction-db.h"
 #include "pk-transaction.h"
@@ -62,6 +64,9 @@ static void pk_transaction_dispose (GObject *object);
 static gchar *pk_transaction_get_content_type_for_file (const gchar *filename, GError **error);
 static gboolean pk_transaction_is_supported_content_type (PkTransaction *transaction,
 							  const gchar *content_type);
+static gboolean pk_transaction_emit_signal (PkTransaction *transaction,
+					    const gchar *signal_name,
+					    GVariant *parameters);
 
 #define PK_TRANSACTION_UPDATES_CHANGED_TIMEOUT 100 /* ms */
 
@@ -110,8 +115,22 @@ struct _PkTransaction
 
 	/* Rate limiting of progress reporting */
 	gboolean progress_changed;
+	GPtrArray *item_progress_pending; /* (element-type PkItemProgress) (owned) */
 	GSource *progress_timeout_source; /* (nullable) (owned) */
 
+	/* monotonic times in us, or 0 if the phase has not been reached */
+	gint64 state_time[PK_TRANSACTION_STATE_UNKNOWN];
+	gint64 results_emitted_time;
+
+	/* set if this is following an identical transaction */
+	PkTransaction *primary;
+	PkExitEnum exit_enum;
+
+	/* set if the results of this query can be cached */
+	gchar *result_cache_key;
+	guint result_cache_generation;
+	gboolean result_cache_hit;
+
 	/* needed for gui coldplugging */
 	gchar *last_package_id;
 	gchar *tid;
@@ -143,6 +162,7 @@ struct _PkTransaction
 	guint registration_id;
 	GDBusConnection *connection;
 	GDBusNodeInfo *introspection;
+	PkResultChannel *result_channel; /* (nullable) (owned) */
 };
 
 typedef enum {
@@ -258,6 +278,9 @@ pk_transaction_finish_invalidate_caches (PkTransaction *transaction)
 	    transaction->role == PK_ROLE_ENUM_REPO_REMOVE ||
 	    transaction->role == PK_ROLE_ENUM_REFRESH_CACHE) {
 
+		/* the cached results are out of date now */
+		pk_backend_result_cache_invalidate (transaction->backend);
+
 		/* this needs to be done after a small delay */
 		pk_backend_updates_changed_delay (transaction->backend,
 						  PK_TRANSACTION_UPDATES_CHANGED_TIMEOUT);
@@ -320,13 +343,30 @@ pk_transaction_emit_property_changed (PkTransaction *transaction,
 
 /* If any progress-related properties have changed since the last
  * `PropertiesChanged` emission, immediately emit that D-Bus signal with the
- * latest values and clear the pending changes flag.
+ * latest values and clear the pending changes flag. Any queued `ItemProgress`
+ * signals are emitted first.
  *
  * See schedule_progress_changed().
  */
 static void
 flush_progress_changed (PkTransaction *transaction)
 {
+	/* the latest progress of each item, in the order they were first seen */
+	if (transaction->item_progress_pending->len > 0) {
+		g_autoptr(GPtrArray) items = g_steal_pointer (&transaction->item_progress_pending);
+
+		transaction->item_progress_pending = g_ptr_array_new_with_free_func (g_object_unref);
+		for (guint i = 0; i < items->len; i++) {
+			PkItemProgress *item_progress = g_ptr_array_index (items, i);
+			pk_transaction_emit_signal (transaction,
+						    "ItemProgress",
+						    g_variant_new ("(suu)",
+								   pk_item_progress_get_package_id (item_progress),
+								   pk_item_progress_get_status (item_progress),
+								   pk_item_progress_get_percentage (item_progress)));
+		}
+	}
+
 	if (!transaction->progress_changed)
 		return;
 
@@ -377,10 +417,8 @@ progress_timeout_cb (gpointer user_data)
  * flush_progress_changed().
  */
 static void
-schedule_progress_changed (PkTransaction *transaction)
+schedule_progress_timeout (PkTransaction *transaction)
 {
-	transaction->progress_changed = TRUE;
-
 	if (transaction->progress_timeout_source == NULL) {
 		g_autoptr(GSource) source = NULL;
 
@@ -399,6 +437,38 @@ schedule_progress_changed (PkTransaction *transaction)
 	}
 }
 
+static void
+schedule_progress_changed (PkTransaction *transaction)
+{
+	transaction->progress_changed = TRUE;
+	schedule_progress_timeout (transaction);
+}
+
+/* ItemProgress is rate limited in the same way, keeping only the latest
+ * update for each package. A package changing status is not coalesced, so
+ * that clients see every step it goes through. */
+static void
+schedule_item_progress (PkTransaction *transaction, PkItemProgress *item_progress)
+{
+	const gchar *package_id = pk_item_progress_get_package_id (item_progress);
+	GPtrArray *pending = transaction->item_progress_pending;
+
+	for (guint i = 0; i < pending->len; i++) {
+		PkItemProgress *item_tmp = g_ptr_array_index (pending, i);
+		if (g_strcmp0 (pk_item_progress_get_package_id (item_tmp), package_id) != 0)
+			continue;
+		if (pk_item_progress_get_status (item_tmp) != pk_item_progress_get_status (item_progress)) {
+			flush_progress_changed (transaction);
+			break;
+		}
+		g_ptr_array_index (pending, i) = g_object_ref (item_progress);
+		g_object_unref (item_tmp);
+		return;
+	}
+	g_ptr_array_add (transaction->item_progress_pending, g_object_ref (item_progress));
+	schedule_progress_timeout (transaction);
+}
+
 /* Remove the @progress_timeout_source, if set. */
 static void
 unschedule_progress_changed (PkTransaction *transaction)
@@ -469,20 +539,46 @@ pk_transaction_status_changed_emit (PkTransaction *transaction, PkStatusEnum sta
 	pk_transaction_emit_property_changed (transaction, "Status", g_variant_new_uint32 (status));
 }
 
+/* emits a signal on the transaction, sending it over the result channel
+ * instead of the bus if the client has opened one */
+static gboolean
+pk_transaction_emit_signal (PkTransaction *transaction,
+			    const gchar *signal_name,
+			    GVariant *parameters)
+{
+	g_autoptr(GVariant) parameters_owned = g_variant_ref_sink (parameters);
+
+	if (transaction->result_channel != NULL &&
+	    pk_result_channel_emit (transaction->result_channel, signal_name, parameters_owned)) {
+		/* other clients watching the transaction still want to know
+		 * when it is done */
+		if (g_strcmp0 (signal_name, "Finished") != 0)
+			return TRUE;
+		pk_result_channel_close (transaction->result_channel);
+	}
+	return g_dbus_connection_emit_signal (transaction->connection,
+					      NULL,
+					      transaction->tid,
+					      PK_DBUS_INTERFACE_TRANSACTION,
+					      signal_name,
+					      parameters_owned,
+					      NULL);
+}
+
 static void
 pk_transaction_finished_emit (PkTransaction *transaction, PkExitEnum exit_enum, guint time_ms)
 {
 	g_assert (!transaction->emitted_finished);
 	transaction->emitted_finished = TRUE;
+	transaction->exit_enum = exit_enum;
+
+	/* stop following the other transaction */
+	pk_transaction_unsubscribe (transaction);
 
 	g_debug ("emitting finished '%s', %i", pk_exit_enum_to_string (exit_enum), time_ms);
-	g_dbus_connection_emit_signal (transaction->connection,
-				       NULL,
-				       transaction->tid,
-				       PK_DBUS_INTERFACE_TRANSACTION,
-				       "Finished",
-				       g_variant_new ("(uu)", exit_enum, time_ms),
-				       NULL);
+	pk_transaction_emit_signal (transaction,
+				    "Finished",
+				    g_variant_new ("(uu)", exit_enum, time_ms));
 
 	/* For the transaction list */
 	g_signal_emit (transaction, signals[SIGNAL_FINISHED], 0);
@@ -494,13 +590,9 @@ pk_transaction_error_code_emit (PkTransaction *transaction,
 				const gchar *details)
 {
 	g_debug ("emitting error-code %s, '%s'", pk_error_enum_to_string (error_enum), details);
-	g_dbus_connection_emit_signal (transaction->connection,
-				       NULL,
-				       transaction->tid,
-				       PK_DBUS_INTERFACE_TRANSACTION,
-				       "ErrorCode",
-				       g_variant_new ("(us)", error_enum, details),
-				       NULL);
+	pk_transaction_emit_signal (transaction,
+				    "ErrorCode",
+				    g_variant_new ("(us)", error_enum, details));
 }
 
 static void
@@ -528,22 +620,14 @@ pk_transaction_locked_changed_cb (PkBackendJob *job, gboolean locked, PkTransact
 		pk_transaction_make_exclusive (transaction);
 }
 
-static void
-pk_transaction_details_cb (PkBackendJob *job, PkDetails *item, PkTransaction *transaction)
+static GVariant *
+pk_transaction_details_to_variant (PkDetails *item)
 {
 	GVariantBuilder builder;
 	PkGroupEnum group;
 	const gchar *tmp;
 	guint64 size;
 
-	g_return_if_fail (PK_IS_TRANSACTION (transaction));
-	g_return_if_fail (transaction->tid != NULL);
-
-	/* add to results */
-	pk_results_add_details (transaction->results, item);
-
-	/* emit */
-	g_debug ("emitting details");
 	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));
 	g_variant_builder_add (&builder,
 			       "{sv}",
@@ -573,14 +657,73 @@ pk_transaction_details_cb (PkBackendJob *job, PkDetails *item, PkTransaction *tr
 				       "{sv}",
 				       "download-size",
 				       g_variant_new_uint64 (size));
+	return g_variant_builder_end (&builder);
+}
 
-	g_dbus_connection_emit_signal (transaction->connection,
-				       NULL,
-				       transaction->tid,
-				       PK_DBUS_INTERFACE_TRANSACTION,
-				       "Details",
-				       g_variant_new ("(a{sv})", &builder),
-				       NULL);
+static void
+pk_transaction_details_cb (PkBackendJob *job, PkDetails *item, PkTransaction *transaction)
+{
+	g_return_if_fail (PK_IS_TRANSACTION (transaction));
+	g_return_if_fail (transaction->tid != NULL);
+
+	/* add to results */
+	pk_results_add_details (transaction->results, item);
+
+	/* emit */
+	g_debug ("emitting details");
+	pk_transaction_emit_signal (transaction,
+				    "Details",
+				    g_variant_new ("(@a{sv})", pk_transaction_details_to_variant (item)));
+}
+
+static void
+pk_transaction_details_list_cb (PkBackendJob *job,
+				GPtrArray *details_array, /* (element-type PkDetails) */
+				PkTransaction *transaction)
+{
+	g_auto(GVariantBuilder) builder = G_VARIANT_BUILDER_INIT (G_VARIANT_TYPE ("aa{sv}"));
+	g_autoptr(GVariant) details_array_variant = NULL;
+	gboolean emitted = FALSE;
+
+	g_return_if_fail (PK_IS_TRANSACTION (transaction));
+	g_return_if_fail (transaction->tid != NULL);
+
+	if (details_array->len == 0) {
+		g_debug ("Empty details array");
+		return;
+	}
+
+	for (guint i = 0; i < details_array->len; i++) {
+		PkDetails *item = g_ptr_array_index (details_array, i);
+
+		/* add to results */
+		pk_results_add_details (transaction->results, item);
+		g_variant_builder_add_value (&builder, pk_transaction_details_to_variant (item));
+	}
+	details_array_variant = g_variant_ref_sink (g_variant_builder_end (&builder));
+
+	/* Emit the signal, see pk_transaction_packages_cb() for why this is
+	 * grouped into one signal, and fall back to one signal per item if
+	 * the client does not support it or the D-Bus limits are hit. */
+	g_debug ("emitting details-list of %u items", details_array->len);
+	if (transaction->client_supports_plural_signals &&
+	    pk_transaction_emit_signal (transaction,
+					"DetailsList",
+					g_variant_new ("(@aa{sv})", details_array_variant)))
+		emitted = TRUE;
+
+	if (!emitted) {
+		GVariantIter iter;
+		g_autoptr(GVariant) child = NULL;
+
+		g_variant_iter_init (&iter, details_array_variant);
+		while ((child = g_variant_iter_next_value (&iter))) {
+			pk_transaction_emit_signal (transaction,
+						    "Details",
+						    g_variant_new_tuple (&child, 1));
+			g_clear_pointer (&child, g_variant_unref);
+		}
+	}
 }
 
 static void
@@ -614,23 +757,17 @@ pk_transaction_error_code_cb (PkBackendJob *job, PkError *item, PkTransaction *t
 	}
 }
 
-static void
-pk_transaction_files_cb (PkBackendJob *job, PkFiles *item, PkTransaction *transaction)
+/* adds @item to the results, and returns a new (s^as) variant */
+static GVariant *
+pk_transaction_files_add_result (PkTransaction *transaction, PkFiles *item)
 {
-	guint i;
-	g_autofree gchar *package_id = NULL;
-	g_auto(GStrv) files = NULL;
-
-	g_return_if_fail (PK_IS_TRANSACTION (transaction));
-	g_return_if_fail (transaction->tid != NULL);
-
-	/* get data */
-	g_object_get (item, "package-id", &package_id, "files", &files, NULL);
+	const gchar *package_id = pk_files_get_package_id (item);
+	gchar **files = pk_files_get_files (item);
 
 	/* ensure the files have the correct prefix */
 	if (transaction->role == PK_ROLE_ENUM_DOWNLOAD_PACKAGES &&
 	    transaction->cached_directory != NULL) {
-		for (i = 0; files[i] != NULL; i++) {
+		for (guint i = 0; files[i] != NULL; i++) {
 			if (!g_str_has_prefix (files[i], transaction->cached_directory)) {
 				g_warning ("%s does not have the correct prefix (%s)",
 					   files[i],
@@ -642,16 +779,68 @@ pk_transaction_files_cb (PkBackendJob *job, PkFiles *item, PkTransaction *transa
 	/* add to results */
 	pk_results_add_files (transaction->results, item);
 
+	return g_variant_new ("(s^as)", package_id != NULL ? package_id : "", files);
+}
+
+static void
+pk_transaction_files_cb (PkBackendJob *job, PkFiles *item, PkTransaction *transaction)
+{
+	GVariant *files_variant;
+
+	g_return_if_fail (PK_IS_TRANSACTION (transaction));
+	g_return_if_fail (transaction->tid != NULL);
+
+	files_variant = pk_transaction_files_add_result (transaction, item);
+
 	/* emit */
-	g_debug ("emitting files %s", package_id);
-	g_dbus_connection_emit_signal (
-	    transaction->connection,
-	    NULL,
-	    transaction->tid,
-	    PK_DBUS_INTERFACE_TRANSACTION,
-	    "Files",
-	    g_variant_new ("(s^as)", package_id != NULL ? package_id : "", files),
-	    NULL);
+	g_debug ("emitting files %s", pk_files_get_package_id (item));
+	pk_transaction_emit_signal (transaction, "Files", files_variant);
+}
+
+static void
+pk_transaction_files_list_cb (PkBackendJob *job,
+			      GPtrArray *files_array, /* (element-type PkFiles) */
+			      PkTransaction *transaction)
+{
+	g_auto(GVariantBuilder) builder = G_VARIANT_BUILDER_INIT (G_VARIANT_TYPE ("a(sas)"));
+	g_autoptr(GVariant) files_array_variant = NULL;
+	gboolean emitted = FALSE;
+
+	g_return_if_fail (PK_IS_TRANSACTION (transaction));
+	g_return_if_fail (transaction->tid != NULL);
+
+	if (files_array->len == 0) {
+		g_debug ("Empty files array");
+		return;
+	}
+
+	for (guint i = 0; i < files_array->len; i++) {
+		PkFiles *item = g_ptr_array_index (files_array, i);
+		g_variant_builder_add_value (&builder,
+					     pk_transaction_files_add_result (transaction, item));
+	}
+	files_array_variant = g_variant_ref_sink (g_variant_builder_end (&builder));
+
+	/* Emit the signal, see pk_transaction_packages_cb() for why this is
+	 * grouped into one signal, and fall back to one signal per item if
+	 * the client does not support it or the D-Bus limits are hit. */
+	g_debug ("emitting files-list of %u items", files_array->len);
+	if (transaction->client_supports_plural_signals &&
+	    pk_transaction_emit_signal (transaction,
+					"FilesList",
+					g_variant_new ("(@a(sas))", files_array_variant)))
+		emitted = TRUE;
+
+	if (!emitted) {
+		GVariantIter iter;
+		g_autoptr(GVariant) child = NULL;
+
+		g_variant_iter_init (&iter, files_array_variant);
+		while ((child = g_variant_iter_next_value (&iter))) {
+			pk_transaction_emit_signal (transaction, "Files", child);
+			g_clear_pointer (&child, g_variant_unref);
+		}
+	}
 }
 
 static void
@@ -685,18 +874,14 @@ pk_transaction_category_cb (PkBackendJob *job, PkCategory *item, PkTransaction *
 
 	/* emit */
 	g_debug ("emitting category %s, %s, %s, %s, %s ", parent_id, cat_id, name, summary, icon);
-	g_dbus_connection_emit_signal (transaction->connection,
-				       NULL,
-				       transaction->tid,
-				       PK_DBUS_INTERFACE_TRANSACTION,
-				       "Category",
-				       g_variant_new ("(sssss)",
-						      parent_id != NULL ? parent_id : "",
-						      cat_id,
-						      name,
-						      summary,
-						      icon != NULL ? icon : ""),
-				       NULL);
+	pk_transaction_emit_signal (transaction,
+				    "Category",
+				    g_variant_new ("(sssss)",
+						   parent_id != NULL ? parent_id : "",
+						   cat_id,
+						   name,
+						   summary,
+						   icon != NULL ? icon : ""));
 }
 
 static void
@@ -707,22 +892,12 @@ pk_transaction_item_progress_cb (PkBackendJob *job,
 	g_return_if_fail (PK_IS_TRANSACTION (transaction));
 	g_return_if_fail (transaction->tid != NULL);
 
-	/* emit */
-	g_debug ("emitting item-progress %s, %s: %u",
+	/* emitted with the other progress */
+	g_debug ("queueing item-progress %s, %s: %u",
 		 pk_item_progress_get_package_id (item_progress),
 		 pk_status_enum_to_string (pk_item_progress_get_status (item_progress)),
 		 pk_item_progress_get_percentage (item_progress));
-	g_dbus_connection_emit_signal (
-	    transaction->connection,
-	    NULL,
-	    transaction->tid,
-	    PK_DBUS_INTERFACE_TRANSACTION,
-	    "ItemProgress",
-	    g_variant_new ("(suu)",
-			   pk_item_progress_get_package_id (item_progress),
-			   pk_item_progress_get_status (item_progress),
-			   pk_item_progress_get_percentage (item_progress)),
-	    NULL);
+	schedule_item_progress (transaction, item_progress);
 }
 
 static void
@@ -748,14 +923,9 @@ pk_transaction_distro_upgrade_cb (PkBackendJob *job,
 		 pk_update_state_enum_to_string (state),
 		 name,
 		 summary);
-	g_dbus_connection_emit_signal (
-	    transaction->connection,
-	    NULL,
-	    transaction->tid,
-	    PK_DBUS_INTERFACE_TRANSACTION,
-	    "DistroUpgrade",
-	    g_variant_new ("(uss)", state, name, summary != NULL ? summary : ""),
-	    NULL);
+	pk_transaction_emit_signal (transaction,
+				    "DistroUpgrade",
+				    g_variant_new ("(uss)", state, name, summary != NULL ? summary : ""));
 }
 
 static gchar *
@@ -832,6 +1002,8 @@ pk_transaction_set_state (PkTransaction *transaction, PkTransactionState state)
 
 	g_debug ("transaction now %s", pk_transaction_state_to_string (state));
 	transaction->state = state;
+	if (state < PK_TRANSACTION_STATE_UNKNOWN)
+		transaction->state_time[state] = g_get_monotonic_time ();
 	g_signal_emit (transaction, signals[SIGNAL_STATE_CHANGED], 0, state);
 
 	/* only get cmdline when it's going to be saved into the database */
@@ -1084,6 +1256,42 @@ pk_transaction_offline_finished (PkTransaction *transaction)
 	}
 }
 
+/* in ms, or -1 if either phase was not reached */
+static gint
+pk_transaction_get_phase_duration (gint64 start, gint64 end)
+{
+	if (start == 0 || end == 0 || end < start)
+		return -1;
+	return (end - start) / 1000;
+}
+
+static GVariant *
+pk_transaction_get_timings (PkTransaction *transaction)
+{
+	GVariantBuilder builder;
+	gint64 backend_finished_time = 0;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{st}"));
+	for (guint i = 0; i < PK_TRANSACTION_STATE_UNKNOWN; i++) {
+		if (transaction->state_time[i] == 0)
+			continue;
+		g_variant_builder_add (&builder, "{st}",
+				       pk_transaction_state_to_string (i),
+				       (guint64) transaction->state_time[i]);
+	}
+	if (transaction->job != NULL)
+		backend_finished_time = pk_backend_job_get_finished_time (transaction->job);
+	if (backend_finished_time != 0)
+		g_variant_builder_add (&builder, "{st}",
+				       "backend-finished",
+				       (guint64) backend_finished_time);
+	if (transaction->results_emitted_time != 0)
+		g_variant_builder_add (&builder, "{st}",
+				       "results-emitted",
+				       (guint64) transaction->results_emitted_time);
+	return g_variant_builder_end (&builder);
+}
+
 static void
 pk_transaction_finished_cb (PkBackendJob *job, PkExitEnum exit_enum, PkTransaction *transaction)
 {
@@ -1102,6 +1310,9 @@ pk_transaction_finished_cb (PkBackendJob *job, PkExitEnum exit_enum, PkTransacti
 		return;
 	}
 
+	/* all the results the backend emitted have now been processed */
+	transaction->results_emitted_time = g_get_monotonic_time ();
+
 	/* Ensure any pending progress has been emitted and remove the progress
 	 * timer since it’s unlikely to be used again. */
 	unschedule_progress_changed (transaction);
@@ -1139,9 +1350,29 @@ pk_transaction_finished_cb (PkBackendJob *job, PkExitEnum exit_enum, PkTransacti
 	if (exit_enum == PK_EXIT_ENUM_SUCCESS)
 		pk_transaction_finish_invalidate_caches (transaction);
 
+	/* the same query can now be answered without asking the backend */
+	if (exit_enum == PK_EXIT_ENUM_SUCCESS &&
+	    transaction->result_cache_key != NULL &&
+	    !transaction->result_cache_hit) {
+		pk_backend_result_cache_add (transaction->backend,
+					     transaction->result_cache_key,
+					     transaction->result_cache_generation,
+					     transaction->results);
+	}
+
 	/* find the length of time we have been running */
 	time_ms = pk_transaction_get_runtime (transaction);
 	g_debug ("backend was running for %i ms", time_ms);
+	g_debug ("%s took auth:%ims queued:%ims backend:%ims emit:%ims",
+		 pk_role_enum_to_string (transaction->role),
+		 pk_transaction_get_phase_duration (transaction->state_time[PK_TRANSACTION_STATE_WAITING_FOR_AUTH],
+						    transaction->state_time[PK_TRANSACTION_STATE_READY]),
+		 pk_transaction_get_phase_duration (transaction->state_time[PK_TRANSACTION_STATE_READY],
+						    transaction->state_time[PK_TRANSACTION_STATE_RUNNING]),
+		 pk_transaction_get_phase_duration (transaction->state_time[PK_TRANSACTION_STATE_RUNNING],
+						    pk_backend_job_get_finished_time (job)),
+		 pk_transaction_get_phase_duration (pk_backend_job_get_finished_time (job),
+						    transaction->results_emitted_time));
 
 	/* add to the database if we are going to log it */
 	if (transaction->role == PK_ROLE_ENUM_UPDATE_PACKAGES ||
@@ -1303,14 +1534,9 @@ pk_transaction_package_cb (PkBackend *backend, PkPackage *item, PkTransaction *t
 	update_severity = pk_package_get_update_severity (item);
 	encoded_value = info | (((guint32) update_severity) << 16);
 
-	g_dbus_connection_emit_signal (
-	    transaction->connection,
-	    NULL,
-	    transaction->tid,
-	    PK_DBUS_INTERFACE_TRANSACTION,
-	    "Package",
-	    g_variant_new ("(uss)", encoded_value, package_id, summary ? summary : ""),
-	    NULL);
+	pk_transaction_emit_signal (transaction,
+				    "Package",
+				    g_variant_new ("(uss)", encoded_value, package_id, summary ? summary : ""));
 }
 
 static void
@@ -1422,13 +1648,9 @@ pk_transaction_packages_cb (PkBackend *backend,
 	 * maximum message size of 128MB) until it’s listing on the order of
 	 * 100000 packages. If it does, we fall back below. */
 	if (transaction->client_supports_plural_signals &&
-	    g_dbus_connection_emit_signal (transaction->connection,
-					   NULL,
-					   transaction->tid,
-					   PK_DBUS_INTERFACE_TRANSACTION,
-					   "Packages",
-					   g_variant_new ("(@a(uss))", package_array_variant),
-					   NULL))
+	    pk_transaction_emit_signal (transaction,
+					"Packages",
+					g_variant_new ("(@a(uss))", package_array_variant)))
 		emitted = TRUE;
 
 	if (!emitted) {
@@ -1439,13 +1661,7 @@ pk_transaction_packages_cb (PkBackend *backend,
 		g_variant_iter_init (&iter, package_array_variant);
 
 		while ((child = g_variant_iter_next_value (&iter))) {
-			g_dbus_connection_emit_signal (transaction->connection,
-						       NULL,
-						       transaction->tid,
-						       PK_DBUS_INTERFACE_TRANSACTION,
-						       "Package",
-						       child,
-						       NULL);
+			pk_transaction_emit_signal (transaction, "Package", child);
 			g_clear_pointer (&child, g_variant_unref);
 		}
 	}
@@ -1469,14 +1685,9 @@ pk_transaction_repo_detail_cb (PkBackend *backend, PkRepoDetail *item, PkTransac
 	description = pk_repo_detail_get_description (item);
 	enabled = pk_repo_detail_get_enabled (item);
 	g_debug ("emitting repo-detail %s, %s, %i", repo_id, description, enabled);
-	g_dbus_connection_emit_signal (
-	    transaction->connection,
-	    NULL,
-	    transaction->tid,
-	    PK_DBUS_INTERFACE_TRANSACTION,
-	    "RepoDetail",
-	    g_variant_new ("(ssb)", repo_id, description != NULL ? description : "", enabled),
-	    NULL);
+	pk_transaction_emit_signal (transaction,
+				    "RepoDetail",
+				    g_variant_new ("(ssb)", repo_id, description != NULL ? description : "", enabled));
 }
 
 static void
@@ -1529,22 +1740,17 @@ pk_transaction_repo_signature_required_cb (PkBackend *backend,
 		 key_fingerprint,
 		 key_timestamp,
 		 pk_sig_type_enum_to_string (type));
-	g_dbus_connection_emit_signal (
-	    transaction->connection,
-	    NULL,
-	    transaction->tid,
-	    PK_DBUS_INTERFACE_TRANSACTION,
-	    "RepoSignatureRequired",
-	    g_variant_new ("(sssssssu)",
-			   package_id,
-			   repository_name,
-			   key_url != NULL ? key_url : "",
-			   key_userid != NULL ? key_userid : "",
-			   key_id != NULL ? key_id : "",
-			   key_fingerprint != NULL ? key_fingerprint : "",
-			   key_timestamp != NULL ? key_timestamp : "",
-			   type),
-	    NULL);
+	pk_transaction_emit_signal (transaction,
+				    "RepoSignatureRequired",
+				    g_variant_new ("(sssssssu)",
+						   package_id,
+						   repository_name,
+						   key_url != NULL ? key_url : "",
+						   key_userid != NULL ? key_userid : "",
+						   key_id != NULL ? key_id : "",
+						   key_fingerprint != NULL ? key_fingerprint : "",
+						   key_timestamp != NULL ? key_timestamp : "",
+						   type));
 
 	/* we should mark this transaction so that we finish with a special code */
 	transaction->emit_signature_required = TRUE;
@@ -1578,18 +1784,13 @@ pk_transaction_eula_required_cb (PkBackend *backend,
 		 package_id,
 		 vendor_name,
 		 license_agreement);
-	g_dbus_connection_emit_signal (
-	    transaction->connection,
-	    NULL,
-	    transaction->tid,
-	    PK_DBUS_INTERFACE_TRANSACTION,
-	    "EulaRequired",
-	    g_variant_new ("(ssss)",
-			   eula_id,
-			   package_id,
-			   vendor_name != NULL ? vendor_name : "",
-			   license_agreement != NULL ? license_agreement : ""),
-	    NULL);
+	pk_transaction_emit_signal (transaction,
+				    "EulaRequired",
+				    g_variant_new ("(ssss)",
+						   eula_id,
+						   package_id,
+						   vendor_name != NULL ? vendor_name : "",
+						   license_agreement != NULL ? license_agreement : ""));
 
 	/* we should mark this transaction so that we finish with a special code */
 	transaction->emit_eula_required = TRUE;
@@ -1625,14 +1826,9 @@ pk_transaction_media_change_required_cb (PkBackend *backend,
 		 pk_media_type_enum_to_string (media_type),
 		 media_id,
 		 media_text);
-	g_dbus_connection_emit_signal (
-	    transaction->connection,
-	    NULL,
-	    transaction->tid,
-	    PK_DBUS_INTERFACE_TRANSACTION,
-	    "MediaChangeRequired",
-	    g_variant_new ("(uss)", media_type, media_id, media_text != NULL ? media_text : ""),
-	    NULL);
+	pk_transaction_emit_signal (transaction,
+				    "MediaChangeRequired",
+				    g_variant_new ("(uss)", media_type, media_id, media_text != NULL ? media_text : ""));
 
 	/* we should mark this transaction so that we finish with a special code */
 	transaction->emit_media_change_required = TRUE;
@@ -1683,13 +1879,9 @@ pk_transaction_require_restart_cb (PkBackend *backend,
 	g_debug ("emitting require-restart %s, '%s'",
 		 pk_restart_enum_to_string (restart),
 		 package_id);
-	g_dbus_connection_emit_signal (transaction->connection,
-				       NULL,
-				       transaction->tid,
-				       PK_DBUS_INTERFACE_TRANSACTION,
-				       "RequireRestart",
-				       g_variant_new ("(us)", restart, package_id),
-				       NULL);
+	pk_transaction_emit_signal (transaction,
+				    "RequireRestart",
+				    g_variant_new ("(us)", restart, package_id));
 }
 
 static void
@@ -1749,25 +1941,21 @@ pk_transaction_update_detail_cb (PkBackend *backend,
 	issued = pk_update_detail_get_issued (item);
 	updated = pk_update_detail_get_updated (item);
 	g_debug ("emitting update-detail for %s", package_id);
-	g_dbus_connection_emit_signal (transaction->connection,
-				       NULL,
-				       transaction->tid,
-				       PK_DBUS_INTERFACE_TRANSACTION,
-				       "UpdateDetail",
-				       g_variant_new ("(s^as^as^as^as^asussuss)",
-						      package_id,
-						      updates != NULL ? updates : empty,
-						      obsoletes != NULL ? obsoletes : empty,
-						      vendor_urls != NULL ? vendor_urls : empty,
-						      bugzilla_urls != NULL ? bugzilla_urls : empty,
-						      cve_urls != NULL ? cve_urls : empty,
-						      pk_update_detail_get_restart (item),
-						      update_text != NULL ? update_text : "",
-						      changelog != NULL ? changelog : "",
-						      pk_update_detail_get_state (item),
-						      issued != NULL ? issued : "",
-						      updated != NULL ? updated : ""),
-				       NULL);
+	pk_transaction_emit_signal (transaction,
+				    "UpdateDetail",
+				    g_variant_new ("(s^as^as^as^as^asussuss)",
+						   package_id,
+						   updates != NULL ? updates : empty,
+						   obsoletes != NULL ? obsoletes : empty,
+						   vendor_urls != NULL ? vendor_urls : empty,
+						   bugzilla_urls != NULL ? bugzilla_urls : empty,
+						   cve_urls != NULL ? cve_urls : empty,
+						   pk_update_detail_get_restart (item),
+						   update_text != NULL ? update_text : "",
+						   changelog != NULL ? changelog : "",
+						   pk_update_detail_get_state (item),
+						   issued != NULL ? issued : "",
+						   updated != NULL ? updated : ""));
 }
 
 static void
@@ -1851,14 +2039,9 @@ pk_transaction_update_details_cb (
 	 * 6400 updates, if we assume 10KB of changelog/details per update.
 	 * If it does hit the limits, we fall back to the old code below. */
 	if (transaction->client_supports_plural_signals &&
-	    g_dbus_connection_emit_signal (
-		transaction->connection,
-		NULL,
-		transaction->tid,
-		PK_DBUS_INTERFACE_TRANSACTION,
-		"UpdateDetails",
-		g_variant_new ("(@a(sasasasasasussuss))", update_details_array_variant),
-		NULL))
+	    pk_transaction_emit_signal (transaction,
+					"UpdateDetails",
+					g_variant_new ("(@a(sasasasasasussuss))", update_details_array_variant)))
 		emitted = TRUE;
 
 	if (!emitted) {
@@ -1869,13 +2052,7 @@ pk_transaction_update_details_cb (
 		g_variant_iter_init (&iter, update_details_array_variant);
 
 		while ((child = g_variant_iter_next_value (&iter))) {
-			g_dbus_connection_emit_signal (transaction->connection,
-						       NULL,
-						       transaction->tid,
-						       PK_DBUS_INTERFACE_TRANSACTION,
-						       "UpdateDetail",
-						       child,
-						       NULL);
+			pk_transaction_emit_signal (transaction, "UpdateDetail", child);
 			g_clear_pointer (&child, g_variant_unref);
 		}
 	}
@@ -1969,57 +2146,9 @@ pk_transaction_percentage_cb (PkBackendJob *job, guint percentage, PkTransaction
 	schedule_progress_changed (transaction);
 }
 
-gboolean
-pk_transaction_run (PkTransaction *transaction)
+static void
+pk_transaction_set_vfuncs (PkTransaction *transaction)
 {
-	GError *error = NULL;
-	PkExitEnum exit_status;
-
-	g_return_val_if_fail (PK_IS_TRANSACTION (transaction), FALSE);
-	g_return_val_if_fail (transaction->tid != NULL, FALSE);
-	g_return_val_if_fail (transaction->backend != NULL, FALSE);
-
-	/* we are no longer waiting, we are setting up */
-	pk_transaction_status_changed_emit (transaction, PK_STATUS_ENUM_SETUP);
-
-	/* set proxy */
-	if (!pk_transaction_set_session_state (transaction, &error)) {
-		g_debug ("failed to set the session state (non-fatal): %s", error->message);
-		g_clear_error (&error);
-	}
-
-	/* already cancelled? */
-	if (pk_backend_job_get_exit_code (transaction->job) == PK_EXIT_ENUM_CANCELLED) {
-		exit_status = pk_backend_job_get_exit_code (transaction->job);
-		pk_transaction_finished_emit (transaction, exit_status, 0);
-		return TRUE;
-	}
-
-	/* run the job */
-	pk_backend_start_job (transaction->backend, transaction->job);
-
-	/* is an error code set? */
-	if (pk_backend_job_get_is_error_set (transaction->job)) {
-		exit_status = pk_backend_job_get_exit_code (transaction->job);
-		pk_transaction_finished_emit (transaction, exit_status, 0);
-		/* do not fail the transaction */
-	}
-
-	/* check if we should skip this transaction */
-	if (pk_backend_job_get_exit_code (transaction->job) == PK_EXIT_ENUM_SKIP_TRANSACTION) {
-		pk_transaction_finished_emit (transaction, PK_EXIT_ENUM_SUCCESS, 0);
-		/* do not fail the transaction */
-	}
-
-	/* set the role */
-	pk_backend_job_set_role (transaction->job, transaction->role);
-	g_debug ("setting role for %s to %s",
-		 transaction->tid,
-		 pk_role_enum_to_string (transaction->role));
-
-	/* reset after the pre-transaction checks */
-	pk_backend_job_set_percentage (transaction->job, PK_BACKEND_PERCENTAGE_INVALID);
-
 	/* connect signal to receive backend lock changes */
 	pk_backend_job_set_vfunc (transaction->job,
 				  PK_BACKEND_SIGNAL_LOCKED_CHANGED,
@@ -2109,6 +2238,137 @@ pk_transaction_run (PkTransaction *transaction)
 				  PK_BACKEND_SIGNAL_CATEGORY,
 				  PK_BACKEND_JOB_VFUNC (pk_transaction_category_cb),
 				  transaction);
+	pk_backend_job_set_vfunc (transaction->job,
+				  PK_BACKEND_SIGNAL_DETAILS_LIST,
+				  PK_BACKEND_JOB_VFUNC (pk_transaction_details_list_cb),
+				  transaction);
+	pk_backend_job_set_vfunc (transaction->job,
+				  PK_BACKEND_SIGNAL_FILES_LIST,
+				  PK_BACKEND_JOB_VFUNC (pk_transaction_files_list_cb),
+				  transaction);
+}
+
+/* returns NULL if the results of the role cannot be cached */
+static gchar *
+pk_transaction_get_result_cache_key (PkTransaction *transaction)
+{
+	const gchar *locale;
+	g_autofree gchar *filters = NULL;
+	g_autofree gchar *package_ids = NULL;
+
+	switch (transaction->role) {
+	case PK_ROLE_ENUM_GET_DETAILS:
+	case PK_ROLE_ENUM_GET_PACKAGES:
+	case PK_ROLE_ENUM_GET_UPDATE_DETAIL:
+	case PK_ROLE_ENUM_GET_UPDATES:
+		break;
+	default:
+		return NULL;
+	}
+
+	filters = pk_filter_bitfield_to_string (transaction->cached_filters);
+	if (transaction->cached_package_ids != NULL)
+		package_ids = g_strjoinv ("\t", transaction->cached_package_ids);
+	locale = pk_backend_job_get_locale (transaction->job);
+	return g_strdup_printf ("%s|%s|%s|%s",
+				pk_role_enum_to_string (transaction->role),
+				filters,
+				package_ids != NULL ? package_ids : "",
+				locale != NULL ? locale : "");
+}
+
+/* sends the cached results through the same path as the backend would */
+static void
+pk_transaction_replay_results (PkTransaction *transaction, PkResults *results)
+{
+	g_autoptr(GPtrArray) packages = NULL;
+	g_autoptr(GPtrArray) details = NULL;
+	g_autoptr(GPtrArray) update_details = NULL;
+
+	pk_backend_job_set_status (transaction->job, PK_STATUS_ENUM_QUERY);
+
+	packages = pk_results_get_package_array (results);
+	if (packages->len > 0)
+		pk_backend_job_packages (transaction->job, packages);
+	details = pk_results_get_details_array (results);
+	if (details->len > 0)
+		pk_backend_job_details_list (transaction->job, details);
+	update_details = pk_results_get_update_detail_array (results);
+	if (update_details->len > 0)
+		pk_backend_job_update_details (transaction->job, update_details);
+
+	pk_backend_job_finished (transaction->job);
+}
+
+gboolean
+pk_transaction_run (PkTransaction *transaction)
+{
+	GError *error = NULL;
+	PkExitEnum exit_status;
+
+	g_return_val_if_fail (PK_IS_TRANSACTION (transaction), FALSE);
+	g_return_val_if_fail (transaction->tid != NULL, FALSE);
+	g_return_val_if_fail (transaction->backend != NULL, FALSE);
+
+	/* we are no longer waiting, we are setting up */
+	pk_transaction_status_changed_emit (transaction, PK_STATUS_ENUM_SETUP);
+
+	/* set proxy */
+	if (!pk_transaction_set_session_state (transaction, &error)) {
+		g_debug ("failed to set the session state (non-fatal): %s", error->message);
+		g_clear_error (&error);
+	}
+
+	/* already cancelled? */
+	if (pk_backend_job_get_exit_code (transaction->job) == PK_EXIT_ENUM_CANCELLED) {
+		exit_status = pk_backend_job_get_exit_code (transaction->job);
+		pk_transaction_finished_emit (transaction, exit_status, 0);
+		return TRUE;
+	}
+
+	/* run the job */
+	pk_backend_start_job (transaction->backend, transaction->job);
+
+	/* is an error code set? */
+	if (pk_backend_job_get_is_error_set (transaction->job)) {
+		exit_status = pk_backend_job_get_exit_code (transaction->job);
+		pk_transaction_finished_emit (transaction, exit_status, 0);
+		/* do not fail the transaction */
+	}
+
+	/* check if we should skip this transaction */
+	if (pk_backend_job_get_exit_code (transaction->job) == PK_EXIT_ENUM_SKIP_TRANSACTION) {
+		pk_transaction_finished_emit (transaction, PK_EXIT_ENUM_SUCCESS, 0);
+		/* do not fail the transaction */
+	}
+
+	/* set the role */
+	pk_backend_job_set_role (transaction->job, transaction->role);
+	g_debug ("setting role for %s to %s",
+		 transaction->tid,
+		 pk_role_enum_to_string (transaction->role));
+
+	/* reset after the pre-transaction checks */
+	pk_backend_job_set_percentage (transaction->job, PK_BACKEND_PERCENTAGE_INVALID);
+
+	pk_transaction_set_vfuncs (transaction);
+
+	/* nothing has changed since the same query was last run */
+	transaction->result_cache_key = pk_transaction_get_result_cache_key (transaction);
+	if (transaction->result_cache_key != NULL) {
+		g_autoptr(PkResults) results = NULL;
+
+		transaction->result_cache_generation = pk_backend_result_cache_get_generation (transaction->backend);
+		results = pk_backend_result_cache_lookup (transaction->backend,
+							  transaction->result_cache_key,
+							  pk_backend_job_get_cache_age (transaction->job));
+		if (results != NULL) {
+			g_debug ("using cached results for %s", transaction->tid);
+			transaction->result_cache_hit = TRUE;
+			pk_transaction_replay_results (transaction, results);
+			return TRUE;
+		}
+	}
 
 	/* do the correct action with the cached parameters */
 	switch (transaction->role) {
@@ -2299,6 +2559,214 @@ pk_transaction_run (PkTransaction *transaction)
 	return TRUE;
 }
 
+PkExitEnum
+pk_transaction_get_exit_code (PkTransaction *transaction)
+{
+	g_return_val_if_fail (PK_IS_TRANSACTION (transaction), PK_EXIT_ENUM_UNKNOWN);
+
+	return transaction->exit_enum;
+}
+
+/**
+ * pk_transaction_can_coalesce:
+ *
+ * Return value: %TRUE if @transaction would get exactly the same results as
+ * @primary, and so can follow it rather than being run itself
+ **/
+gboolean
+pk_transaction_can_coalesce (PkTransaction *transaction, PkTransaction *primary)
+{
+	g_return_val_if_fail (PK_IS_TRANSACTION (transaction), FALSE);
+	g_return_val_if_fail (PK_IS_TRANSACTION (primary), FALSE);
+
+	if (transaction->role != primary->role)
+		return FALSE;
+	switch (transaction->role) {
+	case PK_ROLE_ENUM_GET_DETAILS:
+	case PK_ROLE_ENUM_GET_FILES:
+	case PK_ROLE_ENUM_GET_PACKAGES:
+	case PK_ROLE_ENUM_GET_REPO_LIST:
+	case PK_ROLE_ENUM_GET_UPDATE_DETAIL:
+	case PK_ROLE_ENUM_GET_UPDATES:
+		break;
+	case PK_ROLE_ENUM_REFRESH_CACHE:
+		if (transaction->cached_force || primary->cached_force)
+			return FALSE;
+		break;
+	default:
+		return FALSE;
+	}
+
+	/* the other transaction is about to finish */
+	if (primary->finished || primary->primary != NULL)
+		return FALSE;
+	if (pk_backend_job_get_exit_code (primary->job) != PK_EXIT_ENUM_UNKNOWN)
+		return FALSE;
+
+	/* this would cancel the other transaction */
+	if (pk_transaction_get_background (primary) &&
+	    !pk_transaction_get_background (transaction))
+		return FALSE;
+
+	if (transaction->cached_filters != primary->cached_filters)
+		return FALSE;
+	if ((transaction->cached_package_ids == NULL) != (primary->cached_package_ids == NULL))
+		return FALSE;
+	if (transaction->cached_package_ids != NULL &&
+	    !g_strv_equal ((const gchar * const *) transaction->cached_package_ids,
+			   (const gchar * const *) primary->cached_package_ids))
+		return FALSE;
+	if (pk_backend_job_get_cache_age (transaction->job) !=
+	    pk_backend_job_get_cache_age (primary->job))
+		return FALSE;
+	if (g_strcmp0 (pk_backend_job_get_locale (transaction->job),
+		       pk_backend_job_get_locale (primary->job)) != 0)
+		return FALSE;
+	return TRUE;
+}
+
+/**
+ * pk_transaction_subscribe:
+ *
+ * Makes @transaction follow @primary rather than running it. The results
+ * @primary has already sent are replayed, and everything it sends from now on
+ * is forwarded. The caller has to finish @transaction using
+ * pk_transaction_finish_subscription() once @primary has finished.
+ **/
+void
+pk_transaction_subscribe (PkTransaction *transaction, PkTransaction *primary)
+{
+	g_autoptr(GPtrArray) packages = NULL;
+	g_autoptr(GPtrArray) details = NULL;
+	g_autoptr(GPtrArray) update_details = NULL;
+	g_autoptr(GPtrArray) files = NULL;
+	g_autoptr(GPtrArray) repo_details = NULL;
+
+	g_return_if_fail (PK_IS_TRANSACTION (transaction));
+	g_return_if_fail (PK_IS_TRANSACTION (primary));
+	g_return_if_fail (transaction->primary == NULL);
+
+	g_debug ("%s is following %s", transaction->tid, primary->tid);
+	transaction->primary = g_object_ref (primary);
+	pk_transaction_set_vfuncs (transaction);
+
+	/* the subscriber can always be cancelled */
+	pk_transaction_allow_cancel_emit (transaction, TRUE);
+	if (primary->state == PK_TRANSACTION_STATE_RUNNING)
+		pk_transaction_status_changed_emit (transaction, primary->status);
+
+	/* catch up with what has already been sent */
+	packages = pk_results_get_package_array (primary->results);
+	if (packages->len > 0)
+		pk_transaction_packages_cb (NULL, packages, transaction);
+	details = pk_results_get_details_array (primary->results);
+	if (details->len > 0)
+		pk_transaction_details_list_cb (transaction->job, details, transaction);
+	update_details = pk_results_get_update_detail_array (primary->results);
+	if (update_details->len > 0)
+		pk_transaction_update_details_cb (NULL, update_details, transaction);
+	files = pk_results_get_files_array (primary->results);
+	if (files->len > 0)
+		pk_transaction_files_list_cb (transaction->job, files, transaction);
+	repo_details = pk_results_get_repo_detail_array (primary->results);
+	for (guint i = 0; i < repo_details->len; i++)
+		pk_transaction_repo_detail_cb (NULL, g_ptr_array_index (repo_details, i), transaction);
+
+	/* then get everything else as it happens */
+	pk_backend_job_add_subscriber (primary->job, transaction->job);
+}
+
+/**
+ * pk_transaction_unsubscribe:
+ *
+ * Stops following the other transaction, so that @transaction can be run on
+ * its own instead.
+ *
+ * Return value: %TRUE if the client was not sent any results in the meantime
+ **/
+gboolean
+pk_transaction_unsubscribe (PkTransaction *transaction)
+{
+	g_autoptr(GPtrArray) packages = NULL;
+	g_autoptr(GPtrArray) details = NULL;
+	g_autoptr(GPtrArray) update_details = NULL;
+	g_autoptr(GPtrArray) files = NULL;
+	g_autoptr(GPtrArray) repo_details = NULL;
+
+	g_return_val_if_fail (PK_IS_TRANSACTION (transaction), FALSE);
+
+	if (transaction->primary == NULL)
+		return TRUE;
+
+	g_debug ("%s is no longer following %s", transaction->tid, transaction->primary->tid);
+	pk_backend_job_remove_subscriber (transaction->primary->job, transaction->job);
+	pk_backend_job_disconnect_vfuncs (transaction->job);
+	g_clear_object (&transaction->primary);
+
+	packages = pk_results_get_package_array (transaction->results);
+	details = pk_results_get_details_array (transaction->results);
+	update_details = pk_results_get_update_detail_array (transaction->results);
+	files = pk_results_get_files_array (transaction->results);
+	repo_details = pk_results_get_repo_detail_array (transaction->results);
+	return packages->len == 0 && details->len == 0 &&
+	       update_details->len == 0 && files->len == 0 &&
+	       repo_details->len == 0;
+}
+
+/**
+ * pk_transaction_reset_subscription:
+ *
+ * Forgets the results forwarded so far, as the transaction being followed
+ * is run again after failing to get the lock and sends them again.
+ **/
+void
+pk_transaction_reset_subscription (PkTransaction *transaction)
+{
+	g_return_if_fail (PK_IS_TRANSACTION (transaction));
+	g_return_if_fail (transaction->primary != NULL);
+
+	g_object_unref (transaction->results);
+	transaction->results = pk_results_new ();
+}
+
+PkTransaction *
+pk_transaction_get_primary (PkTransaction *transaction)
+{
+	g_return_val_if_fail (PK_IS_TRANSACTION (transaction), NULL);
+
+	return transaction->primary;
+}
+
+/**
+ * pk_transaction_finish_subscription:
+ * @exit_enum: how the transaction that was being followed finished
+ **/
+void
+pk_transaction_finish_subscription (PkTransaction *transaction, PkExitEnum exit_enum)
+{
+	gint64 runtime;
+
+	g_return_if_fail (PK_IS_TRANSACTION (transaction));
+
+	/* the client of this transaction did not cancel it */
+	if (exit_enum == PK_EXIT_ENUM_CANCELLED ||
+	    exit_enum == PK_EXIT_ENUM_CANCELLED_PRIORITY) {
+		g_autofree gchar *msg = NULL;
+		msg = g_strdup_printf ("%s was following a transaction which was cancelled",
+				       transaction->tid);
+		pk_transaction_error_code_emit (transaction,
+						PK_ERROR_ENUM_TRANSACTION_CANCELLED,
+						msg);
+		exit_enum = PK_EXIT_ENUM_FAILED;
+	}
+
+	unschedule_progress_changed (transaction);
+	pk_results_set_exit_code (transaction->results, exit_enum);
+	transaction->finished = TRUE;
+	runtime = g_get_monotonic_time () - transaction->state_time[PK_TRANSACTION_STATE_READY];
+	pk_transaction_finished_emit (transaction, exit_enum, runtime / 1000);
+}
+
 const gchar *
 pk_transaction_get_tid (PkTransaction *transaction)
 {
@@ -3637,9 +4105,9 @@ out:
 }
 
 static void
-pk_transaction_get_old_transactions (PkTransaction *transaction,
-				     GVariant *params,
-				     GDBusMethodInvocation *context)
+pk_transaction_emit_old_transactions (PkTransaction *transaction,
+				      const PkTransactionDbFilter *filter,
+				      GDBusMethodInvocation *context)
 {
 	const gchar *cmdline;
 	const gchar *data;
@@ -3650,20 +4118,12 @@ pk_transaction_get_old_transactions (PkTransaction *transaction,
 	GList *transactions = NULL;
 	guint duration;
 	guint idle_id;
-	guint number;
 	guint uid;
 	PkRoleEnum role;
 	PkTransactionPast *item;
 
-	g_return_if_fail (PK_IS_TRANSACTION (transaction));
-	g_return_if_fail (transaction->tid != NULL);
-
-	g_variant_get (params, "(u)", &number);
-
-	g_debug ("GetOldTransactions method called");
-
 	pk_transaction_set_role (transaction, PK_ROLE_ENUM_GET_OLD_TRANSACTIONS);
-	transactions = pk_transaction_db_get_list (transaction->transaction_db, number);
+	transactions = pk_transaction_db_get_list_filtered (transaction->transaction_db, filter);
 	for (l = transactions; l != NULL; l = l->next) {
 		item = PK_TRANSACTION_PAST (l->data);
 
@@ -3690,21 +4150,17 @@ pk_transaction_get_old_transactions (PkTransaction *transaction,
 			 data,
 			 uid,
 			 cmdline);
-		g_dbus_connection_emit_signal (transaction->connection,
-					       NULL,
-					       transaction->tid,
-					       PK_DBUS_INTERFACE_TRANSACTION,
-					       "Transaction",
-					       g_variant_new ("(osbuusus)",
-							      tid,
-							      modified,
-							      succeeded,
-							      role,
-							      duration,
-							      data != NULL ? data : "",
-							      uid,
-							      cmdline != NULL ? cmdline : ""),
-					       NULL);
+		pk_transaction_emit_signal (transaction,
+					    "Transaction",
+					    g_variant_new ("(osbuusus)",
+							   tid,
+							   modified,
+							   succeeded,
+							   role,
+							   duration,
+							   data != NULL ? data : "",
+							   uid,
+							   cmdline != NULL ? cmdline : ""));
 	}
 	g_list_free_full (transactions, (GDestroyNotify) g_object_unref);
 
@@ -3714,6 +4170,53 @@ pk_transaction_get_old_transactions (PkTransaction *transaction,
 	pk_transaction_dbus_return (context, NULL);
 }
 
+static void
+pk_transaction_get_old_transactions (PkTransaction *transaction,
+				     GVariant *params,
+				     GDBusMethodInvocation *context)
+{
+	PkTransactionDbFilter filter = PK_TRANSACTION_DB_FILTER_INIT;
+
+	g_return_if_fail (PK_IS_TRANSACTION (transaction));
+	g_return_if_fail (transaction->tid != NULL);
+
+	g_variant_get (params, "(u)", &filter.limit);
+
+	g_debug ("GetOldTransactions method called");
+
+	pk_transaction_emit_old_transactions (transaction, &filter, context);
+}
+
+static void
+pk_transaction_get_old_transactions_full (PkTransaction *transaction,
+					  GVariant *params,
+					  GDBusMethodInvocation *context)
+{
+	PkTransactionDbFilter filter = PK_TRANSACTION_DB_FILTER_INIT;
+	gboolean succeeded;
+	g_autoptr(GVariant) options = NULL;
+
+	g_return_if_fail (PK_IS_TRANSACTION (transaction));
+	g_return_if_fail (transaction->tid != NULL);
+
+	g_variant_get (params, "(@a{sv})", &options);
+
+	g_debug ("GetOldTransactionsFull method called");
+
+	/* unknown options are ignored, so clients can use newer ones */
+	g_variant_lookup (options, "limit", "u", &filter.limit);
+	g_variant_lookup (options, "since-tid", "&s", &filter.since_tid);
+	g_variant_lookup (options, "before-tid", "&s", &filter.before_tid);
+	g_variant_lookup (options, "since-timespec", "&s", &filter.since_timespec);
+	g_variant_lookup (options, "role", "u", &filter.role);
+	g_variant_lookup (options, "uid", "u", &filter.uid);
+	g_variant_lookup (options, "data", "b", &filter.with_data);
+	if (g_variant_lookup (options, "succeeded", "b", &succeeded))
+		filter.succeeded = succeeded ? 1 : 0;
+
+	pk_transaction_emit_old_transactions (transaction, &filter, context);
+}
+
 static void
 pk_transaction_get_repo_list (PkTransaction *transaction,
 			      GVariant *params,
@@ -4891,6 +5394,56 @@ out:
 	pk_transaction_dbus_return (context, error);
 }
 
+static void
+pk_transaction_open_result_channel (PkTransaction *transaction,
+				    GVariant *params,
+				    GDBusMethodInvocation *context)
+{
+	gint fd = -1;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GUnixFDList) fd_list = NULL;
+
+	g_return_if_fail (PK_IS_TRANSACTION (transaction));
+	g_return_if_fail (transaction->tid != NULL);
+
+	g_debug ("OpenResultChannel method called");
+
+	/* the results must all go the same way */
+	if (transaction->state != PK_TRANSACTION_STATE_NEW ||
+	    transaction->role != PK_ROLE_ENUM_UNKNOWN ||
+	    transaction->result_channel != NULL) {
+		g_set_error_literal (&error,
+				     PK_TRANSACTION_ERROR,
+				     PK_TRANSACTION_ERROR_INVALID_STATE,
+				     "the result channel can only be opened once, "
+				     "before the transaction is started");
+		pk_transaction_dbus_return (context, error);
+		return;
+	}
+	if ((g_dbus_connection_get_capabilities (transaction->connection) &
+	     G_DBUS_CAPABILITY_FLAGS_UNIX_FD_PASSING) == 0) {
+		g_set_error_literal (&error,
+				     PK_TRANSACTION_ERROR,
+				     PK_TRANSACTION_ERROR_NOT_SUPPORTED,
+				     "file descriptor passing is not supported");
+		pk_transaction_dbus_return (context, error);
+		return;
+	}
+
+	transaction->result_channel = pk_result_channel_new (&fd, &error);
+	if (transaction->result_channel == NULL) {
+		g_prefix_error (&error, "failed to open result channel: ");
+		pk_transaction_dbus_return (context, error);
+		return;
+	}
+
+	/* this takes ownership of the fd */
+	fd_list = g_unix_fd_list_new_from_array (&fd, 1);
+	g_dbus_method_invocation_return_value_with_unix_fd_list (context,
+								 g_variant_new ("(h)", 0),
+								 fd_list);
+}
+
 static void
 pk_transaction_update_packages (PkTransaction *transaction,
 				GVariant *params,
@@ -5153,6 +5706,8 @@ pk_transaction_get_property (GDBusConnection *connection_,
 		return g_variant_new_uint64 (transaction->cached_transaction_flags);
 	if (g_strcmp0 (property_name, "RemainingTime") == 0)
 		return g_variant_new_uint32 (transaction->remaining_time);
+	if (g_strcmp0 (property_name, "Timings") == 0)
+		return pk_transaction_get_timings (transaction);
 
 	g_set_error (error,
 		     G_DBUS_ERROR,
@@ -5194,6 +5749,10 @@ pk_transaction_method_call (GDBusConnection *connection_,
 		pk_transaction_cancel (transaction, parameters, invocation);
 		return;
 	}
+	if (g_strcmp0 (method_name, "OpenResultChannel") == 0) {
+		pk_transaction_open_result_channel (transaction, parameters, invocation);
+		return;
+	}
 
 	/* All action methods below must only be invoked once on a new transaction.
 	 * Reject any attempt to re-invoke them after the transaction has been initialized,
@@ -5249,6 +5808,10 @@ pk_transaction_method_call (GDBusConnection *connection_,
 		pk_transaction_get_old_transactions (transaction, parameters, invocation);
 		return;
 	}
+	if (g_strcmp0 (method_name, "GetOldTransactionsFull") == 0) {
+		pk_transaction_get_old_transactions_full (transaction, parameters, invocation);
+		return;
+	}
 	if (g_strcmp0 (method_name, "GetPackages") == 0) {
 		pk_transaction_get_packages (transaction, parameters, invocation);
 		return;
@@ -5453,6 +6016,7 @@ pk_transaction_init (PkTransaction *transaction)
 	transaction->dbus = pk_dbus_new ();
 	transaction->results = pk_results_new ();
 	transaction->supported_content_types = g_ptr_array_new_with_free_func (g_free);
+	transaction->item_progress_pending = g_ptr_array_new_with_free_func (g_object_unref);
 	transaction->cancellable = g_cancellable_new ();
 
 	transaction->transaction_db = pk_transaction_db_new ();
@@ -5493,6 +6057,13 @@ pk_transaction_dispose (GObject *object)
 	}
 
 	unschedule_progress_changed (transaction);
+	pk_transaction_unsubscribe (transaction);
+
+	/* the client had until now to read what was queued */
+	if (transaction->result_channel != NULL) {
+		pk_result_channel_shutdown (transaction->result_channel);
+		g_clear_object (&transaction->result_channel);
+	}
 
 	/* send signal to clients that we are about to be destroyed */
 	if (transaction->connection != NULL) {
@@ -5523,6 +6094,7 @@ pk_transaction_finalize (GObject *object)
 	if (transaction->watch_id > 0)
 		g_bus_unwatch_name (transaction->watch_id);
 	g_free (transaction->last_package_id);
+	g_free (transaction->result_cache_key);
 	g_free (transaction->cached_package_id);
 	g_free (transaction->cached_key_id);
 	g_strfreev (transaction->cached_package_ids);
@@ -5536,6 +6108,7 @@ pk_transaction_finalize (GObject *object)
 	g_free (transaction->sender);
 	g_free (transaction->cmdline);
 	g_ptr_array_unref (transaction->supported_content_types);
+	g_ptr_array_unref (transaction->item_progress_pending);
 
 	if (transaction->connection != NULL)
 		g_object_unref (transaction->connection);
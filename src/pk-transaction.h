@@ -71,6 +71,16 @@ gboolean	   pk_transaction_is_exclusive (PkTransaction *transaction);
 gboolean	   pk_transaction_is_finished_with_lock_required (PkTransaction *transaction);
 void		   pk_transaction_reset_after_lock_error (PkTransaction *transaction);
 void		   pk_transaction_make_exclusive (PkTransaction *transaction);
+PkExitEnum	   pk_transaction_get_exit_code (PkTransaction *transaction);
+gboolean	   pk_transaction_can_coalesce (PkTransaction *transaction,
+						PkTransaction *primary);
+void		   pk_transaction_subscribe (PkTransaction *transaction,
+					     PkTransaction *primary);
+gboolean	   pk_transaction_unsubscribe (PkTransaction *transaction);
+void		   pk_transaction_reset_subscription (PkTransaction *transaction);
+PkTransaction	  *pk_transaction_get_primary (PkTransaction *transaction);
+void		   pk_transaction_finish_subscription (PkTransaction *transaction,
+						       PkExitEnum     exit_enum);
 void		   pk_transaction_skip_auth_checks (PkTransaction *transaction,
 						    gboolean	   skip_checks);
 
@@ -0,0 +1,279 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2026 PackageKit Authors
+ *
+ * Licensed under the GNU Lesser General Public License Version 2.1
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+/*
+ * Measures the throughput of a running packagekitd using the synthetic
+ * backend, which emits results without doing any real work. The numbers
+ * therefore only reflect the overhead of the daemon, the bus and the client
+ * library. The number of iterations for each role is set using the
+ * PK_BENCH_ITERATIONS environment variable.
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <glib-object.h>
+#include <gio/gio.h>
+
+#include "pk-client.h"
+#include "pk-client-sync.h"
+#include "pk-common.h"
+#include "pk-results.h"
+
+#define PK_BENCH_DEFAULT_ITERATIONS	20
+#define PK_BENCH_PACKAGE_IDS		100
+
+typedef enum {
+	PK_BENCH_ROLE_GET_PACKAGES,
+	PK_BENCH_ROLE_RESOLVE,
+	PK_BENCH_ROLE_SEARCH_NAMES,
+	PK_BENCH_ROLE_GET_DETAILS,
+	PK_BENCH_ROLE_GET_FILES,
+	PK_BENCH_ROLE_GET_UPDATES,
+	PK_BENCH_ROLE_GET_UPDATE_DETAIL,
+	PK_BENCH_ROLE_LAST
+} PkBenchRole;
+
+static const gchar *
+pk_bench_role_to_string (PkBenchRole role)
+{
+	switch (role) {
+	case PK_BENCH_ROLE_GET_PACKAGES:
+		return "get-packages";
+	case PK_BENCH_ROLE_RESOLVE:
+		return "resolve";
+	case PK_BENCH_ROLE_SEARCH_NAMES:
+		return "search-name";
+	case PK_BENCH_ROLE_GET_DETAILS:
+		return "get-details";
+	case PK_BENCH_ROLE_GET_FILES:
+		return "get-files";
+	case PK_BENCH_ROLE_GET_UPDATES:
+		return "get-updates";
+	case PK_BENCH_ROLE_GET_UPDATE_DETAIL:
+		return "get-update-detail";
+	default:
+		return NULL;
+	}
+}
+
+/* returns the number of items in the results */
+static guint
+pk_bench_run_role (PkClient *client, PkBenchRole role, gchar **names, gchar **package_ids)
+{
+	g_autoptr(GError) error = NULL;
+	g_autoptr(PkResults) results = NULL;
+	g_autoptr(GPtrArray) array = NULL;
+	gchar *search[] = { (gchar *) "synthetic-", NULL };
+
+	switch (role) {
+	case PK_BENCH_ROLE_GET_PACKAGES:
+		results = pk_client_get_packages (client,
+						  pk_bitfield_value (PK_FILTER_ENUM_NONE),
+						  NULL, NULL, NULL, &error);
+		break;
+	case PK_BENCH_ROLE_RESOLVE:
+		results = pk_client_resolve (client,
+					     pk_bitfield_value (PK_FILTER_ENUM_NONE),
+					     names,
+					     NULL, NULL, NULL, &error);
+		break;
+	case PK_BENCH_ROLE_SEARCH_NAMES:
+		results = pk_client_search_names (client,
+						  pk_bitfield_value (PK_FILTER_ENUM_NONE),
+						  search,
+						  NULL, NULL, NULL, &error);
+		break;
+	case PK_BENCH_ROLE_GET_DETAILS:
+		results = pk_client_get_details (client, package_ids, NULL, NULL, NULL, &error);
+		break;
+	case PK_BENCH_ROLE_GET_FILES:
+		results = pk_client_get_files (client, package_ids, NULL, NULL, NULL, &error);
+		break;
+	case PK_BENCH_ROLE_GET_UPDATES:
+		results = pk_client_get_updates (client,
+						 pk_bitfield_value (PK_FILTER_ENUM_NONE),
+						 NULL, NULL, NULL, &error);
+		break;
+	case PK_BENCH_ROLE_GET_UPDATE_DETAIL:
+		results = pk_client_get_update_detail (client, package_ids, NULL, NULL, NULL, &error);
+		break;
+	default:
+		g_assert_not_reached ();
+	}
+	g_assert_no_error (error);
+	g_assert_nonnull (results);
+	g_assert_cmpint (pk_results_get_exit_code (results), ==, PK_EXIT_ENUM_SUCCESS);
+
+	switch (role) {
+	case PK_BENCH_ROLE_GET_DETAILS:
+		array = pk_results_get_details_array (results);
+		break;
+	case PK_BENCH_ROLE_GET_FILES:
+		array = pk_results_get_files_array (results);
+		break;
+	case PK_BENCH_ROLE_GET_UPDATE_DETAIL:
+		array = pk_results_get_update_detail_array (results);
+		break;
+	default:
+		array = pk_results_get_package_array (results);
+		break;
+	}
+	return array->len;
+}
+
+/* in kB, or 0 if unknown */
+static guint64
+pk_bench_get_rss_for_pid (guint32 pid)
+{
+	g_autofree gchar *contents = NULL;
+	g_autofree gchar *fn = NULL;
+	g_auto(GStrv) lines = NULL;
+
+	fn = g_strdup_printf ("/proc/%u/status", pid);
+	if (!g_file_get_contents (fn, &contents, NULL, NULL))
+		return 0;
+	lines = g_strsplit (contents, "\n", -1);
+	for (guint i = 0; lines[i] != NULL; i++) {
+		if (g_str_has_prefix (lines[i], "VmRSS:"))
+			return g_ascii_strtoull (lines[i] + strlen ("VmRSS:"), NULL, 10);
+	}
+	return 0;
+}
+
+static guint32
+pk_bench_get_daemon_pid (void)
+{
+	guint32 pid = 0;
+	g_autoptr(GDBusConnection) connection = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GVariant) value = NULL;
+
+	connection = g_bus_get_sync (G_BUS_TYPE_SYSTEM, NULL, &error);
+	if (connection == NULL) {
+		g_warning ("failed to connect to the system bus: %s", error->message);
+		return 0;
+	}
+	value = g_dbus_connection_call_sync (connection,
+					     "org.freedesktop.DBus",
+					     "/org/freedesktop/DBus",
+					     "org.freedesktop.DBus",
+					     "GetConnectionUnixProcessID",
+					     g_variant_new ("(s)", PK_DBUS_SERVICE),
+					     G_VARIANT_TYPE ("(u)"),
+					     G_DBUS_CALL_FLAGS_NONE,
+					     -1,
+					     NULL,
+					     &error);
+	if (value == NULL) {
+		g_warning ("failed to get the daemon PID: %s", error->message);
+		return 0;
+	}
+	g_variant_get (value, "(u)", &pid);
+	return pid;
+}
+
+static gint
+pk_bench_sort_latency_cb (gconstpointer a, gconstpointer b)
+{
+	gint64 latency_a = *((const gint64 *) a);
+	gint64 latency_b = *((const gint64 *) b);
+	if (latency_a < latency_b)
+		return -1;
+	if (latency_a > latency_b)
+		return 1;
+	return 0;
+}
+
+/* in ms, using the nearest-rank method */
+static gdouble
+pk_bench_percentile (GArray *latencies, guint percentile)
+{
+	guint rank = (percentile * latencies->len + 99) / 100;
+	if (rank == 0)
+		rank = 1;
+	return (gdouble) g_array_index (latencies, gint64, rank - 1) / 1000.f;
+}
+
+int
+main (int argc, char **argv)
+{
+	guint iterations;
+	guint32 daemon_pid;
+	const gchar *tmp;
+	g_autoptr(PkClient) client = NULL;
+	g_auto(GStrv) names = NULL;
+	g_auto(GStrv) package_ids = NULL;
+
+	tmp = g_getenv ("PK_BENCH_ITERATIONS");
+	iterations = tmp != NULL ? atoi (tmp) : PK_BENCH_DEFAULT_ITERATIONS;
+	if (iterations == 0)
+		iterations = PK_BENCH_DEFAULT_ITERATIONS;
+
+	/* these have to match what the synthetic backend generates */
+	names = g_new0 (gchar *, PK_BENCH_PACKAGE_IDS + 1);
+	package_ids = g_new0 (gchar *, PK_BENCH_PACKAGE_IDS + 1);
+	for (guint i = 0; i < PK_BENCH_PACKAGE_IDS; i++) {
+		names[i] = g_strdup_printf ("synthetic-%06u", i);
+		package_ids[i] = g_strdup_printf ("synthetic-%06u;1.%u-1;x86_64;synthetic", i, i % 100);
+	}
+
+	client = pk_client_new ();
+	pk_client_set_background (client, FALSE);
+	pk_client_set_interactive (client, FALSE);
+
+	/* warm up, and make sure this is the right backend */
+	g_assert_cmpint (pk_bench_run_role (client, PK_BENCH_ROLE_RESOLVE, names, package_ids), >, 0);
+	daemon_pid = pk_bench_get_daemon_pid ();
+
+	g_print ("%-18s %8s %10s %10s %10s %10s %10s %10s\n",
+		 "role", "items", "tx/s", "items/s", "p50 ms", "p99 ms", "daemon kB", "client kB");
+	for (guint role = 0; role < PK_BENCH_ROLE_LAST; role++) {
+		gdouble elapsed;
+		guint items = 0;
+		g_autoptr(GArray) latencies = NULL;
+		g_autoptr(GTimer) timer = g_timer_new ();
+
+		latencies = g_array_sized_new (FALSE, FALSE, sizeof (gint64), iterations);
+		for (guint i = 0; i < iterations; i++) {
+			gint64 start = g_get_monotonic_time ();
+			gint64 latency;
+			items += pk_bench_run_role (client, role, names, package_ids);
+			latency = g_get_monotonic_time () - start;
+			g_array_append_val (latencies, latency);
+		}
+		elapsed = g_timer_elapsed (timer, NULL);
+		g_array_sort (latencies, pk_bench_sort_latency_cb);
+		g_print ("%-18s %8u %10.1f %10.0f %10.2f %10.2f %10" G_GUINT64_FORMAT " %10" G_GUINT64_FORMAT "\n",
+			 pk_bench_role_to_string (role),
+			 items / iterations,
+			 iterations / elapsed,
+			 items / elapsed,
+			 pk_bench_percentile (latencies, 50),
+			 pk_bench_percentile (latencies, 99),
+			 pk_bench_get_rss_for_pid (daemon_pid),
+			 pk_bench_get_rss_for_pid (getpid ()));
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,139 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2026 PackageKit Authors
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Measures the enum <-> string conversions, comparing the generated indexes
+ * used by functions such as pk_info_enum_from_string() with a linear scan
+ * using pk_enum_find_value() and pk_enum_find_string() over the same table.
+ * The number of rounds over each enum is set using the PK_BENCH_ITERATIONS
+ * environment variable.
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <glib.h>
+
+#include "pk-enum.h"
+
+#define PK_BENCH_DEFAULT_ITERATIONS	100000
+
+typedef struct {
+	const gchar	*name;
+	guint		 last;
+	const gchar	*(*to_string) (guint value);
+	guint		 (*from_string) (const gchar *string);
+} PkBenchEnum;
+
+#define PK_BENCH_ENUM(name)							\
+static const gchar *								\
+pk_bench_##name##_to_string (guint value)					\
+{										\
+	return pk_##name##_enum_to_string (value);				\
+}										\
+static guint									\
+pk_bench_##name##_from_string (const gchar *string)				\
+{										\
+	return pk_##name##_enum_from_string (string);				\
+}
+
+PK_BENCH_ENUM (role)
+PK_BENCH_ENUM (status)
+PK_BENCH_ENUM (info)
+PK_BENCH_ENUM (filter)
+PK_BENCH_ENUM (error)
+
+static const PkBenchEnum enums[] = {
+	{ "role",	PK_ROLE_ENUM_LAST,	pk_bench_role_to_string,	pk_bench_role_from_string },
+	{ "status",	PK_STATUS_ENUM_LAST,	pk_bench_status_to_string,	pk_bench_status_from_string },
+	{ "info",	PK_INFO_ENUM_LAST,	pk_bench_info_to_string,	pk_bench_info_from_string },
+	{ "filter",	PK_FILTER_ENUM_LAST,	pk_bench_filter_to_string,	pk_bench_filter_from_string },
+	{ "error",	PK_ERROR_ENUM_LAST,	pk_bench_error_to_string,	pk_bench_error_from_string },
+	{ NULL,		0,			NULL,				NULL }
+};
+
+/* nanoseconds for each lookup */
+static gdouble
+pk_bench_get_ns (gint64 start, guint64 lookups)
+{
+	return (gdouble) (g_get_monotonic_time () - start) * 1000.0 / lookups;
+}
+
+static void
+pk_bench_enum (const PkBenchEnum *bench, guint iterations)
+{
+	gint64 start;
+	guint64 lookups;
+	guint sum = 0;
+	g_autofree PkEnumMatch *table = NULL;
+
+	/* the same table, for pk_enum_find_value() and pk_enum_find_string() */
+	table = g_new0 (PkEnumMatch, bench->last + 1);
+	for (guint i = 0; i < bench->last; i++) {
+		table[i].value = i;
+		table[i].string = bench->to_string (i);
+	}
+	lookups = (guint64) iterations * bench->last;
+
+	start = g_get_monotonic_time ();
+	for (guint j = 0; j < iterations; j++) {
+		for (guint i = 0; i < bench->last; i++)
+			sum += pk_enum_find_value (table, table[i].string);
+	}
+	g_print ("%-8s from_string  linear: %6.1f ns", bench->name, pk_bench_get_ns (start, lookups));
+	start = g_get_monotonic_time ();
+	for (guint j = 0; j < iterations; j++) {
+		for (guint i = 0; i < bench->last; i++)
+			sum += bench->from_string (table[i].string);
+	}
+	g_print ("  indexed: %6.1f ns\n", pk_bench_get_ns (start, lookups));
+
+	start = g_get_monotonic_time ();
+	for (guint j = 0; j < iterations; j++) {
+		for (guint i = 0; i < bench->last; i++)
+			sum += *pk_enum_find_string (table, i);
+	}
+	g_print ("%-8s to_string    linear: %6.1f ns", bench->name, pk_bench_get_ns (start, lookups));
+	start = g_get_monotonic_time ();
+	for (guint j = 0; j < iterations; j++) {
+		for (guint i = 0; i < bench->last; i++)
+			sum += *bench->to_string (i);
+	}
+	g_print ("  indexed: %6.1f ns\n", pk_bench_get_ns (start, lookups));
+
+	/* so that the loops are not optimized out */
+	if (sum == 0)
+		g_print ("\n");
+}
+
+int
+main (int argc, char **argv)
+{
+	guint iterations = PK_BENCH_DEFAULT_ITERATIONS;
+	const gchar *iterations_str = g_getenv ("PK_BENCH_ITERATIONS");
+
+	if (iterations_str != NULL)
+		iterations = MAX (g_ascii_strtoull (iterations_str, NULL, 10), 1);
+
+	for (guint i = 0; enums[i].name != NULL; i++)
+		pk_bench_enum (&enums[i], iterations);
+	return EXIT_SUCCESS;
+}
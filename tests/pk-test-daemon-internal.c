@@ -25,11 +25,13 @@
 #include <glib.h>
 #include <glib-object.h>
 #include <glib/gstdio.h>
+#include <unistd.h>
 
 #include "pk-backend.h"
 #include "pk-backend-spawn.h"
 #include "pk-dbus.h"
 #include "pk-engine.h"
+#include "pk-result-channel.h"
 #include "pk-spawn.h"
 #include "pk-transaction-db.h"
 #include "pk-transaction.h"
@@ -300,6 +302,197 @@ pk_test_backend_func (void)
 	g_assert_cmpint (pk_backend_job_get_exit_code (job), ==, PK_EXIT_ENUM_NEED_UNTRUSTED);
 }
 
+static void
+pk_test_backend_progress_percentage_cb (PkBackendJob *job, gpointer data, gpointer user_data)
+{
+	GString *events = (GString *) user_data;
+	g_string_append_printf (events, "percentage:%u;", GPOINTER_TO_UINT (data));
+}
+
+static void
+pk_test_backend_progress_status_cb (PkBackendJob *job, gpointer data, gpointer user_data)
+{
+	GString *events = (GString *) user_data;
+	g_string_append_printf (events,
+				"status:%s;",
+				pk_status_enum_to_string (GPOINTER_TO_UINT (data)));
+}
+
+static void
+pk_test_backend_progress_item_cb (PkBackendJob *job, PkItemProgress *item, gpointer user_data)
+{
+	GString *events = (GString *) user_data;
+	g_string_append_printf (events,
+				"item:%s:%s:%u;",
+				pk_item_progress_get_package_id (item),
+				pk_status_enum_to_string (pk_item_progress_get_status (item)),
+				pk_item_progress_get_percentage (item));
+}
+
+static void
+pk_test_backend_progress_func (void)
+{
+	const gchar *package_id = "vips-doc;7.12.4-2.fc8;noarch;linva";
+	g_autoptr(GKeyFile) conf = g_key_file_new ();
+	g_autoptr(GString) events = g_string_new (NULL);
+	g_autoptr(PkBackendJob) job = NULL;
+
+	job = pk_backend_job_new (conf);
+	pk_backend_job_set_vfunc (job,
+				  PK_BACKEND_SIGNAL_PERCENTAGE,
+				  PK_BACKEND_JOB_VFUNC (pk_test_backend_progress_percentage_cb),
+				  events);
+	pk_backend_job_set_vfunc (job,
+				  PK_BACKEND_SIGNAL_STATUS_CHANGED,
+				  PK_BACKEND_JOB_VFUNC (pk_test_backend_progress_status_cb),
+				  events);
+	pk_backend_job_set_vfunc (job,
+				  PK_BACKEND_SIGNAL_ITEM_PROGRESS,
+				  PK_BACKEND_JOB_VFUNC (pk_test_backend_progress_item_cb),
+				  events);
+
+	/* only the latest value is sent, but every status of an item is */
+	pk_backend_job_set_percentage (job, 10);
+	pk_backend_job_set_percentage (job, 20);
+	pk_backend_job_set_item_progress (job, package_id, PK_STATUS_ENUM_DOWNLOAD, 10);
+	pk_backend_job_set_item_progress (job, package_id, PK_STATUS_ENUM_DOWNLOAD, 50);
+	pk_backend_job_set_item_progress (job, package_id, PK_STATUS_ENUM_INSTALL, 0);
+	pk_backend_job_set_item_progress (job, package_id, PK_STATUS_ENUM_INSTALL, 30);
+	pk_backend_job_set_percentage (job, 30);
+
+	/* progress set before another signal is sent before it */
+	pk_backend_job_set_status (job, PK_STATUS_ENUM_INSTALL);
+	pk_backend_job_set_percentage (job, 40);
+	_g_test_loop_wait (100);
+
+	g_assert_cmpstr (events->str, ==,
+			 "percentage:30;"
+			 "item:vips-doc;7.12.4-2.fc8;noarch;linva:download:50;"
+			 "item:vips-doc;7.12.4-2.fc8;noarch;linva:install:30;"
+			 "status:install;"
+			 "percentage:40;");
+}
+
+static void
+pk_test_backend_result_cache_func (void)
+{
+	guint generation;
+	g_autoptr(GKeyFile) conf = NULL;
+	g_autoptr(PkBackend) backend = NULL;
+	g_autoptr(PkResults) results = NULL;
+	g_autoptr(PkResults) results_tmp = NULL;
+
+	conf = g_key_file_new ();
+	g_key_file_set_boolean (conf, "Daemon", "CacheResults", TRUE);
+	backend = pk_backend_new (conf);
+	results = pk_results_new ();
+
+	/* nothing cached yet */
+	results_tmp = pk_backend_result_cache_lookup (backend, "get-updates|none||", G_MAXUINT);
+	g_assert_null (results_tmp);
+
+	/* add and get back */
+	generation = pk_backend_result_cache_get_generation (backend);
+	pk_backend_result_cache_add (backend, "get-updates|none||", generation, results);
+	results_tmp = pk_backend_result_cache_lookup (backend, "get-updates|none||", G_MAXUINT);
+	g_assert_true (results_tmp == results);
+	g_clear_object (&results_tmp);
+
+	/* a different query */
+	results_tmp = pk_backend_result_cache_lookup (backend, "get-updates|installed||", G_MAXUINT);
+	g_assert_null (results_tmp);
+
+	/* results of a query started before the invalidation are dropped */
+	pk_backend_result_cache_invalidate (backend);
+	results_tmp = pk_backend_result_cache_lookup (backend, "get-updates|none||", G_MAXUINT);
+	g_assert_null (results_tmp);
+	pk_backend_result_cache_add (backend, "get-updates|none||", generation, results);
+	results_tmp = pk_backend_result_cache_lookup (backend, "get-updates|none||", G_MAXUINT);
+	g_assert_null (results_tmp);
+
+	g_assert_cmpint (pk_backend_result_cache_get_hits (backend), ==, 1);
+	g_assert_cmpint (pk_backend_result_cache_get_misses (backend), ==, 4);
+}
+
+static void
+pk_test_backend_download_cache_func (void)
+{
+	gboolean ret;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GKeyFile) conf = NULL;
+	g_autoptr(PkBackend) backend = NULL;
+	g_autofree gchar *tmp_dir = NULL;
+	g_autofree gchar *cache_dir = NULL;
+	g_autofree gchar *downloaded = NULL;
+	g_autofree gchar *reused = NULL;
+	g_autofree gchar *cached = NULL;
+	g_autofree gchar *checksum = NULL;
+	g_autofree gchar *hash = NULL;
+	g_autofree gchar *data = NULL;
+
+	tmp_dir = g_dir_make_tmp ("pk-self-test-XXXXXX", &error);
+	g_assert_no_error (error);
+	cache_dir = g_build_filename (tmp_dir, "download-cache", NULL);
+	downloaded = g_build_filename (tmp_dir, "powertop-1.8-1.fc8.rpm", NULL);
+	reused = g_build_filename (tmp_dir, "reused.rpm", NULL);
+	hash = g_compute_checksum_for_string (G_CHECKSUM_SHA256, "powertop", -1);
+	checksum = g_strdup_printf ("sha256:%s", hash);
+	cached = g_build_filename (cache_dir, checksum, NULL);
+	ret = g_file_set_contents (downloaded, "powertop", -1, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+
+	conf = g_key_file_new ();
+	g_key_file_set_integer (conf, "Daemon", "DownloadCacheAge", 3600);
+	backend = pk_backend_new (conf);
+	pk_backend_set_download_cache_directory (backend, cache_dir);
+
+	/* nothing cached yet */
+	g_assert_false (pk_backend_download_cache_link (backend, checksum, reused));
+
+	/* the checksum is used as the file name, so has to be safe */
+	pk_backend_download_cache_add (backend, "sha256:../../etc", downloaded);
+	g_assert_false (pk_backend_download_cache_link (backend, "sha256:../../etc", reused));
+
+	/* and we have to be able to verify it */
+	pk_backend_download_cache_add (backend, "sha224:0123", downloaded);
+	g_assert_false (g_file_test (cache_dir, G_FILE_TEST_EXISTS));
+
+	/* add and get back */
+	pk_backend_download_cache_add (backend, checksum, downloaded);
+	g_assert_true (g_file_test (cached, G_FILE_TEST_IS_REGULAR));
+	g_assert_true (pk_backend_download_cache_link (backend, checksum, reused));
+	ret = g_file_get_contents (reused, &data, NULL, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	g_assert_cmpstr (data, ==, "powertop");
+	g_unlink (reused);
+
+	/* recently used, so kept */
+	pk_backend_download_cache_expire (backend);
+	g_assert_true (g_file_test (cached, G_FILE_TEST_IS_REGULAR));
+
+	/* a corrupted entry is not used, and dropped */
+	ret = g_file_set_contents (cached, "corrupted", -1, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	g_assert_false (pk_backend_download_cache_link (backend, checksum, reused));
+	g_assert_false (g_file_test (reused, G_FILE_TEST_EXISTS));
+	g_assert_false (g_file_test (cached, G_FILE_TEST_EXISTS));
+
+	/* disabling the cache empties it */
+	pk_backend_download_cache_add (backend, checksum, downloaded);
+	g_assert_true (g_file_test (cached, G_FILE_TEST_IS_REGULAR));
+	g_key_file_set_integer (conf, "Daemon", "DownloadCacheAge", 0);
+	g_assert_false (pk_backend_download_cache_link (backend, checksum, reused));
+	pk_backend_download_cache_expire (backend);
+	g_assert_false (g_file_test (cached, G_FILE_TEST_EXISTS));
+
+	g_unlink (downloaded);
+	g_rmdir (cache_dir);
+	g_rmdir (tmp_dir);
+}
+
 static guint _backend_spawn_number_packages = 0;
 
 static void
@@ -815,6 +1008,12 @@ pk_test_transaction_db_func (void)
 	g_autoptr(PkTransactionDb) db = NULL;
 	g_autofree gchar *proxy_http = NULL;
 	g_autofree gchar *proxy_ftp = NULL;
+	g_autofree gchar *tid1 = NULL;
+	g_autofree gchar *tid2 = NULL;
+	g_autofree gchar *tid3 = NULL;
+	GList *list;
+	PkTransactionPast *item;
+	PkTransactionDbFilter filter = PK_TRANSACTION_DB_FILTER_INIT;
 
 	/* remove the self check file */
 #if PK_BUILD_LOCAL
@@ -940,6 +1139,76 @@ pk_test_transaction_db_func (void)
 	g_assert_true (ret);
 	g_assert_cmpstr (proxy_http, ==, "127.0.0.1:80");
 	g_assert_cmpstr (proxy_ftp, ==, "127.0.0.1:21");
+
+	/* add some history */
+	tid1 = pk_transaction_db_generate_id (db);
+	tid2 = pk_transaction_db_generate_id (db);
+	tid3 = pk_transaction_db_generate_id (db);
+	g_assert_true (pk_transaction_db_add (db, tid1));
+	g_assert_true (pk_transaction_db_set_role (db, tid1, PK_ROLE_ENUM_INSTALL_PACKAGES));
+	g_assert_true (pk_transaction_db_add (db, tid2));
+	g_assert_true (pk_transaction_db_set_role (db, tid2, PK_ROLE_ENUM_REMOVE_PACKAGES));
+	g_assert_true (pk_transaction_db_set_uid (db, tid2, 500));
+	g_assert_true (pk_transaction_db_set_data (db, tid2, "removing\tgtk2;2.14.0;i386;fedora"));
+	g_assert_true (pk_transaction_db_set_finished (db, tid2, TRUE, 1000));
+	g_assert_true (pk_transaction_db_add (db, tid3));
+	g_assert_true (pk_transaction_db_set_role (db, tid3, PK_ROLE_ENUM_INSTALL_PACKAGES));
+
+	/* everything after the first, oldest first */
+	filter.since_tid = tid1;
+	list = pk_transaction_db_get_list_filtered (db, &filter);
+	g_assert_cmpint (g_list_length (list), ==, 2);
+	item = PK_TRANSACTION_PAST (list->data);
+	g_assert_cmpstr (pk_transaction_past_get_id (item), ==, tid2);
+	g_assert_cmpint (pk_transaction_past_get_role (item), ==, PK_ROLE_ENUM_REMOVE_PACKAGES);
+	g_assert_cmpint (pk_transaction_past_get_uid (item), ==, 500);
+	g_assert_cmpint (pk_transaction_past_get_duration (item), ==, 1000);
+	g_assert_true (pk_transaction_past_get_succeeded (item));
+	g_assert_cmpstr (pk_transaction_past_get_data (item), ==, "removing\tgtk2;2.14.0;i386;fedora");
+	item = PK_TRANSACTION_PAST (list->next->data);
+	g_assert_cmpstr (pk_transaction_past_get_id (item), ==, tid3);
+	g_list_free_full (list, (GDestroyNotify) g_object_unref);
+
+	/* filtered by role */
+	filter.role = PK_ROLE_ENUM_INSTALL_PACKAGES;
+	list = pk_transaction_db_get_list_filtered (db, &filter);
+	g_assert_cmpint (g_list_length (list), ==, 1);
+	g_assert_cmpstr (pk_transaction_past_get_id (list->data), ==, tid3);
+	g_list_free_full (list, (GDestroyNotify) g_object_unref);
+
+	/* filtered by uid and success, without the data */
+	filter.role = PK_ROLE_ENUM_UNKNOWN;
+	filter.uid = 500;
+	filter.succeeded = 1;
+	filter.with_data = FALSE;
+	list = pk_transaction_db_get_list_filtered (db, &filter);
+	g_assert_cmpint (g_list_length (list), ==, 1);
+	g_assert_cmpstr (pk_transaction_past_get_id (list->data), ==, tid2);
+	g_assert_cmpstr (pk_transaction_past_get_data (list->data), ==, NULL);
+	g_list_free_full (list, (GDestroyNotify) g_object_unref);
+
+	/* paging backwards */
+	filter = (PkTransactionDbFilter) PK_TRANSACTION_DB_FILTER_INIT;
+	filter.before_tid = tid3;
+	filter.limit = 1;
+	list = pk_transaction_db_get_list_filtered (db, &filter);
+	g_assert_cmpint (g_list_length (list), ==, 1);
+	g_assert_cmpstr (pk_transaction_past_get_id (list->data), ==, tid2);
+	g_list_free_full (list, (GDestroyNotify) g_object_unref);
+
+	/* an unknown cursor matches nothing */
+	filter.before_tid = "/9999_ffffffff";
+	list = pk_transaction_db_get_list_filtered (db, &filter);
+	g_assert_null (list);
+
+	/* paging forwards gets the ones right after the cursor */
+	filter = (PkTransactionDbFilter) PK_TRANSACTION_DB_FILTER_INIT;
+	filter.since_tid = tid1;
+	filter.limit = 1;
+	list = pk_transaction_db_get_list_filtered (db, &filter);
+	g_assert_cmpint (g_list_length (list), ==, 1);
+	g_assert_cmpstr (pk_transaction_past_get_id (list->data), ==, tid2);
+	g_list_free_full (list, (GDestroyNotify) g_object_unref);
 }
 
 static PkTransactionDb *db = NULL;
@@ -1282,6 +1551,269 @@ pk_test_scheduler_func (void)
 	g_object_unref (db);
 }
 
+static void
+pk_test_scheduler_coalesce_func (void)
+{
+	gboolean ret;
+	PkTransaction *transaction1;
+	PkTransaction *transaction2;
+	GError *error = NULL;
+	g_autofree gchar *tid_item1 = NULL;
+	g_autofree gchar *tid_item2 = NULL;
+	g_autoptr(GKeyFile) conf = NULL;
+	g_autoptr(PkBackend) backend = NULL;
+	g_autoptr(PkScheduler) tlist = NULL;
+
+	db = pk_transaction_db_new ();
+	ret = pk_transaction_db_load (db, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+
+	/* try to load a valid backend */
+	conf = g_key_file_new ();
+	g_key_file_set_string (conf, "Daemon", "DefaultBackend", "dummy");
+	backend = pk_backend_new (conf);
+	ret = pk_backend_load (backend, NULL);
+	g_assert_true (ret);
+
+	tlist = pk_scheduler_new (conf);
+	pk_scheduler_set_backend (tlist, backend);
+
+	tid_item1 = pk_test_scheduler_create_transaction (tlist);
+	tid_item2 = pk_test_scheduler_create_transaction (tlist);
+	transaction1 = pk_scheduler_get_transaction (tlist, tid_item1);
+	transaction2 = pk_scheduler_get_transaction (tlist, tid_item2);
+	g_signal_connect (transaction2,
+			  "finished",
+			  G_CALLBACK (pk_test_scheduler_finished_cb),
+			  NULL);
+
+	/* the first one runs */
+	pk_transaction_get_updates (transaction1,
+				    g_variant_new ("(t)", pk_bitfield_value (PK_FILTER_ENUM_NONE)),
+				    NULL);
+	g_assert_cmpint (pk_transaction_get_state (transaction1), ==, PK_TRANSACTION_STATE_RUNNING);
+
+	/* and the identical second one just follows it */
+	pk_transaction_get_updates (transaction2,
+				    g_variant_new ("(t)", pk_bitfield_value (PK_FILTER_ENUM_NONE)),
+				    NULL);
+	g_assert_cmpint (pk_transaction_get_state (transaction2), ==, PK_TRANSACTION_STATE_READY);
+	g_assert_true (pk_transaction_get_primary (transaction2) == transaction1);
+
+	/* both finish at the same time */
+	_g_test_loop_run_with_timeout (10000);
+	g_assert_cmpint (pk_transaction_get_state (transaction1), ==, PK_TRANSACTION_STATE_FINISHED);
+	g_assert_cmpint (pk_transaction_get_state (transaction2), ==, PK_TRANSACTION_STATE_FINISHED);
+	g_assert_cmpint (pk_transaction_get_exit_code (transaction2), ==,
+			 pk_transaction_get_exit_code (transaction1));
+	g_assert_null (pk_transaction_get_primary (transaction2));
+
+	g_object_unref (db);
+}
+
+typedef struct {
+	GPtrArray	*order;
+	guint		 expected;
+} PkTestSchedulerOrder;
+
+static void
+pk_test_scheduler_order_finished_cb (PkTransaction *transaction,
+				     const gchar *exit_text,
+				     guint time,
+				     PkTestSchedulerOrder *helper)
+{
+	g_ptr_array_add (helper->order, g_strdup (pk_transaction_get_tid (transaction)));
+	if (helper->order->len == helper->expected)
+		_g_test_loop_quit ();
+}
+
+/* queues a search, or a GetUpdates which is not as urgent, for @uid; they are
+ * exclusive, so they run one after the other in the order the scheduler picks */
+static gchar *
+pk_test_scheduler_queue (PkScheduler *tlist,
+			 guint uid,
+			 gboolean interactive,
+			 PkTestSchedulerOrder *helper)
+{
+	PkTransaction *transaction;
+	gchar *tid;
+	g_auto(GStrv) search = g_strsplit ("power", " ", -1);
+
+	tid = pk_test_scheduler_create_transaction (tlist);
+	pk_scheduler_set_uid (tlist, tid, uid);
+	transaction = pk_scheduler_get_transaction (tlist, tid);
+	g_signal_connect (transaction,
+			  "finished",
+			  G_CALLBACK (pk_test_scheduler_order_finished_cb),
+			  helper);
+	pk_transaction_make_exclusive (transaction);
+	if (interactive) {
+		pk_transaction_search_names (transaction,
+					     g_variant_new ("(t^as)", pk_bitfield_value (PK_FILTER_ENUM_NONE), search),
+					     NULL);
+	} else {
+		pk_transaction_get_updates (transaction,
+					    g_variant_new ("(t)", pk_bitfield_value (PK_FILTER_ENUM_NONE)),
+					    NULL);
+	}
+	return tid;
+}
+
+static void
+pk_test_scheduler_fairness_func (void)
+{
+	gboolean ret;
+	GError *error = NULL;
+	PkTestSchedulerOrder helper = { NULL, 4 };
+	g_autofree gchar *tid_running = NULL;
+	g_autofree gchar *tid_a1 = NULL;
+	g_autofree gchar *tid_a2 = NULL;
+	g_autofree gchar *tid_b1 = NULL;
+	g_autoptr(GKeyFile) conf = NULL;
+	g_autoptr(PkBackend) backend = NULL;
+	g_autoptr(PkScheduler) tlist = NULL;
+	g_autoptr(GPtrArray) order = g_ptr_array_new_with_free_func (g_free);
+
+	db = pk_transaction_db_new ();
+	ret = pk_transaction_db_load (db, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+
+	conf = g_key_file_new ();
+	g_key_file_set_string (conf, "Daemon", "DefaultBackend", "dummy");
+	backend = pk_backend_new (conf);
+	ret = pk_backend_load (backend, NULL);
+	g_assert_true (ret);
+
+	tlist = pk_scheduler_new (conf);
+	pk_scheduler_set_backend (tlist, backend);
+	helper.order = order;
+
+	/* the first user has three transactions, and the second just one */
+	tid_running = pk_test_scheduler_queue (tlist, 1000, TRUE, &helper);
+	tid_a1 = pk_test_scheduler_queue (tlist, 1000, TRUE, &helper);
+	tid_a2 = pk_test_scheduler_queue (tlist, 1000, TRUE, &helper);
+	tid_b1 = pk_test_scheduler_queue (tlist, 1001, TRUE, &helper);
+	_g_test_loop_run_with_timeout (10000);
+
+	/* the second user does not wait for all of the first user's */
+	g_assert_cmpuint (order->len, ==, 4);
+	g_assert_cmpstr (g_ptr_array_index (order, 0), ==, tid_running);
+	g_assert_cmpstr (g_ptr_array_index (order, 1), ==, tid_b1);
+	g_assert_cmpstr (g_ptr_array_index (order, 2), ==, tid_a1);
+	g_assert_cmpstr (g_ptr_array_index (order, 3), ==, tid_a2);
+
+	g_object_unref (db);
+}
+
+static void
+pk_test_scheduler_aging_func (void)
+{
+	gboolean ret;
+	GError *error = NULL;
+	PkTestSchedulerOrder helper = { NULL, 4 };
+	g_autofree gchar *tid_running = NULL;
+	g_autofree gchar *tid_old = NULL;
+	g_autofree gchar *tid_new = NULL;
+	g_autofree gchar *tid_interactive = NULL;
+	g_autoptr(GKeyFile) conf = NULL;
+	g_autoptr(PkBackend) backend = NULL;
+	g_autoptr(PkScheduler) tlist = NULL;
+	g_autoptr(GPtrArray) order = g_ptr_array_new_with_free_func (g_free);
+
+	db = pk_transaction_db_new ();
+	ret = pk_transaction_db_load (db, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+
+	conf = g_key_file_new ();
+	g_key_file_set_string (conf, "Daemon", "DefaultBackend", "dummy");
+	backend = pk_backend_new (conf);
+	ret = pk_backend_load (backend, NULL);
+	g_assert_true (ret);
+
+	tlist = pk_scheduler_new (conf);
+	pk_scheduler_set_backend (tlist, backend);
+	helper.order = order;
+
+	/* two GetUpdates, one of which has been waiting for a while, and then
+	 * a search which would otherwise be run before both of them */
+	tid_running = pk_test_scheduler_queue (tlist, 1000, TRUE, &helper);
+	tid_old = pk_test_scheduler_queue (tlist, 1000, FALSE, &helper);
+	tid_new = pk_test_scheduler_queue (tlist, 1000, FALSE, &helper);
+	tid_interactive = pk_test_scheduler_queue (tlist, 1000, TRUE, &helper);
+	pk_scheduler_set_waited (tlist, tid_old, 10);
+	_g_test_loop_run_with_timeout (10000);
+
+	/* the old one has caught up with the search, and was queued first */
+	g_assert_cmpuint (order->len, ==, 4);
+	g_assert_cmpstr (g_ptr_array_index (order, 0), ==, tid_running);
+	g_assert_cmpstr (g_ptr_array_index (order, 1), ==, tid_old);
+	g_assert_cmpstr (g_ptr_array_index (order, 2), ==, tid_interactive);
+	g_assert_cmpstr (g_ptr_array_index (order, 3), ==, tid_new);
+
+	g_object_unref (db);
+}
+
+static void
+pk_test_scheduler_priority_func (void)
+{
+	gboolean ret;
+	guint64 transactions = 0;
+	PkTransaction *transaction;
+	GError *error = NULL;
+	g_auto(GStrv) search = NULL;
+	g_autofree gchar *tid = NULL;
+	g_autoptr(GKeyFile) conf = NULL;
+	g_autoptr(PkBackend) backend = NULL;
+	g_autoptr(PkScheduler) tlist = NULL;
+
+	db = pk_transaction_db_new ();
+	ret = pk_transaction_db_load (db, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+
+	/* try to load a valid backend */
+	conf = g_key_file_new ();
+	g_key_file_set_string (conf, "Daemon", "DefaultBackend", "dummy");
+	backend = pk_backend_new (conf);
+	ret = pk_backend_load (backend, NULL);
+	g_assert_true (ret);
+
+	tlist = pk_scheduler_new (conf);
+	pk_scheduler_set_backend (tlist, backend);
+
+	/* nothing has been run yet */
+	g_assert_cmpint (pk_scheduler_get_queue_wait (tlist, PK_SCHEDULER_PRIORITY_INTERACTIVE, &transactions), ==, 0);
+	g_assert_cmpint (transactions, ==, 0);
+
+	tid = pk_test_scheduler_create_transaction (tlist);
+	transaction = pk_scheduler_get_transaction (tlist, tid);
+	g_signal_connect (transaction,
+			  "finished",
+			  G_CALLBACK (pk_test_scheduler_finished_cb),
+			  NULL);
+
+	/* a search is a short query */
+	search = g_strsplit ("power", " ", -1);
+	pk_transaction_search_names (transaction,
+				     g_variant_new ("(t^as)", pk_bitfield_value (PK_FILTER_ENUM_NONE), search),
+				     NULL);
+	g_assert_cmpint (pk_transaction_get_state (transaction), ==, PK_TRANSACTION_STATE_RUNNING);
+	_g_test_loop_run_with_timeout (10000);
+
+	/* and it was counted in the right class */
+	pk_scheduler_get_queue_wait (tlist, PK_SCHEDULER_PRIORITY_INTERACTIVE, &transactions);
+	g_assert_cmpint (transactions, ==, 1);
+	pk_scheduler_get_queue_wait (tlist, PK_SCHEDULER_PRIORITY_NORMAL, &transactions);
+	g_assert_cmpint (transactions, ==, 0);
+	pk_scheduler_get_queue_wait (tlist, PK_SCHEDULER_PRIORITY_BACKGROUND, &transactions);
+	g_assert_cmpint (transactions, ==, 0);
+
+	g_object_unref (db);
+}
+
 static void
 pk_test_scheduler_parallel_func (void)
 {
@@ -1498,6 +2030,59 @@ pk_test_scheduler_parallel_func (void)
 	g_object_unref (db);
 }
 
+static void
+pk_test_result_channel_drain (gint fd)
+{
+	gchar buf[4096];
+	gssize len;
+
+	/* the daemon end has been closed if this ends */
+	do {
+		len = read (fd, buf, sizeof (buf));
+	} while (len > 0);
+	g_assert_cmpint (len, ==, 0);
+}
+
+static void
+pk_test_result_channel_func (void)
+{
+	g_autoptr(GError) error = NULL;
+	g_autoptr(PkResultChannel) channel = NULL;
+	g_autofree gchar *summary = g_strnfill (1024, 'x');
+	gint client_fd = -1;
+	guint i;
+
+	/* a client which never reads is cut off once the buffer is full */
+	channel = pk_result_channel_new (&client_fd, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (channel);
+	pk_result_channel_set_max_size (channel, 64 * 1024);
+	for (i = 0; i < 100000; i++) {
+		if (!pk_result_channel_emit (channel, "Package",
+					     g_variant_new ("(uss)", 1, "hal;0.0.1;i386;fedora", summary)))
+			break;
+	}
+	g_assert_cmpuint (i, <, 100000);
+	g_assert_false (pk_result_channel_emit (channel, "Finished", g_variant_new ("(uu)", 1, 0)));
+	pk_test_result_channel_drain (client_fd);
+	close (client_fd);
+	g_clear_object (&channel);
+
+	/* anything still queued is dropped when the transaction goes away */
+	channel = pk_result_channel_new (&client_fd, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (channel);
+	for (i = 0; i < 1000; i++) {
+		g_assert_true (pk_result_channel_emit (channel, "Package",
+						       g_variant_new ("(uss)", 1, "hal;0.0.1;i386;fedora", summary)));
+	}
+	pk_result_channel_close (channel);
+	pk_result_channel_shutdown (channel);
+	g_assert_false (pk_result_channel_emit (channel, "Finished", g_variant_new ("(uu)", 1, 0)));
+	pk_test_result_channel_drain (client_fd);
+	close (client_fd);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -1513,10 +2098,18 @@ main (int argc, char **argv)
 	g_test_add_func ("/packagekit/spawn", pk_test_spawn_func);
 	g_test_add_func ("/packagekit/scheduler", pk_test_scheduler_func);
 	g_test_add_func ("/packagekit/scheduler-parallel", pk_test_scheduler_parallel_func);
+	g_test_add_func ("/packagekit/scheduler-coalesce", pk_test_scheduler_coalesce_func);
+	g_test_add_func ("/packagekit/scheduler-priority", pk_test_scheduler_priority_func);
+	g_test_add_func ("/packagekit/scheduler-fairness", pk_test_scheduler_fairness_func);
+	g_test_add_func ("/packagekit/scheduler-aging", pk_test_scheduler_aging_func);
 	g_test_add_func ("/packagekit/transaction-db", pk_test_transaction_db_func);
+	g_test_add_func ("/packagekit/result-channel", pk_test_result_channel_func);
 
 	/* backend stuff */
 	g_test_add_func ("/packagekit/backend", pk_test_backend_func);
+	g_test_add_func ("/packagekit/backend-result-cache", pk_test_backend_result_cache_func);
+	g_test_add_func ("/packagekit/backend-download-cache", pk_test_backend_download_cache_func);
+	g_test_add_func ("/packagekit/backend-progress", pk_test_backend_progress_func);
 	g_test_add_func ("/packagekit/backend_spawn", pk_test_backend_spawn_func);
 
 	return g_test_run ();
@@ -27,6 +27,7 @@
 #include <gio/gunixsocketaddress.h>
 
 #include "pk-client-helper.h"
+#include "pk-client-private.h"
 #include "pk-common.h"
 #include "pk-control.h"
 #include "pk-debug.h"
@@ -348,6 +349,18 @@ pk_test_package_id_func (void)
 	gboolean ret;
 	gchar *text;
 	gchar **sections;
+	PkPackageIdView view;
+	const gchar *package_ids[] = {
+		"moo;0.0.1;i386;fedora",
+		"kde-i18n-csb;4:3.5.8~pre20071001-0ubuntu1;all;",
+		"moo;;;",
+		"moo;;;installed:fedora",
+		"",
+		";",
+		"foo;moo",
+		"foo;moo;dave;clive;dan",
+		";0.1.2;i386;data",
+	};
 
 	/* check not valid - NULL */
 	ret = pk_package_id_check (NULL);
@@ -419,6 +432,30 @@ pk_test_package_id_func (void)
 	/* test fail missing first */
 	sections = pk_package_id_split (";0.1.2;i386;data");
 	g_assert_true (sections == NULL);
+
+	/* parsing agrees with splitting */
+	for (guint i = 0; i < G_N_ELEMENTS (package_ids); i++) {
+		g_auto(GStrv) split = pk_package_id_split (package_ids[i]);
+
+		ret = pk_package_id_parse (package_ids[i], &view);
+		g_assert_cmpint (ret, ==, split != NULL);
+		if (!ret)
+			continue;
+		for (guint j = PK_PACKAGE_ID_NAME; j <= PK_PACKAGE_ID_DATA; j++) {
+			g_autofree gchar *section = g_strndup (view.sections[j], view.lengths[j]);
+			g_assert_cmpstr (section, ==, split[j]);
+			g_assert_true (pk_package_id_view_equal (&view, j, split[j]));
+		}
+	}
+
+	/* only the whole section is equal */
+	ret = pk_package_id_parse ("moo;0.0.1;i386;fedora", &view);
+	g_assert_true (ret);
+	g_assert_true (pk_package_id_view_equal (&view, PK_PACKAGE_ID_NAME, "moo"));
+	g_assert_false (pk_package_id_view_equal (&view, PK_PACKAGE_ID_NAME, "mo"));
+	g_assert_false (pk_package_id_view_equal (&view, PK_PACKAGE_ID_NAME, "moose"));
+	g_assert_false (pk_package_id_view_equal (&view, PK_PACKAGE_ID_ARCH, NULL));
+	g_assert_true (pk_package_id_view_equal (&view, PK_PACKAGE_ID_DATA, "fedora"));
 }
 
 static void
@@ -685,6 +722,33 @@ pk_test_offline_func (void)
 	g_assert_true (sack != NULL);
 	g_assert_cmpint (pk_package_sack_get_size (sack), ==, 1);
 
+	/* no plan from the backend */
+	tmp = pk_offline_get_prepared_plan ("dummy", "1", (gchar **) package_ids, &error);
+	g_assert_error (error, PK_OFFLINE_ERROR, PK_OFFLINE_ERROR_NO_DATA);
+	g_assert_null (tmp);
+	g_clear_error (&error);
+
+	/* the plan is only returned for the state it was made against */
+	ret = pk_offline_auth_set_prepared_plan ("dummy", "1", (gchar **) package_ids, "{}", &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	tmp = pk_offline_get_prepared_plan ("dummy", "1", (gchar **) package_ids, &error);
+	g_assert_no_error (error);
+	g_assert_cmpstr (tmp, ==, "{}");
+	g_free (tmp);
+	tmp = pk_offline_get_prepared_plan ("dummy", "2", (gchar **) package_ids, &error);
+	g_assert_error (error, PK_OFFLINE_ERROR, PK_OFFLINE_ERROR_INVALID_VALUE);
+	g_assert_null (tmp);
+	g_clear_error (&error);
+	tmp = pk_offline_get_prepared_plan ("dnf5", "1", (gchar **) package_ids, &error);
+	g_assert_error (error, PK_OFFLINE_ERROR, PK_OFFLINE_ERROR_INVALID_VALUE);
+	g_assert_null (tmp);
+	g_clear_error (&error);
+	tmp = pk_offline_get_prepared_plan ("dummy", "1", NULL, &error);
+	g_assert_error (error, PK_OFFLINE_ERROR, PK_OFFLINE_ERROR_INVALID_VALUE);
+	g_assert_null (tmp);
+	g_clear_error (&error);
+
 	/* check monitor */
 	monitor = pk_offline_get_prepared_monitor (NULL, &error);
 	g_assert_no_error (error);
@@ -726,6 +790,7 @@ pk_test_offline_func (void)
 	g_assert_no_error (error);
 	g_assert_true (ret);
 	g_assert_true (!g_file_test (PK_OFFLINE_PREPARED_FILENAME, G_FILE_TEST_EXISTS));
+	g_assert_true (!g_file_test (PK_OFFLINE_PREPARED_PLAN_FILENAME, G_FILE_TEST_EXISTS));
 	g_assert_true (!g_file_test (PK_OFFLINE_TRIGGER_FILENAME, G_FILE_TEST_EXISTS));
 	g_assert_true (!g_file_test (PK_OFFLINE_ACTION_FILENAME, G_FILE_TEST_EXISTS));
 	g_assert_true (!g_file_test (PK_OFFLINE_RESULTS_FILENAME, G_FILE_TEST_EXISTS));
@@ -998,6 +1063,73 @@ pk_test_client_helper_func (void)
 	g_rmdir (tmp_dir);
 }
 
+/* the daemon keeps the downloaded packages, so the copies handed to the
+ * caller must never share an inode with them */
+static void
+pk_test_client_copy_file_func (void)
+{
+	GStatBuf st_src;
+	GStatBuf st_dest;
+	gboolean ret;
+	g_autoptr(GError) error = NULL;
+	g_autofree gchar *tmp_dir = NULL;
+	g_autofree gchar *src = NULL;
+	g_autofree gchar *dest = NULL;
+	g_autofree gchar *missing = NULL;
+	g_autofree gchar *data = NULL;
+
+	tmp_dir = g_dir_make_tmp ("pk-self-test-XXXXXX", &error);
+	g_assert_no_error (error);
+	src = g_build_filename (tmp_dir, "powertop-1.8-1.fc8.rpm", NULL);
+	dest = g_build_filename (tmp_dir, "copy.rpm", NULL);
+	missing = g_build_filename (tmp_dir, "missing.rpm", NULL);
+	ret = g_file_set_contents (src, "powertop", -1, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+
+	/* reflink or copy_file_range, but never link() */
+	ret = pk_client_copy_file (src, dest, NULL, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	g_assert_cmpint (g_stat (src, &st_src), ==, 0);
+	g_assert_cmpint (g_stat (dest, &st_dest), ==, 0);
+	g_assert_cmpuint (st_src.st_ino, !=, st_dest.st_ino);
+	g_assert_cmpuint (st_src.st_nlink, ==, 1);
+	ret = g_file_get_contents (dest, &data, NULL, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	g_assert_cmpstr (data, ==, "powertop");
+	g_clear_pointer (&data, g_free);
+
+	/* changing the copy does not change the original */
+	ret = g_file_set_contents (dest, "changed", -1, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	ret = g_file_get_contents (src, &data, NULL, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	g_assert_cmpstr (data, ==, "powertop");
+	g_clear_pointer (&data, g_free);
+
+	/* the fast paths refuse an existing file, so g_file_copy() is used */
+	ret = pk_client_copy_file (src, dest, NULL, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	ret = g_file_get_contents (dest, &data, NULL, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	g_assert_cmpstr (data, ==, "powertop");
+
+	/* and reports the error when there is nothing to copy */
+	ret = pk_client_copy_file (missing, dest, NULL, &error);
+	g_assert_error (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
+	g_assert_false (ret);
+
+	g_unlink (src);
+	g_unlink (dest);
+	g_rmdir (tmp_dir);
+}
+
 #define PK_TEST_TYPE(TYPE_NAME, CTOR_NAME)     \
 	{                                      \
 		TYPE_NAME *var = CTOR_NAME (); \
@@ -1067,6 +1199,7 @@ main (int argc, char **argv)
 	g_test_add_func ("/packagekit-glib2/offline-upgrade", pk_test_offline_upgrade_func);
 	g_test_add_func ("/packagekit-glib2/object-types", pk_test_object_types_func);
 	g_test_add_func ("/packagekit-glib2/client-helper", pk_test_client_helper_func);
+	g_test_add_func ("/packagekit-glib2/client-copy-file", pk_test_client_copy_file_func);
 
 	return g_test_run ();
 }
@@ -8,7 +8,9 @@
 """Run the PackageKit daemon tests.
 
 The pk-test-e2e binary exercises the client library against a running
-PackageKit daemon (using the dummy backend) over the system D-Bus.
+PackageKit daemon (using the dummy backend) over the system D-Bus. The
+same harness runs the pk-bench-daemon benchmark against the synthetic
+backend.
 This script forwards the test binary's output straight to stdout/stderr
 and keeps the daemon's own output in a buffer that is only printed
 when something goes wrong.
@@ -189,6 +191,7 @@ def main():
     parser = argparse.ArgumentParser(description='Run the PackageKit daemon test.')
     parser.add_argument('--daemon', required=True, help='path to the packagekitd binary')
     parser.add_argument('--test', required=True, help='path to the pk-test-e2e binary')
+    parser.add_argument('--backend', default='dummy', help='name of the backend to load')
     args = parser.parse_args()
 
     reasons = check_prerequisites()
@@ -237,9 +240,15 @@ def main():
         bus_proc, bus_tmpdir = start_system_bus_if_needed(daemon_log)
         polkitd_proc = start_polkitd_if_needed(daemon_log)
 
-        print('Launching {} with the dummy backend...'.format(args.daemon))
+        print('Launching {} with the {} backend...'.format(args.daemon, args.backend))
         daemon = subprocess.Popen(
-            [args.daemon, '--verbose', '--disable-timer', '--keep-environment', '--backend=dummy'],
+            [
+                args.daemon,
+                '--verbose',
+                '--disable-timer',
+                '--keep-environment',
+                '--backend=' + args.backend,
+            ],
             cwd=build_root,
             stdout=daemon_log,
             stderr=subprocess.STDOUT,